@@ -0,0 +1,28 @@
+#include "common.vert.h"
+
+layout(location = 0) in vec3 inPos;
+layout(location = 0) out vec3 outViewPos;
+layout(location = 1) in vec3 inNormal;
+layout(location = 1) out vec3 outViewNormal;
+layout(location = 2) in mat4 instanceModel;
+layout(location = 6) in vec4 instanceColor;
+layout(location = 2) out vec4 outColor;
+
+struct UBO_VS_Data {
+    mat4 view;
+    mat4 proj;
+};
+layout (set = 0, binding = 0, std140) uniform UBO_VS {
+    UBO_VS_Data ubo;
+};
+
+void main() {
+	// The instance transforms are assumed to have a uniform scale,
+	// so the normals are transformed by the modelView matrix
+	mat4 modelView = ubo.view * instanceModel;
+	vec4 viewPos = modelView * vec4(inPos, 1.0);
+	outViewPos = vec3(viewPos);
+	outViewNormal = normalize(mat3(modelView) * inNormal);
+	outColor = instanceColor;
+	setPos(ubo.proj * viewPos);
+}
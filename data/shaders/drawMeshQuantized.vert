@@ -0,0 +1,43 @@
+#include "common.vert.h"
+
+// The attributes are fetched from quantized vertex buffers,
+// the missing components are filled in by the vertex input
+layout(location = 0) in vec4 inPos;
+layout(location = 0) out vec3 outViewPos;
+layout(location = 1) in vec4 inNormal;
+layout(location = 1) out vec3 outViewNormal;
+
+#define NORMAL_DECODE_NONE 0
+#define NORMAL_DECODE_UNORM 1
+#define NORMAL_DECODE_OCTAHEDRAL 2
+
+struct UBO_VS_Data {
+    // modelView and modelViewProj include the dequantization of the positions
+    mat4 modelView;
+    mat4 modelViewInverseTranspose;
+    mat4 modelViewProj;
+    int normalDecode, padding0, padding1, padding2;
+};
+layout (set = 0, binding = 0, std140) uniform UBO_VS {
+    UBO_VS_Data ubo;
+};
+
+vec3 octDecode(vec2 e) {
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0);
+	n.xy += mix(vec2(t), vec2(-t), greaterThanEqual(n.xy, vec2(0.0)));
+	return n;
+}
+
+vec3 decodeNormal(vec4 n) {
+	if (ubo.normalDecode == NORMAL_DECODE_OCTAHEDRAL) return octDecode(n.xy);
+	if (ubo.normalDecode == NORMAL_DECODE_UNORM) return n.xyz * 2.0 - 1.0;
+	return n.xyz;
+}
+
+void main() {
+	vec4 pos = vec4(inPos.xyz, 1.0);
+	outViewPos = vec3(ubo.modelView * pos);
+	outViewNormal = vec3(ubo.modelViewInverseTranspose * vec4(normalize(decodeNormal(inNormal)), 0.0));
+	setPos(ubo.modelViewProj * pos);
+}
@@ -0,0 +1,10 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+layout (set = 0, binding = 0) uniform sampler2D textures[];
+layout (location = 0) in vec2 v_texCoord;
+layout (location = 1) flat in uint v_textureIndex;
+layout (location = 0) out vec4 fragColor;
+
+void main() {
+	fragColor = texture(textures[nonuniformEXT(v_textureIndex)], v_texCoord);
+}
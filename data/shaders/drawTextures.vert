@@ -0,0 +1,14 @@
+#include "common.vert.h"
+
+layout(location = 0) in vec2 pos;
+layout(location = 1) in vec2 texCoord;
+layout(location = 2) in vec4 rect;
+layout(location = 3) in uint textureIndex;
+layout(location = 0) out vec2 v_texCoord;
+layout(location = 1) flat out uint v_textureIndex;
+
+void main() {
+	setPos(vec4(rect.xy + pos * rect.zw, 0.0, 1.0));
+	v_texCoord = texCoord;
+	v_textureIndex = textureIndex;
+}
@@ -0,0 +1,86 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#pragma once
+#include "ngfx/graphics/Buffer.h"
+#include "ngfx/graphics/CommandBuffer.h"
+#include "ngfx/graphics/Graphics.h"
+#include "ngfx/graphics/GraphicsContext.h"
+#include "ngfx/graphics/Texture.h"
+#include <functional>
+
+/** \class AsyncCompute
+ *
+ *  This class submits compute passes to the compute queue, so that they
+ *  overlap with the graphics work instead of being serialized with it.
+ *  The buffers and textures written by the compute pass and read by the
+ *  graphics queue are registered as shared resources: their ownership is
+ *  transferred between the queue families, and the graphics frame waits
+ *  for the compute pass with a semaphore.
+ *  The expected order is one compute pass per frame:
+ *  submit, then submit the frame whose command buffer was recorded
+ *  with join ... release.
+ *  On devices without a dedicated compute queue family, or if the dedicated
+ *  queue is disabled, the compute passes are submitted to the graphics queue
+ *  and the ownership transfers are replaced by regular barriers.
+ */
+
+namespace ngfx {
+class AsyncCompute {
+public:
+  /** The record callback. It's called inside a compute pass */
+  typedef std::function<void(CommandBuffer *commandBuffer)> RecordFn;
+  /** Create the async compute interface
+   *  @param ctx The graphics context
+   *  @param graphics The graphics interface
+   *  @param enableDedicatedQueue Use the dedicated compute queue, if the
+   *  device has one
+   */
+  static AsyncCompute *create(GraphicsContext *ctx, Graphics *graphics,
+                              bool enableDedicatedQueue = true);
+  /** Destroy the async compute interface. Waits for the last compute pass */
+  virtual ~AsyncCompute() {}
+  /** Share a buffer that's written by the compute passes and read by the
+   *  graphics queue (e.g. as a vertex, index, uniform or storage buffer) */
+  virtual void addSharedBuffer(Buffer *buffer) = 0;
+  /** Share a texture that's written by the compute passes as a storage
+   *  image and sampled by the graphics queue */
+  virtual void addSharedTexture(Texture *texture) = 0;
+  /** Record and submit a compute pass.
+   *  If the previous compute pass is still running, it's waited for first.
+   *  With a dedicated compute queue, a frame must be submitted between
+   *  two compute passes, otherwise this is an error.
+   *  @param record The function that records the compute commands
+   */
+  virtual void submit(RecordFn record) = 0;
+  /** Record the acquire barriers of the shared resources to a graphics
+   *  command buffer, before the commands that read them.
+   *  Must be called outside a render pass */
+  virtual void join(CommandBuffer *commandBuffer) = 0;
+  /** Record the barriers that hand the shared resources back to the
+   *  compute queue, after the commands that read them.
+   *  Must be called outside a render pass */
+  virtual void release(CommandBuffer *commandBuffer) = 0;
+  /** Wait for the last compute pass */
+  virtual void wait() = 0;
+  /** True if the compute passes run on a dedicated compute queue */
+  bool dedicatedQueue = false;
+};
+} // namespace ngfx
@@ -0,0 +1,109 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#pragma once
+#include "ngfx/compute/ComputeOp.h"
+#include "ngfx/compute/ComputePipeline.h"
+#include "ngfx/graphics/Buffer.h"
+#include "ngfx/graphics/Graphics.h"
+#include "ngfx/graphics/MeshData.h"
+#include <memory>
+#include <vector>
+
+/** \class ClusterCullOp
+ *
+ *  Cull the meshlets of a mesh on the GPU, see
+ *  MeshOptimizer::buildMeshlets.
+ *  Each meshlet is tested against the camera frustum with its bounding
+ *  sphere, and against the view direction with its normal cone.
+ *  The indices of the visible meshlets are compacted into a 32-bit index
+ *  buffer, and their count is written to an indexed indirect draw command,
+ *  so the mesh is drawn with standard vertex shaders, without mesh shaders
+ *  or any CPU work or readback.
+ */
+
+namespace ngfx {
+class ClusterCullOp : public ComputeOp {
+public:
+  /** The culling statistics of the last test */
+  struct Stats {
+    uint32_t numMeshlets = 0, numVisible = 0, numFrustumCulled = 0,
+             numBackfaceCulled = 0, numVisibleFaces = 0;
+  };
+  /** Create the culling operation
+   *  @param ctx The graphics context
+   *  @param meshData The mesh, with meshlets
+   */
+  ClusterCullOp(GraphicsContext *ctx, const MeshData &meshData);
+  /** Create the culling operation for a quantized mesh
+   *  @param ctx The graphics context
+   *  @param meshData The quantized mesh, with meshlets
+   */
+  ClusterCullOp(GraphicsContext *ctx, const QuantizedMeshData &meshData);
+  virtual ~ClusterCullOp() {}
+  void apply(CommandBuffer *commandBuffer = nullptr,
+             Graphics *graphics = nullptr) override;
+  /** Update the culling parameters.
+   *  The culling is done in model space, the frustum planes and the camera
+   *  position are derived from the matrices
+   *  @param modelView The model view matrix
+   *  @param proj The projection matrix
+   *  @param lod The level of detail whose meshlets are culled
+   *  @param backfaceCulling Cull the meshlets that are facing away from
+   *  the camera
+   */
+  virtual void update(const mat4 &modelView, const mat4 &proj,
+                      uint32_t lod = 0, bool backfaceCulling = true);
+  /** Read back the statistics of the last test.
+   *  Only valid once the GPU has completed the command buffer */
+  Stats getStats();
+  /** The meshlets and the indices of the mesh */
+  std::unique_ptr<Buffer> bMeshlets, bFaces;
+  /** The indices of the visible meshlets, a 32-bit index buffer */
+  std::unique_ptr<Buffer> bIndices;
+  /** A DrawIndexedIndirectCommand with the number of visible indices,
+   *  followed by the culling counters */
+  std::unique_ptr<Buffer> bDrawArgs;
+  std::unique_ptr<Buffer> bUbo;
+  uint32_t firstMeshlet = 0, numMeshlets = 0;
+
+protected:
+  struct UboData {
+    vec4 frustumPlanes[6];
+    vec4 cameraPos;
+    uint32_t firstMeshlet, numMeshlets, backfaceCulling, padding;
+  };
+  struct DrawArgs {
+    DrawIndexedIndirectCommand command;
+    uint32_t numFrustumCulled, numBackfaceCulled, padding;
+  };
+  void init(const std::vector<Meshlet> &meshlets,
+            const std::vector<MeshLOD> &lods,
+            const std::vector<uint32_t> &indices);
+  void createPipelines();
+  ComputePipeline *cullPipeline, *resetPipeline;
+  /** The first meshlet of each LOD, followed by the number of meshlets */
+  std::vector<uint32_t> lodMeshlets;
+  uint32_t U_UBO = 0, SSBO_MESHLETS = 1, SSBO_FACES = 2, SSBO_INDICES = 3,
+           SSBO_DRAW_ARGS = 4;
+  uint32_t RESET_SSBO_DRAW_ARGS = 0;
+  static const uint32_t THREADS_PER_GROUP = 64, MAX_GROUPS_X = 65535;
+};
+} // namespace ngfx
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#pragma once
+#include "ngfx/compute/ComputeOp.h"
+#include "ngfx/compute/ComputePipeline.h"
+#include "ngfx/graphics/Buffer.h"
+#include "ngfx/graphics/Graphics.h"
+#include "ngfx/graphics/MeshData.h"
+#include <memory>
+
+/** \class FrustumCullOp
+ *
+ *  Cull a set of mesh instances against the camera frustum on the GPU.
+ *  Each instance's bounding sphere, derived from the mesh bounds and
+ *  scaled by the instance's model matrix, is tested against the six
+ *  frustum planes. The surviving instances are compacted into the
+ *  output buffers, and their count is written to an indexed indirect draw
+ *  command, so the instances are drawn without any CPU work or readback.
+ */
+
+namespace ngfx {
+class FrustumCullOp : public ComputeOp {
+public:
+  /** Create the culling operation
+   *  @param ctx The graphics context
+   *  @param meshData The mesh, used for its bounds and index count
+   */
+  FrustumCullOp(GraphicsContext *ctx, const MeshData &meshData);
+  virtual ~FrustumCullOp() {}
+  void apply(CommandBuffer *commandBuffer = nullptr,
+             Graphics *graphics = nullptr) override;
+  /** Update the culling parameters.
+   *  The output buffers are reallocated if the number of instances
+   *  exceeds their capacity.
+   *  @param viewProj The view projection matrix
+   *  @param instanceModel The model matrix of each instance,
+   *  a storage buffer
+   *  @param instanceColor The color of each instance, a storage buffer
+   *  @param numInstances The number of instances
+   */
+  virtual void update(const mat4 &viewProj, Buffer *instanceModel,
+                      Buffer *instanceColor, uint32_t numInstances);
+  /** The visible instances, used as instance-rate vertex buffers */
+  std::unique_ptr<Buffer> bVisibleModel, bVisibleColor;
+  /** A DrawIndexedIndirectCommand with the number of visible instances */
+  std::unique_ptr<Buffer> bDrawArgs;
+  std::unique_ptr<Buffer> bUbo;
+  uint32_t numInstances = 0, maxInstances = 0;
+
+protected:
+  struct UboData {
+    vec4 frustumPlanes[6];
+    vec4 boundingSphere;
+    uint32_t numInstances, indexCount, padding[2];
+  };
+  void createPipelines();
+  void createOutputBuffers(uint32_t maxInstances);
+  ComputePipeline *cullPipeline, *resetPipeline;
+  Buffer *bInstanceModel = nullptr, *bInstanceColor = nullptr;
+  vec4 boundingSphere;
+  uint32_t indexCount;
+  uint32_t U_UBO = 0, SSBO_INSTANCE_MODEL = 1, SSBO_INSTANCE_COLOR = 2,
+           SSBO_VISIBLE_MODEL = 3, SSBO_VISIBLE_COLOR = 4, SSBO_DRAW_ARGS = 5;
+  uint32_t RESET_SSBO_DRAW_ARGS = 0;
+  static const uint32_t THREADS_PER_GROUP = 64;
+};
+} // namespace ngfx
@@ -0,0 +1,145 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#pragma once
+#include "ngfx/compute/ComputeOp.h"
+#include "ngfx/compute/ComputePipeline.h"
+#include "ngfx/graphics/Buffer.h"
+#include "ngfx/graphics/Graphics.h"
+#include "ngfx/graphics/MeshData.h"
+#include "ngfx/graphics/Texture.h"
+#include <memory>
+#include <vector>
+
+/** \class HiZCullOp
+ *
+ *  Cull a set of mesh instances against the camera frustum and against
+ *  a hierarchical depth buffer (Hi-Z) on the GPU.
+ *  The depth pyramid is built from a depth buffer by a chain of compute
+ *  passes, each texel keeping the farthest depth of the texels it covers.
+ *  An instance is occluded if the nearest depth of its bounding box is
+ *  behind the pyramid texels covering its screen space bounding rectangle.
+ *
+ *  Culling runs in two phases each frame:
+ *  1. cullPreviousVisible: the instances that were visible in the previous
+ *  frame are written to the output buffers. Drawing them to a depth buffer
+ *  gives a good approximation of the occluders.
+ *  2. buildDepthPyramid and apply: every instance is tested against the
+ *  pyramid built from that depth buffer. The visible instances overwrite
+ *  the output buffers and are drawn in the final pass, and the visibility
+ *  is kept for the next frame.
+ */
+
+namespace ngfx {
+class HiZCullOp : public ComputeOp {
+public:
+  /** The culling statistics of the last occlusion test */
+  struct Stats {
+    uint32_t numInstances = 0, numVisible = 0, numFrustumCulled = 0,
+             numOcclusionCulled = 0;
+  };
+  /** Create the culling operation
+   *  @param ctx The graphics context
+   *  @param meshData The mesh, used for its bounds and index count
+   *  @param depthW The width of the depth buffer
+   *  @param depthH The height of the depth buffer
+   */
+  HiZCullOp(GraphicsContext *ctx, const MeshData &meshData, uint32_t depthW,
+            uint32_t depthH);
+  virtual ~HiZCullOp() {}
+  /** Write the instances that were visible in the previous frame
+   *  and are inside the frustum to the output buffers */
+  void cullPreviousVisible(CommandBuffer *commandBuffer, Graphics *graphics);
+  /** Build the depth pyramid
+   *  @param depthTexture The depth buffer, a sampled texture in
+   *  IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL layout
+   */
+  void buildDepthPyramid(CommandBuffer *commandBuffer, Graphics *graphics,
+                         Texture *depthTexture);
+  /** Test every instance against the frustum and the depth pyramid,
+   *  and write the visible instances to the output buffers */
+  void apply(CommandBuffer *commandBuffer = nullptr,
+             Graphics *graphics = nullptr) override;
+  /** Update the culling parameters.
+   *  The output buffers are reallocated if the number of instances
+   *  exceeds their capacity, which resets the visibility history.
+   *  @param viewProj The view projection matrix
+   *  @param instanceModel The model matrix of each instance,
+   *  a storage buffer
+   *  @param instanceColor The color of each instance, a storage buffer
+   *  @param numInstances The number of instances
+   */
+  virtual void update(const mat4 &viewProj, Buffer *instanceModel,
+                      Buffer *instanceColor, uint32_t numInstances);
+  /** Read back the statistics of the last occlusion test.
+   *  Only valid once the GPU has completed the command buffer */
+  Stats getStats();
+  /** The visible instances, used as instance-rate vertex buffers */
+  std::unique_ptr<Buffer> bVisibleModel, bVisibleColor;
+  /** A DrawIndexedIndirectCommand with the number of visible instances,
+   *  followed by the culling counters */
+  std::unique_ptr<Buffer> bDrawArgs;
+  /** The depth pyramid levels, packed from the finest to the coarsest */
+  std::unique_ptr<Buffer> bDepthPyramid;
+  /** The visibility of each instance in the last occlusion test */
+  std::unique_ptr<Buffer> bVisibility;
+  std::unique_ptr<Buffer> bUbo;
+  uint32_t numInstances = 0, maxInstances = 0;
+
+protected:
+  static const uint32_t MAX_LEVELS = 16;
+  enum Phase { PHASE_RESET, PHASE_PREVIOUS_VISIBLE, PHASE_OCCLUSION };
+  struct UboData {
+    mat4 viewProj;
+    vec4 frustumPlanes[6];
+    vec4 boundingSphere;
+    vec4 boxMin, boxMax;
+    vec4 ndcToUv;
+    uvec4 levelOffsets[MAX_LEVELS / 4];
+    uint32_t numInstances, indexCount, depthW, depthH;
+    uint32_t numLevels, padding[3];
+  };
+  struct DrawArgs {
+    DrawIndexedIndirectCommand command;
+    uint32_t numFrustumCulled, numOcclusionCulled, padding;
+  };
+  struct PyramidLevel {
+    uint32_t w, h, offset;
+  };
+  struct ReducePushConstants {
+    uint32_t srcW, srcH, dstW, dstH, srcOffset, dstOffset;
+  };
+  void createPipelines();
+  void createOutputBuffers(uint32_t maxInstances);
+  void cull(CommandBuffer *commandBuffer, Graphics *graphics, Phase phase);
+  ComputePipeline *cullPipeline, *depthPipeline, *reducePipeline;
+  Buffer *bInstanceModel = nullptr, *bInstanceColor = nullptr;
+  std::vector<PyramidLevel> pyramidLevels;
+  vec4 boundingSphere;
+  vec3 boxMin, boxMax;
+  uint32_t indexCount, depthW, depthH;
+  uint32_t U_UBO = 0, SSBO_INSTANCE_MODEL = 1, SSBO_INSTANCE_COLOR = 2,
+           SSBO_DEPTH_PYRAMID = 3, SSBO_VISIBILITY = 4, SSBO_VISIBLE_MODEL = 5,
+           SSBO_VISIBLE_COLOR = 6, SSBO_DRAW_ARGS = 7;
+  uint32_t DEPTH_TEXTURE = 0, DEPTH_SSBO_DEPTH_PYRAMID = 1;
+  uint32_t REDUCE_SSBO_DEPTH_PYRAMID = 0;
+  static const uint32_t THREADS_PER_GROUP = 64, TILE_SIZE = 8;
+};
+} // namespace ngfx
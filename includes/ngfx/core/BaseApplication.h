@@ -60,6 +60,6 @@ public:
 protected:
   bool initOnce = true;
   std::unique_ptr<ngfx::Texture> outputTexture, depthTexture;
-  std::unique_ptr<Framebuffer> outputFramebuffer;
+  std::shared_ptr<Framebuffer> outputFramebuffer;
 };
 }; // namespace ngfx
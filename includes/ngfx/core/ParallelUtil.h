@@ -0,0 +1,116 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace ngfx {
+class ParallelUtil {
+public:
+  /** Get the number of threads of a parallel loop.
+   *  Smaller inputs are processed by fewer threads
+   *  @param numThreads The number of threads. If 0, the number of hardware
+   *  threads is used
+   *  @param numItems The number of items
+   *  @param minItemsPerThread The minimum number of items per thread
+   */
+  static uint32_t getNumThreads(uint32_t numThreads, size_t numItems,
+                                size_t minItemsPerThread = 16384) {
+    if (numThreads == 0)
+      numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    size_t maxThreads = std::max<size_t>(numItems / minItemsPerThread, 1);
+    return uint32_t(std::min<size_t>(numThreads, maxThreads));
+  }
+  /** Split the items into a contiguous range per thread, and call
+   *  fn(thread, begin, end) for each range.
+   *  The ranges only depend on the number of threads and items */
+  template <typename F>
+  static void parallelFor(uint32_t numThreads, size_t numItems, F fn) {
+    if (numThreads == 1) {
+      fn(0u, size_t(0), numItems);
+      return;
+    }
+    std::vector<std::thread> threads;
+    for (uint32_t j = 0; j < numThreads; j++)
+      threads.emplace_back(fn, j, numItems * j / numThreads,
+                           numItems * (j + 1) / numThreads);
+    for (auto &t : threads)
+      t.join();
+  }
+  /** Call write(thread, item, outIndex) for each item that is kept,
+   *  with the kept items numbered in order
+   *  @return The number of items kept
+   */
+  template <typename K, typename W>
+  static size_t parallelCompact(uint32_t numThreads, size_t numItems, K keep,
+                                W write) {
+    std::vector<size_t> offsets(numThreads + 1, 0);
+    parallelFor(numThreads, numItems,
+                [&](uint32_t thread, size_t begin, size_t end) {
+                  size_t count = 0;
+                  for (size_t j = begin; j < end; j++)
+                    count += keep(j) ? 1 : 0;
+                  offsets[thread + 1] = count;
+                });
+    for (uint32_t j = 0; j < numThreads; j++)
+      offsets[j + 1] += offsets[j];
+    parallelFor(numThreads, numItems,
+                [&](uint32_t thread, size_t begin, size_t end) {
+                  size_t outIndex = offsets[thread];
+                  for (size_t j = begin; j < end; j++) {
+                    if (keep(j))
+                      write(thread, j, outIndex++);
+                  }
+                });
+    return offsets[numThreads];
+  }
+  /** Sort a range per thread, then merge the ranges pairwise */
+  template <typename T>
+  static void parallelSort(std::vector<T> &v, uint32_t numThreads) {
+    std::vector<size_t> bounds(numThreads + 1);
+    for (uint32_t j = 0; j <= numThreads; j++)
+      bounds[j] = v.size() * j / numThreads;
+    parallelFor(numThreads, numThreads,
+                [&](uint32_t, size_t begin, size_t end) {
+                  for (size_t j = begin; j < end; j++)
+                    std::sort(v.begin() + bounds[j], v.begin() + bounds[j + 1]);
+                });
+    for (uint32_t width = 1; width < numThreads; width *= 2) {
+      uint32_t numMerges = (numThreads + 2 * width - 1) / (2 * width);
+      parallelFor(numMerges, numMerges,
+                  [&](uint32_t, size_t begin, size_t end) {
+                    for (size_t j = begin; j < end; j++) {
+                      size_t first = j * 2 * width,
+                             middle =
+                                 std::min<size_t>(first + width, numThreads),
+                             last = std::min<size_t>(first + 2 * width,
+                                                     numThreads);
+                      std::inplace_merge(v.begin() + bounds[first],
+                                         v.begin() + bounds[middle],
+                                         v.begin() + bounds[last]);
+                    }
+                  });
+    }
+  }
+};
+} // namespace ngfx
@@ -0,0 +1,208 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#pragma once
+#include <cstdint>
+#include <cstring>
+#if defined(__SSE__) || defined(_M_X64) ||                                     \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define NGFX_SIMD_SSE
+#include <xmmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define NGFX_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+// On x86, the functions that use AVX2 or AVX-512 are compiled for these
+// instruction sets with NGFX_SIMD_AVX2_TARGET and NGFX_SIMD_AVX512_TARGET,
+// and only called if the CPU supports them
+#if defined(NGFX_SIMD_SSE) && (defined(__GNUC__) || defined(_MSC_VER))
+#define NGFX_SIMD_AVX
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define NGFX_SIMD_AVX2_TARGET
+#define NGFX_SIMD_AVX512_TARGET
+#else
+#define NGFX_SIMD_AVX2_TARGET __attribute__((target("avx2")))
+#define NGFX_SIMD_AVX512_TARGET __attribute__((target("avx512f")))
+#endif
+#endif
+
+/** \class float4
+ *
+ *  A vector of 4 floats, mapped to SSE on x86 and to NEON on ARM64,
+ *  with a scalar fallback.
+ *  The comparisons return a mask with all the bits of a lane set
+ *  if the comparison is true.
+ */
+
+namespace ngfx {
+/** The x86 instruction sets that are detected at runtime */
+enum SIMDInstructionSet { SIMD_AVX2, SIMD_AVX512 };
+
+/** Check if the CPU and the OS support an instruction set */
+inline bool cpuSupports(SIMDInstructionSet instructionSet) {
+#if !defined(NGFX_SIMD_AVX)
+  return false;
+#elif defined(_MSC_VER) && !defined(__clang__)
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] < 7)
+    return false;
+  // The OS must save the AVX registers, and the AVX-512 registers
+  __cpuid(info, 1);
+  if (!(info[2] & (1 << 27)))
+    return false;
+  uint64_t xcr0 = _xgetbv(0),
+           xcr0Mask = (instructionSet == SIMD_AVX512) ? 0xE6 : 0x6;
+  if ((xcr0 & xcr0Mask) != xcr0Mask)
+    return false;
+  __cpuidex(info, 7, 0);
+  return (instructionSet == SIMD_AVX512) ? (info[1] & (1 << 16)) != 0
+                                         : (info[1] & (1 << 5)) != 0;
+#else
+  __builtin_cpu_init();
+  return (instructionSet == SIMD_AVX512) ? __builtin_cpu_supports("avx512f")
+                                         : __builtin_cpu_supports("avx2");
+#endif
+}
+
+struct float4 {
+#if defined(NGFX_SIMD_SSE)
+  __m128 v;
+  float4() {}
+  float4(__m128 v) : v(v) {}
+  explicit float4(float f) : v(_mm_set1_ps(f)) {}
+  static float4 load(const float *p) { return _mm_loadu_ps(p); }
+  void store(float *p) const { _mm_storeu_ps(p, v); }
+  float4 operator+(const float4 &b) const { return _mm_add_ps(v, b.v); }
+  float4 operator-(const float4 &b) const { return _mm_sub_ps(v, b.v); }
+  float4 operator*(const float4 &b) const { return _mm_mul_ps(v, b.v); }
+  float4 operator<=(const float4 &b) const { return _mm_cmple_ps(v, b.v); }
+  float4 operator<(const float4 &b) const { return _mm_cmplt_ps(v, b.v); }
+  float4 operator&(const float4 &b) const { return _mm_and_ps(v, b.v); }
+  float4 operator|(const float4 &b) const { return _mm_or_ps(v, b.v); }
+  static float4 min(const float4 &a, const float4 &b) {
+    return _mm_min_ps(a.v, b.v);
+  }
+  static float4 max(const float4 &a, const float4 &b) {
+    return _mm_max_ps(a.v, b.v);
+  }
+  /** Get a bit per lane, from the sign bits */
+  int movemask() const { return _mm_movemask_ps(v); }
+#elif defined(NGFX_SIMD_NEON)
+  float32x4_t v;
+  float4() {}
+  float4(float32x4_t v) : v(v) {}
+  explicit float4(float f) : v(vdupq_n_f32(f)) {}
+  static float4 load(const float *p) { return vld1q_f32(p); }
+  void store(float *p) const { vst1q_f32(p, v); }
+  float4 operator+(const float4 &b) const { return vaddq_f32(v, b.v); }
+  float4 operator-(const float4 &b) const { return vsubq_f32(v, b.v); }
+  float4 operator*(const float4 &b) const { return vmulq_f32(v, b.v); }
+  float4 operator<=(const float4 &b) const {
+    return vreinterpretq_f32_u32(vcleq_f32(v, b.v));
+  }
+  float4 operator<(const float4 &b) const {
+    return vreinterpretq_f32_u32(vcltq_f32(v, b.v));
+  }
+  float4 operator&(const float4 &b) const {
+    return vreinterpretq_f32_u32(
+        vandq_u32(vreinterpretq_u32_f32(v), vreinterpretq_u32_f32(b.v)));
+  }
+  float4 operator|(const float4 &b) const {
+    return vreinterpretq_f32_u32(
+        vorrq_u32(vreinterpretq_u32_f32(v), vreinterpretq_u32_f32(b.v)));
+  }
+  static float4 min(const float4 &a, const float4 &b) {
+    return vminnmq_f32(a.v, b.v);
+  }
+  static float4 max(const float4 &a, const float4 &b) {
+    return vmaxnmq_f32(a.v, b.v);
+  }
+  int movemask() const {
+    const int32_t shifts[4] = {0, 1, 2, 3};
+    uint32x4_t signBits = vshrq_n_u32(vreinterpretq_u32_f32(v), 31);
+    return int(vaddvq_u32(vshlq_u32(signBits, vld1q_s32(shifts))));
+  }
+#else
+  float v[4];
+  float4() {}
+  explicit float4(float f) : v{f, f, f, f} {}
+  static float4 load(const float *p) {
+    float4 r;
+    memcpy(r.v, p, sizeof(r.v));
+    return r;
+  }
+  void store(float *p) const { memcpy(p, v, sizeof(v)); }
+  template <typename F> float4 map(const float4 &b, F fn) const {
+    float4 r;
+    for (uint32_t j = 0; j < 4; j++)
+      r.v[j] = fn(v[j], b.v[j]);
+    return r;
+  }
+  static float mask(bool b) {
+    uint32_t bits = b ? 0xFFFFFFFF : 0;
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+  }
+  static uint32_t bits(float f) {
+    uint32_t b;
+    memcpy(&b, &f, sizeof(b));
+    return b;
+  }
+  float4 operator+(const float4 &b) const {
+    return map(b, [](float x, float y) { return x + y; });
+  }
+  float4 operator-(const float4 &b) const {
+    return map(b, [](float x, float y) { return x - y; });
+  }
+  float4 operator*(const float4 &b) const {
+    return map(b, [](float x, float y) { return x * y; });
+  }
+  float4 operator<=(const float4 &b) const {
+    return map(b, [](float x, float y) { return mask(x <= y); });
+  }
+  float4 operator<(const float4 &b) const {
+    return map(b, [](float x, float y) { return mask(x < y); });
+  }
+  float4 operator&(const float4 &b) const {
+    return map(b, [](float x, float y) { return mask(bits(x) & bits(y)); });
+  }
+  float4 operator|(const float4 &b) const {
+    return map(b, [](float x, float y) { return mask(bits(x) | bits(y)); });
+  }
+  static float4 min(const float4 &a, const float4 &b) {
+    return a.map(b, [](float x, float y) { return y < x ? y : x; });
+  }
+  static float4 max(const float4 &a, const float4 &b) {
+    return a.map(b, [](float x, float y) { return y > x ? y : x; });
+  }
+  int movemask() const {
+    int m = 0;
+    for (uint32_t j = 0; j < 4; j++)
+      m |= int(bits(v[j]) >> 31) << j;
+    return m;
+  }
+#endif
+};
+} // namespace ngfx
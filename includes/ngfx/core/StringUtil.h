@@ -27,5 +27,7 @@ class StringUtil {
 public:
   static std::string toLower(const std::string &str);
   static std::wstring toWString(const std::string &str);
+  /** Escape a string for a JSON string literal */
+  static std::string escapeJSON(const std::string &str);
 };
 } // namespace ngfx
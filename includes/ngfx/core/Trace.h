@@ -0,0 +1,90 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/** \class Trace
+ *
+ *  A low-overhead CPU tracer.
+ *  Each thread records its events to its own ring buffer, without locking.
+ *  When a buffer is full, the oldest events are overwritten.
+ *  The events can be saved in the Chrome trace event format, and viewed
+ *  with chrome://tracing or Perfetto.
+ *  Code is instrumented with the NGFX_TRACE_SCOPE macro, which is removed at
+ *  compile time unless NGFX_ENABLE_TRACE is defined.
+ */
+
+namespace ngfx {
+class Trace {
+public:
+  /** A trace event. The name must be a string literal (or outlive the
+   *  trace), timestamps are in nanoseconds */
+  struct Event {
+    const char *name;
+    uint64_t start, end;
+  };
+  /** The number of events in each thread's ring buffer (power of 2) */
+  static constexpr uint32_t BUFFER_SIZE = 1 << 16;
+  /** Get the current time, in nanoseconds */
+  static inline uint64_t now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+  /** Record an event to the calling thread's buffer */
+  static void addEvent(const char *name, uint64_t start, uint64_t end);
+  /** Set the name of the calling thread in the trace */
+  static void setThreadName(const std::string &name);
+  /** Discard the recorded events */
+  static void clear();
+  /** Save the recorded events to a Chrome trace file (JSON).
+   *  At most BUFFER_SIZE - 1 events are saved per thread, the slot of the
+   *  next event may be in the middle of being written.
+   *  Events that are overwritten while the file is written are skipped.
+   *  @param filename The output filename
+   */
+  static void dump(const std::string &filename);
+};
+
+/** Records a trace event for the lifetime of the object */
+class TraceScope {
+public:
+  TraceScope(const char *name) : name(name), start(Trace::now()) {}
+  ~TraceScope() { Trace::addEvent(name, start, Trace::now()); }
+
+private:
+  const char *name;
+  uint64_t start;
+};
+} // namespace ngfx
+
+#define NGFX_TRACE_CONCAT_(a, b) a##b
+#define NGFX_TRACE_CONCAT(a, b) NGFX_TRACE_CONCAT_(a, b)
+#ifdef NGFX_ENABLE_TRACE
+#define NGFX_TRACE_SCOPE(name)                                                 \
+  ngfx::TraceScope NGFX_TRACE_CONCAT(traceScope, __LINE__)(name)
+#else
+#define NGFX_TRACE_SCOPE(name)
+#endif
@@ -20,6 +20,7 @@
  */
 #pragma once
 #include <algorithm>
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -30,5 +31,9 @@ public:
     return (std::find(v.begin(), v.end(), item) != v.end());
   }
   static uint64_t hash(const std::string &s);
+  /** Combine a value into a hash seed */
+  static void hashCombine(uint64_t &seed, uint64_t value) {
+    seed ^= value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+  }
 };
 } // namespace ngfx
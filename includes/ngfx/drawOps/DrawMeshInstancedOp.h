@@ -0,0 +1,98 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#pragma once
+#include "ngfx/drawOps/DrawMeshOp.h"
+#include "ngfx/graphics/Buffer.h"
+#include "ngfx/graphics/DrawOp.h"
+#include "ngfx/graphics/GraphicsPipeline.h"
+#include "ngfx/graphics/MeshData.h"
+#include <memory>
+#include <vector>
+
+/** \class DrawMeshInstancedOp
+ *
+ *  Draw many copies of a mesh with a single instanced draw call.
+ *  Each instance has its own model matrix and color, stored in
+ *  instance-rate vertex buffers that are updated in bulk, so the cost
+ *  of an instance is 80 bytes of vertex data instead of a draw operation,
+ *  a uniform buffer upload and a draw call.
+ *  The model matrices are assumed to have a uniform scale.
+ */
+
+namespace ngfx {
+class DrawMeshInstancedOp : public DrawOp {
+public:
+  typedef DrawMeshOp::LightData LightData;
+  /** Create the draw operation
+   *  @param ctx The graphics context
+   *  @param meshData The mesh data
+   *  @param maxInstances The initial capacity of the instance buffers
+   */
+  DrawMeshInstancedOp(GraphicsContext *ctx, MeshData &meshData,
+                      uint32_t maxInstances = 1);
+  virtual ~DrawMeshInstancedOp() {}
+  void draw(CommandBuffer *commandBuffer, Graphics *graphics) override;
+  /** Draw the instances with an indexed indirect draw, e.g. the visible
+   *  instances written by FrustumCullOp
+   *  @param drawArgs A DrawIndexedIndirectCommand
+   *  @param instanceModel The model matrix of each instance
+   *  @param instanceColor The color of each instance
+   */
+  void drawIndirect(CommandBuffer *commandBuffer, Graphics *graphics,
+                    Buffer *drawArgs, Buffer *instanceModel,
+                    Buffer *instanceColor);
+  /** Update the view and light parameters shared by all the instances */
+  virtual void update(mat4 &view, mat4 &proj, LightData &lightData);
+  /** Update the instances.
+   *  The instance buffers are reallocated if the number of instances
+   *  exceeds their capacity.
+   *  Like the uniform buffers, they must not be updated while a frame
+   *  that uses them is in flight.
+   *  @param modelMats The model matrix of each instance
+   *  @param colors The color of each instance
+   */
+  virtual void updateInstances(const std::vector<mat4> &modelMats,
+                               const std::vector<vec4> &colors);
+  std::unique_ptr<Buffer> bPos, bNormals;
+  std::unique_ptr<Buffer> bFaces;
+  std::unique_ptr<Buffer> bInstanceModel, bInstanceColor;
+  std::unique_ptr<Buffer> bUboVS, bUboFS;
+  uint32_t numInstances = 0, maxInstances = 0;
+
+protected:
+  struct UBO_VS_Data {
+    mat4 view;
+    mat4 proj;
+  };
+  struct UBO_FS_Data {
+    LightData light0;
+  };
+  virtual void createPipeline();
+  void createInstanceBuffers(uint32_t maxInstances);
+  void bindBuffers(CommandBuffer *commandBuffer, Graphics *graphics,
+                   Buffer *instanceModel, Buffer *instanceColor);
+  GraphicsPipeline *graphicsPipeline;
+  uint32_t B_POS, B_NORMALS, B_INSTANCE_MODEL, B_INSTANCE_COLOR;
+  uint32_t U_UBO_VS, U_UBO_FS;
+  uint32_t numFaces;
+  IndexFormat indexFormat;
+};
+} // namespace ngfx
@@ -28,9 +28,40 @@
 namespace ngfx {
 class DrawMeshOp : public DrawOp {
 public:
-  DrawMeshOp(GraphicsContext *ctx, MeshData &meshData);
+  /** Draw a mesh
+   *  @param ctx The graphics context
+   *  @param meshData The mesh data
+   *  @param interleaved Pack the positions and the normals in a single
+   *  vertex buffer. Ignored if the mesh doesn't have one normal per vertex
+   */
+  DrawMeshOp(GraphicsContext *ctx, MeshData &meshData,
+             bool interleaved = true);
+  /** Draw a quantized mesh.
+   *  The packed vertex attributes are fetched as is and decoded in the
+   *  vertex shader, with a pipeline variant for each encoding.
+   *  @param ctx The graphics context
+   *  @param meshData The quantized mesh data
+   *  @param interleaved Pack the vertex attributes in a single buffer
+   */
+  DrawMeshOp(GraphicsContext *ctx, QuantizedMeshData &meshData,
+             bool interleaved = true);
+  /** Draw a mesh read in place.
+   *  The vertex buffers are created from the views without repacking.
+   *  Interleaved attributes are uploaded as a single vertex buffer, the
+   *  separate attributes are only repacked if they are strided.
+   *  @param ctx The graphics context
+   *  @param meshView The mesh view. The mesh must have normals
+   */
+  DrawMeshOp(GraphicsContext *ctx, const MeshView &meshView);
   virtual ~DrawMeshOp() {}
   void draw(CommandBuffer *commandBuffer, Graphics *graphics) override;
+  /** Draw the mesh with an indexed indirect draw, e.g. the visible
+   *  meshlets written by ClusterCullOp
+   *  @param indices A 32-bit index buffer
+   *  @param drawArgs A DrawIndexedIndirectCommand
+   */
+  void drawIndirect(CommandBuffer *commandBuffer, Graphics *graphics,
+                    Buffer *indices, Buffer *drawArgs);
   struct LightData {
     vec4 ambient = vec4(0.2f, 0.2f, 0.2f, 1.0f);
     vec4 diffuse = vec4(1.0f);
@@ -40,7 +71,28 @@ public:
   };
   virtual void update(mat4 &modelView, mat4 &modelViewInverseTranspose,
                       mat4 &modelViewProj, LightData &lightData);
+  /** Select the coarsest level of detail whose projected geometric error
+   *  is below a threshold.
+   *  The error is projected at the point of the mesh bounding sphere that
+   *  is closest to the camera.
+   *  @param modelView The model view matrix
+   *  @param proj The projection matrix
+   *  @param viewportHeight The viewport height (in pixels)
+   *  @param maxPixelError The maximum screen space error (in pixels)
+   *  @return The selected level of detail
+   */
+  uint32_t selectLOD(const mat4 &modelView, const mat4 &proj,
+                     float viewportHeight, float maxPixelError = 1.0f);
+  /** Get the number of levels of detail */
+  uint32_t numLODs() const { return uint32_t(lods.size()); }
+  /** Get the number of faces of a level of detail */
+  uint32_t numLODFaces(uint32_t j) const { return lods[j].numFaces; }
+  /** The level of detail that is drawn */
+  uint32_t lod = 0;
+  /** The vertex attributes, in separate buffers */
   std::unique_ptr<Buffer> bPos, bNormals;
+  /** The interleaved vertex attributes */
+  std::unique_ptr<Buffer> bVertices;
   std::unique_ptr<Buffer> bFaces;
   std::unique_ptr<Buffer> bUboVS, bUboFS;
 
@@ -49,14 +101,35 @@ protected:
     mat4 modelView;
     mat4 modelViewInverseTranspose;
     mat4 modelViewProj;
+    int32_t normalDecode = 0, padding[3];
   };
   struct UBO_FS_Data {
     LightData light0;
   };
   virtual void createPipeline();
+  void bindBuffers(CommandBuffer *commandBuffer, Graphics *graphics,
+                   Buffer *indices, IndexFormat indexFormat);
   GraphicsPipeline *graphicsPipeline;
   uint32_t B_POS, B_NORMALS, U_UBO_VS, U_UBO_FS;
   uint32_t numVerts, numNormals;
   uint32_t numFaces;
+  /** The levels of detail. A mesh without levels of detail
+   *  has a single level with all the faces */
+  std::vector<MeshLOD> lods;
+  /** The bounding sphere, in model space */
+  vec3 boundsCenter = vec3(0.0f);
+  float boundsRadius = 0.0f;
+  void initLODs(const std::vector<MeshLOD> &meshLODs, const vec3 &boundsMin,
+                const vec3 &boundsMax);
+  IndexFormat indexFormat = INDEXFORMAT_UINT32;
+  bool quantized = false;
+  PositionEncoding posEncoding = POSITION_ENCODING_FLOAT3;
+  NormalEncoding normalEncoding = NORMAL_ENCODING_FLOAT3;
+  uint32_t posStride = sizeof(vec3), normalStride = sizeof(vec3);
+  bool interleaved = false;
+  /** The size of an interleaved vertex, and the offset of the normal */
+  uint32_t vertexStride = 0, normalOffset = sizeof(vec3);
+  /** Maps the quantized positions to the model space */
+  mat4 dequantizeMat = mat4(1.0f);
 };
 } // namespace ngfx
@@ -0,0 +1,59 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#pragma once
+#include "ngfx/graphics/Buffer.h"
+#include "ngfx/graphics/DrawOp.h"
+#include <map>
+#include <memory>
+
+/** \class DrawTexturesOp
+ *
+ *  Draw a batch of textured rectangles with a single instanced draw call.
+ *  The textures are added to the bindless descriptor heap, and each
+ *  instance selects its texture by index, so the number of descriptor
+ *  binds doesn't depend on the number of textures.
+ *  This requires a device that supports descriptor indexing.
+ */
+
+namespace ngfx {
+class DrawTexturesOp : public DrawOp {
+public:
+  /** Create the draw operation
+   *  @param ctx The graphics context
+   *  @param textures The texture of each rectangle
+   *  @param rects The rectangles (x, y, w, h), in normalized device
+   *  coordinates
+   */
+  DrawTexturesOp(GraphicsContext *ctx, const std::vector<Texture *> &textures,
+                 const std::vector<glm::vec4> &rects);
+  virtual ~DrawTexturesOp();
+  void draw(CommandBuffer *commandBuffer, Graphics *graphics) override;
+  std::unique_ptr<Buffer> bPos, bTexCoord, bRect, bTextureIndex;
+
+protected:
+  virtual void createPipeline();
+  GraphicsPipeline *graphicsPipeline;
+  /** The index of each texture in the bindless heap */
+  std::map<Texture *, uint32_t> textureIndices;
+  uint32_t numInstances;
+  uint32_t B_POS, B_TEXCOORD, B_RECT, B_TEXTURE_INDEX, U_TEXTURES;
+};
+} // namespace ngfx
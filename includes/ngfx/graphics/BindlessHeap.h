@@ -0,0 +1,89 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#pragma once
+#include "ngfx/graphics/Buffer.h"
+#include "ngfx/graphics/CommandBuffer.h"
+#include "ngfx/graphics/Graphics.h"
+#include "ngfx/graphics/Texture.h"
+
+/** \class BindlessHeap
+ *
+ *  A global heap of descriptor arrays: one array of sampled textures,
+ *  one array of storage images and one array of storage buffers.
+ *  Resources are added once, and shaders address them by index,
+ *  e.g. with per-instance data, so draws that use different textures
+ *  don't need to bind a descriptor set each.
+ *
+ *  A shader declares an array as an unsized array, with its own binding:
+ *
+ *      #extension GL_EXT_nonuniform_qualifier : require
+ *      layout(set = 0, binding = 0) uniform sampler2D textures[];
+ *      ...
+ *      texture(textures[nonuniformEXT(index)], texCoord);
+ *
+ *  and the application binds the array with bind() after binding the
+ *  pipeline.
+ *  The heap is only available if the device supports descriptor
+ *  indexing, see GraphicsContext::bindlessHeap.
+ */
+
+namespace ngfx {
+class BindlessHeap {
+public:
+  virtual ~BindlessHeap() {}
+  /** Add a sampled texture.
+   *  The texture must be in IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL when it's
+   *  sampled.
+   *  @param texture The texture
+   *  @return The index of the texture in the texture array
+   */
+  virtual uint32_t addTexture(Texture *texture) = 0;
+  /** Add a storage image.
+   *  The texture must be in IMAGE_LAYOUT_GENERAL when it's accessed.
+   *  @param texture The texture
+   *  @return The index of the image in the storage image array
+   */
+  virtual uint32_t addStorageImage(Texture *texture) = 0;
+  /** Add a storage buffer
+   *  @param buffer The buffer
+   *  @return The index of the buffer in the storage buffer array
+   */
+  virtual uint32_t addStorageBuffer(Buffer *buffer) = 0;
+  /** Remove a resource from the heap.
+   *  The index is only reused once the submissions that may still
+   *  access it have completed.
+   *  @param type The descriptor type of the array
+   *  @param index The index of the resource
+   */
+  virtual void remove(DescriptorType type, uint32_t index) = 0;
+  /** Bind an array to the current pipeline
+   *  @param commandBuffer The command buffer
+   *  @param graphics The graphics interface
+   *  @param type The descriptor type of the array
+   *  @param set The descriptor set index
+   */
+  virtual void bind(CommandBuffer *commandBuffer, Graphics *graphics,
+                    DescriptorType type, uint32_t set) = 0;
+  /** Get the maximum number of resources in an array.
+   *  It's 0 if the device doesn't support the array */
+  virtual uint32_t capacity(DescriptorType type) = 0;
+};
+} // namespace ngfx
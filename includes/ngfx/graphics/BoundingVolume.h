@@ -0,0 +1,106 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#pragma once
+#include <cfloat>
+#include <glm/glm.hpp>
+#include <vector>
+using namespace glm;
+
+namespace ngfx {
+/** An axis aligned bounding box */
+struct BoundingBox {
+  BoundingBox() {}
+  BoundingBox(const vec3 &min, const vec3 &max) : min(min), max(max) {}
+  /** Get the bounding box of the box transformed by a matrix */
+  BoundingBox transform(const mat4 &m) const {
+    vec3 center = (min + max) * 0.5f, extent = (max - min) * 0.5f;
+    vec3 c = vec3(m * vec4(center, 1.0f)), e;
+    for (int j = 0; j < 3; j++)
+      e[j] = abs(m[0][j]) * extent.x + abs(m[1][j]) * extent.y +
+             abs(m[2][j]) * extent.z;
+    return BoundingBox(c - e, c + e);
+  }
+  vec3 min = vec3(FLT_MAX), max = vec3(-FLT_MAX);
+};
+
+/** A bounding sphere */
+struct BoundingSphere {
+  BoundingSphere() {}
+  BoundingSphere(const vec3 &center, float radius)
+      : center(center), radius(radius) {}
+  /** Create the sphere that bounds a box */
+  explicit BoundingSphere(const BoundingBox &box)
+      : center((box.min + box.max) * 0.5f),
+        radius(length(box.max - box.min) * 0.5f) {}
+  vec3 center = vec3(0.0f);
+  float radius = 0.0f;
+};
+
+/** An array of bounding spheres, stored per component so that
+ *  several spheres are tested at a time */
+struct BoundingSphereArray {
+  void push_back(const BoundingSphere &sphere) {
+    centerX.push_back(sphere.center.x);
+    centerY.push_back(sphere.center.y);
+    centerZ.push_back(sphere.center.z);
+    radius.push_back(sphere.radius);
+  }
+  BoundingSphere operator[](size_t j) const {
+    return BoundingSphere(vec3(centerX[j], centerY[j], centerZ[j]),
+                          radius[j]);
+  }
+  void clear() {
+    centerX.clear();
+    centerY.clear();
+    centerZ.clear();
+    radius.clear();
+  }
+  size_t size() const { return radius.size(); }
+  std::vector<float> centerX, centerY, centerZ, radius;
+};
+
+/** An array of bounding boxes, stored per component so that
+ *  several boxes are tested at a time */
+struct BoundingBoxArray {
+  void push_back(const BoundingBox &box) {
+    minX.push_back(box.min.x);
+    minY.push_back(box.min.y);
+    minZ.push_back(box.min.z);
+    maxX.push_back(box.max.x);
+    maxY.push_back(box.max.y);
+    maxZ.push_back(box.max.z);
+  }
+  BoundingBox operator[](size_t j) const {
+    return BoundingBox(vec3(minX[j], minY[j], minZ[j]),
+                       vec3(maxX[j], maxY[j], maxZ[j]));
+  }
+  void clear() {
+    minX.clear();
+    minY.clear();
+    minZ.clear();
+    maxX.clear();
+    maxY.clear();
+    maxZ.clear();
+  }
+  size_t size() const { return minX.size(); }
+  std::vector<float> minX, minY, minZ, maxX, maxY, maxZ;
+};
+} // namespace ngfx
@@ -20,6 +20,7 @@
  */
 #pragma once
 #include "ngfx/graphics/Buffer.h"
+#include <glm/glm.hpp>
 
 /** \class BufferUtil
  * 
@@ -68,6 +69,30 @@ namespace ngfx {
                                           uint32_t stride = sizeof(uint32_t)) {
     return createIndexBuffer(ctx, v.data(), uint32_t(v.size() * sizeof(v[0])));
   }
+  /** Create an index buffer from a list of triangles.
+   *  The indices are 16-bit if there are at most 65536 vertices
+   *  @param ctx The graphics context
+   *  @param faces The triangles
+   *  @param numVerts The number of vertices
+   *  @param indexFormat The index format of the buffer
+   */
+  static Buffer *createIndexBuffer(GraphicsContext *ctx,
+                                   const std::vector<glm::ivec3> &faces,
+                                   uint32_t numVerts,
+                                   IndexFormat &indexFormat) {
+    if (numVerts > 65536) {
+      indexFormat = INDEXFORMAT_UINT32;
+      return createIndexBuffer(ctx, faces.data(),
+                               uint32_t(faces.size() * sizeof(faces[0])));
+    }
+    std::vector<uint16_t> indices(faces.size() * 3);
+    for (uint32_t j = 0; j < indices.size(); j++)
+      indices[j] = uint16_t(faces[j / 3][j % 3]);
+    indexFormat = INDEXFORMAT_UINT16;
+    return createIndexBuffer(ctx, indices.data(),
+                             uint32_t(indices.size() * sizeof(indices[0])),
+                             sizeof(indices[0]));
+  }
   /** Create a uniform buffer
    *  @param ctx The graphics context
    *  @param data The buffer data
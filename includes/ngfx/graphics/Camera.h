@@ -19,6 +19,7 @@
  * under the License.
  */
 #pragma once
+#include "ngfx/graphics/Frustum.h"
 #include "ngfx/input/InputListener.h"
 #include <glm/glm.hpp>
 using namespace glm;
@@ -57,6 +58,12 @@ public:
    *  This function is called once per frame
    */
   void update();
+  /** Get the view frustum, for culling
+   *  @param projMat The projection matrix
+   */
+  Frustum getFrustum(const mat4 &projMat) const {
+    return Frustum(projMat * viewMat);
+  }
   float panX = 0.0f, /**< The camera pan along the x axis */
         panY = 0.0f, /**< The camera pan along the y axis */ 
         zoom = 0.0f, /**< The camera zoom */
@@ -32,6 +32,7 @@
 
 namespace ngfx {
 class GraphicsContext;
+class Queue;
 class CommandBuffer {
 public:
   /** Create the command buffer
@@ -47,5 +48,10 @@ public:
   virtual void begin() = 0;
   /** End recording */
   virtual void end() = 0;
+  /** The ticket of the last submission of this command buffer.
+   *  See Queue::lastTicket */
+  uint64_t ticket = 0;
+  /** The queue of the last submission, that the ticket belongs to */
+  Queue *queue = nullptr;
 };
 }; // namespace ngfx
@@ -26,7 +26,8 @@
  * 
  *  This is the base class for filter operations.
  *  A filter can output to a texture or to a framebuffer.
- *  TODO: support chained filters.
+ *  Chains of filters can be scheduled with a FrameGraph, which manages
+ *  the intermediate textures.
  */
  
 namespace ngfx {
@@ -40,6 +41,11 @@ public:
    */
   FilterOp(GraphicsContext *ctx, Graphics *graphics, uint32_t dstWidth,
            uint32_t dstHeight);
+  /** Create a filter operation without an output texture.
+   *  This is used when the output is managed by a FrameGraph.
+   *  @param ctx The graphics context
+   */
+  FilterOp(GraphicsContext *ctx) : DrawOp(ctx) {}
   /** Destroy the filter operation */
   virtual ~FilterOp() {}
   /** Apply the filter
@@ -49,9 +55,13 @@ public:
    */
   void apply(GraphicsContext *ctx, CommandBuffer *commandBuffer,
              Graphics *graphics);
+  /** The input textures.
+   *  When the filter is part of a FrameGraph, they're set by the graph
+   *  before the filter is drawn. */
+  std::vector<Texture *> inputTextures;
   /** The output texture */
   std::unique_ptr<Texture> outputTexture;
-  /** The output framebuffer */
-  std::unique_ptr<Framebuffer> outputFramebuffer;
+  /** The output framebuffer, shared through the framebuffer cache */
+  std::shared_ptr<Framebuffer> outputFramebuffer;
 };
 }; // namespace ngfx
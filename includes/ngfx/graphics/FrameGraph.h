@@ -0,0 +1,161 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#pragma once
+#include "ngfx/graphics/FilterOp.h"
+#include "ngfx/graphics/Framebuffer.h"
+#include "ngfx/graphics/GraphicsContext.h"
+#include "ngfx/graphics/Texture.h"
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+/** \class FrameGraph
+ *
+ *  A frame graph records a set of passes together with the textures
+ *  that each pass reads and writes.
+ *  When the graph is compiled, passes that don't contribute to an
+ *  imported texture are culled, the remaining passes are sorted by their
+ *  dependencies, and transient textures whose lifetimes don't overlap
+ *  share the same physical texture (e.g. a chain of filters only needs
+ *  two ping-pong targets).
+ *  When the graph is executed, the layout transitions between passes are
+ *  recorded automatically.
+ */
+
+namespace ngfx {
+class FrameGraph {
+public:
+  typedef uint32_t ResourceHandle;
+  /** The pass execute callback.
+   *  It's called inside the pass's render pass */
+  typedef std::function<void(CommandBuffer *commandBuffer, Graphics *graphics)>
+      ExecuteFn;
+  /** The description of a transient texture */
+  struct TextureDescription {
+    bool operator==(const TextureDescription &rhs) const {
+      return rhs.w == w && rhs.h == h && rhs.format == format;
+    }
+    uint32_t w = 0, h = 0;
+    PixelFormat format = PIXELFORMAT_RGBA8_UNORM;
+  };
+  /** Create a frame graph
+   *  @param ctx The graphics context
+   *  @param graphics The graphics interface
+   */
+  FrameGraph(GraphicsContext *ctx, Graphics *graphics)
+      : ctx(ctx), graphics(graphics) {}
+  /** Destroy the frame graph */
+  virtual ~FrameGraph() {}
+  /** Declare a transient texture.
+   *  The physical texture is allocated by the graph when it's compiled,
+   *  and may be shared with other transient textures.
+   *  @param name The texture name
+   *  @param desc The texture description
+   */
+  ResourceHandle createTexture(const std::string &name,
+                               const TextureDescription &desc);
+  /** Import an external texture.
+   *  Imported textures are never aliased, and the passes that write
+   *  to them are never culled.
+   *  @param name The texture name
+   *  @param texture The texture
+   *  @param framebuffer The framebuffer used to render to the texture.
+   *  If not set, the framebuffer is created by the graph.
+   *  The render pass is derived from the framebuffer attachments: the
+   *  attachments with the depth stencil usage are the depth attachment,
+   *  the others are color attachments (resolve attachments aren't
+   *  supported)
+   */
+  ResourceHandle importTexture(const std::string &name, Texture *texture,
+                               Framebuffer *framebuffer = nullptr);
+  /** Add a pass
+   *  @param name The pass name
+   *  @param inputs The textures read by the pass
+   *  @param output The texture written by the pass
+   *  @param execute The function that records the draw commands
+   */
+  void addPass(const std::string &name,
+               const std::vector<ResourceHandle> &inputs,
+               ResourceHandle output, ExecuteFn execute);
+  /** Add a filter pass.
+   *  The graph sets the filter's inputTextures to the physical textures of
+   *  the inputs before the filter is drawn.
+   *  @param filterOp The filter operation
+   *  @param inputs The textures read by the filter
+   *  @param output The texture written by the filter
+   */
+  void addFilterPass(FilterOp *filterOp,
+                     const std::vector<ResourceHandle> &inputs,
+                     ResourceHandle output);
+  /** Cull and sort the passes, and allocate the transient textures */
+  void compile();
+  /** Record the passes to the command buffer.
+   *  The graph is compiled first if needed.
+   *  @param commandBuffer The command buffer
+   */
+  void execute(CommandBuffer *commandBuffer);
+  /** Get the physical texture of a resource. Only valid after compile */
+  Texture *getTexture(ResourceHandle handle);
+  /** Get the number of physical textures allocated by the graph */
+  uint32_t numPhysicalTextures() const {
+    return uint32_t(physicalTextures.size());
+  }
+  /** Get the number of passes that are executed after culling */
+  uint32_t numActivePasses() const { return uint32_t(passOrder.size()); }
+
+protected:
+  struct PhysicalTexture {
+    TextureDescription desc;
+    std::unique_ptr<Texture> texture;
+    std::shared_ptr<Framebuffer> framebuffer;
+  };
+  struct Resource {
+    std::string name;
+    TextureDescription desc;
+    bool imported = false;
+    Texture *texture = nullptr;
+    Framebuffer *framebuffer = nullptr;
+    RenderPass *renderPass = nullptr;
+    std::shared_ptr<Framebuffer> importedFramebuffer;
+    int32_t writer = -1, firstUse = -1, lastUse = -1;
+  };
+  struct Pass {
+    std::string name;
+    std::vector<ResourceHandle> inputs;
+    ResourceHandle output;
+    ExecuteFn execute;
+  };
+  RenderPass *getRenderPass(PixelFormat format);
+  RenderPass *
+  getRenderPass(const std::vector<Framebuffer::Attachment> &attachments);
+  void cullPasses(std::vector<bool> &activePasses);
+  void sortPasses(const std::vector<bool> &activePasses);
+  void allocateTextures();
+  GraphicsContext *ctx;
+  Graphics *graphics;
+  std::vector<std::unique_ptr<Resource>> resources;
+  std::vector<Pass> passes;
+  std::vector<uint32_t> passOrder;
+  std::vector<std::unique_ptr<PhysicalTexture>> physicalTextures;
+  bool compiled = false;
+};
+} // namespace ngfx
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#pragma once
+#include "ngfx/graphics/BoundingVolume.h"
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+using namespace glm;
+
+/** \class Frustum
+ *
+ *  The view frustum, as 6 planes extracted from a view projection matrix,
+ *  and the culling of bounding volumes against it.
+ *  The arrays of bounding volumes are tested with the widest SIMD
+ *  instructions supported by the CPU: 16 volumes at a time with AVX-512,
+ *  8 with AVX2, and 4 with SSE or NEON. The visible volumes are
+ *  compacted into a list of indices.
+ *  A volume is culled if it's entirely outside one of the planes, so a few
+ *  volumes near the corners of the frustum are visible but outside it.
+ */
+
+namespace ngfx {
+class Frustum {
+public:
+  Frustum() {}
+  /** Extract the frustum planes from the rows of a view projection
+   *  matrix. The near plane assumes a -1 to 1 depth range, which is
+   *  conservative for a 0 to 1 depth range.
+   *  With a model view projection matrix, the planes are in model space
+   *  @param viewProjMat The view projection matrix
+   */
+  explicit Frustum(const mat4 &viewProjMat);
+  /** Test if a sphere is inside or intersects the frustum */
+  bool intersects(const BoundingSphere &sphere) const;
+  /** Test if a box is inside or intersects the frustum */
+  bool intersects(const BoundingBox &box) const;
+  /** Cull an array of spheres
+   *  @param spheres The spheres
+   *  @param visible The indices of the visible spheres, in increasing order
+   *  @param simdWidth The number of spheres tested at a time: 1, 4, 8 or
+   *  16. If 0, the widest width supported by the CPU is used
+   *  @return The number of visible spheres
+   */
+  uint32_t cull(const BoundingSphereArray &spheres,
+                std::vector<uint32_t> &visible, uint32_t simdWidth = 0) const;
+  /** Cull an array of boxes
+   *  @param boxes The boxes
+   *  @param visible The indices of the visible boxes, in increasing order
+   *  @param simdWidth The number of boxes tested at a time: 1, 4, 8 or 16.
+   *  If 0, the widest width supported by the CPU is used
+   *  @return The number of visible boxes
+   */
+  uint32_t cull(const BoundingBoxArray &boxes, std::vector<uint32_t> &visible,
+                uint32_t simdWidth = 0) const;
+  /** Get the widest SIMD width supported by the CPU */
+  static uint32_t getMaxSIMDWidth();
+  /** Test if a SIMD width is supported by the CPU */
+  static bool isSIMDWidthSupported(uint32_t simdWidth);
+  /** The planes: the normal, pointing inside, and the distance to the
+   *  origin. The normals are normalized */
+  vec4 planes[6];
+};
+} // namespace ngfx
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#pragma once
+#include "ngfx/core/MappedFile.h"
+#include "ngfx/graphics/MeshData.h"
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+using namespace glm;
+
+/** \class GLBScene
+ *
+ *  Import the meshes of a binary glTF file (.glb).
+ *  The file is memory mapped, and the vertex attributes and the indices of
+ *  a primitive are read in place when their layout matches DrawMeshOp:
+ *  32-bit float positions and normals, interleaved or not, and the 16 or
+ *  32-bit indices of a triangle list.
+ *  The other primitives are repacked: 8-bit indices, triangle strips and
+ *  fans, primitives without indices, quantized attributes, and missing
+ *  normals, which are generated.
+ *  The primitives are loaded in parallel.
+ */
+
+namespace ngfx {
+class GLBScene {
+public:
+  /** A primitive of a mesh, with triangles */
+  struct Primitive {
+    /** The index of the mesh */
+    uint32_t mesh = 0;
+    /** The view of the attributes and the indices, in the file mapping
+     *  or in the repacked data */
+    MeshView view;
+    /** The repacked data. Empty if the data is read in place */
+    std::vector<uint8_t> pos, normal, indices;
+  };
+  struct Mesh {
+    std::string name;
+    uint32_t firstPrimitive = 0, numPrimitives = 0;
+  };
+  /** A mesh placed in the scene by a node */
+  struct Instance {
+    uint32_t mesh = 0;
+    /** The node to world transform */
+    mat4 transform = mat4(1.0f);
+  };
+  /** Load a .glb file.
+   *  The point and line primitives are skipped
+   *  @param file The file
+   *  @param numThreads The number of threads. If 0, the number of hardware
+   *  threads is used
+   */
+  void load(const std::string &file, uint32_t numThreads = 0);
+  /** Copy a primitive to a mesh, e.g. for the mesh processing passes */
+  void getMeshData(uint32_t primitive, MeshData &meshData) const;
+  std::vector<Primitive> primitives;
+  std::vector<Mesh> meshes;
+  /** The instances of the meshes in the default scene */
+  std::vector<Instance> instances;
+
+protected:
+  MappedFile mappedFile;
+};
+} // namespace ngfx
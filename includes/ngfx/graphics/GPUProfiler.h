@@ -0,0 +1,159 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#pragma once
+#include "ngfx/graphics/CommandBuffer.h"
+#include "ngfx/graphics/Graphics.h"
+#include "ngfx/graphics/GraphicsContext.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/** \class GPUProfiler
+ *
+ *  A hierarchical GPU profiler.
+ *  Each named region writes a pair of timestamp queries to the command buffer.
+ *  Regions can be nested, e.g. a filter pass inside a frame.
+ *  Each frame uses its own set of queries, from a ring of numFrames sets,
+ *  and the results of a frame are read back without stalling when its set is
+ *  reused, numFrames frames later.
+ *  If the results of the closed regions aren't available yet at that point,
+ *  the frame is dropped. Regions that are still open at the end of the
+ *  frame are ignored.
+ *  The timestamps wrap around after timestampValidBits bits. They are
+ *  unwrapped relative to the first timestamp of each frame, so the frames
+ *  must be resolved before the timestamps wrap around more than once.
+ *  The resolved regions can be exported to the Chrome trace event format,
+ *  and viewed with chrome://tracing or Perfetto.
+ */
+
+namespace ngfx {
+class GPUProfiler {
+public:
+  /** A resolved region. Times are in milliseconds */
+  struct Region {
+    std::string name;
+    uint32_t depth;
+    uint64_t frame;
+    double start, duration;
+  };
+  /** Create the GPU profiler
+   *  @param ctx The graphics context
+   *  @param numFrames The number of frames in flight before the results of
+   *  a frame are read back
+   *  @param maxRegions The maximum number of regions per frame
+   */
+  static GPUProfiler *create(GraphicsContext *ctx, uint32_t numFrames = 4,
+                             uint32_t maxRegions = 256);
+  /** Destroy the GPU profiler */
+  virtual ~GPUProfiler() {}
+  /** Begin a new frame.
+   *  This resolves the oldest frame in the ring and resets its queries,
+   *  so it must be recorded outside of a render pass, before any region.
+   *  @param commandBuffer The command buffer
+   */
+  void beginFrame(CommandBuffer *commandBuffer);
+  /** Begin a named region
+   *  @param commandBuffer The command buffer
+   *  @param name The region name
+   */
+  void beginRegion(CommandBuffer *commandBuffer, const std::string &name);
+  /** End the current region
+   *  @param commandBuffer The command buffer
+   */
+  void endRegion(CommandBuffer *commandBuffer);
+  /** Export the resolved regions to a Chrome trace file (JSON)
+   *  @param filename The output filename
+   */
+  void exportChromeTrace(const std::string &filename);
+  /** Begins a region when constructed and ends it when destroyed.
+   *  Does nothing if the graphics module doesn't have a profiler */
+  class Scope {
+  public:
+    Scope(Graphics *graphics, CommandBuffer *commandBuffer,
+          const std::string &name)
+        : profiler(graphics ? graphics->profiler : nullptr),
+          commandBuffer(commandBuffer) {
+      if (profiler)
+        profiler->beginRegion(commandBuffer, name);
+    }
+    ~Scope() {
+      if (profiler)
+        profiler->endRegion(commandBuffer);
+    }
+
+  private:
+    GPUProfiler *profiler;
+    CommandBuffer *commandBuffer;
+  };
+  /** The regions of the most recently resolved frame */
+  std::vector<Region> results;
+  /** All the resolved regions, in frame order */
+  std::vector<Region> trace;
+  /** Keep the resolved regions for exportChromeTrace */
+  bool enableTrace = true;
+  /** Set to false if the device doesn't support timestamp queries */
+  bool enabled = true;
+  /** The number of frames whose results weren't available in time */
+  uint64_t numDroppedFrames = 0;
+
+protected:
+  void init(uint32_t numFrames, uint32_t maxRegions);
+  /** Reset the queries of a frame */
+  virtual void resetQueries(CommandBuffer *commandBuffer,
+                            uint32_t frameSlot) = 0;
+  /** Write a timestamp. Begin timestamps are written before the
+   *  following commands start, end timestamps after the previous
+   *  commands complete */
+  virtual void writeTimestamp(CommandBuffer *commandBuffer, uint32_t frameSlot,
+                              uint32_t query, bool begin) = 0;
+  /** Read back the timestamps of a frame, in ticks, without waiting.
+   *  @param available Set to false for the queries whose results aren't
+   *  available */
+  virtual void getTimestamps(uint32_t frameSlot, uint32_t numQueries,
+                             std::vector<uint64_t> &timestamps,
+                             std::vector<bool> &available) = 0;
+  void resolveFrame(uint32_t frameSlot);
+  struct PendingRegion {
+    std::string name;
+    uint32_t depth;
+    uint32_t beginQuery, endQuery;
+  };
+  struct Frame {
+    uint64_t index = 0;
+    std::vector<PendingRegion> regions;
+    uint32_t numQueries = 0;
+  };
+  std::vector<Frame> frames;
+  /** The indices of the open regions, UINT32_MAX if a region was skipped */
+  std::vector<uint32_t> regionStack;
+  uint32_t maxQueries = 0;
+  uint64_t frameIndex = 0;
+  int32_t currentFrameSlot = -1;
+  /** The duration of a tick, in nanoseconds */
+  double timestampPeriod = 1.0;
+  /** The valid bits of the timestamps */
+  uint64_t timestampMask = ~0ull;
+  /** The first timestamp of the last resolved frame, and its offset from
+   *  the first resolved frame (in ticks) */
+  uint64_t lastFrameStart = 0, lastFrameOffset = 0;
+  bool timelineStarted = false;
+};
+} // namespace ngfx
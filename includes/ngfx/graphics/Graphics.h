@@ -29,6 +29,7 @@
 #include <glm/glm.hpp>
 
 namespace ngfx {
+class GPUProfiler;
 
 /** \class Graphics
  *
@@ -69,15 +70,21 @@ public:
   */
   virtual void endRenderPass(CommandBuffer *commandBuffer) = 0;
   /** Begin GPU profiling.
-      Use beginProfile/endProfile to profile a group of commands in the command buffer.
-  *   @param commandBuffer The command buffer
-  */
+   *  Use beginProfile/endProfile to profile a group of commands in the
+   *  command buffer, and getProfileResult to read back the duration.
+   *  For nested regions, see GPUProfiler
+   *  @param commandBuffer The command buffer
+   */
   virtual void beginProfile(CommandBuffer *commandBuffer) = 0;
   /** End GPU profiling
-  *   @param commandBuffer The command buffer
-  *   @return The profiling result
-  */
-  virtual uint64_t endProfile(CommandBuffer *commandBuffer) = 0;
+   *  @param commandBuffer The command buffer
+   */
+  virtual void endProfile(CommandBuffer *commandBuffer) = 0;
+  /** Get the duration of the last profile that completed on the GPU.
+   *  It doesn't wait for the GPU: it's 0 until the first profile completes
+   *  @return The duration, in nanoseconds
+   */
+  virtual uint64_t getProfileResult() = 0;
   /** Bind a buffer as a per-vertex input to the vertex shader module
    *  @param commandBuffer The command buffer
    *  @param buffer The input buffer
@@ -86,6 +93,21 @@ public:
    */
   virtual void bindVertexBuffer(CommandBuffer *commandBuffer, Buffer *buffer,
                                 uint32_t location, uint32_t stride) = 0;
+  /** Bind multiple vertex buffers.
+   *  Buffers at consecutive bindings are bound with a single command
+   *  @param commandBuffer The command buffer
+   *  @param buffers The input buffers
+   *  @param bindings The target binding of each buffer
+   *  (see GraphicsPipeline::vertexAttributeBindings)
+   *  @param strides The size of each element (bytes)
+   */
+  virtual void bindVertexBuffers(CommandBuffer *commandBuffer,
+                                 const std::vector<Buffer *> &buffers,
+                                 const std::vector<uint32_t> &bindings,
+                                 const std::vector<uint32_t> &strides) {
+    for (uint32_t j = 0; j < buffers.size(); j++)
+      bindVertexBuffer(commandBuffer, buffers[j], bindings[j], strides[j]);
+  }
   /** Bind a buffer of vertex indices, for indexed drawing
    *  @param commandBuffer The command buffer
    *  @param buffer The input buffer
@@ -134,12 +156,25 @@ public:
                                     GraphicsPipeline *graphicsPipeline) = 0;
   /** Bind texture.
   *   This allows the GPU shader module to sample the texture.
+  *   In a compute pipeline, the texture is bound as a storage image,
+  *   or as a sampled texture if the shader declares a sampler at this set.
   *   @param cmdBuffer The command buffer
   *   @param texture The input texture
   *   @param set The descriptor set index
   */
   virtual void bindTexture(CommandBuffer *commandBuffer, Texture *texture,
                            uint32_t set) = 0;
+  /** Update the push constants of the current pipeline.
+  *   Push constants are small amounts of data recorded directly in the command buffer,
+  *   without a buffer or a descriptor set.
+  *   The push constant range is reflected from the shaders' push_constant block.
+  *   @param commandBuffer The command buffer
+  *   @param data The push constant data
+  *   @param size The size of the data, in bytes
+  *   @param offset The offset in the push constant block, in bytes
+  */
+  virtual void pushConstants(CommandBuffer *commandBuffer, const void *data,
+                             uint32_t size, uint32_t offset = 0);
 
   // TODO: copyBuffer: ToBuffer, copyBuffer: ToTexture, copyTexture: ToBuffer,
   // blit
@@ -180,6 +215,49 @@ public:
                         uint32_t groupCountY, uint32_t groupCountZ,
                         uint32_t threadsPerGroupX, uint32_t threadsPerGroupY,
                         uint32_t threadsPerGroupZ) = 0;
+  /** Draw primitives, with the arguments read from a buffer by the GPU.
+  *   The buffer contains drawCount DrawIndirectCommand structures,
+      e.g. written by a compute shader, so the draw count doesn't need to be read back.
+  *   @param cmdBuffer The command buffer
+  *   @param buffer The indirect buffer, created with BUFFER_USAGE_INDIRECT_BUFFER_BIT
+  *   @param offset The offset of the first command in the buffer (in bytes)
+  *   @param drawCount The number of draws. More than one draw requires
+  *   multi draw indirect support, see GraphicsContext::multiDrawIndirect
+  *   @param stride The stride between the commands (in bytes)
+  */
+  virtual void drawIndirect(CommandBuffer *cmdBuffer, Buffer *buffer,
+                            uint32_t offset = 0, uint32_t drawCount = 1,
+                            uint32_t stride = sizeof(DrawIndirectCommand)) {
+    NGFX_ERR("indirect draws are not supported by this backend");
+  }
+  /** Draw indexed primitives, with the arguments read from a buffer by the GPU.
+  *   The buffer contains drawCount DrawIndexedIndirectCommand structures.
+  *   @param cmdBuffer The command buffer
+  *   @param buffer The indirect buffer, created with BUFFER_USAGE_INDIRECT_BUFFER_BIT
+  *   @param offset The offset of the first command in the buffer (in bytes)
+  *   @param drawCount The number of draws. More than one draw requires
+  *   multi draw indirect support, see GraphicsContext::multiDrawIndirect
+  *   @param stride The stride between the commands (in bytes)
+  */
+  virtual void
+  drawIndexedIndirect(CommandBuffer *cmdBuffer, Buffer *buffer,
+                      uint32_t offset = 0, uint32_t drawCount = 1,
+                      uint32_t stride = sizeof(DrawIndexedIndirectCommand)) {
+    NGFX_ERR("indirect draws are not supported by this backend");
+  }
+  /** Dispatch compute worker threads, with the number of groups read from a
+      DispatchIndirectCommand in a buffer by the GPU.
+  *   @param cmdBuffer The command buffer
+  *   @param buffer The indirect buffer, created with BUFFER_USAGE_INDIRECT_BUFFER_BIT
+  *   @param offset The offset of the command in the buffer (in bytes)
+  *   @param threadsPerGroupX, threadsPerGroupY, threadsPerGroupZ The number of threads per group (tensor)
+  */
+  virtual void dispatchIndirect(CommandBuffer *cmdBuffer, Buffer *buffer,
+                                uint32_t offset, uint32_t threadsPerGroupX,
+                                uint32_t threadsPerGroupY,
+                                uint32_t threadsPerGroupZ) {
+    NGFX_ERR("indirect dispatches are not supported by this backend");
+  }
   /** Set the viewport
   *   This defines the mapping of view coordinates to NDC coordinates.
   *   @param cmdBuffer The command buffer
@@ -203,6 +281,9 @@ public:
   Pipeline *currentPipeline = nullptr;
   RenderPass *currentRenderPass = nullptr;
   Framebuffer *currentFramebuffer = nullptr;
+  /** The GPU profiler, used by the draw, compute and filter operations.
+   *  Profiling is disabled if not set */
+  GPUProfiler *profiler = nullptr;
 
 protected:
   GraphicsContext *ctx;
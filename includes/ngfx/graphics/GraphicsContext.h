@@ -20,6 +20,8 @@
  */
 #pragma once
 #include "ngfx/compute/ComputePass.h"
+#include "ngfx/core/Util.h"
+#include "ngfx/graphics/BindlessHeap.h"
 #include "ngfx/graphics/CommandBuffer.h"
 #include "ngfx/graphics/Device.h"
 #include "ngfx/graphics/Framebuffer.h"
@@ -29,6 +31,7 @@
 #include "ngfx/graphics/RenderPass.h"
 #include "ngfx/graphics/Surface.h"
 #include "ngfx/graphics/Swapchain.h"
+#include <memory>
 #include <optional>
 #include <vector>
 
@@ -80,7 +83,17 @@ public:
       return rhs.format == format && rhs.initialLayout == initialLayout &&
              rhs.finalLayout == finalLayout;
     }
+    void hash(uint64_t &seed) const {
+      Util::hashCombine(seed, uint64_t(format));
+      // Offset the layouts so that an unset layout doesn't collide
+      // with IMAGE_LAYOUT_UNDEFINED
+      Util::hashCombine(seed, initialLayout ? uint64_t(*initialLayout) + 1 : 0);
+      Util::hashCombine(seed, finalLayout ? uint64_t(*finalLayout) + 1 : 0);
+    }
     PixelFormat format;
+    /** The depth contents are only kept after the render pass if the
+     *  depth attachment's final layout is
+     *  IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL */
     std::optional<ImageLayout> initialLayout, finalLayout;
   };
 
@@ -95,15 +108,58 @@ public:
     uint32_t numColorAttachments() const {
       return uint32_t(colorAttachmentDescriptions.size());
     }
+    uint64_t hash() const {
+      uint64_t seed = 0;
+      Util::hashCombine(seed, numColorAttachments());
+      for (auto &desc : colorAttachmentDescriptions)
+        desc.hash(seed);
+      if (depthStencilAttachmentDescription)
+        depthStencilAttachmentDescription->hash(seed);
+      Util::hashCombine(seed, enableDepthStencilResolve);
+      Util::hashCombine(seed, numSamples);
+      return seed;
+    }
+    struct Hash {
+      size_t operator()(const RenderPassConfig &config) const {
+        return size_t(config.hash());
+      }
+    };
     std::vector<AttachmentDescription> colorAttachmentDescriptions;
     std::optional<AttachmentDescription> depthStencilAttachmentDescription;
     bool enableDepthStencilResolve = false;
     uint32_t numSamples = 1;
   };
   virtual RenderPass *getRenderPass(RenderPassConfig config) = 0;
+  /** Get a framebuffer from the framebuffer cache.
+   *  Requests with the same render pass, attachments and size share
+   *  the same framebuffer.
+   *  The cache may evict the framebuffer when it's no longer used by the GPU,
+   *  or when one of its attachments is destroyed, so callers that keep the
+   *  framebuffer across frames should hold on to the returned pointer.
+   *  Backends without a framebuffer cache create a new framebuffer.
+   *  @param renderPass The render pass
+   *  @param attachments The output attachments
+   *  @param w The destination width
+   *  @param h The destination height
+   *  @param layers The number of output layers
+   */
+  virtual std::shared_ptr<Framebuffer>
+  getFramebuffer(RenderPass *renderPass,
+                 const std::vector<Framebuffer::Attachment> &attachments,
+                 uint32_t w, uint32_t h, uint32_t layers = 1) {
+    return std::shared_ptr<Framebuffer>(
+        Framebuffer::create(device, renderPass, attachments, w, h, layers));
+  }
+  struct CacheStats {
+    uint64_t hits = 0, misses = 0, evictions = 0;
+  };
+  CacheStats renderPassCacheStats, framebufferCacheStats;
 
   std::vector<Framebuffer *> swapchainFramebuffers;
   Queue *queue = nullptr;
+  /** The compute queue. It's the same as the graphics queue if the device
+   *  doesn't have a dedicated compute queue family */
+  Queue *computeQueue = nullptr;
   RenderPass *defaultRenderPass = nullptr,
              *defaultOffscreenRenderPass = nullptr;
   Swapchain *swapchain = nullptr;
@@ -114,6 +170,11 @@ public:
   Semaphore *presentCompleteSemaphore = nullptr,
             *renderCompleteSemaphore = nullptr;
   PipelineCache *pipelineCache = nullptr;
+  /** The bindless descriptor heap.
+   *  It's null if the device doesn't support descriptor indexing */
+  BindlessHeap *bindlessHeap = nullptr;
+  /** True if the device supports more than one draw per indirect draw call */
+  bool multiDrawIndirect = false;
   PixelFormat surfaceFormat = PIXELFORMAT_UNDEFINED,
               defaultOffscreenSurfaceFormat = PIXELFORMAT_UNDEFINED,
               depthFormat = PIXELFORMAT_UNDEFINED;
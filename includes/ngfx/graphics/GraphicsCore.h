@@ -39,8 +39,28 @@ typedef Flags FenceCreateFlags;
 typedef Flags ImageUsageFlags;
 typedef Flags ColorComponentFlags;
 typedef Flags BufferUsageFlags;
+/** The filter used to generate the mipmaps of a texture */
+enum MipmapFilter {
+  MIPMAP_FILTER_BLIT, /**< Successive linear blits, one level at a time */
+  MIPMAP_FILTER_BOX,  /**< 2x2 box filter, several levels per dispatch */
+  MIPMAP_FILTER_KAISER /**< Kaiser windowed sinc filter, one level per dispatch */
+};
 struct Rect2D {
   int32_t x, y;
   uint32_t w, h;
 };
+/** The arguments of an indirect draw, as stored in the indirect buffer */
+struct DrawIndirectCommand {
+  uint32_t vertexCount, instanceCount, firstVertex, firstInstance;
+};
+/** The arguments of an indirect indexed draw */
+struct DrawIndexedIndirectCommand {
+  uint32_t indexCount, instanceCount, firstIndex;
+  int32_t vertexOffset;
+  uint32_t firstInstance;
+};
+/** The arguments of an indirect dispatch */
+struct DispatchIndirectCommand {
+  uint32_t groupCountX, groupCountY, groupCountZ;
+};
 } // namespace ngfx
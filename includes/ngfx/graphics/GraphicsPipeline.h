@@ -32,6 +32,17 @@ namespace ngfx {
 class GraphicsContext;
 class GraphicsPipeline : public Pipeline {
 public:
+  /** An interleaved vertex buffer layout: the attributes that are read
+   *  from the same buffer, each at an offset within the vertex */
+  struct VertexBufferLayout {
+    struct Attribute {
+      std::string name;
+      uint32_t offset = 0;
+    };
+    std::vector<Attribute> attributes;
+    /** The size of a vertex (in bytes) */
+    uint32_t stride = 0;
+  };
   struct State {
     PrimitiveTopology primitiveTopology = PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
     PolygonMode polygonMode = POLYGON_MODE_FILL;
@@ -49,6 +60,9 @@ public:
     bool depthTestEnable = false, depthWriteEnable = false;
     RenderPass *renderPass = nullptr;
     uint32_t numSamples = 1, numColorAttachments = 1;
+    /** The interleaved vertex buffers. The attributes that aren't part
+     *  of a layout are read from their own buffer */
+    std::vector<VertexBufferLayout> vertexBufferLayouts;
   };
   struct Descriptor {
     DescriptorType type;
@@ -60,8 +74,24 @@ public:
          PixelFormat colorFormat, PixelFormat depthFormat,
          std::set<std::string> instanceAttributes = {});
   virtual ~GraphicsPipeline() {}
+  /** Get the descriptor bindings and the vertex buffer bindings.
+   *  The attributes of an interleaved layout share the same binding */
   void getBindings(std::vector<uint32_t *> pDescriptorBindings,
                    std::vector<uint32_t *> pVertexAttribBindings);
   std::vector<uint32_t> descriptorBindings, vertexAttributeBindings;
+
+protected:
+  /** Where a vertex attribute is read from */
+  struct VertexInput {
+    uint32_t binding, offset, stride;
+  };
+  /** Resolve the binding, offset and stride of each vertex attribute.
+   *  Each buffer is bound at the location of its first attribute
+   *  @param vs The vertex shader module
+   *  @param vertexBufferLayouts The interleaved vertex buffers
+   */
+  static std::vector<VertexInput>
+  getVertexInputs(VertexShaderModule *vs,
+                  const std::vector<VertexBufferLayout> &vertexBufferLayouts);
 };
 }; // namespace ngfx
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/** \class ImageWriter
+ *
+ *  This class writes image sequences (e.g. offscreen renders) to files,
+ *  using a pool of worker threads, so encoding doesn't stall the renderer.
+ *  Frames are copied to a bounded queue: when the queue is full, write()
+ *  blocks until a worker is done with a frame, which applies back-pressure
+ *  to the renderer instead of buffering an unbounded number of frames.
+ */
+
+namespace ngfx {
+class ImageWriter {
+public:
+  enum FileFormat { FILE_FORMAT_PNG, FILE_FORMAT_PPM, FILE_FORMAT_RAW };
+  struct Stats {
+    uint64_t numFramesWritten = 0, numBytesWritten = 0;
+    /** The total time spent encoding, summed over the workers (seconds) */
+    double encodeTime = 0.0;
+    /** The time the producer spent waiting for a free queue slot (seconds) */
+    double waitTime = 0.0;
+    /** The time since the writer was created (seconds) */
+    double elapsed = 0.0;
+    double framesPerSecond() const {
+      return elapsed > 0.0 ? numFramesWritten / elapsed : 0.0;
+    }
+  };
+  /** Create the image writer
+   *  @param filenamePattern The output filename, with a printf integer
+   *  specifier for the frame index, e.g. "frame_%05d.png".
+   *  The full 64-bit frame index is written, whatever the length modifier
+   *  @param fileFormat The file format
+   *  @param numThreads The number of worker threads.
+   *  If 0, the number of hardware threads is used.
+   *  @param maxQueuedFrames The maximum number of frames waiting to be written
+   */
+  ImageWriter(const std::string &filenamePattern,
+              FileFormat fileFormat = FILE_FORMAT_PNG, uint32_t numThreads = 0,
+              uint32_t maxQueuedFrames = 8);
+  /** Destroy the image writer. Waits until all the frames are written */
+  virtual ~ImageWriter();
+  /** Queue a RGBA8 frame. The pixels are copied, so the caller can reuse
+   *  the memory when the function returns.
+   *  Blocks while the queue is full.
+   *  @param frameIndex The frame index, used in the filename
+   *  @param data The pixels
+   *  @param w The frame width
+   *  @param h The frame height
+   */
+  void write(uint64_t frameIndex, const void *data, uint32_t w, uint32_t h);
+  /** Wait until all the queued frames are written */
+  void finish();
+  /** Get the current statistics */
+  Stats getStats();
+
+protected:
+  struct Job {
+    uint64_t frameIndex;
+    uint32_t w, h;
+    std::vector<uint8_t> data;
+  };
+  void run();
+  void encode(const Job &job);
+  std::string filenamePattern;
+  /** The filename pattern, with its specifier rewritten for a uint64_t */
+  std::string filenameFormat;
+  FileFormat fileFormat;
+  uint32_t maxQueuedFrames;
+  std::vector<std::thread> workers;
+  std::mutex mutex;
+  std::condition_variable jobAvailable, slotAvailable, jobsDone;
+  std::deque<Job> jobs;
+  /** Pixel buffers that can be reused for new jobs */
+  std::vector<std::vector<uint8_t>> freeBuffers;
+  uint32_t numActiveJobs = 0;
+  bool stopping = false;
+  Stats stats;
+  std::chrono::steady_clock::time_point t0;
+};
+} // namespace ngfx
@@ -0,0 +1,56 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#pragma once
+#include "ngfx/graphics/GraphicsCore.h"
+#include <string>
+#include <vector>
+
+/** \class KTXFile
+ *
+ *  Read and write KTX2 texture files.
+ *  The levels are stored in memory from the largest to the smallest, as
+ *  expected by Texture::create. Each level contains the array layers, the
+ *  faces of each layer, and the depth slices of each face.
+ *  The supercompressed files (e.g. Basis Universal) are not supported.
+ */
+
+namespace ngfx {
+class KTXFile {
+public:
+  /** Load a file. The file is memory mapped while it's read */
+  void load(const std::string &filename);
+  /** Save a file, with a basic data format descriptor */
+  void save(const std::string &filename) const;
+  /** Decode the levels to RGBA8, e.g. when the device doesn't support
+   *  the compressed format
+   *  @param numThreads The number of threads. If 0, the number of hardware
+   *  threads is used
+   */
+  void decode(uint32_t numThreads = 0);
+  /** Get the size of a level (in bytes) */
+  uint32_t getLevelSize(uint32_t level) const;
+  /** Get the offset of a level in the data (in bytes) */
+  uint32_t getLevelOffset(uint32_t level) const;
+  PixelFormat format = PIXELFORMAT_UNDEFINED;
+  uint32_t w = 0, h = 0, d = 1, arrayLayers = 1, numFaces = 1, mipLevels = 1;
+  std::vector<uint8_t> data;
+};
+} // namespace ngfx
@@ -0,0 +1,124 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#pragma once
+#include "ngfx/graphics/MeshData.h"
+#include "ngfx/graphics/Ray.h"
+#include <string>
+#include <vector>
+
+/** \class MeshBVH
+ *
+ *  A bounding volume hierarchy over the triangles of a mesh, for picking
+ *  and ray queries on the CPU.
+ *  The builder splits the triangles with the surface area heuristic,
+ *  evaluated on a fixed number of bins along each axis, and each node
+ *  has up to 4 children whose bounds are stored in SIMD order, so a ray
+ *  is tested against the 4 children at once.
+ *  The large nodes are split with a parallel binning pass, and the
+ *  subtrees below them are built in parallel. The hierarchy doesn't
+ *  depend on the number of threads.
+ *  If the mesh has levels of detail, the hierarchy only contains the
+ *  faces of the finest level.
+ *  The hierarchy can be saved next to the mesh file, so it doesn't have
+ *  to be rebuilt when the mesh is loaded. The bounds must match the
+ *  vertices as they are loaded, e.g. the hierarchy of a quantized mesh
+ *  is built from the dequantized vertices. The file stores a hash of
+ *  the faces, so a hierarchy built for another version of the mesh is
+ *  rejected.
+ */
+
+namespace ngfx {
+class MeshBVH {
+public:
+  static const uint32_t INVALID_INDEX = 0xFFFFFFFF;
+  struct BuildOptions {
+    /** The maximum number of triangles in a leaf */
+    uint32_t maxLeafSize = 8;
+    /** The number of bins per axis of the surface area heuristic */
+    uint32_t numBins = 16;
+    /** The number of threads. If 0, the number of hardware threads
+     *  is used */
+    uint32_t numThreads = 0;
+  };
+  /** A node with up to 4 children (128 bytes).
+   *  The bounds of the children are stored per axis, and an unused child
+   *  has empty bounds */
+  struct Node {
+    float minX[4], minY[4], minZ[4], maxX[4], maxY[4], maxZ[4];
+    /** The index of the child node, or of the first triangle of a leaf */
+    uint32_t children[4];
+    /** The number of triangles of a leaf, 0 for a node */
+    uint32_t numFaces[4];
+  };
+  /** The closest intersection along a ray */
+  struct Hit {
+    float t = FLT_MAX;
+    /** The index of the face in MeshData::faces */
+    uint32_t face = INVALID_INDEX;
+    /** The barycentric coordinates of the hit point, relative to the
+     *  second and the third vertex of the face */
+    vec2 barycentrics = vec2(0.0f);
+  };
+  /** Build the hierarchy
+   *  @param meshData The mesh
+   *  @param options The build options
+   */
+  void build(const MeshData &meshData, const BuildOptions &options);
+  void build(const MeshData &meshData) { build(meshData, BuildOptions()); }
+  /** Find the closest intersection of a ray with the mesh.
+   *  The triangles are two-sided
+   *  @param ray The ray
+   *  @param hit The intersection
+   *  @return True if the ray hits the mesh in [ray.tMin, ray.tMax]
+   */
+  bool intersect(const Ray &ray, Hit &hit) const;
+  /** Test if a ray hits the mesh in [ray.tMin, ray.tMax], e.g. for
+   *  shadow rays. It stops at the first intersection found */
+  bool intersectAny(const Ray &ray) const;
+  /** Save the hierarchy. The triangles are not saved */
+  void save(const std::string &file) const;
+  /** Load the hierarchy of a mesh.
+   *  It's an error if the file is invalid or doesn't match the mesh
+   *  @param file The file
+   *  @param meshData The mesh the hierarchy was built for
+   */
+  void load(const std::string &file, const MeshData &meshData);
+  /** The nodes. The first node is the root */
+  std::vector<Node> nodes;
+  /** The index of the face of each triangle, in the order of the leaves */
+  std::vector<uint32_t> faceIndices;
+
+protected:
+  /** A triangle in the layout of the intersection test */
+  struct Triangle {
+    vec3 v0, e1, e2;
+  };
+  template <bool anyHit> bool traverse(const Ray &ray, Hit &hit) const;
+  static MeshLOD getFaceRange(const MeshData &meshData);
+  /** Get the hash of the number of vertices and of the faces
+   *  of the hierarchy */
+  static uint64_t getMeshHash(const MeshData &meshData);
+  void gatherTriangles(const MeshData &meshData);
+  void checkNodes(const std::string &file) const;
+  std::vector<Triangle> triangles;
+  uint64_t meshHash = 0;
+};
+} // namespace ngfx
@@ -19,14 +19,114 @@
  * under the License.
  */
 #pragma once
+#include <cfloat>
+#include <cstdint>
 #include <glm/glm.hpp>
 #include <vector>
 using namespace glm;
 
 namespace ngfx {
+/** A level of detail of a mesh: a range of faces */
+struct MeshLOD {
+  uint32_t firstFace = 0, numFaces = 0;
+  /** The geometric error relative to the full resolution mesh
+   *  (in model units) */
+  float error = 0.0f;
+};
+
+/** A cluster of neighboring faces, culled as a whole.
+ *  The layout matches the std430 layout of the culling shader */
+struct Meshlet {
+  uint32_t firstFace = 0, numFaces = 0, numVerts = 0, padding = 0;
+  /** The bounding sphere: the center and the radius */
+  vec4 boundingSphere = vec4(0.0f);
+  /** The normal cone: the axis, and the cutoff in w.
+   *  The meshlet is back facing if
+   *  dot(center - cameraPos, axis) >= cutoff * length(center - cameraPos)
+   *  + radius. A cutoff of 1 means that the meshlet can't be back face
+   *  culled */
+  vec4 normalCone = vec4(0.0f, 0.0f, 0.0f, 1.0f);
+};
+
 struct MeshData {
   std::vector<vec3> pos, normal;
   std::vector<ivec3> faces;
   vec3 bounds[2] = {vec3(FLT_MAX), vec3(FLT_MIN)};
+  /** The levels of detail, from the finest to the coarsest.
+   *  All the LODs share the vertices. If empty, the faces are
+   *  a single LOD */
+  std::vector<MeshLOD> lods;
+  /** The meshlets, in the order of the faces. Each meshlet belongs
+   *  to a single LOD */
+  std::vector<Meshlet> meshlets;
+};
+
+/** The position encodings of a quantized mesh */
+enum PositionEncoding : uint32_t {
+  /** 3 x 32-bit float (12 bytes) */
+  POSITION_ENCODING_FLOAT3,
+  /** 4 x 16-bit float (8 bytes) */
+  POSITION_ENCODING_HALF4,
+  /** 4 x 16-bit unorm relative to the mesh bounds (8 bytes) */
+  POSITION_ENCODING_UNORM16
+};
+/** The normal encodings of a quantized mesh */
+enum NormalEncoding : uint32_t {
+  /** 3 x 32-bit float (12 bytes) */
+  NORMAL_ENCODING_FLOAT3,
+  /** 4 x 16-bit float (8 bytes) */
+  NORMAL_ENCODING_HALF4,
+  /** 4 x 8-bit snorm (4 bytes) */
+  NORMAL_ENCODING_SNORM8,
+  /** 10:10:10:2 unorm, remapped from [-1, 1] to [0, 1] (4 bytes) */
+  NORMAL_ENCODING_UNORM10,
+  /** Octahedral encoding, 2 x 16-bit snorm (4 bytes) */
+  NORMAL_ENCODING_OCT16,
+  /** Octahedral encoding, 2 x 8-bit snorm (2 bytes) */
+  NORMAL_ENCODING_OCT8
+};
+
+/** \class QuantizedMeshData
+ *
+ *  A mesh with packed vertex attributes, ready to be uploaded to vertex
+ *  buffers as is.
+ *  The indices are 16-bit when the number of vertices allows it.
+ */
+struct QuantizedMeshData {
+  /** Get the size of a vertex position (in bytes) */
+  uint32_t posStride() const {
+    return (posEncoding == POSITION_ENCODING_FLOAT3) ? 12 : 8;
+  }
+  /** Get the size of a vertex normal (in bytes) */
+  uint32_t normalStride() const {
+    const uint32_t strides[] = {12, 8, 4, 4, 4, 2};
+    return strides[normalEncoding];
+  }
+  PositionEncoding posEncoding = POSITION_ENCODING_FLOAT3;
+  NormalEncoding normalEncoding = NORMAL_ENCODING_FLOAT3;
+  uint32_t numVerts = 0, numNormals = 0, numFaces = 0;
+  /** The size of an index: 2 or 4 bytes */
+  uint32_t indexSize = 4;
+  std::vector<uint8_t> pos, normal, indices;
+  vec3 bounds[2] = {vec3(FLT_MAX), vec3(FLT_MIN)};
+  std::vector<MeshLOD> lods;
+  std::vector<Meshlet> meshlets;
+};
+
+/** \class MeshView
+ *
+ *  A mesh whose vertex attributes and indices are read in place, e.g. from
+ *  a memory mapped file, so they are uploaded without an intermediate copy.
+ *  The positions and the normals are 3 x 32-bit float, and the attribute of
+ *  the vertex j starts at pos + j * posStride (resp. normal), so they can
+ *  be interleaved.
+ */
+struct MeshView {
+  const uint8_t *pos = nullptr, *normal = nullptr, *indices = nullptr;
+  uint32_t posStride = sizeof(vec3), normalStride = sizeof(vec3);
+  /** The size of an index: 2 or 4 bytes */
+  uint32_t indexSize = 4;
+  uint32_t numVerts = 0, numFaces = 0;
+  vec3 bounds[2] = {vec3(FLT_MAX), vec3(-FLT_MAX)};
 };
 }; // namespace ngfx
\ No newline at end of file
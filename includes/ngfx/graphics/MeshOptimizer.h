@@ -0,0 +1,110 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#pragma once
+#include "ngfx/graphics/MeshData.h"
+#include <cstdint>
+
+/** \class MeshOptimizer
+ *
+ *  Reorder the triangles and vertices of a mesh for rendering efficiency.
+ *  The passes are meant to be applied in this order:
+ *  1. optimizeVertexCache: reorder the triangles to reuse the vertices in
+ *  the post-transform vertex cache (Forsyth's linear-speed algorithm).
+ *  2. optimizeOverdraw: split the triangles into clusters at the points
+ *  where the vertex cache is flushed, and sort the clusters so that the
+ *  outward-facing clusters are drawn first, with a bounded loss of
+ *  vertex cache efficiency.
+ *  3. optimizeVertexFetch: reorder the vertices in the order in which
+ *  they're first referenced, for the locality of the vertex fetches.
+ *  The LODs are generated first, the first two passes are applied to
+ *  each LOD separately.
+ *  The meshlets are built last, from the triangles in vertex cache order.
+ *  Once they're built, the first two passes are applied to each meshlet
+ *  separately.
+ */
+
+namespace ngfx {
+struct MeshOptimizer {
+  /** The post-transform vertex cache statistics */
+  struct VertexCacheStats {
+    /** The average cache miss ratio: transformed vertices per triangle,
+     *  from 3.0 down to about 0.5 for a regular grid */
+    float acmr = 0.0f;
+    /** The average transform to vertex ratio: transformed vertices
+     *  per vertex, 1.0 is optimal */
+    float atvr = 0.0f;
+  };
+  /** Simulate a FIFO post-transform vertex cache
+   *  @param meshData The mesh
+   *  @param cacheSize The number of vertices in the cache
+   */
+  static VertexCacheStats analyzeVertexCache(const MeshData &meshData,
+                                             uint32_t cacheSize = 16);
+  /** Reorder the triangles for the post-transform vertex cache */
+  static void optimizeVertexCache(MeshData &meshData);
+  /** Reorder the clusters of triangles to reduce overdraw
+   *  @param meshData The mesh, with the triangles in vertex cache order
+   *  @param threshold The maximum ratio between the ACMR of the result
+   *  and the ACMR of the input, e.g. 1.05 allows for a 5% increase
+   */
+  static void optimizeOverdraw(MeshData &meshData, float threshold = 1.05f);
+  /** Reorder the vertices in the order of first use.
+   *  The vertices that aren't referenced by a triangle are removed */
+  static void optimizeVertexFetch(MeshData &meshData);
+  /** Simplify a list of triangles with quadric error metrics.
+   *  Edges are collapsed onto one of their vertices, so the result
+   *  only references the input vertices and can share their buffers.
+   *  The border edges are preserved, and the vertices with the same
+   *  position are simplified together.
+   *  @param meshData The mesh vertices
+   *  @param faces The triangles to simplify, e.g. the previous LOD
+   *  @param targetNumFaces The target number of triangles
+   *  @param result The simplified triangles
+   *  @return The geometric error of the simplification (in model units)
+   */
+  static float simplify(const MeshData &meshData,
+                        const std::vector<ivec3> &faces,
+                        uint32_t targetNumFaces, std::vector<ivec3> &result);
+  /** Generate a chain of LODs, by simplifying each LOD into the next one.
+   *  The faces of the LODs are appended to the faces of the mesh,
+   *  and their ranges and errors are stored in meshData.lods
+   *  @param meshData The mesh
+   *  @param maxLODs The maximum number of LODs, including the input mesh
+   *  @param reduction The ratio of triangles between successive LODs
+   *  @param minFaces The minimum number of triangles of a LOD
+   */
+  static void generateLODs(MeshData &meshData, uint32_t maxLODs = 8,
+                           float reduction = 0.5f, uint32_t minFaces = 64);
+  /** Partition the triangles of each LOD into meshlets.
+   *  The triangles are reordered so that each meshlet is a range of faces,
+   *  and each meshlet gets a bounding sphere and a normal cone for
+   *  culling. The defaults fit the mesh shader limits of most GPUs.
+   *  @param meshData The mesh
+   *  @param maxVerts The maximum number of vertices of a meshlet
+   *  @param maxFaces The maximum number of triangles of a meshlet
+   *  @param coneWeight The weight of the normal deviation when growing a
+   *  meshlet. Higher values give tighter normal cones for back face
+   *  culling, at the cost of more vertices per triangle
+   */
+  static void buildMeshlets(MeshData &meshData, uint32_t maxVerts = 64,
+                            uint32_t maxFaces = 124, float coneWeight = 0.25f);
+};
+} // namespace ngfx
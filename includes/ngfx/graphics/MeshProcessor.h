@@ -0,0 +1,99 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#pragma once
+#include "ngfx/graphics/MeshData.h"
+#include <cstdint>
+
+/** \class MeshProcessor
+ *
+ *  Clean up an imported mesh, e.g. a scan without normals or a triangle
+ *  soup without shared vertices.
+ *  1. weldVertices: merge the vertices that are closer than a tolerance,
+ *  using a hash grid, and update the bounds.
+ *  2. removeDegenerateFaces: remove the triangles with a repeated vertex
+ *  or a zero area, e.g. the triangles collapsed by welding.
+ *  3. generateNormals: compute the vertex normals as the weighted sum of
+ *  the normals of the adjacent triangles.
+ *  The passes are multithreaded, and their results don't depend on the
+ *  number of threads.
+ *  The vertices and the triangles are renumbered, so the passes are
+ *  meant to be applied before the MeshOptimizer passes.
+ */
+
+namespace ngfx {
+struct MeshProcessor {
+  /** The weight of a triangle in the normal of its vertices */
+  enum NormalWeighting {
+    /** The triangle area, favors the large triangles */
+    NORMAL_WEIGHTING_AREA,
+    /** The triangle angle at the vertex, doesn't depend on the
+     *  tessellation */
+    NORMAL_WEIGHTING_ANGLE,
+    /** The product of the area and the angle */
+    NORMAL_WEIGHTING_AREA_ANGLE
+  };
+  struct Options {
+    bool weldVertices = true;
+    /** The maximum distance between two welded vertices.
+     *  If 0, only the vertices at the same position are welded */
+    float weldTolerance = 0.0f;
+    bool removeDegenerateFaces = true;
+    /** Generate the normals. The normals are always generated if the
+     *  mesh doesn't have them */
+    bool generateNormals = false;
+    NormalWeighting normalWeighting = NORMAL_WEIGHTING_AREA_ANGLE;
+    /** The number of threads. If 0, the number of hardware threads
+     *  is used */
+    uint32_t numThreads = 0;
+  };
+  struct Stats {
+    uint32_t numWeldedVerts = 0, numDegenerateFaces = 0;
+  };
+  /** Apply the passes enabled by the options, and update the bounds.
+   *  The LODs and the meshlets are discarded */
+  static Stats process(MeshData &meshData, const Options &options);
+  /** Merge the vertices that are closer than a tolerance.
+   *  Each vertex is merged into the first vertex within the tolerance,
+   *  so a chain of close vertices is merged into a single vertex.
+   *  If the mesh has normals, the vertices are only merged if their
+   *  normals match as well.
+   *  The bounds are updated in the same pass.
+   *  @param meshData The mesh
+   *  @param tolerance The maximum distance between two welded vertices
+   *  @param numThreads The number of threads
+   *  @return The number of vertices that were merged
+   */
+  static uint32_t weldVertices(MeshData &meshData, float tolerance = 0.0f,
+                               uint32_t numThreads = 0);
+  /** Remove the triangles with a repeated vertex or a zero area
+   *  @return The number of triangles that were removed
+   */
+  static uint32_t removeDegenerateFaces(MeshData &meshData,
+                                        uint32_t numThreads = 0);
+  /** Compute a normal for each vertex, from the adjacent triangles */
+  static void
+  generateNormals(MeshData &meshData,
+                  NormalWeighting weighting = NORMAL_WEIGHTING_AREA_ANGLE,
+                  uint32_t numThreads = 0);
+  /** Compute the bounds of the vertices */
+  static void updateBounds(MeshData &meshData, uint32_t numThreads = 0);
+};
+} // namespace ngfx
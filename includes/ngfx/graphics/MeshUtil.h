@@ -24,7 +24,42 @@
 
 namespace ngfx {
 struct MeshUtil {
+  /** Import a mesh. A quantized mesh file is dequantized */
   static void importMesh(const std::string &file, MeshData &meshData);
   static void exportMesh(const std::string &file, MeshData &meshData);
+  /** Import a quantized mesh. A float mesh file is imported with the
+   *  float encodings */
+  static void importMesh(const std::string &file,
+                         QuantizedMeshData &meshData);
+  static void exportMesh(const std::string &file,
+                         QuantizedMeshData &meshData);
+  /** Pack the vertex attributes and the indices of a mesh.
+   *  The positions are quantized relative to the bounds of the vertices,
+   *  and the indices are 16-bit if there are at most 65536 vertices.
+   *  @param meshData The input mesh
+   *  @param quantizedMeshData The output mesh
+   *  @param posEncoding The position encoding
+   *  @param normalEncoding The normal encoding
+   */
+  static void quantizeMesh(const MeshData &meshData,
+                           QuantizedMeshData &quantizedMeshData,
+                           PositionEncoding posEncoding,
+                           NormalEncoding normalEncoding);
+  /** Unpack the vertex attributes and the indices of a quantized mesh */
+  static void dequantizeMesh(const QuantizedMeshData &quantizedMeshData,
+                             MeshData &meshData);
+  /** Pack the vertex attributes in a single buffer, one vertex after the
+   *  other: the position is followed by the normal.
+   *  The mesh must have one normal per vertex.
+   *  @param meshData The input mesh
+   *  @param vertices The interleaved vertices
+   *  @return The size of a vertex (in bytes)
+   */
+  static uint32_t interleaveVertices(const MeshData &meshData,
+                                     std::vector<uint8_t> &vertices);
+  /** Pack the encoded vertex attributes in a single buffer.
+   *  The vertex size is padded to a multiple of 4 bytes */
+  static uint32_t interleaveVertices(const QuantizedMeshData &meshData,
+                                     std::vector<uint8_t> &vertices);
 };
 } // namespace ngfx
\ No newline at end of file
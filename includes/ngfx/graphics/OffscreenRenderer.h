@@ -0,0 +1,87 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#pragma once
+#include "ngfx/graphics/CommandBuffer.h"
+#include "ngfx/graphics/Graphics.h"
+#include "ngfx/graphics/GraphicsContext.h"
+#include <cstdint>
+#include <functional>
+
+/** \class OffscreenRenderer
+ *
+ *  This class renders sequences of frames offscreen, without stalling the GPU.
+ *  It owns a ring of numFrames output framebuffers, each with its own
+ *  command buffer, fence and persistently mapped readback buffer.
+ *  The pixels of frame N are handed back to onFrameReady when its slot
+ *  is reused, while frames N+1 ... N+numFrames-1 are still rendering.
+ *  Data that's read by the GPU (e.g. uniform buffers) must not be modified
+ *  while a frame that uses it is in flight.
+ */
+
+namespace ngfx {
+class OffscreenRenderer {
+public:
+  /** A frame that has been read back */
+  struct Frame {
+    uint64_t index;
+    uint32_t w, h;
+    uint32_t size;
+    /** The RGBA8 pixels, only valid during the onFrameReady callback */
+    const void *data;
+  };
+  /** The record callback. It's called inside the frame's render pass */
+  typedef std::function<void(CommandBuffer *commandBuffer, uint64_t frameIndex)>
+      RecordFn;
+  typedef std::function<void(const Frame &frame)> FrameReadyFn;
+  /** Create the offscreen renderer
+   *  @param ctx The graphics context
+   *  @param graphics The graphics interface
+   *  @param w The frame width
+   *  @param h The frame height
+   *  @param numFrames The number of frames in flight
+   *  @param enableDepthStencil Add a depth stencil attachment
+   */
+  static OffscreenRenderer *create(GraphicsContext *ctx, Graphics *graphics,
+                                   uint32_t w, uint32_t h,
+                                   uint32_t numFrames = 3,
+                                   bool enableDepthStencil = false);
+  /** Destroy the offscreen renderer. Waits for the frames in flight */
+  virtual ~OffscreenRenderer() {}
+  /** Record and submit the next frame.
+   *  If the frame's slot is still in use, the previous frame in that slot
+   *  is waited for and passed to onFrameReady first.
+   *  @param record The function that records the draw commands
+   */
+  virtual void renderFrame(RecordFn record) = 0;
+  /** Wait for all the frames in flight and pass them to onFrameReady,
+   *  in order */
+  virtual void flush() = 0;
+  /** Called with the pixels of each frame, in order */
+  FrameReadyFn onFrameReady;
+  /** The render pass of the frames, with a depth stencil attachment if
+   *  enableDepthStencil is set. Pipelines used to draw the frames must be
+   *  compatible with it */
+  RenderPass *renderPass = nullptr;
+  uint32_t w = 0, h = 0, numFrames = 0;
+  /** The index of the next frame */
+  uint64_t frameIndex = 0;
+};
+} // namespace ngfx
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#pragma once
+#include "ngfx/graphics/GraphicsCore.h"
+#include <cstdint>
+
+namespace ngfx {
+/** The block compression family of a pixel format */
+enum PixelFormatCompression {
+  PIXELFORMAT_COMPRESSION_NONE,
+  PIXELFORMAT_COMPRESSION_BC,
+  PIXELFORMAT_COMPRESSION_ETC2,
+  PIXELFORMAT_COMPRESSION_ASTC
+};
+struct PixelFormatUtil {
+  /** The layout of a pixel format.
+   *  An uncompressed format has 1x1 blocks */
+  struct FormatInfo {
+    PixelFormat format;
+    /** The Vulkan format, as stored in the KTX2 files */
+    uint32_t vkFormat;
+    uint32_t blockWidth, blockHeight, blockSize;
+    PixelFormatCompression compression;
+    bool srgb;
+  };
+  /** Get the layout of a format, or nullptr if the format is unknown */
+  static const FormatInfo *getFormatInfo(PixelFormat format);
+  static const FormatInfo *getFormatInfoFromVkFormat(uint32_t vkFormat);
+  static bool isCompressed(PixelFormat format);
+  /** Get the format the compressed textures are decoded to
+   *  when the device doesn't support them: RGBA8, UNORM or SRGB */
+  static PixelFormat getDecodedFormat(PixelFormat format);
+  /** Get the size of an image (in bytes).
+   *  It's an error if the size doesn't fit in 32 bits
+   *  @param format The format. It must be known
+   *  @param w The width, in pixels
+   *  @param h The height, in pixels
+   *  @param d The depth
+   *  @param arrayLayers The number of array layers
+   */
+  static uint32_t getImageSize(PixelFormat format, uint32_t w, uint32_t h,
+                               uint32_t d = 1, uint32_t arrayLayers = 1);
+  /** Get the size of a row of blocks (in bytes) */
+  static uint32_t getRowPitch(PixelFormat format, uint32_t w);
+  /** Get the size of a mip level, with all the array layers */
+  static uint32_t getLevelSize(PixelFormat format, uint32_t w, uint32_t h,
+                               uint32_t d, uint32_t arrayLayers,
+                               uint32_t level);
+  /** Get the number of levels of a full mipmap chain, down to 1x1x1 */
+  static uint32_t getMaxMipLevels(uint32_t w, uint32_t h, uint32_t d = 1);
+};
+} // namespace ngfx
@@ -32,5 +32,15 @@ public:
   virtual void present() = 0;
   virtual void submit(CommandBuffer *commandBuffer) = 0;
   virtual void waitIdle() = 0;
+  /** Get the ticket of the last completed submission, without blocking */
+  virtual uint64_t completedTicket() { return lastTicket; }
+  /** Check if the submission with the given ticket has completed */
+  bool isComplete(uint64_t ticket) { return ticket <= completedTicket(); }
+  /** Wait until the submission with the given ticket has completed */
+  virtual void wait(uint64_t ticket) { waitIdle(); }
+  /** The ticket of the last submission.
+   *  Each submission gets the next ticket, and the ticket of a command
+   *  buffer's last submission is stored in CommandBuffer::ticket */
+  uint64_t lastTicket = 0;
 };
 } // namespace ngfx
\ No newline at end of file
@@ -0,0 +1,51 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#pragma once
+#include <cfloat>
+#include <glm/glm.hpp>
+using namespace glm;
+
+namespace ngfx {
+/** A ray, with the range of the parameter t of the points
+ *  origin + t * dir that are considered by the queries */
+struct Ray {
+  Ray() {}
+  Ray(const vec3 &origin, const vec3 &dir, float tMin = 0.0f,
+      float tMax = FLT_MAX)
+      : origin(origin), dir(dir), tMin(tMin), tMax(tMax) {}
+  /** Create a picking ray through a point of the viewport.
+   *  The depth range of the projection is [0, 1], and the ray goes from
+   *  the near plane to the far plane, so it works with perspective and
+   *  orthographic projections.
+   *  @param ndc The point in normalized device coordinates, in [-1, 1]
+   *  @param viewProjMat The view projection matrix
+   */
+  static Ray fromNDC(const vec2 &ndc, const mat4 &viewProjMat) {
+    mat4 invViewProjMat = inverse(viewProjMat);
+    vec4 p0 = invViewProjMat * vec4(ndc, 0.0f, 1.0f),
+         p1 = invViewProjMat * vec4(ndc, 1.0f, 1.0f);
+    vec3 origin = vec3(p0) / p0.w, dir = vec3(p1) / p1.w - origin;
+    return Ray(origin, normalize(dir));
+  }
+  vec3 origin = vec3(0.0f), dir = vec3(0.0f, 0.0f, -1.0f);
+  float tMin = 0.0f, tMax = FLT_MAX;
+};
+} // namespace ngfx
@@ -36,6 +36,9 @@ public:
     std::string name;
     uint32_t set;
     DescriptorType type;
+    /** True if the descriptor is an unsized array, that's bound to the
+     *  bindless descriptor heap */
+    bool bindless = false;
   };
   typedef std::vector<DescriptorInfo> DescriptorInfos;
   DescriptorInfos descriptors;
@@ -70,6 +73,14 @@ public:
     return &it->second;
   }
   BufferInfos uniformBufferInfos, shaderStorageBufferInfos;
+  /** The push constant block, the set index is unused */
+  BufferInfos pushConstantInfos;
+  /** The byte range of the push constant block.
+   *  The size is 0 if the shader doesn't use push constants */
+  struct PushConstantRange {
+    uint32_t offset = 0, size = 0;
+  };
+  PushConstantRange pushConstantRange;
   void initBindings(std::ifstream &in, ShaderStageFlags shaderStages);
   void initBindings(const std::string &filename, ShaderStageFlags shaderStages);
 };
@@ -93,6 +104,15 @@ public:
     }
     return nullptr;
   }
+  /** Override the format of a vertex attribute.
+   *  The reflected format only depends on the shader input type, e.g. a vec4
+   *  input can also be fetched from a quantized vertex buffer
+   *  (VERTEXFORMAT_USHORT4_NORM, VERTEXFORMAT_HALF4, ...).
+   *  It must be called before the graphics pipeline is created.
+   *  @param name The attribute name
+   *  @param format The vertex format of the attribute's vertex buffer
+   */
+  void setAttributeFormat(const std::string &name, VertexFormat format);
   void initBindings(const std::string &filename);
 };
 class FragmentShaderModule : public ShaderModule {
@@ -28,6 +28,12 @@ class Graphics;
 class GraphicsContext;
 class Texture {
 public:
+  /** Create a texture from an image file.
+   *  The KTX2 files (.ktx2) are uploaded with their format and their
+   *  mip levels. If the device doesn't support the compressed format, the
+   *  levels are decoded to RGBA8. genMipmaps only applies to the files
+   *  with a single level
+   */
   static Texture *
   create(GraphicsContext *graphicsContext, Graphics *graphics,
          const char *filename,
@@ -38,6 +44,12 @@ public:
          FilterMode minFilter = FILTER_NEAREST,
          FilterMode magFilter = FILTER_NEAREST,
          FilterMode mipFilter = FILTER_NEAREST, uint32_t numSamples = 1);
+  /** Create a texture.
+   *  @param mipLevels The number of precomputed mip levels in the data,
+   *  from the largest to the smallest, when genMipmaps is false.
+   *  The levels are uploaded with a single copy. A later upload of the
+   *  whole texture also contains all the levels
+   */
   static Texture *
   create(GraphicsContext *graphicsContext, Graphics *graphics, void *data,
          PixelFormat format, uint32_t size, uint32_t w, uint32_t h, uint32_t d,
@@ -48,15 +60,22 @@ public:
          TextureType textureType = TEXTURE_TYPE_2D, bool genMipmaps = false,
          FilterMode minFilter = FILTER_NEAREST,
          FilterMode magFilter = FILTER_NEAREST,
-         FilterMode mipFilter = FILTER_NEAREST, uint32_t numSamples = 1);
+         FilterMode mipFilter = FILTER_NEAREST, uint32_t numSamples = 1,
+         uint32_t mipLevels = 1);
+  /** Return true if the device can sample a texture with this format,
+   *  e.g. a block compressed format */
+  static bool isFormatSupported(GraphicsContext *graphicsContext,
+                                PixelFormat format);
   virtual ~Texture() {}
   virtual void upload(void *data, uint32_t size, uint32_t x = 0, uint32_t y = 0,
                       uint32_t z = 0, int32_t w = -1, int32_t h = -1,
                       int32_t d = -1, int32_t arrayLayers = -1) = 0;
+  /** Download a region of a mip level of the texture.
+   *  The default width, height and depth are the size of the level */
   virtual void download(void *data, uint32_t size, uint32_t x = 0,
                         uint32_t y = 0, uint32_t z = 0, int32_t w = -1,
                         int32_t h = -1, int32_t d = -1,
-                        int32_t arrayLayers = -1) = 0;
+                        int32_t arrayLayers = -1, uint32_t level = 0) = 0;
   virtual void changeLayout(CommandBuffer *commandBuffer,
                             ImageLayout imageLayout) = 0;
   virtual void generateMipmaps(CommandBuffer *commandBuffer) = 0;
@@ -64,5 +83,10 @@ public:
   uint32_t w = 0, h = 0, d = 1, arrayLayers = 1, mipLevels = 1, numSamples = 1;
   ImageUsageFlags imageUsageFlags;
   TextureType textureType;
+  /** The filter used by generateMipmaps.
+   *  The compute filters require a texture created with
+   *  IMAGE_USAGE_STORAGE_BIT, they fall back to MIPMAP_FILTER_BLIT if it
+   *  wasn't or if the texture format isn't supported as a storage image */
+  MipmapFilter mipmapFilter = MIPMAP_FILTER_BLIT;
 };
 } // namespace ngfx
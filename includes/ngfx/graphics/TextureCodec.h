@@ -0,0 +1,68 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#pragma once
+#include "ngfx/graphics/GraphicsCore.h"
+#include <cstdint>
+
+/** \class TextureCodec
+ *
+ *  Encode and decode the block compressed formats on the CPU.
+ *  The decoders are the fallback when the device doesn't support a format,
+ *  and the encoders build the KTX2 files offline (see ktxTool).
+ *  The supported formats are BC1 (RGBA), BC3, BC4, BC5, and ETC2 RGB8 and
+ *  RGBA8 (with EAC alpha). BC7 and ASTC are only decoded by the devices.
+ *  The BC encoders fit the endpoints to the principal axis of the block,
+ *  and the ETC2 encoder searches the ETC1 compatible modes, so they favor
+ *  simplicity and speed over the quality of the best offline compressors.
+ *  The images are processed in parallel, by rows of blocks.
+ */
+
+namespace ngfx {
+class TextureCodec {
+public:
+  /** Return true if the format can be encoded and decoded */
+  static bool isSupported(PixelFormat format);
+  /** Decode an image to RGBA8
+   *  @param format The compressed format
+   *  @param data The blocks, row by row
+   *  @param w The width, in pixels
+   *  @param h The height, in pixels
+   *  @param rgba The decoded pixels (w * h * 4 bytes)
+   *  @param numThreads The number of threads. If 0, the number of hardware
+   *  threads is used
+   */
+  static void decode(PixelFormat format, const uint8_t *data, uint32_t w,
+                     uint32_t h, uint8_t *rgba, uint32_t numThreads = 0);
+  /** Encode an RGBA8 image.
+   *  The partial blocks at the right and bottom edges repeat the last
+   *  column and row
+   *  @param format The compressed format
+   *  @param rgba The pixels (w * h * 4 bytes)
+   *  @param w The width, in pixels
+   *  @param h The height, in pixels
+   *  @param data The blocks, row by row
+   *  @param numThreads The number of threads. If 0, the number of hardware
+   *  threads is used
+   */
+  static void encode(PixelFormat format, const uint8_t *rgba, uint32_t w,
+                     uint32_t h, uint8_t *data, uint32_t numThreads = 0);
+};
+} // namespace ngfx
@@ -54,7 +54,8 @@ enum BufferUsageFlagBits {
   BUFFER_USAGE_UNIFORM_BUFFER_BIT = 4,
   BUFFER_USAGE_STORAGE_BUFFER_BIT = 8,
   BUFFER_USAGE_VERTEX_BUFFER_BIT = 16,
-  BUFFER_USAGE_INDEX_BUFFER_BIT = 32
+  BUFFER_USAGE_INDEX_BUFFER_BIT = 32,
+  BUFFER_USAGE_INDIRECT_BUFFER_BIT = 64
 };
 enum BlendOp {
   BLEND_OP_ADD = D3D12_BLEND_OP_ADD,
@@ -119,9 +120,25 @@ enum PixelFormat {
   DEFINE_PIXELFORMATS(32, UINT, UINT),
   DEFINE_PIXELFORMATS(32, SFLOAT, FLOAT),
   PIXELFORMAT_BGRA8_UNORM = DXGI_FORMAT_B8G8R8A8_UNORM,
+  PIXELFORMAT_RGBA8_SRGB = DXGI_FORMAT_R8G8B8A8_UNORM_SRGB,
   PIXELFORMAT_D16_UNORM = DXGI_FORMAT_D16_UNORM,
   PIXELFORMAT_D24_UNORM = DXGI_FORMAT_D24_UNORM_S8_UINT,
-  PIXELFORMAT_D24_UNORM_S8 = DXGI_FORMAT_D24_UNORM_S8_UINT
+  PIXELFORMAT_D24_UNORM_S8 = DXGI_FORMAT_D24_UNORM_S8_UINT,
+  PIXELFORMAT_BC1_RGBA_UNORM = DXGI_FORMAT_BC1_UNORM,
+  PIXELFORMAT_BC1_RGBA_SRGB = DXGI_FORMAT_BC1_UNORM_SRGB,
+  PIXELFORMAT_BC3_UNORM = DXGI_FORMAT_BC3_UNORM,
+  PIXELFORMAT_BC3_SRGB = DXGI_FORMAT_BC3_UNORM_SRGB,
+  PIXELFORMAT_BC4_UNORM = DXGI_FORMAT_BC4_UNORM,
+  PIXELFORMAT_BC5_UNORM = DXGI_FORMAT_BC5_UNORM,
+  PIXELFORMAT_BC7_UNORM = DXGI_FORMAT_BC7_UNORM,
+  PIXELFORMAT_BC7_SRGB = DXGI_FORMAT_BC7_UNORM_SRGB,
+  // DXGI doesn't have the ETC2 and ASTC formats, they are never supported
+  PIXELFORMAT_ETC2_RGB8_UNORM = 0x10000,
+  PIXELFORMAT_ETC2_RGB8_SRGB,
+  PIXELFORMAT_ETC2_RGBA8_UNORM,
+  PIXELFORMAT_ETC2_RGBA8_SRGB,
+  PIXELFORMAT_ASTC_4X4_UNORM,
+  PIXELFORMAT_ASTC_4X4_SRGB
 };
 
 enum IndexFormat {
@@ -135,7 +152,18 @@ enum IndexFormat {
   VERTEXFORMAT_##t0##3 = DXGI_FORMAT_R##s##G##s##B##s##_##t1,                  \
   VERTEXFORMAT_##t0##4 = DXGI_FORMAT_R##s##G##s##B##s##A##s##_##t1
 
-enum VertexFormat { DEFINE_VERTEXFORMATS(32, FLOAT, FLOAT) };
+enum VertexFormat {
+  DEFINE_VERTEXFORMATS(32, FLOAT, FLOAT),
+  VERTEXFORMAT_HALF2 = DXGI_FORMAT_R16G16_FLOAT,
+  VERTEXFORMAT_HALF4 = DXGI_FORMAT_R16G16B16A16_FLOAT,
+  VERTEXFORMAT_SHORT2_NORM = DXGI_FORMAT_R16G16_SNORM,
+  VERTEXFORMAT_SHORT4_NORM = DXGI_FORMAT_R16G16B16A16_SNORM,
+  VERTEXFORMAT_USHORT4_NORM = DXGI_FORMAT_R16G16B16A16_UNORM,
+  VERTEXFORMAT_CHAR2_NORM = DXGI_FORMAT_R8G8_SNORM,
+  VERTEXFORMAT_CHAR4_NORM = DXGI_FORMAT_R8G8B8A8_SNORM,
+  VERTEXFORMAT_UINT1010102_NORM = DXGI_FORMAT_R10G10B10A2_UNORM,
+  VERTEXFORMAT_UINT = DXGI_FORMAT_R32_UINT
+};
 
 enum DescriptorType {
   DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
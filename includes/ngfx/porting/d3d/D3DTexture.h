@@ -39,13 +39,13 @@ public:
               uint32_t arrayLayers, DXGI_FORMAT format,
               ImageUsageFlags usageFlags, TextureType textureType,
               bool genMipmaps, uint32_t numSamples,
-              const D3DSamplerDesc &samplerDesc);
+              const D3DSamplerDesc &samplerDesc, uint32_t mipLevels = 1);
   void upload(void *data, uint32_t size, uint32_t x = 0, uint32_t y = 0,
               uint32_t z = 0, int32_t w = -1, int32_t h = -1, int32_t d = -1,
               int32_t arrayLayers = -1) override;
   void download(void *data, uint32_t size, uint32_t x = 0, uint32_t y = 0,
                 uint32_t z = 0, int32_t w = -1, int32_t h = -1, int32_t d = -1,
-                int32_t arrayLayers = -1) override;
+                int32_t arrayLayers = -1, uint32_t level = 0) override;
   void changeLayout(CommandBuffer *commandBuffer,
                     ImageLayout imageLayout) override;
   void
@@ -74,16 +74,21 @@ public:
   };
   std::vector<SrvData> srvDescriptorCache;
   D3D12_RESOURCE_DESC resourceDesc;
+  bool genMipmaps = false;
 
 private:
   void downloadFn(D3DCommandList *cmdList, D3DReadbackBuffer &readbackBuffer,
                   D3D12_BOX &srcRegion,
-                  D3D12_PLACED_SUBRESOURCE_FOOTPRINT &dstFootprint);
+                  D3D12_PLACED_SUBRESOURCE_FOOTPRINT &dstFootprint,
+                  uint32_t level);
   void uploadFn(D3DCommandList *cmdList, void *data, uint32_t size,
                 D3DBuffer *stagingBuffer, uint32_t x = 0, uint32_t y = 0,
                 uint32_t z = 0, int32_t w = -1, int32_t h = -1, int32_t d = -1,
                 int32_t arrayLayers = -1);
   void generateMipmapsFn(D3DCommandList *cmdList);
+  /** Get the number of levels in the data of an upload */
+  uint32_t getNumUploadLevels(uint32_t x, uint32_t y, uint32_t z, int32_t w,
+                              int32_t h, int32_t d, int32_t arrayLayers);
   D3DGraphicsContext *ctx;
   D3DGraphics *graphics;
   uint32_t size;
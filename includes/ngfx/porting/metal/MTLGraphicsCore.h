@@ -63,7 +63,8 @@ enum BufferUsageFlagBits {
   BUFFER_USAGE_UNIFORM_BUFFER_BIT,
   BUFFER_USAGE_STORAGE_BUFFER_BIT,
   BUFFER_USAGE_VERTEX_BUFFER_BIT,
-  BUFFER_USAGE_INDEX_BUFFER_BIT
+  BUFFER_USAGE_INDEX_BUFFER_BIT,
+  BUFFER_USAGE_INDIRECT_BUFFER_BIT
 };
 enum ColorComponentFlagBits {
   COLOR_COMPONENT_R_BIT = MTLColorWriteMaskRed,
@@ -128,9 +129,24 @@ enum PixelFormat {
   DEFINE_PIXELFORMATS(32, UINT, Uint),
   DEFINE_PIXELFORMATS(32, SFLOAT, Float),
   PIXELFORMAT_BGRA8_UNORM = MTLPixelFormatBGRA8Unorm,
+  PIXELFORMAT_RGBA8_SRGB = MTLPixelFormatRGBA8Unorm_sRGB,
   PIXELFORMAT_D16_UNORM = MTLPixelFormatDepth16Unorm,
   PIXELFORMAT_D24_UNORM = MTLPixelFormatDepth24Unorm_Stencil8,
-  PIXELFORMAT_D24_UNORM_S8 = MTLPixelFormatDepth24Unorm_Stencil8
+  PIXELFORMAT_D24_UNORM_S8 = MTLPixelFormatDepth24Unorm_Stencil8,
+  PIXELFORMAT_BC1_RGBA_UNORM = MTLPixelFormatBC1_RGBA,
+  PIXELFORMAT_BC1_RGBA_SRGB = MTLPixelFormatBC1_RGBA_sRGB,
+  PIXELFORMAT_BC3_UNORM = MTLPixelFormatBC3_RGBA,
+  PIXELFORMAT_BC3_SRGB = MTLPixelFormatBC3_RGBA_sRGB,
+  PIXELFORMAT_BC4_UNORM = MTLPixelFormatBC4_RUnorm,
+  PIXELFORMAT_BC5_UNORM = MTLPixelFormatBC5_RGUnorm,
+  PIXELFORMAT_BC7_UNORM = MTLPixelFormatBC7_RGBAUnorm,
+  PIXELFORMAT_BC7_SRGB = MTLPixelFormatBC7_RGBAUnorm_sRGB,
+  PIXELFORMAT_ETC2_RGB8_UNORM = MTLPixelFormatETC2_RGB8,
+  PIXELFORMAT_ETC2_RGB8_SRGB = MTLPixelFormatETC2_RGB8_sRGB,
+  PIXELFORMAT_ETC2_RGBA8_UNORM = MTLPixelFormatEAC_RGBA8,
+  PIXELFORMAT_ETC2_RGBA8_SRGB = MTLPixelFormatEAC_RGBA8_sRGB,
+  PIXELFORMAT_ASTC_4X4_UNORM = MTLPixelFormatASTC_4x4_LDR,
+  PIXELFORMAT_ASTC_4X4_SRGB = MTLPixelFormatASTC_4x4_sRGB
 };
 
 enum IndexFormat {
@@ -144,7 +160,18 @@ enum IndexFormat {
   VERTEXFORMAT_##t0##3 = MTLVertexFormat##t1##3,                               \
   VERTEXFORMAT_##t0##4 = MTLVertexFormat##t1##4
 
-enum VertexFormat { DEFINE_VERTEXFORMATS(FLOAT, Float) };
+enum VertexFormat {
+  DEFINE_VERTEXFORMATS(FLOAT, Float),
+  VERTEXFORMAT_HALF2 = MTLVertexFormatHalf2,
+  VERTEXFORMAT_HALF4 = MTLVertexFormatHalf4,
+  VERTEXFORMAT_SHORT2_NORM = MTLVertexFormatShort2Normalized,
+  VERTEXFORMAT_SHORT4_NORM = MTLVertexFormatShort4Normalized,
+  VERTEXFORMAT_USHORT4_NORM = MTLVertexFormatUShort4Normalized,
+  VERTEXFORMAT_CHAR2_NORM = MTLVertexFormatChar2Normalized,
+  VERTEXFORMAT_CHAR4_NORM = MTLVertexFormatChar4Normalized,
+  VERTEXFORMAT_UINT1010102_NORM = MTLVertexFormatUInt1010102Normalized,
+  VERTEXFORMAT_UINT = MTLVertexFormatUInt
+};
 
 enum DescriptorType {
   DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
@@ -32,14 +32,15 @@ public:
               uint32_t size, uint32_t w, uint32_t h, uint32_t d,
               uint32_t arrayLayers, MTLTextureUsage textureUsage,
               ::MTLTextureType textureType, bool genMipmaps,
-              MTLSamplerDescriptor *samplerDescriptor, uint32_t numSamples);
+              MTLSamplerDescriptor *samplerDescriptor, uint32_t numSamples,
+              uint32_t mipLevels = 1);
   virtual ~MTLTexture();
   void upload(void *data, uint32_t size, uint32_t x = 0, uint32_t y = 0,
               uint32_t z = 0, int32_t w = -1, int32_t h = -1, int32_t d = -1,
               int32_t arrayLayers = -1) override;
   void download(void *data, uint32_t size, uint32_t x = 0, uint32_t y = 0,
                 uint32_t z = 0, int32_t w = -1, int32_t h = -1, int32_t d = -1,
-                int32_t arrayLayers = -1) override;
+                int32_t arrayLayers = -1, uint32_t level = 0) override;
   void changeLayout(CommandBuffer *commandBuffer,
                     ImageLayout imageLayout) override {}
   void generateMipmaps(CommandBuffer *commandBuffer) override;
@@ -47,6 +48,7 @@ public:
   id<MTLTexture> v;
   id<MTLSamplerState> mtlSamplerState;
   bool depthTexture = false, stencilTexture = false;
+  bool genMipmaps = false;
 
 private:
   void generateMipmapsFn(id<MTLCommandBuffer> mtlCommandBuffer);
@@ -24,12 +24,14 @@
 #include "ngfx/porting/metal/MTLCommandBuffer.h"
 #include "ngfx/porting/metal/MTLRenderCommandEncoder.h"
 #include "ngfx/core/DebugUtil.h"
+#include "ngfx/graphics/PixelFormatUtil.h"
 using namespace ngfx;
 
 void MTLTexture::create(MTLGraphicsContext *ctx, void* data, ::MTLPixelFormat format, uint32_t size,
         uint32_t w, uint32_t h, uint32_t d, uint32_t arrayLayers,
         MTLTextureUsage textureUsage, ::MTLTextureType textureType,
-        bool genMipmaps, MTLSamplerDescriptor* samplerDescriptor, uint32_t numSamples) {
+        bool genMipmaps, MTLSamplerDescriptor* samplerDescriptor, uint32_t numSamples,
+        uint32_t mipLevels) {
     this->ctx = ctx;
     this->w = w; this->h = h; this->d = d; this->arrayLayers = arrayLayers;
     this->textureType = ngfx::TextureType(textureType);
@@ -52,8 +54,9 @@ void MTLTexture::create(MTLGraphicsContext *ctx, void* data, ::MTLPixelFormat fo
     else if (numSamples > 1 && textureType == ::MTLTextureType2DArray)
     textureDescriptor.textureType = ::MTLTextureType2DMultisampleArray;
     else textureDescriptor.textureType = textureType;
-    mipLevels = genMipmaps ? floor(log2(float(glm::min(w, h)))) + 1 : 1;
-    textureDescriptor.mipmapLevelCount =  mipLevels;
+    this->mipLevels = genMipmaps ? floor(log2(float(glm::min(w, h)))) + 1 : mipLevels;
+    this->genMipmaps = genMipmaps;
+    textureDescriptor.mipmapLevelCount = this->mipLevels;
     
     const std::vector<MTLPixelFormat> depthFormats = {
         MTLPixelFormatDepth16Unorm, MTLPixelFormatDepth24Unorm_Stencil8,
@@ -86,23 +89,38 @@ void MTLTexture::upload(void* data, uint32_t size, uint32_t x, uint32_t y, uint3
     if (h == -1) h = this->h;
     if (d == -1) d = this->d;
     if (arrayLayers == -1) arrayLayers = this->arrayLayers;
-    NSUInteger bytesPerRow = size / (h * d * arrayLayers);
-    NSUInteger bytesPerImage;
-    if (MTLTextureType(textureType) == MTLTextureType3D) bytesPerImage = size / d;
-    else if (MTLTextureType(textureType) == MTLTextureTypeCube) bytesPerImage = size / arrayLayers;
-    else bytesPerImage = 0;
-    MTLRegion region = MTLRegionMake3D(x, y, z, w, h, d);
+    // An upload of the whole texture contains the precomputed mip levels,
+    // from the largest to the smallest
+    bool wholeTexture = x == 0 && y == 0 && z == 0 && uint32_t(w) == this->w &&
+        uint32_t(h) == this->h && uint32_t(d) == this->d &&
+        uint32_t(arrayLayers) == this->arrayLayers;
+    uint32_t numLevels = (wholeTexture && !genMipmaps) ? mipLevels : 1;
+    auto formatInfo = PixelFormatUtil::getFormatInfo(format);
     uint8_t* srcData = (uint8_t*)data;
-    for (uint32_t slice = 0; slice < arrayLayers; slice++) {
-        [v replaceRegion:region
-            mipmapLevel:0
-              slice:slice
-              withBytes: srcData
-            bytesPerRow:bytesPerRow
-            bytesPerImage:bytesPerImage];
-        srcData += bytesPerImage;
+    for (uint32_t level = 0; level < numLevels; level++) {
+        uint32_t levelW = std::max(uint32_t(w) >> level, 1u),
+                 levelH = std::max(uint32_t(h) >> level, 1u),
+                 levelD = std::max(uint32_t(d) >> level, 1u);
+        // The layout of the formats that aren't described by PixelFormatUtil,
+        // e.g. the depth formats, is derived from the size
+        NSUInteger bytesPerRow = formatInfo ? PixelFormatUtil::getRowPitch(format, levelW)
+                                            : size / (h * d * arrayLayers);
+        NSUInteger numRows = formatInfo ?
+            (levelH + formatInfo->blockHeight - 1) / formatInfo->blockHeight : levelH;
+        NSUInteger bytesPerImage =
+            (MTLTextureType(textureType) == MTLTextureType3D) ? bytesPerRow * numRows : 0;
+        MTLRegion region = MTLRegionMake3D(x, y, z, levelW, levelH, levelD);
+        for (uint32_t slice = 0; slice < arrayLayers; slice++) {
+            [v replaceRegion:region
+                mipmapLevel:level
+                  slice:slice
+                  withBytes: srcData
+                bytesPerRow:bytesPerRow
+                bytesPerImage:bytesPerImage];
+            srcData += bytesPerRow * numRows * levelD;
+        }
     }
-    if (mipLevels != 1) {
+    if (genMipmaps && mipLevels != 1) {
         auto mtlCommandBuffer = [ctx->mtlCommandQueue commandBuffer];
         generateMipmapsFn(mtlCommandBuffer);
         [mtlCommandBuffer commit];
@@ -121,24 +139,25 @@ void MTLTexture::generateMipmapsFn(id<MTLCommandBuffer> mtlCommandBuffer) {
 }
 
 void MTLTexture::download(void* data, uint32_t size, uint32_t x, uint32_t y, uint32_t z,
-          int32_t w, int32_t h, int32_t d, int32_t arrayLayers) {
+          int32_t w, int32_t h, int32_t d, int32_t arrayLayers, uint32_t level) {
     const bool flipY = false; //TODO:move to param
-    if (w == -1) w = this->w;
-    if (h == -1) h = this->h;
-    if (d == -1) d = this->d;
+    uint32_t levelH = std::max(this->h >> level, 1u);
+    if (w == -1) w = std::max(this->w >> level, 1u);
+    if (h == -1) h = levelH;
+    if (d == -1) d = std::max(this->d >> level, 1u);
     
     id<MTLCommandBuffer> mtlCommandBuffer = [ctx->mtlCommandQueue commandBuffer];
     id <MTLBlitCommandEncoder> blitCommandEncoder = [mtlCommandBuffer blitCommandEncoder];
-    [blitCommandEncoder synchronizeTexture:v slice:0 level:0];
+    [blitCommandEncoder synchronizeTexture:v slice:0 level:level];
     [blitCommandEncoder endEncoding];
     [mtlCommandBuffer commit];
     [mtlCommandBuffer waitUntilCompleted];
     
     NSUInteger bytesPerRow = 4 * w;
     if (flipY) {
-        MTLRegion region = { { x, this->h - y - h, z }, { NSUInteger(w), NSUInteger(h), 1 } };
-        [v getBytes:data bytesPerRow: bytesPerRow fromRegion: region mipmapLevel: 0];
-        uint8_t *srcData = (uint8_t *)data, *dstData = &((uint8_t *)data)[(this->h-1) * bytesPerRow];
+        MTLRegion region = { { x, levelH - y - h, z }, { NSUInteger(w), NSUInteger(h), 1 } };
+        [v getBytes:data bytesPerRow: bytesPerRow fromRegion: region mipmapLevel: level];
+        uint8_t *srcData = (uint8_t *)data, *dstData = &((uint8_t *)data)[(levelH-1) * bytesPerRow];
         std::vector<uint8_t> tmpData(bytesPerRow);
         for (uint32_t y = 0; y < (h / 2); y++) {
             if (srcData == dstData) break;
@@ -151,14 +170,14 @@ void MTLTexture::download(void* data, uint32_t size, uint32_t x, uint32_t y, uin
     }
     else {
         MTLRegion region = { { x, y, z }, { NSUInteger(w), NSUInteger(h), 1 } };
-        [v getBytes:data bytesPerRow: bytesPerRow fromRegion: region mipmapLevel: 0];
+        [v getBytes:data bytesPerRow: bytesPerRow fromRegion: region mipmapLevel: level];
     }
 }
 
 Texture* Texture::create(GraphicsContext* ctx, Graphics* graphics, void* data, PixelFormat format, uint32_t size,
          uint32_t w, uint32_t h, uint32_t d, uint32_t arrayLayers, ImageUsageFlags imageUsageFlags,
          TextureType textureType, bool genMipmaps, FilterMode minFilter, FilterMode magFilter, FilterMode mipFilter,
-         uint32_t numSamples) {
+         uint32_t numSamples, uint32_t mipLevels) {
     MTLTexture* mtlTexture = new MTLTexture();
     MTLTextureUsage textureUsage = 0;
     if (imageUsageFlags & IMAGE_USAGE_SAMPLED_BIT) textureUsage |= MTLTextureUsageShaderRead;
@@ -169,7 +188,21 @@ Texture* Texture::create(GraphicsContext* ctx, Graphics* graphics, void* data, P
     mtlSamplerDescriptor.magFilter = ::MTLSamplerMinMagFilter(magFilter);
     mtlSamplerDescriptor.mipFilter = (mipFilter == FILTER_NEAREST) ? MTLSamplerMipFilterNearest : MTLSamplerMipFilterLinear;
     mtlTexture->create(mtl(ctx), data, ::MTLPixelFormat(format), size, w, h, d, arrayLayers,
-       textureUsage, ::MTLTextureType(textureType), genMipmaps, mtlSamplerDescriptor, numSamples);
+       textureUsage, ::MTLTextureType(textureType), genMipmaps, mtlSamplerDescriptor, numSamples,
+       mipLevels);
     [mtlSamplerDescriptor release];
     return mtlTexture;
 }
+
+bool Texture::isFormatSupported(GraphicsContext* ctx, PixelFormat format) {
+    auto formatInfo = PixelFormatUtil::getFormatInfo(format);
+    if (!formatInfo || formatInfo->compression == PIXELFORMAT_COMPRESSION_NONE) return true;
+    auto device = mtl(ctx)->mtlDevice.v;
+    if (formatInfo->compression == PIXELFORMAT_COMPRESSION_BC) {
+        if (@available(macOS 11.0, iOS 16.4, *)) return [device supportsBCTextureCompression];
+        return TARGET_OS_OSX;
+    }
+    // ETC2 and ASTC are supported by the Apple GPUs
+    if (@available(macOS 10.15, iOS 13.0, *)) return [device supportsFamily:MTLGPUFamilyApple2];
+    return false;
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#pragma once
+#include "ngfx/compute/AsyncCompute.h"
+#include "ngfx/porting/vulkan/VKBuffer.h"
+#include "ngfx/porting/vulkan/VKCommandBuffer.h"
+#include "ngfx/porting/vulkan/VKFence.h"
+#include "ngfx/porting/vulkan/VKSemaphore.h"
+#include "ngfx/porting/vulkan/VKTexture.h"
+#include <vector>
+
+namespace ngfx {
+class VKGraphicsContext;
+class VKAsyncCompute : public AsyncCompute {
+public:
+  void create(VKGraphicsContext *ctx, Graphics *graphics,
+              bool enableDedicatedQueue);
+  virtual ~VKAsyncCompute();
+  void addSharedBuffer(Buffer *buffer) override;
+  void addSharedTexture(Texture *texture) override;
+  void submit(RecordFn record) override;
+  void join(CommandBuffer *commandBuffer) override;
+  void release(CommandBuffer *commandBuffer) override;
+  void wait() override;
+  /** The access state of the shared resources on one of the queues */
+  struct QueueState {
+    uint32_t queueFamilyIndex;
+    VkPipelineStageFlags stageMask;
+    VkAccessFlags bufferAccessMask, imageAccessMask;
+    VkImageLayout imageLayout;
+  };
+  VKCommandBuffer commandBuffer;
+  VKFence fence;
+  VKSemaphore computeCompleteSemaphore, graphicsCompleteSemaphore;
+
+protected:
+  /** Record the barriers that transfer the shared resources from src to dst.
+   *  With a dedicated compute queue, the transfer is split into a release
+   *  barrier on the source queue and an acquire barrier on the destination
+   *  queue. Otherwise a single barrier is recorded on the acquire side */
+  void transfer(VkCommandBuffer cmdBuffer, const QueueState &src,
+                const QueueState &dst, bool acquire);
+  VKGraphicsContext *ctx = nullptr;
+  Graphics *graphics = nullptr;
+  QueueState computeState, graphicsState;
+  std::vector<VKBuffer *> sharedBuffers;
+  std::vector<VKTexture *> sharedTextures;
+  uint64_t numSubmissions = 0;
+};
+} // namespace ngfx
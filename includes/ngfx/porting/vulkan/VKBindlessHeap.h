@@ -0,0 +1,91 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#pragma once
+#include "ngfx/graphics/BindlessHeap.h"
+#include <deque>
+#include <map>
+#include <set>
+#include <vulkan/vulkan.h>
+
+namespace ngfx {
+class VKGraphicsContext;
+
+class VKBindlessHeap : public BindlessHeap {
+public:
+  /** Create the heap. The capacities are clamped to the device limits.
+   *  The storage arrays have no capacity if the device can't update
+   *  them after they're bound */
+  void create(VKGraphicsContext *ctx, uint32_t maxTextures = 4096,
+              uint32_t maxStorageImages = 1024,
+              uint32_t maxStorageBuffers = 1024);
+  virtual ~VKBindlessHeap();
+  uint32_t addTexture(Texture *texture) override;
+  uint32_t addStorageImage(Texture *texture) override;
+  uint32_t addStorageBuffer(Buffer *buffer) override;
+  void remove(DescriptorType type, uint32_t index) override;
+  void bind(CommandBuffer *commandBuffer, Graphics *graphics,
+            DescriptorType type, uint32_t set) override;
+  uint32_t capacity(DescriptorType type) override;
+  /** Get the layout of an array, used to create the pipeline layouts */
+  VkDescriptorSetLayout getDescriptorSetLayout(VkDescriptorType type);
+  /** Called by the queues when a command buffer is submitted, to track
+   *  the submissions that may access the heap */
+  void onSubmit(CommandBuffer *commandBuffer, Queue *queue, uint64_t ticket);
+
+private:
+  /** A removed index */
+  struct FreeIndex {
+    uint32_t index;
+    /** The last submission on each queue that may access the index */
+    std::map<Queue *, uint64_t> tickets;
+    /** The command buffers that bound the heap before the index was
+     *  removed, and that haven't been submitted since */
+    std::set<CommandBuffer *> pendingCommandBuffers;
+  };
+  struct DescriptorArray {
+    VkDescriptorType type;
+    VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+    VkDescriptorSet set = VK_NULL_HANDLE;
+    uint32_t capacity = 0, size = 0;
+    /** The removed indices, in the order of removal */
+    std::deque<FreeIndex> freeList;
+  };
+  bool isComplete(const FreeIndex &freeIndex);
+  DescriptorArray &getArray(VkDescriptorType type);
+  /** Get an array, and fail if the device doesn't support it */
+  DescriptorArray &getCreatedArray(VkDescriptorType type);
+  void createArray(DescriptorArray &array, VkDescriptorType type,
+                   uint32_t capacity);
+  uint32_t allocate(DescriptorArray &array);
+  void write(DescriptorArray &array, uint32_t index,
+             const VkDescriptorImageInfo *imageInfo,
+             const VkDescriptorBufferInfo *bufferInfo);
+  VKGraphicsContext *ctx = nullptr;
+  VkDevice device = VK_NULL_HANDLE;
+  VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+  DescriptorArray textures, storageImages, storageBuffers;
+  /** The command buffers whose recording binds the heap, and the ones
+   *  among them that haven't been submitted since they bound it */
+  std::set<CommandBuffer *> boundCommandBuffers, recordedCommandBuffers;
+  /** The ticket of the last submission that binds the heap, on each queue */
+  std::map<Queue *, uint64_t> lastTickets;
+};
+} // namespace ngfx
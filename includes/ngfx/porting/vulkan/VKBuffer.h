@@ -47,6 +47,29 @@ public:
   const VkDescriptorSet &
   getSsboDescriptorSet(ShaderStageFlags shaderStageFlags);
   VkDescriptorSet uboDescriptorSet = 0, ssboDescriptorSet = 0;
+  /** Update the tracked access state for a new access to this buffer.
+   *  Returns true and fills in the barrier (and its source stage mask) when
+   *  the new access has to be ordered against the previous ones:
+   *  a read from a stage that the last write isn't visible to yet,
+   *  or a write after reads or writes. */
+  bool updateAccess(VkAccessFlags dstAccessMask,
+                    VkPipelineStageFlags dstStageMask,
+                    VkBufferMemoryBarrier &bufferMemoryBarrier,
+                    VkPipelineStageFlags &srcStageMask);
+  void barrier(VkCommandBuffer commandBuffer, VkAccessFlags dstAccessMask,
+               VkPipelineStageFlags dstStageMask);
+  /** Reset the tracked state after an external barrier, e.g. a queue
+   *  ownership transfer, which made the previous writes visible to these
+   *  accesses */
+  void setAccess(VkAccessFlags accessMask, VkPipelineStageFlags stageMask);
+  /** The last write */
+  VkAccessFlags writeAccessMask = 0;
+  VkPipelineStageFlags writeStageMask = 0;
+  /** The stages that read the buffer since the last write */
+  VkPipelineStageFlags readStageMask = 0;
+  /** The accesses and stages that the last write is visible to */
+  VkAccessFlags visibleAccessMask = 0;
+  VkPipelineStageFlags visibleStageMask = 0;
 
 protected:
   void createBuffer(const void *data, uint32_t size,
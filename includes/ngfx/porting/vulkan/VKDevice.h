@@ -39,11 +39,20 @@ public:
     uint32_t transfer;
   } queueFamilyIndices;
   VkDevice v = VK_NULL_HANDLE;
-  bool enableDebugMarkers = false;
+  bool enableDebugMarkers = false, enableMaintenance2 = false,
+       enableTimelineSemaphore = false, enableDescriptorIndexing = false;
+  /** VK_KHR_timeline_semaphore entry points, only set if
+   *  enableTimelineSemaphore is true */
+  PFN_vkGetSemaphoreCounterValueKHR getSemaphoreCounterValue = nullptr;
+  PFN_vkWaitSemaphoresKHR waitSemaphores = nullptr;
+  PFN_vkSignalSemaphoreKHR signalSemaphore = nullptr;
   std::vector<std::string> deviceExtensions;
   VKPhysicalDevice *vkPhysicalDevice;
   VkDeviceCreateInfo createInfo;
   std::vector<const char *> enabledDeviceExtensions;
+  VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timelineSemaphoreFeatures;
+  VkPhysicalDeviceDescriptorIndexingFeaturesEXT descriptorIndexingFeatures;
+  VkPhysicalDeviceFeatures enabledFeatures;
 
 private:
   uint32_t getQueueFamilyIndex(VkQueueFlags queueFlags);
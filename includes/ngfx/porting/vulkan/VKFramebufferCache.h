@@ -0,0 +1,109 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#pragma once
+#include "ngfx/graphics/CommandBuffer.h"
+#include "ngfx/graphics/Framebuffer.h"
+#include "ngfx/graphics/GraphicsContext.h"
+#include "ngfx/graphics/Queue.h"
+#include <functional>
+#include <list>
+#include <memory>
+#include <set>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace ngfx {
+/** \class VKFramebufferCache
+ *
+ *  A cache of framebuffers, indexed by the render pass, the attachment
+ *  image views and the framebuffer size.
+ *  When the cache is full, the least recently used framebuffers that
+ *  are no longer used by the GPU are evicted: a framebuffer is in use
+ *  until the submissions of the command buffers that begin a render pass
+ *  with it are complete.
+ *  Framebuffers that reference an image view are evicted when the
+ *  image view is destroyed, so a recycled handle never matches a stale
+ *  entry.
+ */
+class VKFramebufferCache {
+public:
+  typedef std::function<Framebuffer *()> CreateFn;
+  /** Create the cache
+   *  @param stats The cache statistics
+   *  @param capacity The number of framebuffers kept by the cache
+   */
+  void create(GraphicsContext::CacheStats *stats, uint32_t capacity = 256);
+  /** Get a framebuffer, or create it with createFn on a cache miss */
+  std::shared_ptr<Framebuffer> get(VkRenderPass renderPass,
+                                   const std::vector<VkImageView> &imageViews,
+                                   uint32_t w, uint32_t h, uint32_t layers,
+                                   CreateFn createFn);
+  /** Called when a render pass begins, to track the command buffers that
+   *  use a cached framebuffer */
+  void use(CommandBuffer *commandBuffer, Framebuffer *framebuffer);
+  /** Called by the queues when a command buffer is submitted */
+  void onSubmit(CommandBuffer *commandBuffer, Queue *queue, uint64_t ticket);
+  /** Evict the framebuffers that reference the image view */
+  void evict(VkImageView imageView);
+  /** Evict all the framebuffers */
+  void clear();
+  uint32_t size() const { return uint32_t(entries.size()); }
+
+private:
+  struct Key {
+    bool operator==(const Key &rhs) const {
+      return rhs.renderPass == renderPass && rhs.imageViews == imageViews &&
+             rhs.w == w && rhs.h == h && rhs.layers == layers;
+    }
+    VkRenderPass renderPass;
+    std::vector<VkImageView> imageViews;
+    uint32_t w, h, layers;
+  };
+  struct KeyHash {
+    size_t operator()(const Key &key) const;
+  };
+  struct Entry {
+    Key key;
+    std::shared_ptr<Framebuffer> framebuffer;
+    /** The last submission that uses the framebuffer */
+    Queue *queue = nullptr;
+    uint64_t ticket = 0;
+    /** The command buffers recorded with the framebuffer, and the ones
+     *  among them that haven't been submitted since */
+    std::set<CommandBuffer *> commandBuffers, pendingCommandBuffers;
+  };
+  typedef std::list<Entry>::iterator EntryIterator;
+  bool isInUse(const Entry &entry);
+  void erase(EntryIterator it);
+  void trim();
+  /** The entries, ordered from the most to the least recently used */
+  std::list<Entry> entries;
+  std::unordered_map<Key, EntryIterator, KeyHash> index;
+  std::unordered_multimap<VkImageView, EntryIterator> imageViewIndex;
+  std::unordered_map<Framebuffer *, EntryIterator> framebufferIndex;
+  /** The cached framebuffers used by each command buffer */
+  std::unordered_map<CommandBuffer *, std::set<Framebuffer *>>
+      commandBufferFramebuffers;
+  GraphicsContext::CacheStats *stats = nullptr;
+  uint32_t capacity = 256;
+};
+} // namespace ngfx
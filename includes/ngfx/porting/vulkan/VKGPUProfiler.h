@@ -0,0 +1,46 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#pragma once
+#include "ngfx/graphics/GPUProfiler.h"
+#include "ngfx/porting/vulkan/VKQueryPool.h"
+#include "ngfx/porting/vulkan/VKUtil.h"
+#include <memory>
+#include <vector>
+
+namespace ngfx {
+class VKGraphicsContext;
+class VKGPUProfiler : public GPUProfiler {
+public:
+  void create(VKGraphicsContext *ctx, uint32_t numFrames, uint32_t maxRegions);
+  virtual ~VKGPUProfiler() {}
+  std::vector<std::unique_ptr<VKQueryPool>> vkQueryPools;
+
+protected:
+  void resetQueries(CommandBuffer *commandBuffer, uint32_t frameSlot) override;
+  void writeTimestamp(CommandBuffer *commandBuffer, uint32_t frameSlot,
+                      uint32_t query, bool begin) override;
+  void getTimestamps(uint32_t frameSlot, uint32_t numQueries,
+                     std::vector<uint64_t> &timestamps,
+                     std::vector<bool> &available) override;
+  VkDevice device = VK_NULL_HANDLE;
+};
+VK_CAST(GPUProfiler);
+} // namespace ngfx
@@ -21,8 +21,12 @@
 #pragma once
 #include "ngfx/graphics/Graphics.h"
 #include "ngfx/porting/vulkan/VKUtil.h"
+#include <map>
+#include <vulkan/vulkan.h>
 
 namespace ngfx {
+class VKBuffer;
+
 class VKGraphics : public Graphics {
 public:
   void create() {}
@@ -36,9 +40,14 @@ public:
                        uint32_t clearStencil = 0) override;
   void endRenderPass(CommandBuffer *commandBuffer) override;
   void beginProfile(CommandBuffer *commandBuffer) override;
-  uint64_t endProfile(CommandBuffer *commandBuffer) override;
+  void endProfile(CommandBuffer *commandBuffer) override;
+  uint64_t getProfileResult() override;
   void bindVertexBuffer(CommandBuffer *commandBuffer, Buffer *buffer,
                         uint32_t location, uint32_t stride) override;
+  void bindVertexBuffers(CommandBuffer *commandBuffer,
+                         const std::vector<Buffer *> &buffers,
+                         const std::vector<uint32_t> &bindings,
+                         const std::vector<uint32_t> &strides) override;
   void bindIndexBuffer(CommandBuffer *commandBuffer, Buffer *buffer,
                        IndexFormat indexFormat) override;
   void bindUniformBuffer(CommandBuffer *commandBuffer, Buffer *buffer,
@@ -53,6 +62,8 @@ public:
                             GraphicsPipeline *graphicsPipeline) override;
   void bindTexture(CommandBuffer *commandBuffer, Texture *texture,
                    uint32_t set) override;
+  void pushConstants(CommandBuffer *commandBuffer, const void *data,
+                     uint32_t size, uint32_t offset = 0) override;
   void dispatch(CommandBuffer *cmdBuffer, uint32_t groupCountX,
                 uint32_t groupCountY, uint32_t groupCountZ,
                 uint32_t threadsPerGroupX, uint32_t threadsPerGroupY,
@@ -64,9 +75,48 @@ public:
                    uint32_t instanceCount = 1, uint32_t firstIndex = 0,
                    int32_t vertexOffset = 0,
                    uint32_t firstInstance = 0) override;
+  void drawIndirect(CommandBuffer *cmdBuffer, Buffer *buffer,
+                    uint32_t offset = 0, uint32_t drawCount = 1,
+                    uint32_t stride = sizeof(DrawIndirectCommand)) override;
+  void drawIndexedIndirect(
+      CommandBuffer *cmdBuffer, Buffer *buffer, uint32_t offset = 0,
+      uint32_t drawCount = 1,
+      uint32_t stride = sizeof(DrawIndexedIndirectCommand)) override;
+  void dispatchIndirect(CommandBuffer *cmdBuffer, Buffer *buffer,
+                        uint32_t offset, uint32_t threadsPerGroupX,
+                        uint32_t threadsPerGroupY,
+                        uint32_t threadsPerGroupZ) override;
   void setViewport(CommandBuffer *cmdBuffer, Rect2D rect) override;
   void setScissor(CommandBuffer *cmdBuffer, Rect2D rect) override;
   void waitIdle(CommandBuffer *cmdBuffer) override;
+
+protected:
+  /** Track an access to a buffer bound to the graphics pipeline.
+   *  Pipeline barriers can't be recorded inside a render pass, so
+   *  hazards against compute writes are resolved when the render pass begins.
+   *  Any other barrier needed inside a render pass is an error.
+   */
+  void bindGraphicsBuffer(CommandBuffer *commandBuffer, VKBuffer *buffer,
+                          VkAccessFlags accessMask,
+                          VkPipelineStageFlags stageMask);
+  /** Record the barriers for the buffers bound to the compute pipeline,
+   *  and for the indirect buffer if set */
+  void computeBarriers(CommandBuffer *commandBuffer,
+                       VKBuffer *indirectBuffer = nullptr);
+  struct BufferAccess {
+    VKBuffer *buffer;
+    VkAccessFlags accessMask;
+    VkPipelineStageFlags stageMask;
+  };
+  /** Buffers bound to the current compute pipeline, indexed by set.
+   *  The barriers are recorded when the next dispatch is recorded */
+  std::map<uint32_t, BufferAccess> computeBufferBindings;
+  bool computeWritesPending = false;
+  /** Read back the result of the last profile, if it completed */
+  void readProfileResult();
+  /** The duration of the last completed profile, in nanoseconds */
+  uint64_t profileResult = 0;
+  bool profileQueriesReset = false;
 };
 VK_CAST(Graphics);
 } // namespace ngfx
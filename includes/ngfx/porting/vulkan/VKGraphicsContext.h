@@ -21,6 +21,7 @@
 #pragma once
 #include "ngfx/graphics/GraphicsContext.h"
 #include "ngfx/graphics/Window.h"
+#include "ngfx/porting/vulkan/VKBindlessHeap.h"
 #include "ngfx/porting/vulkan/VKCommandBuffer.h"
 #include "ngfx/porting/vulkan/VKCommandPool.h"
 #include "ngfx/porting/vulkan/VKDebugMessenger.h"
@@ -29,8 +30,10 @@
 #include "ngfx/porting/vulkan/VKDevice.h"
 #include "ngfx/porting/vulkan/VKFence.h"
 #include "ngfx/porting/vulkan/VKFramebuffer.h"
+#include "ngfx/porting/vulkan/VKFramebufferCache.h"
 #include "ngfx/porting/vulkan/VKImage.h"
 #include "ngfx/porting/vulkan/VKInstance.h"
+#include "ngfx/porting/vulkan/VKMipmapGenerator.h"
 #include "ngfx/porting/vulkan/VKPhysicalDevice.h"
 #include "ngfx/porting/vulkan/VKPipelineCache.h"
 #include "ngfx/porting/vulkan/VKQueue.h"
@@ -38,6 +41,7 @@
 #include "ngfx/porting/vulkan/VKSemaphore.h"
 #include "ngfx/porting/vulkan/VKSwapchain.h"
 #include "ngfx/porting/vulkan/VKQueryPool.h"
+#include <unordered_map>
 //#define ENABLE_DEPTH_STENCIL
 
 namespace ngfx {
@@ -53,8 +57,10 @@ public:
   VKInstance vkInstance;
   VKPhysicalDevice vkPhysicalDevice;
   VKDevice vkDevice;
-  VKCommandPool vkCommandPool;
-  VKQueue vkQueue;
+  VKCommandPool vkCommandPool, vkComputeCommandPool;
+  VKQueue vkQueue, vkComputeQueue;
+  /** True if vkComputeQueue belongs to a dedicated compute queue family */
+  bool dedicatedComputeQueue = false;
   std::unique_ptr<VKSwapchain> vkSwapchain;
   std::vector<VKCommandBuffer> vkDrawCommandBuffers;
   VKCommandBuffer vkCopyCommandBuffer, vkComputeCommandBuffer;
@@ -66,7 +72,14 @@ public:
     VKRenderPass vkRenderPass;
   };
   RenderPass *getRenderPass(RenderPassConfig config) override;
-  std::vector<std::unique_ptr<VKRenderPassData>> vkRenderPassCache;
+  std::unordered_map<RenderPassConfig, std::unique_ptr<VKRenderPassData>,
+                     RenderPassConfig::Hash>
+      vkRenderPassCache;
+  std::shared_ptr<Framebuffer>
+  getFramebuffer(RenderPass *renderPass,
+                 const std::vector<Framebuffer::Attachment> &attachments,
+                 uint32_t w, uint32_t h, uint32_t layers = 1) override;
+  VKFramebufferCache vkFramebufferCache;
   VKRenderPass *vkDefaultRenderPass = nullptr,
                *vkDefaultOffscreenRenderPass = nullptr;
   VKPipelineCache vkPipelineCache;
@@ -84,6 +97,8 @@ public:
   VKImageCreateInfo msDepthImageCreateInfo;
   VKDebugMessenger vkDebugMessenger;
   VKQueryPool vkQueryPool;
+  std::unique_ptr<VKMipmapGenerator> vkMipmapGenerator;
+  std::unique_ptr<VKBindlessHeap> vkBindlessHeap;
 
 private:
   void initDescriptorPool();
@@ -66,7 +66,8 @@ enum BufferUsageFlagBits {
   VK(BUFFER_USAGE_UNIFORM_BUFFER_BIT),
   VK(BUFFER_USAGE_STORAGE_BUFFER_BIT),
   VK(BUFFER_USAGE_VERTEX_BUFFER_BIT),
-  VK(BUFFER_USAGE_INDEX_BUFFER_BIT)
+  VK(BUFFER_USAGE_INDEX_BUFFER_BIT),
+  VK(BUFFER_USAGE_INDIRECT_BUFFER_BIT)
 };
 enum ColorComponentFlagBits {
   VK(COLOR_COMPONENT_R_BIT),
@@ -129,9 +130,24 @@ enum PixelFormat {
   DEFINE_PIXELFORMATS(32, UINT, UINT),
   DEFINE_PIXELFORMATS(32, SFLOAT, SFLOAT),
   PIXELFORMAT_BGRA8_UNORM = VK_FORMAT_B8G8R8A8_UNORM,
+  PIXELFORMAT_RGBA8_SRGB = VK_FORMAT_R8G8B8A8_SRGB,
   PIXELFORMAT_D16_UNORM = VK_FORMAT_D16_UNORM,
   PIXELFORMAT_D24_UNORM = VK_FORMAT_X8_D24_UNORM_PACK32,
-  PIXELFORMAT_D24_UNORM_S8 = VK_FORMAT_D24_UNORM_S8_UINT
+  PIXELFORMAT_D24_UNORM_S8 = VK_FORMAT_D24_UNORM_S8_UINT,
+  PIXELFORMAT_BC1_RGBA_UNORM = VK_FORMAT_BC1_RGBA_UNORM_BLOCK,
+  PIXELFORMAT_BC1_RGBA_SRGB = VK_FORMAT_BC1_RGBA_SRGB_BLOCK,
+  PIXELFORMAT_BC3_UNORM = VK_FORMAT_BC3_UNORM_BLOCK,
+  PIXELFORMAT_BC3_SRGB = VK_FORMAT_BC3_SRGB_BLOCK,
+  PIXELFORMAT_BC4_UNORM = VK_FORMAT_BC4_UNORM_BLOCK,
+  PIXELFORMAT_BC5_UNORM = VK_FORMAT_BC5_UNORM_BLOCK,
+  PIXELFORMAT_BC7_UNORM = VK_FORMAT_BC7_UNORM_BLOCK,
+  PIXELFORMAT_BC7_SRGB = VK_FORMAT_BC7_SRGB_BLOCK,
+  PIXELFORMAT_ETC2_RGB8_UNORM = VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK,
+  PIXELFORMAT_ETC2_RGB8_SRGB = VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK,
+  PIXELFORMAT_ETC2_RGBA8_UNORM = VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK,
+  PIXELFORMAT_ETC2_RGBA8_SRGB = VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK,
+  PIXELFORMAT_ASTC_4X4_UNORM = VK_FORMAT_ASTC_4x4_UNORM_BLOCK,
+  PIXELFORMAT_ASTC_4X4_SRGB = VK_FORMAT_ASTC_4x4_SRGB_BLOCK
 };
 
 enum IndexFormat {
@@ -145,7 +161,18 @@ enum IndexFormat {
   VERTEXFORMAT_##t0##3 = VK_FORMAT_R##s##G##s##B##s##_##t1,                    \
   VERTEXFORMAT_##t0##4 = VK_FORMAT_R##s##G##s##B##s##A##s##_##t1
 
-enum VertexFormat { DEFINE_VERTEXFORMATS(32, FLOAT, SFLOAT) };
+enum VertexFormat {
+  DEFINE_VERTEXFORMATS(32, FLOAT, SFLOAT),
+  VERTEXFORMAT_HALF2 = VK_FORMAT_R16G16_SFLOAT,
+  VERTEXFORMAT_HALF4 = VK_FORMAT_R16G16B16A16_SFLOAT,
+  VERTEXFORMAT_SHORT2_NORM = VK_FORMAT_R16G16_SNORM,
+  VERTEXFORMAT_SHORT4_NORM = VK_FORMAT_R16G16B16A16_SNORM,
+  VERTEXFORMAT_USHORT4_NORM = VK_FORMAT_R16G16B16A16_UNORM,
+  VERTEXFORMAT_CHAR2_NORM = VK_FORMAT_R8G8_SNORM,
+  VERTEXFORMAT_CHAR4_NORM = VK_FORMAT_R8G8B8A8_SNORM,
+  VERTEXFORMAT_UINT1010102_NORM = VK_FORMAT_A2B10G10R10_UNORM_PACK32,
+  VERTEXFORMAT_UINT = VK_FORMAT_R32_UINT
+};
 
 enum DescriptorType {
   VK(DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER),
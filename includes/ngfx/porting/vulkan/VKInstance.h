@@ -30,12 +30,17 @@ public:
               bool enableValidation);
   virtual ~VKInstance();
   bool hasInstanceLayer(const char *name);
+  bool hasInstanceExtension(const char *name);
   struct {
     bool enableValidation = false;
   } settings;
   std::vector<const char *> instanceExtensions;
   std::vector<const char *> instanceLayers;
   std::vector<VkLayerProperties> instanceLayerProperties;
+  std::vector<VkExtensionProperties> instanceExtensionProperties;
+  /** True if VK_KHR_get_physical_device_properties2 is enabled.
+   *  It's required to query the features of device extensions */
+  bool enablePhysicalDeviceProperties2 = false;
   VkInstance v = VK_NULL_HANDLE;
   VkInstanceCreateInfo createInfo;
   VkApplicationInfo appInfo;
@@ -0,0 +1,80 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#pragma once
+#include "ngfx/graphics/GraphicsCore.h"
+#include "ngfx/porting/vulkan/VKShaderModule.h"
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace ngfx {
+class VKDevice;
+class VKGraphicsContext;
+class VKTexture;
+
+/** \class VKMipmapGenerator
+ *
+ *  Generates the mip chain of a texture with a compute shader.
+ *  Each dispatch downsamples up to MAX_LEVELS_PER_DISPATCH levels,
+ *  using workgroup shared memory for the intermediate levels, so a
+ *  4096x4096 texture only needs three dispatches instead of twelve
+ *  blits.
+ *  The descriptor sets are allocated from the generator's own pools,
+ *  and freed when the texture is destroyed.
+ */
+class VKMipmapGenerator {
+public:
+  enum {
+    MAX_LEVELS_PER_DISPATCH = 5,
+    TILE_SIZE = 16,
+    MAX_DESCRIPTOR_SETS_PER_POOL = 64
+  };
+  /** A descriptor set, with the pool it was allocated from */
+  struct DescriptorSet {
+    VkDescriptorPool pool;
+    VkDescriptorSet v;
+  };
+  void create(VKGraphicsContext *ctx);
+  virtual ~VKMipmapGenerator();
+  /** Returns true if the mipmaps of a texture with the given format
+   *  can be generated with the compute path.
+   *  sRGB textures are accessed through a UNORM view and
+   *  converted in the shader, this requires VK_KHR_maintenance2 */
+  static bool isFormatSupported(VKDevice *device, VkFormat format);
+  void generateMipmaps(VkCommandBuffer cmdBuffer, VKTexture *texture,
+                       MipmapFilter filter);
+  /** Free the descriptor sets of a texture */
+  void freeDescriptorSets(VKTexture *texture);
+  VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+  VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+  VkPipeline pipeline = VK_NULL_HANDLE;
+
+private:
+  VkDescriptorSet getDescriptorSet(VKTexture *texture, uint32_t srcLevel);
+  DescriptorSet allocateDescriptorSet();
+  struct PushConstants {
+    int32_t numLevels, filter, srgb, padding;
+  };
+  VKGraphicsContext *ctx;
+  VkDevice device;
+  VKShaderModule shaderModule;
+  std::vector<VkDescriptorPool> descriptorPools;
+};
+} // namespace ngfx
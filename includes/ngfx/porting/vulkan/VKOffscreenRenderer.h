@@ -0,0 +1,58 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#pragma once
+#include "ngfx/graphics/Framebuffer.h"
+#include "ngfx/graphics/OffscreenRenderer.h"
+#include "ngfx/graphics/Texture.h"
+#include "ngfx/porting/vulkan/VKBuffer.h"
+#include "ngfx/porting/vulkan/VKCommandBuffer.h"
+#include "ngfx/porting/vulkan/VKFence.h"
+#include <memory>
+#include <vector>
+
+namespace ngfx {
+class VKGraphicsContext;
+class VKOffscreenRenderer : public OffscreenRenderer {
+public:
+  void create(VKGraphicsContext *ctx, Graphics *graphics, uint32_t w,
+              uint32_t h, uint32_t numFrames, bool enableDepthStencil);
+  virtual ~VKOffscreenRenderer();
+  void renderFrame(RecordFn record) override;
+  void flush() override;
+  struct Slot {
+    std::unique_ptr<Texture> outputTexture, depthTexture;
+    std::unique_ptr<Framebuffer> outputFramebuffer;
+    VKCommandBuffer commandBuffer;
+    VKFence fence;
+    VKBuffer readbackBuffer;
+    void *readbackData = nullptr;
+    uint64_t frameIndex = 0;
+    bool pending = false;
+  };
+  std::vector<std::unique_ptr<Slot>> slots;
+
+protected:
+  void readback(Slot &slot);
+  VKGraphicsContext *ctx = nullptr;
+  Graphics *graphics = nullptr;
+  uint32_t size = 0;
+};
+} // namespace ngfx
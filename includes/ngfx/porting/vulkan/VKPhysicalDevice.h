@@ -37,10 +37,20 @@ public:
   std::vector<VkQueueFamilyProperties> queueFamilyProperties;
   std::vector<std::string> supportedExtensions;
   VkFormat depthFormat;
+  /** The descriptor indexing features and limits, and the timeline
+   *  semaphore features.
+   *  They're only queried if VK_KHR_get_physical_device_properties2
+   *  is enabled, otherwise they're all zero */
+  VkPhysicalDeviceDescriptorIndexingFeaturesEXT descriptorIndexingFeatures =
+      {};
+  VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timelineSemaphoreFeatures = {};
+  VkPhysicalDeviceDescriptorIndexingPropertiesEXT
+      descriptorIndexingProperties = {};
 
 private:
   void chooseDepthFormat();
   void selectDevice(VkInstance instance);
   void getProperties();
+  void getExtendedProperties(VkInstance instance);
 };
 }; // namespace ngfx
@@ -22,12 +22,16 @@
 #include "ngfx/porting/vulkan/VKShaderModule.h"
 
 namespace ngfx {
+class VKGraphicsContext;
+
 class VKPipeline {
 public:
   virtual ~VKPipeline();
   struct Descriptor {
     VkDescriptorType type;
     VkShaderStageFlags stageFlags = 0;
+    /** True if the set is bound to the bindless descriptor heap */
+    bool bindless = false;
   };
   struct ShaderStage {
     VkShaderStageFlagBits stage;
@@ -35,12 +39,27 @@ public:
   };
   VkPipeline v = VK_NULL_HANDLE;
   VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+  /** The descriptor of each set of the pipeline layout */
+  std::vector<Descriptor> descriptors;
+  /** The push constant range shared by all the shader stages.
+   *  The size is 0 if the pipeline doesn't use push constants */
+  VkPushConstantRange pushConstantRange = {0, 0, 0};
 
 protected:
   VkDevice device;
 };
 
 struct VKPipelineUtil {
+  /** Get the descriptor set layouts of the pipeline layout */
+  static void getDescriptorSetLayouts(
+      VKGraphicsContext *ctx,
+      const std::vector<VKPipeline::Descriptor> &descriptors,
+      std::vector<VkDescriptorSetLayout> &layouts);
+  /** Merge the push constant block of a shader stage into the
+   *  pipeline's push constant range */
+  static void addPushConstantRange(ShaderModule *shaderModule,
+                                   VkShaderStageFlagBits shaderStage,
+                                   VkPushConstantRange &range);
   static void
   parseDescriptors(std::vector<ShaderModule::DescriptorInfo> &descriptors,
                    VkShaderStageFlagBits shaderStage,
@@ -21,6 +21,7 @@
 #pragma once
 #include "ngfx/graphics/Queue.h"
 #include "ngfx/porting/vulkan/VKDevice.h"
+#include "ngfx/porting/vulkan/VKSemaphore.h"
 #include "ngfx/porting/vulkan/VKUtil.h"
 
 namespace ngfx {
@@ -31,15 +32,37 @@ public:
   virtual ~VKQueue();
   virtual void present();
   virtual void submit(CommandBuffer *commandBuffer);
-  void submit(CommandBuffer *commandBuffer, VkPipelineStageFlags waitStageMask,
-              const std::vector<Semaphore *> &waitSemaphores,
-              const std::vector<Semaphore *> &signalSemaphores,
-              Fence *waitFence);
+  /** Submit a command buffer. Returns the submission's ticket.
+   *  Timeline semaphores in waitSemaphores are waited on until they reach
+   *  their last signaled value (e.g. another queue's last submission) */
+  uint64_t submit(CommandBuffer *commandBuffer,
+                  VkPipelineStageFlags waitStageMask,
+                  const std::vector<Semaphore *> &waitSemaphores,
+                  const std::vector<Semaphore *> &signalSemaphores,
+                  Fence *waitFence);
+  uint64_t submit(CommandBuffer *commandBuffer,
+                  const std::vector<VkPipelineStageFlags> &waitStageMasks,
+                  const std::vector<Semaphore *> &waitSemaphores,
+                  const std::vector<Semaphore *> &signalSemaphores,
+                  Fence *waitFence);
   virtual void waitIdle();
+  uint64_t completedTicket() override;
+  void wait(uint64_t ticket) override;
   VkQueue v = VK_NULL_HANDLE;
+  /** Signaled with the ticket of each submission.
+   *  Only created if the device supports timeline semaphores, otherwise
+   *  waiting on a ticket waits for the queue to be idle */
+  VKSemaphore timelineSemaphore;
+  bool enableTimeline = false;
+  /** Semaphores waited on and signaled by the next submission of a draw
+   *  command buffer, used to join the frame with work submitted to
+   *  other queues. They are cleared after the submission */
+  std::vector<Semaphore *> frameWaitSemaphores, frameSignalSemaphores;
+  std::vector<VkPipelineStageFlags> frameWaitStageMasks;
 
 private:
   VKGraphicsContext *ctx;
+  uint64_t completedTicketValue = 0;
 };
 VK_CAST(Queue);
 } // namespace ngfx
\ No newline at end of file
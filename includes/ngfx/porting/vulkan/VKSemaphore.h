@@ -20,6 +20,7 @@
  */
 #pragma once
 #include "ngfx/graphics/Semaphore.h"
+#include "ngfx/porting/vulkan/VKDevice.h"
 #include "ngfx/porting/vulkan/VKUtil.h"
 #include <vulkan/vulkan.h>
 
@@ -27,14 +28,30 @@ namespace ngfx {
 class VKSemaphore : public Semaphore {
 public:
   void create(VkDevice device);
+  /** Create a timeline semaphore. Requires
+   *  VKDevice::enableTimelineSemaphore */
+  void createTimeline(VKDevice *vkDevice, uint64_t initialValue = 0);
   virtual ~VKSemaphore();
+  /** Wait until the timeline reaches the last signaled value.
+   *  Returns that value */
   virtual uint64_t wait();
+  /** Signal the timeline from the CPU */
   virtual void signal(uint64_t value = 1);
+  /** Wait until the timeline reaches value.
+   *  Returns false if the timeout (in ns) expired first */
+  bool wait(uint64_t value, uint64_t timeout);
+  /** Get the current timeline value, without blocking */
+  uint64_t getValue();
   VkSemaphore v = VK_NULL_HANDLE;
   VkSemaphoreCreateInfo createInfo;
+  VkSemaphoreTypeCreateInfoKHR typeCreateInfo;
+  VkSemaphoreTypeKHR type = VK_SEMAPHORE_TYPE_BINARY_KHR;
+  /** The last value signaled by the CPU or by a queue submission */
+  uint64_t signalValue = 0;
 
 private:
   VkDevice device;
+  VKDevice *vkDevice = nullptr;
 };
 VK_CAST(Semaphore);
 } // namespace ngfx
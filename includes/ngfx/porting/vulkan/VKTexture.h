@@ -25,6 +25,7 @@
 #include "ngfx/porting/vulkan/VKImage.h"
 #include "ngfx/porting/vulkan/VKImageView.h"
 #include "ngfx/porting/vulkan/VKSamplerCreateInfo.h"
+#include <map>
 
 namespace ngfx {
 class VKTexture : public Texture {
@@ -33,17 +34,23 @@ public:
               VkExtent3D extent, uint32_t arrayLayers, VkFormat format,
               VkImageUsageFlags imageUsageFlags, VkImageViewType imageViewType,
               bool genMipmaps, VKSamplerCreateInfo *pSamplerCreateInfo,
-              uint32_t numSamples = 1);
+              uint32_t numSamples = 1, uint32_t mipLevels = 1);
   virtual ~VKTexture();
   void upload(void *data, uint32_t size, uint32_t x = 0, uint32_t y = 0,
               uint32_t z = 0, int32_t w = -1, int32_t h = -1, int32_t d = -1,
               int32_t arrayLayers = -1) override;
   void download(void *data, uint32_t size, uint32_t x = 0, uint32_t y = 0,
                 uint32_t z = 0, int32_t w = -1, int32_t h = -1, int32_t d = -1,
-                int32_t arrayLayers = -1) override;
+                int32_t arrayLayers = -1, uint32_t level = 0) override;
   void changeLayout(CommandBuffer *commandBuffer,
                     ImageLayout imageLayout) override;
   void generateMipmaps(CommandBuffer *commandBuffer) override;
+  /** Record a copy of the texture to a buffer */
+  void downloadFn(VkCommandBuffer cmdBuffer, void *data, uint32_t size,
+                  VKBuffer *stagingBuffer, uint32_t x = 0, uint32_t y = 0,
+                  uint32_t z = 0, int32_t w = -1, int32_t h = -1,
+                  int32_t d = -1, int32_t arrayLayers = -1,
+                  uint32_t level = 0);
   VKImageView *getImageView(VkImageViewType imageViewType, uint32_t mipLevels,
                             uint32_t arrayLayers, uint32_t baseMipLevel = 0,
                             uint32_t baseArrayLayer = 0);
@@ -56,6 +63,11 @@ public:
   VkImageAspectFlags aspectFlags;
   bool depthTexture = false;
   bool genMipmaps = false;
+  /** True if the image supports compute based mipmap generation */
+  bool computeMipmaps = false;
+  std::vector<std::unique_ptr<VKImageView>> mipmapImageViews;
+  /** The descriptor sets of the mipmap generator, per source level */
+  std::map<uint32_t, VKMipmapGenerator::DescriptorSet> mipmapDescriptorSets;
   std::unique_ptr<VKSamplerCreateInfo> samplerCreateInfo;
 
 private:
@@ -66,10 +78,6 @@ private:
                 VKBuffer *stagingBuffer, uint32_t x = 0, uint32_t y = 0,
                 uint32_t z = 0, int32_t w = -1, int32_t h = -1, int32_t d = -1,
                 int32_t arrayLayers = -1);
-  void downloadFn(VkCommandBuffer cmdBuffer, void *data, uint32_t size,
-                  VKBuffer *stagingBuffer, uint32_t x = 0, uint32_t y = 0,
-                  uint32_t z = 0, int32_t w = -1, int32_t h = -1,
-                  int32_t d = -1, int32_t arrayLayers = -1);
   void generateMipmapsFn(VkCommandBuffer cmdBuffer);
   VKGraphicsContext *ctx;
 };
@@ -20,7 +20,7 @@
  */
 #include "ngfx/compute/ComputeApplication.h"
 #include "ngfx/core/DebugUtil.h"
-#include "ngfx/core/Timer.h"
+#include "ngfx/core/Trace.h"
 #include "ngfx/graphics/Graphics.h"
 #include <memory>
 using namespace ngfx;
@@ -43,6 +43,7 @@ void ComputeApplication::init() {
 }
 
 void ComputeApplication::recordCommandBuffer(CommandBuffer *commandBuffer) {
+  NGFX_TRACE_SCOPE("ComputeApplication::recordCommandBuffer");
   commandBuffer->begin();
   onRecordCommandBuffer(commandBuffer);
   commandBuffer->end();
@@ -61,10 +62,10 @@ void ComputeApplication::run() {
 void ComputeApplication::close() {}
 
 void ComputeApplication::doCompute(CommandBuffer *commandBuffer) {
-  Timer timer;
-  graphicsContext->submit(commandBuffer);
-  graphics->waitIdle(commandBuffer);
-  timer.update();
-  NGFX_LOG("compute elapsed: %f", timer.elapsed);
+  {
+    NGFX_TRACE_SCOPE("ComputeApplication::doCompute");
+    graphicsContext->submit(commandBuffer);
+    graphics->waitIdle(commandBuffer);
+  }
   onComputeFinished();
 }
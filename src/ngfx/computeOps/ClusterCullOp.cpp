@@ -0,0 +1,171 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "ngfx/computeOps/ClusterCullOp.h"
+#include "ngfx/core/DebugUtil.h"
+#include "ngfx/graphics/BufferUtil.h"
+#include "ngfx/graphics/Config.h"
+#include "ngfx/graphics/Frustum.h"
+#include "ngfx/graphics/GPUProfiler.h"
+#include "ngfx/graphics/ShaderModule.h"
+#include <cstring>
+using namespace ngfx;
+using namespace glm;
+
+ClusterCullOp::ClusterCullOp(GraphicsContext *ctx, const MeshData &meshData)
+    : ComputeOp(ctx) {
+  std::vector<uint32_t> indices(meshData.faces.size() * 3);
+  memcpy(indices.data(), meshData.faces.data(),
+         indices.size() * sizeof(uint32_t));
+  init(meshData.meshlets, meshData.lods, indices);
+}
+
+ClusterCullOp::ClusterCullOp(GraphicsContext *ctx,
+                             const QuantizedMeshData &meshData)
+    : ComputeOp(ctx) {
+  // The indices are widened to 32-bit, the shader doesn't read
+  // 16-bit values
+  std::vector<uint32_t> indices(meshData.numFaces * 3);
+  if (meshData.indexSize == 2) {
+    auto data = (const uint16_t *)meshData.indices.data();
+    for (uint32_t j = 0; j < indices.size(); j++)
+      indices[j] = data[j];
+  } else {
+    memcpy(indices.data(), meshData.indices.data(),
+           indices.size() * sizeof(uint32_t));
+  }
+  init(meshData.meshlets, meshData.lods, indices);
+}
+
+void ClusterCullOp::init(const std::vector<Meshlet> &meshlets,
+                         const std::vector<MeshLOD> &lods,
+                         const std::vector<uint32_t> &indices) {
+  if (meshlets.empty())
+    NGFX_ERR("the mesh has no meshlets");
+  // The meshlets are built in the order of the LODs
+  uint32_t maxFaces = 0;
+  if (lods.empty()) {
+    lodMeshlets.push_back(0);
+    maxFaces = uint32_t(indices.size() / 3);
+  } else {
+    uint32_t j = 0;
+    for (auto &lod : lods) {
+      while (j < meshlets.size() && meshlets[j].firstFace < lod.firstFace)
+        j++;
+      lodMeshlets.push_back(j);
+      maxFaces = glm::max(maxFaces, lod.numFaces);
+    }
+  }
+  lodMeshlets.push_back(uint32_t(meshlets.size()));
+  bMeshlets.reset(createStorageBuffer(
+      ctx, meshlets.data(), uint32_t(meshlets.size() * sizeof(Meshlet))));
+  bFaces.reset(createStorageBuffer(
+      ctx, indices.data(), uint32_t(indices.size() * sizeof(uint32_t))));
+  bIndices.reset(Buffer::create(
+      ctx, nullptr, maxFaces * 3 * sizeof(uint32_t),
+      BufferUsageFlags(BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                       BUFFER_USAGE_INDEX_BUFFER_BIT)));
+  bUbo.reset(createUniformBuffer(ctx, nullptr, sizeof(UboData)));
+  bDrawArgs.reset(
+      Buffer::create(ctx, nullptr, sizeof(DrawArgs),
+                     BufferUsageFlags(BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                      BUFFER_USAGE_INDIRECT_BUFFER_BIT)));
+  createPipelines();
+}
+
+void ClusterCullOp::apply(CommandBuffer *commandBuffer, Graphics *graphics) {
+  GPUProfiler::Scope profileScope(graphics, commandBuffer, "ClusterCullOp");
+  graphics->bindComputePipeline(commandBuffer, resetPipeline);
+  graphics->bindStorageBuffer(commandBuffer, bDrawArgs.get(),
+                              RESET_SSBO_DRAW_ARGS, SHADER_STAGE_COMPUTE_BIT);
+  graphics->dispatch(commandBuffer, 1, 1, 1, 1, 1, 1);
+  if (numMeshlets == 0)
+    return;
+  graphics->bindComputePipeline(commandBuffer, cullPipeline);
+  graphics->bindUniformBuffer(commandBuffer, bUbo.get(), U_UBO,
+                              SHADER_STAGE_COMPUTE_BIT);
+  graphics->bindStorageBuffer(commandBuffer, bMeshlets.get(), SSBO_MESHLETS,
+                              SHADER_STAGE_COMPUTE_BIT);
+  graphics->bindStorageBuffer(commandBuffer, bFaces.get(), SSBO_FACES,
+                              SHADER_STAGE_COMPUTE_BIT);
+  graphics->bindStorageBuffer(commandBuffer, bIndices.get(), SSBO_INDICES,
+                              SHADER_STAGE_COMPUTE_BIT);
+  graphics->bindStorageBuffer(commandBuffer, bDrawArgs.get(), SSBO_DRAW_ARGS,
+                              SHADER_STAGE_COMPUTE_BIT);
+  // One group per meshlet, the groups wrap around to the next row
+  // beyond the maximum group count
+  uint32_t numGroupsX = glm::min(numMeshlets, MAX_GROUPS_X),
+           numGroupsY = (numMeshlets + numGroupsX - 1) / numGroupsX;
+  graphics->dispatch(commandBuffer, numGroupsX, numGroupsY, 1,
+                     THREADS_PER_GROUP, 1, 1);
+}
+
+void ClusterCullOp::update(const mat4 &modelView, const mat4 &proj,
+                           uint32_t lod, bool backfaceCulling) {
+  if (lod + 1 >= lodMeshlets.size())
+    NGFX_ERR("invalid LOD: %u", lod);
+  firstMeshlet = lodMeshlets[lod];
+  numMeshlets = lodMeshlets[lod + 1] - firstMeshlet;
+  // The frustum planes are in model space
+  UboData uboData;
+  Frustum frustum(proj * modelView);
+  for (int j = 0; j < 6; j++)
+    uboData.frustumPlanes[j] = frustum.planes[j];
+  uboData.cameraPos = inverse(modelView)[3];
+  uboData.firstMeshlet = firstMeshlet;
+  uboData.numMeshlets = numMeshlets;
+  uboData.backfaceCulling = backfaceCulling ? 1 : 0;
+  uboData.padding = 0;
+  bUbo->upload(&uboData, sizeof(uboData));
+}
+
+ClusterCullOp::Stats ClusterCullOp::getStats() {
+  DrawArgs drawArgs;
+  bDrawArgs->download(&drawArgs, sizeof(drawArgs));
+  Stats stats;
+  stats.numMeshlets = numMeshlets;
+  stats.numFrustumCulled = drawArgs.numFrustumCulled;
+  stats.numBackfaceCulled = drawArgs.numBackfaceCulled;
+  stats.numVisible =
+      numMeshlets - stats.numFrustumCulled - stats.numBackfaceCulled;
+  stats.numVisibleFaces = drawArgs.command.indexCount / 3;
+  return stats;
+}
+
+void ClusterCullOp::createPipelines() {
+  const std::string cullKey = "clusterCullOp",
+                    resetKey = "resetClusterDrawArgsOp";
+  cullPipeline = (ComputePipeline *)ctx->pipelineCache->get(cullKey);
+  if (!cullPipeline) {
+    cullPipeline = ComputePipeline::create(
+        ctx, ComputeShaderModule::create(ctx->device,
+                                         NGFX_DATA_DIR "/clusterCull.comp")
+                 .get());
+    ctx->pipelineCache->add(cullKey, cullPipeline);
+  }
+  resetPipeline = (ComputePipeline *)ctx->pipelineCache->get(resetKey);
+  if (!resetPipeline) {
+    resetPipeline = ComputePipeline::create(
+        ctx, ComputeShaderModule::create(
+                 ctx->device, NGFX_DATA_DIR "/resetClusterDrawArgs.comp")
+                 .get());
+    ctx->pipelineCache->add(resetKey, resetPipeline);
+  }
+}
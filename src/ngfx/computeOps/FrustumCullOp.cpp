@@ -0,0 +1,117 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "ngfx/computeOps/FrustumCullOp.h"
+#include "ngfx/graphics/BufferUtil.h"
+#include "ngfx/graphics/Config.h"
+#include "ngfx/graphics/Frustum.h"
+#include "ngfx/graphics/GPUProfiler.h"
+#include "ngfx/graphics/ShaderModule.h"
+using namespace ngfx;
+using namespace glm;
+
+FrustumCullOp::FrustumCullOp(GraphicsContext *ctx, const MeshData &meshData)
+    : ComputeOp(ctx) {
+  auto &b = meshData.bounds;
+  boundingSphere = vec4(0.5f * (b[0] + b[1]), 0.5f * length(b[1] - b[0]));
+  indexCount = uint32_t(meshData.faces.size()) * 3;
+  bUbo.reset(createUniformBuffer(ctx, nullptr, sizeof(UboData)));
+  bDrawArgs.reset(Buffer::create(
+      ctx, nullptr, sizeof(DrawIndexedIndirectCommand),
+      BufferUsageFlags(BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                       BUFFER_USAGE_INDIRECT_BUFFER_BIT)));
+  createOutputBuffers(1);
+  createPipelines();
+}
+
+void FrustumCullOp::createOutputBuffers(uint32_t maxInstances) {
+  this->maxInstances = maxInstances;
+  BufferUsageFlags usageFlags = BufferUsageFlags(
+      BUFFER_USAGE_STORAGE_BUFFER_BIT | BUFFER_USAGE_VERTEX_BUFFER_BIT);
+  bVisibleModel.reset(
+      Buffer::create(ctx, nullptr, maxInstances * sizeof(mat4), usageFlags));
+  bVisibleColor.reset(
+      Buffer::create(ctx, nullptr, maxInstances * sizeof(vec4), usageFlags));
+}
+
+void FrustumCullOp::apply(CommandBuffer *commandBuffer, Graphics *graphics) {
+  GPUProfiler::Scope profileScope(graphics, commandBuffer, "FrustumCullOp");
+  graphics->bindComputePipeline(commandBuffer, resetPipeline);
+  graphics->bindStorageBuffer(commandBuffer, bDrawArgs.get(),
+                              RESET_SSBO_DRAW_ARGS, SHADER_STAGE_COMPUTE_BIT);
+  graphics->pushConstants(commandBuffer, &indexCount, sizeof(indexCount));
+  graphics->dispatch(commandBuffer, 1, 1, 1, 1, 1, 1);
+  if (numInstances == 0)
+    return;
+  graphics->bindComputePipeline(commandBuffer, cullPipeline);
+  graphics->bindUniformBuffer(commandBuffer, bUbo.get(), U_UBO,
+                              SHADER_STAGE_COMPUTE_BIT);
+  graphics->bindStorageBuffer(commandBuffer, bInstanceModel,
+                              SSBO_INSTANCE_MODEL, SHADER_STAGE_COMPUTE_BIT);
+  graphics->bindStorageBuffer(commandBuffer, bInstanceColor,
+                              SSBO_INSTANCE_COLOR, SHADER_STAGE_COMPUTE_BIT);
+  graphics->bindStorageBuffer(commandBuffer, bVisibleModel.get(),
+                              SSBO_VISIBLE_MODEL, SHADER_STAGE_COMPUTE_BIT);
+  graphics->bindStorageBuffer(commandBuffer, bVisibleColor.get(),
+                              SSBO_VISIBLE_COLOR, SHADER_STAGE_COMPUTE_BIT);
+  graphics->bindStorageBuffer(commandBuffer, bDrawArgs.get(), SSBO_DRAW_ARGS,
+                              SHADER_STAGE_COMPUTE_BIT);
+  uint32_t numGroups =
+      (numInstances + THREADS_PER_GROUP - 1) / THREADS_PER_GROUP;
+  graphics->dispatch(commandBuffer, numGroups, 1, 1, THREADS_PER_GROUP, 1, 1);
+}
+
+void FrustumCullOp::update(const mat4 &viewProj, Buffer *instanceModel,
+                           Buffer *instanceColor, uint32_t numInstances) {
+  bInstanceModel = instanceModel;
+  bInstanceColor = instanceColor;
+  this->numInstances = numInstances;
+  if (numInstances > maxInstances)
+    createOutputBuffers(glm::max(numInstances, 2 * maxInstances));
+  UboData uboData;
+  Frustum frustum(viewProj);
+  for (int j = 0; j < 6; j++)
+    uboData.frustumPlanes[j] = frustum.planes[j];
+  uboData.boundingSphere = boundingSphere;
+  uboData.numInstances = numInstances;
+  uboData.indexCount = indexCount;
+  uboData.padding[0] = uboData.padding[1] = 0;
+  bUbo->upload(&uboData, sizeof(uboData));
+}
+
+void FrustumCullOp::createPipelines() {
+  const std::string cullKey = "frustumCullOp", resetKey = "resetDrawArgsOp";
+  cullPipeline = (ComputePipeline *)ctx->pipelineCache->get(cullKey);
+  if (!cullPipeline) {
+    cullPipeline = ComputePipeline::create(
+        ctx, ComputeShaderModule::create(ctx->device,
+                                         NGFX_DATA_DIR "/cullInstances.comp")
+                 .get());
+    ctx->pipelineCache->add(cullKey, cullPipeline);
+  }
+  resetPipeline = (ComputePipeline *)ctx->pipelineCache->get(resetKey);
+  if (!resetPipeline) {
+    resetPipeline = ComputePipeline::create(
+        ctx, ComputeShaderModule::create(ctx->device,
+                                         NGFX_DATA_DIR "/resetDrawArgs.comp")
+                 .get());
+    ctx->pipelineCache->add(resetKey, resetPipeline);
+  }
+}
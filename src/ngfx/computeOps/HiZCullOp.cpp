@@ -0,0 +1,221 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "ngfx/computeOps/HiZCullOp.h"
+#include "ngfx/core/DebugUtil.h"
+#include "ngfx/graphics/BufferUtil.h"
+#include "ngfx/graphics/Config.h"
+#include "ngfx/graphics/Frustum.h"
+#include "ngfx/graphics/GPUProfiler.h"
+#include "ngfx/graphics/ShaderModule.h"
+using namespace ngfx;
+using namespace glm;
+
+HiZCullOp::HiZCullOp(GraphicsContext *ctx, const MeshData &meshData,
+                     uint32_t depthW, uint32_t depthH)
+    : ComputeOp(ctx), depthW(depthW), depthH(depthH) {
+  auto &b = meshData.bounds;
+  boundingSphere = vec4(0.5f * (b[0] + b[1]), 0.5f * length(b[1] - b[0]));
+  boxMin = b[0];
+  boxMax = b[1];
+  indexCount = uint32_t(meshData.faces.size()) * 3;
+  // Each level halves the previous one, down to 1x1
+  uint32_t w = depthW, h = depthH, offset = 0;
+  do {
+    w = glm::max(w / 2, 1u);
+    h = glm::max(h / 2, 1u);
+    pyramidLevels.push_back({w, h, offset});
+    offset += w * h;
+  } while (w > 1 || h > 1);
+  if (pyramidLevels.size() > MAX_LEVELS)
+    NGFX_ERR("depth buffer size %ux%u exceeds the maximum pyramid size",
+             depthW, depthH);
+  bDepthPyramid.reset(Buffer::create(ctx, nullptr, offset * sizeof(float),
+                                     BUFFER_USAGE_STORAGE_BUFFER_BIT));
+  bUbo.reset(createUniformBuffer(ctx, nullptr, sizeof(UboData)));
+  bDrawArgs.reset(
+      Buffer::create(ctx, nullptr, sizeof(DrawArgs),
+                     BufferUsageFlags(BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                      BUFFER_USAGE_INDIRECT_BUFFER_BIT)));
+  createOutputBuffers(1);
+  createPipelines();
+}
+
+void HiZCullOp::createOutputBuffers(uint32_t maxInstances) {
+  this->maxInstances = maxInstances;
+  BufferUsageFlags usageFlags = BufferUsageFlags(
+      BUFFER_USAGE_STORAGE_BUFFER_BIT | BUFFER_USAGE_VERTEX_BUFFER_BIT);
+  bVisibleModel.reset(
+      Buffer::create(ctx, nullptr, maxInstances * sizeof(mat4), usageFlags));
+  bVisibleColor.reset(
+      Buffer::create(ctx, nullptr, maxInstances * sizeof(vec4), usageFlags));
+  // No instance is visible until the first occlusion test
+  std::vector<uint32_t> visibility(maxInstances, 0);
+  bVisibility.reset(Buffer::create(ctx, visibility.data(),
+                                   maxInstances * sizeof(uint32_t),
+                                   BUFFER_USAGE_STORAGE_BUFFER_BIT));
+}
+
+void HiZCullOp::cull(CommandBuffer *commandBuffer, Graphics *graphics,
+                     Phase phase) {
+  graphics->bindComputePipeline(commandBuffer, cullPipeline);
+  graphics->bindUniformBuffer(commandBuffer, bUbo.get(), U_UBO,
+                              SHADER_STAGE_COMPUTE_BIT);
+  graphics->bindStorageBuffer(commandBuffer, bInstanceModel,
+                              SSBO_INSTANCE_MODEL, SHADER_STAGE_COMPUTE_BIT);
+  graphics->bindStorageBuffer(commandBuffer, bInstanceColor,
+                              SSBO_INSTANCE_COLOR, SHADER_STAGE_COMPUTE_BIT);
+  graphics->bindStorageBuffer(commandBuffer, bDepthPyramid.get(),
+                              SSBO_DEPTH_PYRAMID, SHADER_STAGE_COMPUTE_BIT);
+  graphics->bindStorageBuffer(commandBuffer, bVisibility.get(),
+                              SSBO_VISIBILITY, SHADER_STAGE_COMPUTE_BIT);
+  graphics->bindStorageBuffer(commandBuffer, bVisibleModel.get(),
+                              SSBO_VISIBLE_MODEL, SHADER_STAGE_COMPUTE_BIT);
+  graphics->bindStorageBuffer(commandBuffer, bVisibleColor.get(),
+                              SSBO_VISIBLE_COLOR, SHADER_STAGE_COMPUTE_BIT);
+  graphics->bindStorageBuffer(commandBuffer, bDrawArgs.get(), SSBO_DRAW_ARGS,
+                              SHADER_STAGE_COMPUTE_BIT);
+  uint32_t phaseData = PHASE_RESET;
+  graphics->pushConstants(commandBuffer, &phaseData, sizeof(phaseData));
+  graphics->dispatch(commandBuffer, 1, 1, 1, THREADS_PER_GROUP, 1, 1);
+  if (numInstances == 0)
+    return;
+  phaseData = phase;
+  graphics->pushConstants(commandBuffer, &phaseData, sizeof(phaseData));
+  uint32_t numGroups =
+      (numInstances + THREADS_PER_GROUP - 1) / THREADS_PER_GROUP;
+  graphics->dispatch(commandBuffer, numGroups, 1, 1, THREADS_PER_GROUP, 1, 1);
+}
+
+void HiZCullOp::cullPreviousVisible(CommandBuffer *commandBuffer,
+                                    Graphics *graphics) {
+  GPUProfiler::Scope profileScope(graphics, commandBuffer,
+                                  "HiZCullOp::cullPreviousVisible");
+  cull(commandBuffer, graphics, PHASE_PREVIOUS_VISIBLE);
+}
+
+void HiZCullOp::buildDepthPyramid(CommandBuffer *commandBuffer,
+                                  Graphics *graphics, Texture *depthTexture) {
+  GPUProfiler::Scope profileScope(graphics, commandBuffer,
+                                  "HiZCullOp::buildDepthPyramid");
+  uint32_t srcW = depthW, srcH = depthH, srcOffset = 0;
+  for (uint32_t j = 0; j < pyramidLevels.size(); j++) {
+    auto &level = pyramidLevels[j];
+    if (j == 0) {
+      graphics->bindComputePipeline(commandBuffer, depthPipeline);
+      graphics->bindTexture(commandBuffer, depthTexture, DEPTH_TEXTURE);
+      graphics->bindStorageBuffer(commandBuffer, bDepthPyramid.get(),
+                                  DEPTH_SSBO_DEPTH_PYRAMID,
+                                  SHADER_STAGE_COMPUTE_BIT);
+    } else if (j == 1) {
+      graphics->bindComputePipeline(commandBuffer, reducePipeline);
+      graphics->bindStorageBuffer(commandBuffer, bDepthPyramid.get(),
+                                  REDUCE_SSBO_DEPTH_PYRAMID,
+                                  SHADER_STAGE_COMPUTE_BIT);
+    }
+    ReducePushConstants pushConstants = {srcW,    srcH,      level.w,
+                                         level.h, srcOffset, level.offset};
+    graphics->pushConstants(commandBuffer, &pushConstants,
+                            sizeof(pushConstants));
+    graphics->dispatch(commandBuffer, (level.w + TILE_SIZE - 1) / TILE_SIZE,
+                       (level.h + TILE_SIZE - 1) / TILE_SIZE, 1, TILE_SIZE,
+                       TILE_SIZE, 1);
+    srcW = level.w;
+    srcH = level.h;
+    srcOffset = level.offset;
+  }
+}
+
+void HiZCullOp::apply(CommandBuffer *commandBuffer, Graphics *graphics) {
+  GPUProfiler::Scope profileScope(graphics, commandBuffer, "HiZCullOp");
+  cull(commandBuffer, graphics, PHASE_OCCLUSION);
+}
+
+void HiZCullOp::update(const mat4 &viewProj, Buffer *instanceModel,
+                       Buffer *instanceColor, uint32_t numInstances) {
+  bInstanceModel = instanceModel;
+  bInstanceColor = instanceColor;
+  this->numInstances = numInstances;
+  if (numInstances > maxInstances)
+    createOutputBuffers(glm::max(numInstances, 2 * maxInstances));
+  UboData uboData = {};
+  uboData.viewProj = viewProj;
+  Frustum frustum(viewProj);
+  for (uint32_t j = 0; j < 6; j++)
+    uboData.frustumPlanes[j] = frustum.planes[j];
+  uboData.boundingSphere = boundingSphere;
+  uboData.boxMin = vec4(boxMin, 1.0f);
+  uboData.boxMax = vec4(boxMax, 1.0f);
+  // Map the normalized device coordinates to the depth buffer's
+  // texture coordinates
+#ifdef NGFX_GRAPHICS_BACKEND_VULKAN
+  uboData.ndcToUv = vec4(0.5f, 0.5f, 0.5f, 0.5f);
+#else
+  uboData.ndcToUv = vec4(0.5f, -0.5f, 0.5f, 0.5f);
+#endif
+  for (uint32_t j = 0; j < pyramidLevels.size(); j++)
+    uboData.levelOffsets[j / 4][j % 4] = pyramidLevels[j].offset;
+  uboData.numInstances = numInstances;
+  uboData.indexCount = indexCount;
+  uboData.depthW = depthW;
+  uboData.depthH = depthH;
+  uboData.numLevels = uint32_t(pyramidLevels.size());
+  bUbo->upload(&uboData, sizeof(uboData));
+}
+
+HiZCullOp::Stats HiZCullOp::getStats() {
+  DrawArgs drawArgs;
+  bDrawArgs->download(&drawArgs, sizeof(drawArgs));
+  Stats stats;
+  stats.numInstances = numInstances;
+  stats.numVisible = drawArgs.command.instanceCount;
+  stats.numFrustumCulled = drawArgs.numFrustumCulled;
+  stats.numOcclusionCulled = drawArgs.numOcclusionCulled;
+  return stats;
+}
+
+void HiZCullOp::createPipelines() {
+  const std::string cullKey = "hizCullOp", depthKey = "hizDepthOp",
+                    reduceKey = "hizReduceOp";
+  cullPipeline = (ComputePipeline *)ctx->pipelineCache->get(cullKey);
+  if (!cullPipeline) {
+    cullPipeline = ComputePipeline::create(
+        ctx,
+        ComputeShaderModule::create(ctx->device, NGFX_DATA_DIR "/hizCull.comp")
+            .get());
+    ctx->pipelineCache->add(cullKey, cullPipeline);
+  }
+  depthPipeline = (ComputePipeline *)ctx->pipelineCache->get(depthKey);
+  if (!depthPipeline) {
+    depthPipeline = ComputePipeline::create(
+        ctx, ComputeShaderModule::create(ctx->device,
+                                         NGFX_DATA_DIR "/hizDepth.comp")
+                 .get());
+    ctx->pipelineCache->add(depthKey, depthPipeline);
+  }
+  reducePipeline = (ComputePipeline *)ctx->pipelineCache->get(reduceKey);
+  if (!reducePipeline) {
+    reducePipeline = ComputePipeline::create(
+        ctx, ComputeShaderModule::create(ctx->device,
+                                         NGFX_DATA_DIR "/hizReduce.comp")
+                 .get());
+    ctx->pipelineCache->add(reduceKey, reducePipeline);
+  }
+}
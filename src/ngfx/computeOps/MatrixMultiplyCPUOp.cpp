@@ -20,7 +20,7 @@
  */
 #include "ngfx/computeOps/MatrixMultiplyCPUOp.h"
 #include "ngfx/core/DebugUtil.h"
-#include "ngfx/core/Timer.h"
+#include "ngfx/core/Trace.h"
 #include <glm/glm.hpp>
 using namespace ngfx;
 using namespace glm;
@@ -45,7 +45,7 @@ void MatrixMultiplyCPUOp::update(MatrixParam src0, MatrixParam src1) {
 }
 
 void MatrixMultiplyCPUOp::transpose(MatrixParam &src, MatrixParam &dst) {
-  Timer timer;
+  NGFX_TRACE_SCOPE("MatrixMultiplyCPUOp::transpose");
   float *dst_data = dst.data;
   for (uint32_t dst_row = 0; dst_row < dst.h; dst_row++) {
     for (uint32_t dst_col = 0; dst_col < dst.w; dst_col++) {
@@ -53,15 +53,13 @@ void MatrixMultiplyCPUOp::transpose(MatrixParam &src, MatrixParam &dst) {
       *dst_data++ = *src_data;
     }
   }
-  timer.update();
-  NGFX_LOG("transpose elapsed: %f", timer.elapsed);
 }
 
 #define VEC4_LOAD(src, j)                                                      \
   vec4(src.data[j], src.data[j + 1], src.data[j + 2], src.data[j + 3])
 
 void MatrixMultiplyCPUOp::matrixMultiply() {
-  Timer timer;
+  NGFX_TRACE_SCOPE("MatrixMultiplyCPUOp::matrixMultiply");
   float *dst_data = dst.data;
   for (uint32_t dst_row = 0; dst_row < dst.h; dst_row++) {
     uint32_t src0_offset = dst_row * src0.w;
@@ -76,6 +74,4 @@ void MatrixMultiplyCPUOp::matrixMultiply() {
       *dst_data++ = c;
     }
   }
-  timer.update();
-  NGFX_LOG("CPU matrix multiply elapsed: %f", timer.elapsed);
 }
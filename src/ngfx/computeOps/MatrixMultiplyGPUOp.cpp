@@ -21,8 +21,8 @@
 #include "ngfx/computeOps/MatrixMultiplyGPUOp.h"
 #include "ngfx/computeOps/MatrixMultiplyCPUOp.h"
 #include "ngfx/core/DebugUtil.h"
-#include "ngfx/core/Timer.h"
 #include "ngfx/graphics/BufferUtil.h"
+#include "ngfx/graphics/GPUProfiler.h"
 using namespace ngfx;
 
 MatrixMultiplyGPUOp::MatrixMultiplyGPUOp(GraphicsContext *ctx, MatrixParam src0,
@@ -35,6 +35,8 @@ MatrixMultiplyGPUOp::MatrixMultiplyGPUOp(GraphicsContext *ctx, MatrixParam src0,
 MatrixMultiplyGPUOp::~MatrixMultiplyGPUOp() {}
 void MatrixMultiplyGPUOp::apply(CommandBuffer *commandBuffer,
                                 Graphics *graphics) {
+  GPUProfiler::Scope profileScope(graphics, commandBuffer,
+                                  "MatrixMultiplyGPUOp");
   graphics->bindComputePipeline(commandBuffer, computePipeline);
   graphics->bindUniformBuffer(commandBuffer, bUbo.get(), U_UBO,
                               SHADER_STAGE_COMPUTE_BIT);
@@ -21,6 +21,8 @@
 #include "ngfx/core/BaseApplication.h"
 #include "ngfx/core/DebugUtil.h"
 #include "ngfx/core/FPSCounter.h"
+#include "ngfx/core/Trace.h"
+#include "ngfx/graphics/GPUProfiler.h"
 #include <cstdio>
 using namespace ngfx;
 using namespace std::placeholders;
@@ -65,8 +67,8 @@ void BaseApplication::init() {
           1, IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT));
       attachments.push_back({depthTexture.get()});
     }
-    outputFramebuffer.reset(Framebuffer::create(
-        ctx->device, ctx->defaultOffscreenRenderPass, attachments, w, h));
+    outputFramebuffer = ctx->getFramebuffer(ctx->defaultOffscreenRenderPass,
+                                            attachments, w, h);
   }
   onInit();
   if (persistentCommandBuffers)
@@ -109,9 +111,11 @@ void BaseApplication::drawFrame() {
 void BaseApplication::close() {
   auto commandBuffer = graphicsContext->drawCommandBuffer();
   graphics->waitIdle(commandBuffer);
+  graphicsContext->queue->waitIdle();
 }
 
 void BaseApplication::recordCommandBuffers() {
+  NGFX_TRACE_SCOPE("BaseApplication::recordCommandBuffers");
   auto &ctx = graphicsContext;
   for (uint32_t j = 0; j < ctx->numDrawCommandBuffers; j++) {
     auto commandBuffer = ctx->drawCommandBuffer(j);
@@ -125,12 +129,16 @@ void BaseApplication::recordCommandBuffers() {
 void BaseApplication::onPaint() { paint(); }
 
 void BaseApplication::paint() {
+  NGFX_TRACE_SCOPE("BaseApplication::paint");
   auto &ctx = graphicsContext;
   if (!offscreen)
     ctx->swapchain->acquireNextImage();
   auto commandBuffer = ctx->drawCommandBuffer();
   if (!persistentCommandBuffers) {
+    NGFX_TRACE_SCOPE("BaseApplication::recordCommandBuffer");
     commandBuffer->begin();
+    if (graphics->profiler)
+      graphics->profiler->beginFrame(commandBuffer);
     onRecordCommandBuffer(commandBuffer);
     commandBuffer->end();
   }
@@ -0,0 +1,89 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "ngfx/core/MappedFile.h"
+#include "ngfx/core/DebugUtil.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+using namespace ngfx;
+
+void MappedFile::open(const std::string &filename) {
+  close();
+#ifdef _WIN32
+  fileHandle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                           nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                           nullptr);
+  if (fileHandle == INVALID_HANDLE_VALUE) {
+    fileHandle = nullptr;
+    NGFX_ERR("cannot open file: %s", filename.c_str());
+  }
+  LARGE_INTEGER fileSize;
+  GetFileSizeEx(fileHandle, &fileSize);
+  size = size_t(fileSize.QuadPart);
+  if (size == 0)
+    return;
+  mappingHandle =
+      CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mappingHandle)
+    data = (const uint8_t *)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0,
+                                          0);
+#else
+  int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd == -1)
+    NGFX_ERR("cannot open file: %s", filename.c_str());
+  struct stat fileStat;
+  fstat(fd, &fileStat);
+  size = size_t(fileStat.st_size);
+  if (size == 0) {
+    ::close(fd);
+    return;
+  }
+  // The mapping stays valid after the file is closed
+  void *p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (p != MAP_FAILED)
+    data = (const uint8_t *)p;
+#endif
+  if (!data)
+    NGFX_ERR("cannot map file: %s", filename.c_str());
+}
+
+void MappedFile::close() {
+#ifdef _WIN32
+  if (data)
+    UnmapViewOfFile(data);
+  if (mappingHandle)
+    CloseHandle(mappingHandle);
+  if (fileHandle)
+    CloseHandle(fileHandle);
+  mappingHandle = fileHandle = nullptr;
+#else
+  if (data)
+    munmap((void *)data, size);
+#endif
+  data = nullptr;
+  size = 0;
+}
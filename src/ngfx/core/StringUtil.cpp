@@ -20,6 +20,7 @@
  */
 #include "ngfx/core/StringUtil.h"
 #include <codecvt>
+#include <cstdio>
 #include <locale>
 #include <string>
 using namespace std;
@@ -36,4 +37,20 @@ std::wstring StringUtil::toWString(const std::string &str) {
   std::wstring target;
   std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
   return converter.from_bytes(str);
-}
+}
+
+string StringUtil::escapeJSON(const string &str) {
+  string result;
+  for (char c : str) {
+    if (c == '"' || c == '\\') {
+      result += '\\';
+      result += c;
+    } else if (uint8_t(c) < 0x20) {
+      char code[8];
+      snprintf(code, sizeof(code), "\\u%04x", c);
+      result += code;
+    } else
+      result += c;
+  }
+  return result;
+}
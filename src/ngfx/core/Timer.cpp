@@ -23,9 +23,9 @@
 using namespace ngfx;
 using namespace std::chrono;
 
-Timer::Timer() { t0 = system_clock::now(); }
+Timer::Timer() { t0 = steady_clock::now(); }
 void Timer::update() {
-  auto t1 = system_clock::now();
+  auto t1 = steady_clock::now();
   elapsed = duration_cast<nanoseconds>(t1 - t0).count() / float(1e9);
   t0 = t1;
 }
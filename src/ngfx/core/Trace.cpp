@@ -0,0 +1,128 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "ngfx/core/Trace.h"
+#include "ngfx/core/DebugUtil.h"
+#include "ngfx/core/StringUtil.h"
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+using namespace ngfx;
+using namespace std;
+
+namespace {
+struct ThreadBuffer {
+  vector<Trace::Event> events = vector<Trace::Event>(Trace::BUFFER_SIZE);
+  // head is only written by the owning thread
+  atomic<uint64_t> head = {0}, tail = {0};
+  uint32_t tid = 0;
+  string name;
+};
+// Buffers are kept after their thread exits, so their events can be dumped
+mutex threadBuffersMutex;
+vector<shared_ptr<ThreadBuffer>> threadBuffers;
+thread_local ThreadBuffer *threadBuffer = nullptr;
+
+ThreadBuffer *getThreadBuffer() {
+  if (!threadBuffer) {
+    lock_guard<mutex> lock(threadBuffersMutex);
+    auto buffer = make_shared<ThreadBuffer>();
+    buffer->tid = uint32_t(threadBuffers.size());
+    threadBuffers.push_back(buffer);
+    threadBuffer = buffer.get();
+  }
+  return threadBuffer;
+}
+} // namespace
+
+void Trace::addEvent(const char *name, uint64_t start, uint64_t end) {
+  ThreadBuffer *buffer = getThreadBuffer();
+  uint64_t head = buffer->head.load(memory_order_relaxed);
+  buffer->events[head & (BUFFER_SIZE - 1)] = {name, start, end};
+  buffer->head.store(head + 1, memory_order_release);
+}
+
+void Trace::setThreadName(const std::string &name) {
+  ThreadBuffer *buffer = getThreadBuffer();
+  lock_guard<mutex> lock(threadBuffersMutex);
+  buffer->name = name;
+}
+
+void Trace::clear() {
+  lock_guard<mutex> lock(threadBuffersMutex);
+  for (auto &buffer : threadBuffers)
+    buffer->tail.store(buffer->head.load(memory_order_acquire));
+}
+
+void Trace::dump(const std::string &filename) {
+  lock_guard<mutex> lock(threadBuffersMutex);
+  // Copy the events first, the owning threads may still be recording
+  vector<vector<Event>> threadEvents(threadBuffers.size());
+  uint64_t origin = UINT64_MAX;
+  for (uint32_t j = 0; j < threadBuffers.size(); j++) {
+    auto &buffer = threadBuffers[j];
+    uint64_t head = buffer->head.load(memory_order_acquire);
+    uint64_t tail = buffer->tail.load();
+    // The owning thread writes the slot of event head before it publishes
+    // it, which overwrites event head - BUFFER_SIZE
+    if (head - tail >= BUFFER_SIZE)
+      tail = head - BUFFER_SIZE + 1;
+    auto &events = threadEvents[j];
+    for (uint64_t k = tail; k < head; k++)
+      events.push_back(buffer->events[k & (BUFFER_SIZE - 1)]);
+    // Skip the events that were overwritten while they were copied.
+    // The fence orders the copy before the new head is read
+    atomic_thread_fence(memory_order_acquire);
+    uint64_t newHead = buffer->head.load(memory_order_relaxed);
+    if (newHead - tail >= BUFFER_SIZE) {
+      uint64_t numOverwritten = std::min(newHead - tail - BUFFER_SIZE + 1,
+                                         uint64_t(events.size()));
+      events.erase(events.begin(), events.begin() + numOverwritten);
+    }
+    for (auto &event : events)
+      origin = std::min(origin, event.start);
+  }
+  ofstream out(filename);
+  if (!out.is_open())
+    NGFX_ERR("cannot open file: %s", filename.c_str());
+  // Complete events ("ph":"X"), with the timestamps in microseconds
+  out << fixed << setprecision(3) << "{\"traceEvents\":[";
+  const char *separator = "\n";
+  for (uint32_t j = 0; j < threadBuffers.size(); j++) {
+    auto &buffer = threadBuffers[j];
+    if (!buffer->name.empty()) {
+      out << separator
+          << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":"
+          << buffer->tid << ",\"args\":{\"name\":\""
+          << StringUtil::escapeJSON(buffer->name) << "\"}}";
+      separator = ",\n";
+    }
+    for (auto &event : threadEvents[j]) {
+      out << separator << "{\"name\":\"" << StringUtil::escapeJSON(event.name)
+          << "\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":0,\"tid\":"
+          << buffer->tid << ",\"ts\":" << (event.start - origin) * 1e-3
+          << ",\"dur\":" << (event.end - event.start) * 1e-3 << "}";
+      separator = ",\n";
+    }
+  }
+  out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+  out.close();
+}
@@ -21,6 +21,7 @@
 #include "ngfx/drawOps/DrawColorOp.h"
 #include "ngfx/graphics/BufferUtil.h"
 #include "ngfx/graphics/Config.h"
+#include "ngfx/graphics/GPUProfiler.h"
 #include "ngfx/graphics/ShaderModule.h"
 using namespace ngfx;
 using namespace glm;
@@ -37,6 +38,7 @@ DrawColorOp::DrawColorOp(GraphicsContext *ctx,
 }
 
 void DrawColorOp::draw(CommandBuffer *commandBuffer, Graphics *graphics) {
+  GPUProfiler::Scope profileScope(graphics, commandBuffer, "DrawColorOp");
   graphics->bindGraphicsPipeline(commandBuffer, graphicsPipeline);
   graphics->bindVertexBuffer(commandBuffer, bPos.get(), B_POS, sizeof(vec2));
   graphics->bindUniformBuffer(commandBuffer, bUbo.get(), U_UBO,
@@ -0,0 +1,140 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "ngfx/drawOps/DrawMeshInstancedOp.h"
+#include "ngfx/core/DebugUtil.h"
+#include "ngfx/graphics/BufferUtil.h"
+#include "ngfx/graphics/Config.h"
+#include "ngfx/graphics/GPUProfiler.h"
+#include "ngfx/graphics/ShaderModule.h"
+using namespace ngfx;
+using namespace glm;
+
+DrawMeshInstancedOp::DrawMeshInstancedOp(GraphicsContext *ctx,
+                                         MeshData &meshData,
+                                         uint32_t maxInstances)
+    : DrawOp(ctx) {
+  bPos.reset(createVertexBuffer<vec3>(ctx, meshData.pos));
+  bNormals.reset(createVertexBuffer<vec3>(ctx, meshData.normal));
+  bFaces.reset(createIndexBuffer(ctx, meshData.faces,
+                                 uint32_t(meshData.pos.size()), indexFormat));
+  bUboVS.reset(createUniformBuffer(ctx, nullptr, sizeof(UBO_VS_Data)));
+  bUboFS.reset(createUniformBuffer(ctx, nullptr, sizeof(UBO_FS_Data)));
+  numFaces = uint32_t(meshData.faces.size());
+  createInstanceBuffers(glm::max(maxInstances, 1u));
+  createPipeline();
+  graphicsPipeline->getBindings(
+      {&U_UBO_VS, &U_UBO_FS},
+      {&B_POS, &B_NORMALS, &B_INSTANCE_MODEL, &B_INSTANCE_COLOR});
+}
+
+void DrawMeshInstancedOp::createInstanceBuffers(uint32_t maxInstances) {
+  this->maxInstances = maxInstances;
+  // The instances can also be read by a compute pass, e.g. FrustumCullOp
+  BufferUsageFlags usageFlags = BufferUsageFlags(
+      BUFFER_USAGE_VERTEX_BUFFER_BIT | BUFFER_USAGE_STORAGE_BUFFER_BIT);
+  bInstanceModel.reset(
+      Buffer::create(ctx, nullptr, maxInstances * sizeof(mat4), usageFlags));
+  bInstanceColor.reset(
+      Buffer::create(ctx, nullptr, maxInstances * sizeof(vec4), usageFlags));
+}
+
+void DrawMeshInstancedOp::draw(CommandBuffer *commandBuffer,
+                               Graphics *graphics) {
+  if (numInstances == 0)
+    return;
+  GPUProfiler::Scope profileScope(graphics, commandBuffer,
+                                  "DrawMeshInstancedOp");
+  bindBuffers(commandBuffer, graphics, bInstanceModel.get(),
+              bInstanceColor.get());
+  graphics->drawIndexed(commandBuffer, numFaces * 3, numInstances);
+}
+
+void DrawMeshInstancedOp::drawIndirect(CommandBuffer *commandBuffer,
+                                       Graphics *graphics, Buffer *drawArgs,
+                                       Buffer *instanceModel,
+                                       Buffer *instanceColor) {
+  GPUProfiler::Scope profileScope(graphics, commandBuffer,
+                                  "DrawMeshInstancedOp");
+  bindBuffers(commandBuffer, graphics, instanceModel, instanceColor);
+  graphics->drawIndexedIndirect(commandBuffer, drawArgs);
+}
+
+void DrawMeshInstancedOp::bindBuffers(CommandBuffer *commandBuffer,
+                                      Graphics *graphics,
+                                      Buffer *instanceModel,
+                                      Buffer *instanceColor) {
+  graphics->bindGraphicsPipeline(commandBuffer, graphicsPipeline);
+  graphics->bindVertexBuffers(
+      commandBuffer, {bPos.get(), bNormals.get(), instanceModel, instanceColor},
+      {B_POS, B_NORMALS, B_INSTANCE_MODEL, B_INSTANCE_COLOR},
+      {sizeof(vec3), sizeof(vec3), sizeof(mat4), sizeof(vec4)});
+  graphics->bindIndexBuffer(commandBuffer, bFaces.get(), indexFormat);
+  graphics->bindUniformBuffer(commandBuffer, bUboVS.get(), U_UBO_VS,
+                              SHADER_STAGE_VERTEX_BIT);
+  graphics->bindUniformBuffer(commandBuffer, bUboFS.get(), U_UBO_FS,
+                              SHADER_STAGE_FRAGMENT_BIT);
+}
+
+void DrawMeshInstancedOp::update(mat4 &view, mat4 &proj,
+                                 LightData &lightData) {
+  UBO_VS_Data uboVSData = {view, proj};
+  UBO_FS_Data uboFSData = {lightData};
+  bUboVS->upload(&uboVSData, sizeof(uboVSData));
+  bUboFS->upload(&uboFSData, sizeof(uboFSData));
+}
+
+void DrawMeshInstancedOp::updateInstances(const std::vector<mat4> &modelMats,
+                                          const std::vector<vec4> &colors) {
+  if (modelMats.size() != colors.size())
+    NGFX_ERR("%d model matrices, %d colors", int(modelMats.size()),
+             int(colors.size()));
+  numInstances = uint32_t(modelMats.size());
+  if (numInstances > maxInstances)
+    createInstanceBuffers(glm::max(numInstances, 2 * maxInstances));
+  if (numInstances == 0)
+    return;
+  bInstanceModel->upload(modelMats.data(), numInstances * sizeof(mat4));
+  bInstanceColor->upload(colors.data(), numInstances * sizeof(vec4));
+}
+
+void DrawMeshInstancedOp::createPipeline() {
+  const std::string key = "drawMeshInstancedOp";
+  graphicsPipeline = (GraphicsPipeline *)ctx->pipelineCache->get(key);
+  if (graphicsPipeline)
+    return;
+  GraphicsPipeline::State state;
+  state.renderPass = ctx->defaultRenderPass;
+  state.primitiveTopology = PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+  state.depthTestEnable = true;
+  state.depthWriteEnable = true;
+  auto device = ctx->device;
+  graphicsPipeline = GraphicsPipeline::create(
+      ctx, state,
+      VertexShaderModule::create(device,
+                                 NGFX_DATA_DIR "/drawMeshInstanced.vert")
+          .get(),
+      FragmentShaderModule::create(device,
+                                   NGFX_DATA_DIR "/drawMeshInstanced.frag")
+          .get(),
+      ctx->surfaceFormat, ctx->depthFormat,
+      {"instanceModel", "instanceColor"});
+  ctx->pipelineCache->add(key, graphicsPipeline);
+}
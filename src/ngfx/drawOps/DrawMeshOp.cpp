@@ -19,48 +19,261 @@
  * under the License.
  */
 #include "ngfx/drawOps/DrawMeshOp.h"
+#include "ngfx/core/DebugUtil.h"
 #include "ngfx/graphics/BufferUtil.h"
 #include "ngfx/graphics/Config.h"
+#include "ngfx/graphics/GPUProfiler.h"
+#include "ngfx/graphics/MeshUtil.h"
 #include "ngfx/graphics/ShaderModule.h"
+#include <cfloat>
+#include <cstring>
+#include <glm/gtc/matrix_transform.hpp>
+#include <string>
 using namespace ngfx;
 using namespace glm;
 
-DrawMeshOp::DrawMeshOp(GraphicsContext *ctx, MeshData &meshData) : DrawOp(ctx) {
-  bPos.reset(createVertexBuffer<vec3>(ctx, meshData.pos));
-  bNormals.reset(createVertexBuffer<vec3>(ctx, meshData.normal));
-  bFaces.reset(createIndexBuffer<ivec3>(ctx, meshData.faces));
-  bUboVS.reset(createUniformBuffer(ctx, nullptr, sizeof(UBO_VS_Data)));
-  bUboFS.reset(createUniformBuffer(ctx, nullptr, sizeof(UBO_FS_Data)));
+// The normal decoding in drawMeshQuantized.vert
+enum {
+  NORMAL_DECODE_NONE = 0,
+  NORMAL_DECODE_UNORM = 1,
+  NORMAL_DECODE_OCTAHEDRAL = 2
+};
+
+static VertexFormat getVertexFormat(PositionEncoding posEncoding) {
+  const VertexFormat formats[] = {VERTEXFORMAT_FLOAT3, VERTEXFORMAT_HALF4,
+                                  VERTEXFORMAT_USHORT4_NORM};
+  return formats[posEncoding];
+}
+
+static VertexFormat getVertexFormat(NormalEncoding normalEncoding) {
+  const VertexFormat formats[] = {
+      VERTEXFORMAT_FLOAT3,      VERTEXFORMAT_HALF4,
+      VERTEXFORMAT_CHAR4_NORM,  VERTEXFORMAT_UINT1010102_NORM,
+      VERTEXFORMAT_SHORT2_NORM, VERTEXFORMAT_CHAR2_NORM};
+  return formats[normalEncoding];
+}
+
+DrawMeshOp::DrawMeshOp(GraphicsContext *ctx, MeshData &meshData,
+                       bool interleaved)
+    : DrawOp(ctx) {
   numVerts = uint32_t(meshData.pos.size());
   numNormals = uint32_t(meshData.normal.size());
   numFaces = uint32_t(meshData.faces.size());
+  this->interleaved = interleaved && numVerts != 0 && numNormals == numVerts;
+  if (this->interleaved) {
+    std::vector<uint8_t> vertices;
+    vertexStride = MeshUtil::interleaveVertices(meshData, vertices);
+    bVertices.reset(createVertexBuffer(ctx, vertices.data(),
+                                       uint32_t(vertices.size())));
+  } else {
+    bPos.reset(createVertexBuffer<vec3>(ctx, meshData.pos));
+    bNormals.reset(createVertexBuffer<vec3>(ctx, meshData.normal));
+  }
+  bFaces.reset(createIndexBuffer(ctx, meshData.faces, numVerts, indexFormat));
+  vec3 boundsMin(FLT_MAX), boundsMax(-FLT_MAX);
+  for (auto &p : meshData.pos) {
+    boundsMin = glm::min(boundsMin, p);
+    boundsMax = glm::max(boundsMax, p);
+  }
+  initLODs(meshData.lods, boundsMin, boundsMax);
+  bUboVS.reset(createUniformBuffer(ctx, nullptr, sizeof(UBO_VS_Data)));
+  bUboFS.reset(createUniformBuffer(ctx, nullptr, sizeof(UBO_FS_Data)));
+  createPipeline();
+  graphicsPipeline->getBindings({&U_UBO_VS, &U_UBO_FS}, {&B_POS, &B_NORMALS});
+}
+
+DrawMeshOp::DrawMeshOp(GraphicsContext *ctx, QuantizedMeshData &meshData,
+                       bool interleaved)
+    : DrawOp(ctx) {
+  numVerts = meshData.numVerts;
+  numNormals = meshData.numNormals;
+  numFaces = meshData.numFaces;
+  quantized = true;
+  posEncoding = meshData.posEncoding;
+  normalEncoding = meshData.normalEncoding;
+  posStride = meshData.posStride();
+  normalStride = meshData.normalStride();
+  if (posEncoding == POSITION_ENCODING_UNORM16) {
+    auto &bounds = meshData.bounds;
+    dequantizeMat = translate(mat4(1.0f), bounds[0]) *
+                    scale(mat4(1.0f), bounds[1] - bounds[0]);
+  }
+  this->interleaved = interleaved && numVerts != 0 && numNormals == numVerts;
+  if (this->interleaved) {
+    std::vector<uint8_t> vertices;
+    vertexStride = MeshUtil::interleaveVertices(meshData, vertices);
+    normalOffset = posStride;
+    bVertices.reset(createVertexBuffer(ctx, vertices.data(),
+                                       uint32_t(vertices.size())));
+  } else {
+    bPos.reset(createVertexBuffer(ctx, meshData.pos.data(),
+                                  uint32_t(meshData.pos.size())));
+    bNormals.reset(createVertexBuffer(ctx, meshData.normal.data(),
+                                      uint32_t(meshData.normal.size())));
+  }
+  bFaces.reset(createIndexBuffer(ctx, meshData.indices.data(),
+                                 uint32_t(meshData.indices.size()),
+                                 meshData.indexSize));
+  indexFormat =
+      (meshData.indexSize == 2) ? INDEXFORMAT_UINT16 : INDEXFORMAT_UINT32;
+  initLODs(meshData.lods, meshData.bounds[0], meshData.bounds[1]);
+  bUboVS.reset(createUniformBuffer(ctx, nullptr, sizeof(UBO_VS_Data)));
+  bUboFS.reset(createUniformBuffer(ctx, nullptr, sizeof(UBO_FS_Data)));
+  createPipeline();
+  graphicsPipeline->getBindings({&U_UBO_VS, &U_UBO_FS}, {&B_POS, &B_NORMALS});
+}
+
+// The size of the memory spanned by a view of n elements
+static uint32_t getViewSize(uint32_t n, uint32_t stride, uint32_t elementSize) {
+  return n ? (n - 1) * stride + elementSize : 0;
+}
+
+// Create a vertex buffer of 3 x float attributes from a view.
+// The pipeline expects the separate attributes to be packed, so strided
+// views are repacked
+static Buffer *createAttributeBuffer(GraphicsContext *ctx, const uint8_t *data,
+                                     uint32_t n, uint32_t stride) {
+  if (stride == sizeof(vec3))
+    return createVertexBuffer(ctx, data, n * uint32_t(sizeof(vec3)));
+  std::vector<vec3> v(n);
+  for (uint32_t j = 0; j < n; j++)
+    memcpy(&v[j], data + size_t(j) * stride, sizeof(vec3));
+  return createVertexBuffer(ctx, v.data(), n * uint32_t(sizeof(vec3)));
+}
+
+DrawMeshOp::DrawMeshOp(GraphicsContext *ctx, const MeshView &meshView)
+    : DrawOp(ctx) {
+  if (!meshView.normal)
+    NGFX_ERR("the mesh view doesn't have normals");
+  numVerts = numNormals = meshView.numVerts;
+  numFaces = meshView.numFaces;
+  posStride = meshView.posStride;
+  normalStride = meshView.normalStride;
+  // The normals are interleaved with the positions if they are in the same
+  // vertex, after the position
+  ptrdiff_t offset = meshView.normal - meshView.pos;
+  interleaved = posStride == normalStride &&
+                offset >= ptrdiff_t(sizeof(vec3)) &&
+                offset + ptrdiff_t(sizeof(vec3)) <= ptrdiff_t(posStride);
+  if (interleaved) {
+    vertexStride = posStride;
+    normalOffset = uint32_t(offset);
+    bVertices.reset(createVertexBuffer(
+        ctx, meshView.pos,
+        getViewSize(numVerts, vertexStride, normalOffset + sizeof(vec3))));
+  } else {
+    bPos.reset(createAttributeBuffer(ctx, meshView.pos, numVerts, posStride));
+    bNormals.reset(
+        createAttributeBuffer(ctx, meshView.normal, numVerts, normalStride));
+    posStride = normalStride = sizeof(vec3);
+  }
+  bFaces.reset(createIndexBuffer(ctx, meshView.indices,
+                                 numFaces * 3 * meshView.indexSize,
+                                 meshView.indexSize));
+  indexFormat =
+      (meshView.indexSize == 2) ? INDEXFORMAT_UINT16 : INDEXFORMAT_UINT32;
+  initLODs({}, meshView.bounds[0], meshView.bounds[1]);
+  bUboVS.reset(createUniformBuffer(ctx, nullptr, sizeof(UBO_VS_Data)));
+  bUboFS.reset(createUniformBuffer(ctx, nullptr, sizeof(UBO_FS_Data)));
   createPipeline();
   graphicsPipeline->getBindings({&U_UBO_VS, &U_UBO_FS}, {&B_POS, &B_NORMALS});
 }
 
+void DrawMeshOp::initLODs(const std::vector<MeshLOD> &meshLODs,
+                          const vec3 &boundsMin, const vec3 &boundsMax) {
+  lods = meshLODs;
+  if (lods.empty()) {
+    MeshLOD lod0;
+    lod0.numFaces = numFaces;
+    lods.push_back(lod0);
+  }
+  if (numVerts == 0)
+    return;
+  boundsCenter = 0.5f * (boundsMin + boundsMax);
+  boundsRadius = 0.5f * length(boundsMax - boundsMin);
+}
+
+uint32_t DrawMeshOp::selectLOD(const mat4 &modelView, const mat4 &proj,
+                               float viewportHeight, float maxPixelError) {
+  // The largest scale factor of the model view transform
+  float modelScale = glm::max(
+      length(vec3(modelView[0])),
+      glm::max(length(vec3(modelView[1])), length(vec3(modelView[2]))));
+  // The size of a model unit in pixels. With a perspective projection,
+  // it's measured at the closest point of the bounding sphere
+  float pixelsPerUnit = modelScale * proj[1][1] * 0.5f * viewportHeight;
+  if (proj[2][3] != 0.0f) {
+    vec3 viewCenter = vec3(modelView * vec4(boundsCenter, 1.0f));
+    float distance = length(viewCenter) - boundsRadius * modelScale;
+    pixelsPerUnit /= glm::max(distance, 1e-4f);
+  }
+  lod = 0;
+  for (uint32_t j = uint32_t(lods.size()) - 1; j > 0; j--) {
+    if (lods[j].error * pixelsPerUnit <= maxPixelError) {
+      lod = j;
+      break;
+    }
+  }
+  return lod;
+}
+
 void DrawMeshOp::draw(CommandBuffer *commandBuffer, Graphics *graphics) {
+  GPUProfiler::Scope profileScope(graphics, commandBuffer, "DrawMeshOp");
+  bindBuffers(commandBuffer, graphics, bFaces.get(), indexFormat);
+  auto &drawLOD = lods[lod];
+  graphics->drawIndexed(commandBuffer, drawLOD.numFaces * 3, 1,
+                        drawLOD.firstFace * 3);
+}
+
+void DrawMeshOp::drawIndirect(CommandBuffer *commandBuffer, Graphics *graphics,
+                              Buffer *indices, Buffer *drawArgs) {
+  GPUProfiler::Scope profileScope(graphics, commandBuffer, "DrawMeshOp");
+  bindBuffers(commandBuffer, graphics, indices, INDEXFORMAT_UINT32);
+  graphics->drawIndexedIndirect(commandBuffer, drawArgs);
+}
+
+void DrawMeshOp::bindBuffers(CommandBuffer *commandBuffer, Graphics *graphics,
+                             Buffer *indices, IndexFormat indexFormat) {
   graphics->bindGraphicsPipeline(commandBuffer, graphicsPipeline);
-  graphics->bindVertexBuffer(commandBuffer, bPos.get(), B_POS, sizeof(vec3));
-  graphics->bindVertexBuffer(commandBuffer, bNormals.get(), B_NORMALS,
-                             sizeof(vec3));
-  graphics->bindIndexBuffer(commandBuffer, bFaces.get());
+  if (interleaved)
+    graphics->bindVertexBuffer(commandBuffer, bVertices.get(), B_POS,
+                               vertexStride);
+  else
+    graphics->bindVertexBuffers(commandBuffer, {bPos.get(), bNormals.get()},
+                                {B_POS, B_NORMALS}, {posStride, normalStride});
+  graphics->bindIndexBuffer(commandBuffer, indices, indexFormat);
   graphics->bindUniformBuffer(commandBuffer, bUboVS.get(), U_UBO_VS,
                               SHADER_STAGE_VERTEX_BIT);
   graphics->bindUniformBuffer(commandBuffer, bUboFS.get(), U_UBO_FS,
                               SHADER_STAGE_FRAGMENT_BIT);
-  graphics->drawIndexed(commandBuffer, numFaces * 3);
 }
 
 void DrawMeshOp::update(mat4 &modelView, mat4 &modelViewInverseTranspose,
                         mat4 &modelViewProj, LightData &lightData) {
-  UBO_VS_Data uboVSData = {modelView, modelViewInverseTranspose, modelViewProj};
+  UBO_VS_Data uboVSData = {modelView * dequantizeMat,
+                           modelViewInverseTranspose,
+                           modelViewProj * dequantizeMat};
+  if (normalEncoding == NORMAL_ENCODING_UNORM10)
+    uboVSData.normalDecode = NORMAL_DECODE_UNORM;
+  else if (normalEncoding == NORMAL_ENCODING_OCT16 ||
+           normalEncoding == NORMAL_ENCODING_OCT8)
+    uboVSData.normalDecode = NORMAL_DECODE_OCTAHEDRAL;
+  else
+    uboVSData.normalDecode = NORMAL_DECODE_NONE;
   UBO_FS_Data uboFSData = {lightData};
   bUboVS->upload(&uboVSData, sizeof(uboVSData));
   bUboFS->upload(&uboFSData, sizeof(uboFSData));
 }
 
 void DrawMeshOp::createPipeline() {
-  const std::string key = "drawMeshOp";
+  // The quantized pipelines differ by their vertex input formats
+  const std::string key =
+      (quantized ? "drawMeshQuantizedOp_" + std::to_string(posEncoding) + "_" +
+                       std::to_string(normalEncoding)
+                 : "drawMeshOp") +
+      (interleaved ? "_interleaved_" + std::to_string(vertexStride) + "_" +
+                         std::to_string(normalOffset)
+                   : "");
   graphicsPipeline = (GraphicsPipeline *)ctx->pipelineCache->get(key);
   if (graphicsPipeline)
     return;
@@ -69,10 +282,19 @@ void DrawMeshOp::createPipeline() {
   state.primitiveTopology = PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
   state.depthTestEnable = true;
   state.depthWriteEnable = true;
+  if (interleaved)
+    state.vertexBufferLayouts = {
+        {{{"inPos", 0}, {"inNormal", normalOffset}}, vertexStride}};
   auto device = ctx->device;
+  auto vs = VertexShaderModule::create(
+      device, quantized ? NGFX_DATA_DIR "/drawMeshQuantized.vert"
+                        : NGFX_DATA_DIR "/drawMesh.vert");
+  if (quantized) {
+    vs->setAttributeFormat("inPos", getVertexFormat(posEncoding));
+    vs->setAttributeFormat("inNormal", getVertexFormat(normalEncoding));
+  }
   graphicsPipeline = GraphicsPipeline::create(
-      ctx, state,
-      VertexShaderModule::create(device, NGFX_DATA_DIR "/drawMesh.vert").get(),
+      ctx, state, vs.get(),
       FragmentShaderModule::create(device, NGFX_DATA_DIR "/drawMesh.frag")
           .get(),
       ctx->surfaceFormat, ctx->depthFormat);
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "ngfx/drawOps/DrawTexturesOp.h"
+#include "ngfx/core/DebugUtil.h"
+#include "ngfx/graphics/BufferUtil.h"
+#include "ngfx/graphics/Config.h"
+#include "ngfx/graphics/GPUProfiler.h"
+#include "ngfx/graphics/ShaderModule.h"
+using namespace ngfx;
+using namespace glm;
+
+DrawTexturesOp::DrawTexturesOp(GraphicsContext *ctx,
+                               const std::vector<Texture *> &textures,
+                               const std::vector<glm::vec4> &rects)
+    : DrawOp(ctx) {
+  auto bindlessHeap = ctx->bindlessHeap;
+  if (!bindlessHeap)
+    NGFX_ERR("DrawTexturesOp requires descriptor indexing support");
+  std::vector<uint32_t> textureIndex(textures.size());
+  for (uint32_t j = 0; j < textures.size(); j++) {
+    auto texture = textures[j];
+    auto it = textureIndices.find(texture);
+    if (it == textureIndices.end())
+      it = textureIndices
+               .insert({texture, bindlessHeap->addTexture(texture)})
+               .first;
+    textureIndex[j] = it->second;
+  }
+  bPos.reset(createVertexBuffer<vec2>(
+      ctx, {vec2(0, 1), vec2(0, 0), vec2(1, 1), vec2(1, 0)}));
+  bTexCoord.reset(createVertexBuffer<vec2>(
+      ctx, {vec2(0, 0), vec2(0, 1), vec2(1, 0), vec2(1, 1)}));
+  bRect.reset(createVertexBuffer<vec4>(ctx, rects));
+  bTextureIndex.reset(createVertexBuffer<uint32_t>(ctx, textureIndex));
+  numInstances = uint32_t(rects.size());
+  createPipeline();
+  graphicsPipeline->getBindings(
+      {&U_TEXTURES}, {&B_POS, &B_TEXCOORD, &B_RECT, &B_TEXTURE_INDEX});
+}
+
+DrawTexturesOp::~DrawTexturesOp() {
+  for (auto &it : textureIndices)
+    ctx->bindlessHeap->remove(DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                              it.second);
+}
+
+void DrawTexturesOp::draw(CommandBuffer *commandBuffer, Graphics *graphics) {
+  GPUProfiler::Scope profileScope(graphics, commandBuffer, "DrawTexturesOp");
+  graphics->bindGraphicsPipeline(commandBuffer, graphicsPipeline);
+  graphics->bindVertexBuffer(commandBuffer, bPos.get(), B_POS, sizeof(vec2));
+  graphics->bindVertexBuffer(commandBuffer, bTexCoord.get(), B_TEXCOORD,
+                             sizeof(vec2));
+  graphics->bindVertexBuffer(commandBuffer, bRect.get(), B_RECT, sizeof(vec4));
+  graphics->bindVertexBuffer(commandBuffer, bTextureIndex.get(),
+                             B_TEXTURE_INDEX, sizeof(uint32_t));
+  ctx->bindlessHeap->bind(commandBuffer, graphics,
+                          DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, U_TEXTURES);
+  graphics->draw(commandBuffer, 4, numInstances);
+}
+
+void DrawTexturesOp::createPipeline() {
+  const std::string key = "drawTexturesOp";
+  graphicsPipeline = (GraphicsPipeline *)ctx->pipelineCache->get(key);
+  if (graphicsPipeline)
+    return;
+  GraphicsPipeline::State state;
+  state.renderPass = ctx->defaultRenderPass;
+  state.primitiveTopology = PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
+  auto device = ctx->device;
+  graphicsPipeline = GraphicsPipeline::create(
+      ctx, state,
+      VertexShaderModule::create(device, NGFX_DATA_DIR "/drawTextures.vert")
+          .get(),
+      FragmentShaderModule::create(device, NGFX_DATA_DIR "/drawTextures.frag")
+          .get(),
+      ctx->surfaceFormat, ctx->depthFormat, {"rect", "textureIndex"});
+  ctx->pipelineCache->add(key, graphicsPipeline);
+}
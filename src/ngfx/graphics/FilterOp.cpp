@@ -19,6 +19,7 @@
  * under the License.
  */
 #include "ngfx/graphics/FilterOp.h"
+#include "ngfx/graphics/GPUProfiler.h"
 using namespace ngfx;
 
 FilterOp::FilterOp(GraphicsContext *ctx, Graphics *graphics, uint32_t dstWidth,
@@ -29,13 +30,13 @@ FilterOp::FilterOp(GraphicsContext *ctx, Graphics *graphics, uint32_t dstWidth,
       ctx, graphics, nullptr, PIXELFORMAT_RGBA8_UNORM, size, w, h, 1, 1,
       ImageUsageFlags(IMAGE_USAGE_SAMPLED_BIT | IMAGE_USAGE_TRANSFER_DST_BIT |
                       IMAGE_USAGE_COLOR_ATTACHMENT_BIT)));
-  outputFramebuffer.reset(Framebuffer::create(ctx->device,
-                                              ctx->defaultOffscreenRenderPass,
-                                              {{outputTexture.get()}}, w, h));
+  outputFramebuffer = ctx->getFramebuffer(ctx->defaultOffscreenRenderPass,
+                                          {{outputTexture.get()}}, w, h);
 }
 
 void FilterOp::apply(GraphicsContext *ctx, CommandBuffer *commandBuffer,
                      Graphics *graphics) {
+  GPUProfiler::Scope profileScope(graphics, commandBuffer, "FilterOp");
   outputTexture->changeLayout(commandBuffer,
                               IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
   ctx->beginOffscreenRenderPass(commandBuffer, graphics,
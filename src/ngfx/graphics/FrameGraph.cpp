@@ -0,0 +1,279 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "ngfx/graphics/FrameGraph.h"
+#include "ngfx/core/DebugUtil.h"
+#include "ngfx/graphics/PixelFormatUtil.h"
+using namespace ngfx;
+
+FrameGraph::ResourceHandle
+FrameGraph::createTexture(const std::string &name,
+                          const TextureDescription &desc) {
+  auto resource = std::make_unique<Resource>();
+  resource->name = name;
+  resource->desc = desc;
+  resources.emplace_back(std::move(resource));
+  compiled = false;
+  return ResourceHandle(resources.size() - 1);
+}
+
+FrameGraph::ResourceHandle FrameGraph::importTexture(const std::string &name,
+                                                     Texture *texture,
+                                                     Framebuffer *framebuffer) {
+  auto resource = std::make_unique<Resource>();
+  resource->name = name;
+  resource->desc = {texture->w, texture->h, texture->format};
+  resource->imported = true;
+  resource->texture = texture;
+  if (framebuffer) {
+    resource->framebuffer = framebuffer;
+    resource->renderPass =
+        getRenderPass(framebuffer->attachments.empty()
+                          ? std::vector<Framebuffer::Attachment>{{texture}}
+                          : framebuffer->attachments);
+  }
+  resources.emplace_back(std::move(resource));
+  compiled = false;
+  return ResourceHandle(resources.size() - 1);
+}
+
+void FrameGraph::addPass(const std::string &name,
+                         const std::vector<ResourceHandle> &inputs,
+                         ResourceHandle output, ExecuteFn execute) {
+  auto &resource = resources[output];
+  if (resource->writer != -1)
+    NGFX_ERR("texture %s is written by multiple passes",
+             resource->name.c_str());
+  resource->writer = int32_t(passes.size());
+  passes.push_back({name, inputs, output, execute});
+  compiled = false;
+}
+
+void FrameGraph::addFilterPass(FilterOp *filterOp,
+                               const std::vector<ResourceHandle> &inputs,
+                               ResourceHandle output) {
+  addPass("filter" + std::to_string(passes.size()), inputs, output,
+          [this, filterOp, inputs](CommandBuffer *commandBuffer,
+                                   Graphics *graphics) {
+            filterOp->inputTextures.resize(inputs.size());
+            for (uint32_t j = 0; j < inputs.size(); j++)
+              filterOp->inputTextures[j] = getTexture(inputs[j]);
+            filterOp->draw(commandBuffer, graphics);
+          });
+}
+
+RenderPass *FrameGraph::getRenderPass(PixelFormat format) {
+  GraphicsContext::RenderPassConfig config = {
+      {{format, std::nullopt, std::nullopt}}, std::nullopt, false, 1};
+  return ctx->getRenderPass(config);
+}
+
+RenderPass *FrameGraph::getRenderPass(
+    const std::vector<Framebuffer::Attachment> &attachments) {
+  GraphicsContext::RenderPassConfig config = {
+      {}, std::nullopt, false, attachments[0].texture->numSamples};
+  for (auto &attachment : attachments) {
+    auto texture = attachment.texture;
+    GraphicsContext::AttachmentDescription desc = {
+        texture->format, std::nullopt, std::nullopt};
+    if (texture->imageUsageFlags & IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT)
+      config.depthStencilAttachmentDescription = desc;
+    else
+      config.colorAttachmentDescriptions.push_back(desc);
+  }
+  return ctx->getRenderPass(config);
+}
+
+void FrameGraph::cullPasses(std::vector<bool> &activePasses) {
+  // Only keep the passes that contribute to an imported texture
+  activePasses.assign(passes.size(), false);
+  std::vector<int32_t> stack;
+  for (auto &resource : resources) {
+    if (resource->imported && resource->writer != -1)
+      stack.push_back(resource->writer);
+  }
+  while (!stack.empty()) {
+    int32_t passIndex = stack.back();
+    stack.pop_back();
+    if (activePasses[passIndex])
+      continue;
+    activePasses[passIndex] = true;
+    for (auto input : passes[passIndex].inputs) {
+      auto &resource = resources[input];
+      if (resource->writer != -1)
+        stack.push_back(resource->writer);
+      else if (!resource->imported)
+        NGFX_ERR("texture %s is read but never written",
+                 resource->name.c_str());
+    }
+  }
+}
+
+void FrameGraph::sortPasses(const std::vector<bool> &activePasses) {
+  // Topological sort, preserving the declaration order when possible
+  passOrder.clear();
+  std::vector<bool> scheduled(passes.size(), false);
+  uint32_t numActivePasses = 0;
+  for (bool active : activePasses)
+    numActivePasses += active ? 1 : 0;
+  while (passOrder.size() < numActivePasses) {
+    bool progress = false;
+    for (uint32_t j = 0; j < passes.size(); j++) {
+      if (!activePasses[j] || scheduled[j])
+        continue;
+      bool ready = true;
+      for (auto input : passes[j].inputs) {
+        int32_t writer = resources[input]->writer;
+        if (writer != -1 && !scheduled[writer]) {
+          ready = false;
+          break;
+        }
+      }
+      if (!ready)
+        continue;
+      scheduled[j] = true;
+      passOrder.push_back(j);
+      progress = true;
+      break;
+    }
+    if (!progress)
+      NGFX_ERR("cycle detected in frame graph");
+  }
+}
+
+void FrameGraph::allocateTextures() {
+  for (auto &resource : resources) {
+    resource->firstUse = resource->lastUse = -1;
+    if (!resource->imported) {
+      resource->texture = nullptr;
+      resource->framebuffer = nullptr;
+    }
+  }
+  for (uint32_t j = 0; j < passOrder.size(); j++) {
+    auto &pass = passes[passOrder[j]];
+    auto &output = resources[pass.output];
+    if (output->firstUse == -1)
+      output->firstUse = j;
+    output->lastUse = j;
+    for (auto input : pass.inputs)
+      resources[input]->lastUse = j;
+  }
+
+  // Assign the transient textures to physical textures.
+  // A physical texture is returned to the free list after the last pass
+  // that reads it, so it can be reused by the following passes.
+  std::vector<PhysicalTexture *> freeList;
+  for (auto &physicalTexture : physicalTextures)
+    freeList.push_back(physicalTexture.get());
+  for (uint32_t j = 0; j < passOrder.size(); j++) {
+    auto &pass = passes[passOrder[j]];
+    auto &output = resources[pass.output];
+    if (!output->imported && !output->texture) {
+      PhysicalTexture *physicalTexture = nullptr;
+      for (auto it = freeList.begin(); it != freeList.end(); it++) {
+        if ((*it)->desc == output->desc) {
+          physicalTexture = *it;
+          freeList.erase(it);
+          break;
+        }
+      }
+      if (!physicalTexture) {
+        auto &desc = output->desc;
+        uint32_t size =
+            PixelFormatUtil::getImageSize(desc.format, desc.w, desc.h);
+        auto p = std::make_unique<PhysicalTexture>();
+        p->desc = desc;
+        p->texture.reset(Texture::create(
+            ctx, graphics, nullptr, desc.format, size, desc.w, desc.h, 1, 1,
+            ImageUsageFlags(IMAGE_USAGE_SAMPLED_BIT |
+                            IMAGE_USAGE_TRANSFER_SRC_BIT |
+                            IMAGE_USAGE_TRANSFER_DST_BIT |
+                            IMAGE_USAGE_COLOR_ATTACHMENT_BIT)));
+        p->framebuffer = ctx->getFramebuffer(getRenderPass(desc.format),
+                                             {{p->texture.get()}}, desc.w,
+                                             desc.h);
+        physicalTexture = p.get();
+        physicalTextures.emplace_back(std::move(p));
+      }
+      output->texture = physicalTexture->texture.get();
+      output->framebuffer = physicalTexture->framebuffer.get();
+      output->renderPass = getRenderPass(output->desc.format);
+    }
+    for (auto &resource : resources) {
+      if (resource->imported || resource->lastUse != int32_t(j))
+        continue;
+      for (auto &physicalTexture : physicalTextures) {
+        if (physicalTexture->texture.get() == resource->texture)
+          freeList.push_back(physicalTexture.get());
+      }
+    }
+  }
+
+  // Imported textures without a framebuffer get one created by the graph
+  for (auto &resource : resources) {
+    if (!resource->imported || resource->framebuffer ||
+        resource->writer == -1)
+      continue;
+    auto &desc = resource->desc;
+    resource->renderPass = getRenderPass(desc.format);
+    resource->importedFramebuffer = ctx->getFramebuffer(
+        resource->renderPass, {{resource->texture}}, desc.w, desc.h);
+    resource->framebuffer = resource->importedFramebuffer.get();
+  }
+}
+
+void FrameGraph::compile() {
+  std::vector<bool> activePasses;
+  cullPasses(activePasses);
+  sortPasses(activePasses);
+  allocateTextures();
+  compiled = true;
+}
+
+void FrameGraph::execute(CommandBuffer *commandBuffer) {
+  if (!compiled)
+    compile();
+  for (uint32_t passIndex : passOrder) {
+    auto &pass = passes[passIndex];
+    for (auto input : pass.inputs)
+      resources[input]->texture->changeLayout(
+          commandBuffer, IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    auto &output = resources[pass.output];
+    output->texture->changeLayout(commandBuffer,
+                                  IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+    auto framebuffer = output->framebuffer;
+    graphics->beginRenderPass(commandBuffer, output->renderPass, framebuffer,
+                              ctx->clearColor);
+    Rect2D rect = {0, 0, framebuffer->w, framebuffer->h};
+    graphics->setViewport(commandBuffer, rect);
+    graphics->setScissor(commandBuffer, rect);
+    pass.execute(commandBuffer, graphics);
+    graphics->endRenderPass(commandBuffer);
+  }
+  for (auto &resource : resources) {
+    if (resource->imported && resource->writer != -1)
+      resource->texture->changeLayout(commandBuffer,
+                                      IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+  }
+}
+
+Texture *FrameGraph::getTexture(ResourceHandle handle) {
+  return resources[handle]->texture;
+}
@@ -0,0 +1,281 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "ngfx/graphics/Frustum.h"
+#include "ngfx/core/DebugUtil.h"
+#include "ngfx/core/SIMD.h"
+#include <bitset>
+using namespace ngfx;
+using namespace std;
+
+namespace {
+// The input of the culling kernels: for each plane, the x, y and z arrays
+// of the points of the volumes that are tested against the plane, and
+// the radius array of the spheres
+struct CullInput {
+  const float *coords[6][3];
+  const float *radius = nullptr;
+  uint32_t numVolumes = 0;
+};
+} // namespace
+
+Frustum::Frustum(const mat4 &viewProjMat) {
+  vec4 row[4];
+  for (int j = 0; j < 4; j++)
+    row[j] = vec4(viewProjMat[0][j], viewProjMat[1][j], viewProjMat[2][j],
+                  viewProjMat[3][j]);
+  planes[0] = row[3] + row[0];
+  planes[1] = row[3] - row[0];
+  planes[2] = row[3] + row[1];
+  planes[3] = row[3] - row[1];
+  planes[4] = row[3] + row[2];
+  planes[5] = row[3] - row[2];
+  for (auto &plane : planes)
+    plane /= length(vec3(plane));
+}
+
+bool Frustum::intersects(const BoundingSphere &sphere) const {
+  for (auto &plane : planes) {
+    if (dot(vec3(plane), sphere.center) + plane.w < -sphere.radius)
+      return false;
+  }
+  return true;
+}
+
+bool Frustum::intersects(const BoundingBox &box) const {
+  // Test the corner of the box that is the farthest inside each plane
+  for (auto &plane : planes) {
+    vec3 p(plane.x >= 0.0f ? box.max.x : box.min.x,
+           plane.y >= 0.0f ? box.max.y : box.min.y,
+           plane.z >= 0.0f ? box.max.z : box.min.z);
+    if (dot(vec3(plane), p) + plane.w < 0.0f)
+      return false;
+  }
+  return true;
+}
+
+// The kernels write the index of every volume, and only move the output
+// past the visible ones, so the output needs room for all the volumes
+template <bool hasRadius>
+static uint32_t cull1(const vec4 *planes, const CullInput &in,
+                      uint32_t begin, uint32_t *out, uint32_t numVisible) {
+  for (uint32_t j = begin; j < in.numVolumes; j++) {
+    float negRadius = hasRadius ? -in.radius[j] : 0.0f;
+    bool visible = true;
+    for (uint32_t k = 0; k < 6; k++) {
+      auto &coords = in.coords[k];
+      float d = planes[k].x * coords[0][j] + planes[k].y * coords[1][j] +
+                planes[k].z * coords[2][j] + planes[k].w;
+      visible &= (negRadius <= d);
+    }
+    out[numVisible] = j;
+    numVisible += visible ? 1 : 0;
+  }
+  return numVisible;
+}
+
+#if defined(NGFX_SIMD_SSE) || defined(NGFX_SIMD_NEON)
+template <bool hasRadius>
+static uint32_t cull4(const vec4 *planes, const CullInput &in,
+                      uint32_t &end, uint32_t *out, uint32_t numVisible) {
+  float4 px[6], py[6], pz[6], pw[6];
+  for (uint32_t k = 0; k < 6; k++) {
+    px[k] = float4(planes[k].x);
+    py[k] = float4(planes[k].y);
+    pz[k] = float4(planes[k].z);
+    pw[k] = float4(planes[k].w);
+  }
+  uint32_t j = 0;
+  for (; j + 4 <= in.numVolumes; j += 4) {
+    float4 negRadius = hasRadius
+                           ? float4(0.0f) - float4::load(in.radius + j)
+                           : float4(0.0f);
+    int mask = 0xF;
+    for (uint32_t k = 0; k < 6; k++) {
+      auto &coords = in.coords[k];
+      float4 d = px[k] * float4::load(coords[0] + j) +
+                 py[k] * float4::load(coords[1] + j) +
+                 pz[k] * float4::load(coords[2] + j) + pw[k];
+      mask &= (negRadius <= d).movemask();
+    }
+    for (uint32_t k = 0; k < 4; k++) {
+      out[numVisible] = j + k;
+      numVisible += (mask >> k) & 1;
+    }
+  }
+  end = j;
+  return numVisible;
+}
+#endif
+
+#if defined(NGFX_SIMD_AVX)
+template <bool hasRadius>
+NGFX_SIMD_AVX2_TARGET static uint32_t cull8(const vec4 *planes,
+                                            const CullInput &in, uint32_t &end,
+                                            uint32_t *out,
+                                            uint32_t numVisible) {
+  __m256 px[6], py[6], pz[6], pw[6];
+  for (uint32_t k = 0; k < 6; k++) {
+    px[k] = _mm256_set1_ps(planes[k].x);
+    py[k] = _mm256_set1_ps(planes[k].y);
+    pz[k] = _mm256_set1_ps(planes[k].z);
+    pw[k] = _mm256_set1_ps(planes[k].w);
+  }
+  uint32_t j = 0;
+  for (; j + 8 <= in.numVolumes; j += 8) {
+    __m256 negRadius = _mm256_setzero_ps();
+    if (hasRadius)
+      negRadius = _mm256_sub_ps(negRadius, _mm256_loadu_ps(in.radius + j));
+    int mask = 0xFF;
+    for (uint32_t k = 0; k < 6; k++) {
+      auto &coords = in.coords[k];
+      __m256 d = _mm256_add_ps(
+          _mm256_add_ps(_mm256_mul_ps(px[k], _mm256_loadu_ps(coords[0] + j)),
+                        _mm256_mul_ps(py[k], _mm256_loadu_ps(coords[1] + j))),
+          _mm256_add_ps(_mm256_mul_ps(pz[k], _mm256_loadu_ps(coords[2] + j)),
+                        pw[k]));
+      mask &= _mm256_movemask_ps(_mm256_cmp_ps(negRadius, d, _CMP_LE_OQ));
+    }
+    for (uint32_t k = 0; k < 8; k++) {
+      out[numVisible] = j + k;
+      numVisible += (mask >> k) & 1;
+    }
+  }
+  end = j;
+  return numVisible;
+}
+
+template <bool hasRadius>
+NGFX_SIMD_AVX512_TARGET static uint32_t
+cull16(const vec4 *planes, const CullInput &in, uint32_t &end, uint32_t *out,
+       uint32_t numVisible) {
+  __m512 px[6], py[6], pz[6], pw[6];
+  for (uint32_t k = 0; k < 6; k++) {
+    px[k] = _mm512_set1_ps(planes[k].x);
+    py[k] = _mm512_set1_ps(planes[k].y);
+    pz[k] = _mm512_set1_ps(planes[k].z);
+    pw[k] = _mm512_set1_ps(planes[k].w);
+  }
+  const __m512i laneIndices =
+      _mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+  uint32_t j = 0;
+  for (; j + 16 <= in.numVolumes; j += 16) {
+    __m512 negRadius = _mm512_setzero_ps();
+    if (hasRadius)
+      negRadius = _mm512_sub_ps(negRadius, _mm512_loadu_ps(in.radius + j));
+    __mmask16 mask = 0xFFFF;
+    for (uint32_t k = 0; k < 6; k++) {
+      auto &coords = in.coords[k];
+      __m512 d = _mm512_add_ps(
+          _mm512_add_ps(_mm512_mul_ps(px[k], _mm512_loadu_ps(coords[0] + j)),
+                        _mm512_mul_ps(py[k], _mm512_loadu_ps(coords[1] + j))),
+          _mm512_add_ps(_mm512_mul_ps(pz[k], _mm512_loadu_ps(coords[2] + j)),
+                        pw[k]));
+      mask = _mm512_mask_cmp_ps_mask(mask, negRadius, d, _CMP_LE_OQ);
+    }
+    // Store the indices of the visible volumes next to each other
+    __m512i indices =
+        _mm512_add_epi32(_mm512_set1_epi32(int(j)), laneIndices);
+    _mm512_mask_compressstoreu_epi32(out + numVisible, mask, indices);
+    numVisible += uint32_t(bitset<16>(mask).count());
+  }
+  end = j;
+  return numVisible;
+}
+#endif
+
+template <bool hasRadius>
+static uint32_t cull(const vec4 *planes, const CullInput &in,
+                     uint32_t simdWidth, vector<uint32_t> &visible) {
+  if (!Frustum::isSIMDWidthSupported(simdWidth))
+    NGFX_ERR("unsupported SIMD width: %u", simdWidth);
+  visible.resize(in.numVolumes);
+  uint32_t *out = visible.data(), numVisible = 0, end = 0;
+#if defined(NGFX_SIMD_AVX)
+  if (simdWidth == 16)
+    numVisible = cull16<hasRadius>(planes, in, end, out, numVisible);
+  else if (simdWidth == 8)
+    numVisible = cull8<hasRadius>(planes, in, end, out, numVisible);
+#endif
+#if defined(NGFX_SIMD_SSE) || defined(NGFX_SIMD_NEON)
+  if (simdWidth == 4)
+    numVisible = cull4<hasRadius>(planes, in, end, out, numVisible);
+#endif
+  // The remaining volumes are tested one at a time
+  numVisible = cull1<hasRadius>(planes, in, end, out, numVisible);
+  visible.resize(numVisible);
+  return numVisible;
+}
+
+uint32_t Frustum::getMaxSIMDWidth() {
+  static const uint32_t maxSIMDWidth = isSIMDWidthSupported(16)  ? 16
+                                       : isSIMDWidthSupported(8) ? 8
+                                       : isSIMDWidthSupported(4) ? 4
+                                                                 : 1;
+  return maxSIMDWidth;
+}
+
+bool Frustum::isSIMDWidthSupported(uint32_t simdWidth) {
+  switch (simdWidth) {
+  case 1:
+    return true;
+#if defined(NGFX_SIMD_SSE) || defined(NGFX_SIMD_NEON)
+  case 4:
+    return true;
+#endif
+#if defined(NGFX_SIMD_AVX)
+  case 8:
+    return cpuSupports(SIMD_AVX2);
+  case 16:
+    return cpuSupports(SIMD_AVX512);
+#endif
+  default:
+    return false;
+  }
+}
+
+uint32_t Frustum::cull(const BoundingSphereArray &spheres,
+                       vector<uint32_t> &visible, uint32_t simdWidth) const {
+  CullInput in;
+  for (auto &coords : in.coords) {
+    coords[0] = spheres.centerX.data();
+    coords[1] = spheres.centerY.data();
+    coords[2] = spheres.centerZ.data();
+  }
+  in.radius = spheres.radius.data();
+  in.numVolumes = uint32_t(spheres.size());
+  return ::cull<true>(planes, in, simdWidth ? simdWidth : getMaxSIMDWidth(),
+                      visible);
+}
+
+uint32_t Frustum::cull(const BoundingBoxArray &boxes,
+                       vector<uint32_t> &visible, uint32_t simdWidth) const {
+  // Test the corner of each box that is the farthest inside each plane
+  CullInput in;
+  for (uint32_t k = 0; k < 6; k++) {
+    auto &plane = planes[k];
+    in.coords[k][0] = (plane.x >= 0.0f ? boxes.maxX : boxes.minX).data();
+    in.coords[k][1] = (plane.y >= 0.0f ? boxes.maxY : boxes.minY).data();
+    in.coords[k][2] = (plane.z >= 0.0f ? boxes.maxZ : boxes.minZ).data();
+  }
+  in.numVolumes = uint32_t(boxes.size());
+  return ::cull<false>(planes, in, simdWidth ? simdWidth : getMaxSIMDWidth(),
+                       visible);
+}
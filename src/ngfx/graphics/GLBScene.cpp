@@ -0,0 +1,458 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "ngfx/graphics/GLBScene.h"
+#include "ngfx/core/DebugUtil.h"
+#include "ngfx/core/ParallelUtil.h"
+#include "ngfx/graphics/MeshProcessor.h"
+#include <atomic>
+#include <cstring>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <json.hpp>
+using namespace ngfx;
+using namespace std;
+using json = nlohmann::json;
+
+static const uint32_t GLB_MAGIC = 0x46546C67, GLB_VERSION = 2;
+static const uint32_t CHUNK_TYPE_JSON = 0x4E4F534A, CHUNK_TYPE_BIN = 0x004E4942;
+
+// The glTF component types and primitive modes
+enum {
+  COMPONENT_TYPE_BYTE = 5120,
+  COMPONENT_TYPE_UNSIGNED_BYTE = 5121,
+  COMPONENT_TYPE_SHORT = 5122,
+  COMPONENT_TYPE_UNSIGNED_SHORT = 5123,
+  COMPONENT_TYPE_UNSIGNED_INT = 5125,
+  COMPONENT_TYPE_FLOAT = 5126
+};
+enum { MODE_TRIANGLES = 4, MODE_TRIANGLE_STRIP = 5, MODE_TRIANGLE_FAN = 6 };
+
+namespace {
+// An accessor, resolved to a pointer in the binary chunk
+struct Accessor {
+  uint32_t elementSize() const { return componentSize * numComponents; }
+  float readFloat(uint32_t j, uint32_t k) const;
+  uint32_t readIndex(uint32_t j) const;
+  const uint8_t *data = nullptr;
+  uint32_t count = 0, componentType = 0, componentSize = 0,
+           numComponents = 0, stride = 0;
+  bool normalized = false;
+};
+
+// The file data shared by the primitives
+struct GLBData {
+  json gltf;
+  const uint8_t *bin = nullptr;
+  size_t binSize = 0;
+  std::string file;
+};
+} // namespace
+
+// Read a component, converted to float
+float Accessor::readFloat(uint32_t j, uint32_t k) const {
+  const uint8_t *p = data + size_t(j) * stride + k * componentSize;
+  switch (componentType) {
+  case COMPONENT_TYPE_FLOAT: {
+    float v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+  }
+  case COMPONENT_TYPE_BYTE: {
+    int8_t v = int8_t(*p);
+    return normalized ? glm::max(v / 127.0f, -1.0f) : float(v);
+  }
+  case COMPONENT_TYPE_UNSIGNED_BYTE:
+    return normalized ? *p / 255.0f : float(*p);
+  case COMPONENT_TYPE_SHORT: {
+    int16_t v;
+    memcpy(&v, p, sizeof(v));
+    return normalized ? glm::max(v / 32767.0f, -1.0f) : float(v);
+  }
+  case COMPONENT_TYPE_UNSIGNED_SHORT: {
+    uint16_t v;
+    memcpy(&v, p, sizeof(v));
+    return normalized ? v / 65535.0f : float(v);
+  }
+  default: {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return float(v);
+  }
+  }
+}
+
+uint32_t Accessor::readIndex(uint32_t j) const {
+  const uint8_t *p = data + size_t(j) * stride;
+  if (componentSize == 1)
+    return *p;
+  if (componentSize == 2) {
+    uint16_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+  }
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static uint32_t getComponentSize(uint32_t componentType) {
+  switch (componentType) {
+  case COMPONENT_TYPE_BYTE:
+  case COMPONENT_TYPE_UNSIGNED_BYTE:
+    return 1;
+  case COMPONENT_TYPE_SHORT:
+  case COMPONENT_TYPE_UNSIGNED_SHORT:
+    return 2;
+  case COMPONENT_TYPE_UNSIGNED_INT:
+  case COMPONENT_TYPE_FLOAT:
+    return 4;
+  default:
+    return 0;
+  }
+}
+
+static uint32_t getNumComponents(const std::string &type) {
+  const char *types[] = {"SCALAR", "VEC2", "VEC3", "VEC4"};
+  for (uint32_t j = 0; j < 4; j++) {
+    if (type == types[j])
+      return j + 1;
+  }
+  return 0;
+}
+
+// Get an array of the glTF JSON, or an empty array
+static const json &getArray(const json &parent, const char *key) {
+  static const json emptyArray = json::array();
+  auto it = parent.find(key);
+  return (it != parent.end() && it->is_array()) ? *it : emptyArray;
+}
+
+static Accessor getAccessor(const GLBData &data, uint32_t index) {
+  const char *file = data.file.c_str();
+  auto &accessors = getArray(data.gltf, "accessors");
+  if (index >= accessors.size())
+    NGFX_ERR("%s: invalid accessor: %u", file, index);
+  auto &accessor = accessors[index];
+  if (accessor.contains("sparse"))
+    NGFX_ERR("%s: accessor %u: sparse accessors are not supported", file,
+             index);
+  Accessor a;
+  a.componentType = accessor.value("componentType", 0u);
+  a.componentSize = getComponentSize(a.componentType);
+  a.numComponents = getNumComponents(accessor.value("type", ""));
+  a.count = accessor.value("count", 0u);
+  a.normalized = accessor.value("normalized", false);
+  if (a.componentSize == 0 || a.numComponents == 0)
+    NGFX_ERR("%s: accessor %u: unsupported type", file, index);
+  auto &bufferViews = getArray(data.gltf, "bufferViews");
+  uint32_t bufferViewIndex = accessor.value("bufferView", ~0u);
+  if (bufferViewIndex >= bufferViews.size())
+    NGFX_ERR("%s: accessor %u: invalid buffer view", file, index);
+  auto &bufferView = bufferViews[bufferViewIndex];
+  if (bufferView.value("buffer", 0u) != 0)
+    NGFX_ERR("%s: accessor %u: only the binary chunk buffer is supported",
+             file, index);
+  if (!data.bin)
+    NGFX_ERR("%s: missing or truncated binary chunk", file);
+  size_t viewOffset = bufferView.value("byteOffset", size_t(0)),
+         viewSize = bufferView.value("byteLength", size_t(0)),
+         offset = accessor.value("byteOffset", size_t(0));
+  a.stride = bufferView.value("byteStride", a.elementSize());
+  size_t size = a.count ? size_t(a.count - 1) * a.stride + a.elementSize() : 0;
+  if (viewOffset + viewSize > data.binSize || offset + size > viewSize)
+    NGFX_ERR("%s: accessor %u is out of bounds", file, index);
+  a.data = data.bin + viewOffset + offset;
+  return a;
+}
+
+// Read a position or a normal attribute
+static void readAttribute(const uint8_t *data, uint32_t stride,
+                          uint32_t count, std::vector<vec3> &v) {
+  v.resize(count);
+  for (uint32_t j = 0; j < count; j++)
+    memcpy(&v[j], data + size_t(j) * stride, sizeof(vec3));
+}
+
+static uint32_t readIndex(const MeshView &view, uint32_t j) {
+  if (view.indexSize == 2) {
+    uint16_t index;
+    memcpy(&index, view.indices + size_t(j) * 2, sizeof(index));
+    return index;
+  }
+  uint32_t index;
+  memcpy(&index, view.indices + size_t(j) * 4, sizeof(index));
+  return index;
+}
+
+static void readMesh(const MeshView &view, MeshData &meshData) {
+  readAttribute(view.pos, view.posStride, view.numVerts, meshData.pos);
+  if (view.normal)
+    readAttribute(view.normal, view.normalStride, view.numVerts,
+                  meshData.normal);
+  meshData.faces.resize(view.numFaces);
+  for (uint32_t j = 0; j < view.numFaces; j++) {
+    for (uint32_t k = 0; k < 3; k++)
+      meshData.faces[j][k] = int(readIndex(view, j * 3 + k));
+  }
+  meshData.bounds[0] = view.bounds[0];
+  meshData.bounds[1] = view.bounds[1];
+}
+
+static void loadPrimitive(const GLBData &data, const json &gltfPrimitive,
+                          GLBScene::Primitive &primitive) {
+  const char *file = data.file.c_str();
+  auto &view = primitive.view;
+  auto it = gltfPrimitive.find("attributes");
+  if (it == gltfPrimitive.end() || !it->contains("POSITION"))
+    NGFX_ERR("%s: mesh %u: a primitive doesn't have positions", file,
+             primitive.mesh);
+  auto &attributes = *it;
+
+  // Positions
+  Accessor pos = getAccessor(data, attributes["POSITION"].get<uint32_t>());
+  uint32_t numVerts = view.numVerts = pos.count;
+  if (pos.componentType == COMPONENT_TYPE_FLOAT && pos.numComponents == 3 &&
+      pos.stride % 4 == 0) {
+    view.pos = pos.data;
+    view.posStride = pos.stride;
+  } else {
+    primitive.pos.resize(numVerts * sizeof(vec3));
+    vec3 *p = (vec3 *)primitive.pos.data();
+    for (uint32_t j = 0; j < numVerts; j++)
+      p[j] = vec3(pos.readFloat(j, 0), pos.readFloat(j, 1),
+                  pos.readFloat(j, 2));
+    view.pos = primitive.pos.data();
+    view.posStride = sizeof(vec3);
+  }
+  for (uint32_t j = 0; j < numVerts; j++) {
+    vec3 p;
+    memcpy(&p, view.pos + size_t(j) * view.posStride, sizeof(p));
+    view.bounds[0] = glm::min(view.bounds[0], p);
+    view.bounds[1] = glm::max(view.bounds[1], p);
+  }
+
+  // Indices. The triangle lists with 16 or 32-bit indices are read in
+  // place, the other primitives are converted to triangle lists
+  uint32_t mode = gltfPrimitive.value("mode", uint32_t(MODE_TRIANGLES));
+  bool hasIndices = gltfPrimitive.contains("indices");
+  Accessor indices;
+  if (hasIndices)
+    indices =
+        getAccessor(data, gltfPrimitive["indices"].get<uint32_t>());
+  uint32_t numIndices = hasIndices ? indices.count : numVerts;
+  if (hasIndices && mode == MODE_TRIANGLES && indices.componentSize >= 2 &&
+      indices.numComponents == 1 && indices.stride == indices.componentSize) {
+    view.indices = indices.data;
+    view.indexSize = indices.componentSize;
+    view.numFaces = numIndices / 3;
+  } else {
+    auto getIndex = [&](uint32_t j) {
+      return hasIndices ? indices.readIndex(j) : j;
+    };
+    std::vector<uint32_t> triangles;
+    if (mode == MODE_TRIANGLES) {
+      for (uint32_t j = 0; j + 2 < numIndices; j += 3)
+        triangles.insert(triangles.end(),
+                         {getIndex(j), getIndex(j + 1), getIndex(j + 2)});
+    } else if (mode == MODE_TRIANGLE_STRIP) {
+      // Every other triangle is flipped, to keep the winding order
+      for (uint32_t j = 0; j + 2 < numIndices; j++)
+        triangles.insert(triangles.end(), {getIndex(j), getIndex(j + 1 + j % 2),
+                                           getIndex(j + 2 - j % 2)});
+    } else {
+      for (uint32_t j = 1; j + 1 < numIndices; j++)
+        triangles.insert(triangles.end(),
+                         {getIndex(j), getIndex(j + 1), getIndex(0)});
+    }
+    view.numFaces = uint32_t(triangles.size() / 3);
+    view.indexSize = (numVerts <= 65536) ? 2 : 4;
+    primitive.indices.resize(triangles.size() * view.indexSize);
+    for (uint32_t j = 0; j < triangles.size(); j++) {
+      if (view.indexSize == 2) {
+        uint16_t index = uint16_t(triangles[j]);
+        memcpy(&primitive.indices[j * 2], &index, sizeof(index));
+      } else
+        memcpy(&primitive.indices[j * 4], &triangles[j], sizeof(uint32_t));
+    }
+    view.indices = primitive.indices.data();
+  }
+  for (uint32_t j = 0; j < view.numFaces * 3; j++) {
+    if (readIndex(view, j) >= numVerts)
+      NGFX_ERR("%s: mesh %u: invalid index: %u", file, primitive.mesh,
+               readIndex(view, j));
+  }
+
+  // Normals. The missing normals are generated from the triangles
+  if (attributes.contains("NORMAL")) {
+    Accessor normal =
+        getAccessor(data, attributes["NORMAL"].get<uint32_t>());
+    if (normal.count != numVerts)
+      NGFX_ERR("%s: mesh %u: %u vertices, %u normals", file, primitive.mesh,
+               numVerts, normal.count);
+    if (normal.componentType == COMPONENT_TYPE_FLOAT &&
+        normal.numComponents == 3 && normal.stride % 4 == 0) {
+      view.normal = normal.data;
+      view.normalStride = normal.stride;
+      return;
+    }
+    primitive.normal.resize(numVerts * sizeof(vec3));
+    vec3 *n = (vec3 *)primitive.normal.data();
+    for (uint32_t j = 0; j < numVerts; j++)
+      n[j] = normalize(vec3(normal.readFloat(j, 0), normal.readFloat(j, 1),
+                            normal.readFloat(j, 2)));
+  } else {
+    MeshData meshData;
+    readMesh(view, meshData);
+    MeshProcessor::generateNormals(
+        meshData, MeshProcessor::NORMAL_WEIGHTING_AREA_ANGLE, 1);
+    primitive.normal.resize(numVerts * sizeof(vec3));
+    memcpy(primitive.normal.data(), meshData.normal.data(),
+           primitive.normal.size());
+  }
+  view.normal = primitive.normal.data();
+  view.normalStride = sizeof(vec3);
+}
+
+static mat4 getNodeTransform(const json &node) {
+  auto &matrix = getArray(node, "matrix");
+  if (matrix.size() == 16) {
+    mat4 m;
+    for (uint32_t j = 0; j < 16; j++)
+      m[j / 4][j % 4] = matrix[j].get<float>();
+    return m;
+  }
+  vec3 t(0.0f), s(1.0f);
+  quat r(1.0f, 0.0f, 0.0f, 0.0f);
+  auto &translation = getArray(node, "translation"),
+       &rotation = getArray(node, "rotation"), &scale = getArray(node, "scale");
+  if (translation.size() == 3)
+    t = vec3(translation[0].get<float>(), translation[1].get<float>(),
+             translation[2].get<float>());
+  if (rotation.size() == 4)
+    r = quat(rotation[3].get<float>(), rotation[0].get<float>(),
+             rotation[1].get<float>(), rotation[2].get<float>());
+  if (scale.size() == 3)
+    s = vec3(scale[0].get<float>(), scale[1].get<float>(),
+             scale[2].get<float>());
+  return glm::translate(mat4(1.0f), t) * mat4_cast(r) *
+         glm::scale(mat4(1.0f), s);
+}
+
+void GLBScene::load(const std::string &file, uint32_t numThreads) {
+  primitives.clear();
+  meshes.clear();
+  instances.clear();
+  mappedFile.open(file);
+  const uint8_t *p = mappedFile.data;
+  size_t size = mappedFile.size;
+  uint32_t header[5] = {};
+  if (size >= sizeof(header))
+    memcpy(header, p, sizeof(header));
+  if (header[0] != GLB_MAGIC)
+    NGFX_ERR("%s: not a binary glTF file", file.c_str());
+  if (header[1] != GLB_VERSION)
+    NGFX_ERR("%s: unsupported version: %u", file.c_str(), header[1]);
+  // The JSON chunk is followed by an optional binary chunk
+  size_t jsonSize = header[3], binOffset = sizeof(header) + jsonSize;
+  if (header[4] != CHUNK_TYPE_JSON || binOffset > size)
+    NGFX_ERR("%s: invalid JSON chunk", file.c_str());
+  GLBData data;
+  data.file = file;
+  data.gltf = json::parse(p + sizeof(header), p + binOffset, nullptr, false);
+  if (data.gltf.is_discarded() || !data.gltf.is_object())
+    NGFX_ERR("%s: invalid JSON", file.c_str());
+  if (binOffset + 8 <= size) {
+    uint32_t chunkHeader[2];
+    memcpy(chunkHeader, p + binOffset, sizeof(chunkHeader));
+    if (chunkHeader[1] == CHUNK_TYPE_BIN &&
+        binOffset + 8 + chunkHeader[0] <= size) {
+      data.bin = p + binOffset + 8;
+      data.binSize = chunkHeader[0];
+    }
+  }
+
+  // The triangle primitives of each mesh
+  std::vector<const json *> gltfPrimitives;
+  auto &gltfMeshes = getArray(data.gltf, "meshes");
+  meshes.resize(gltfMeshes.size());
+  for (uint32_t j = 0; j < gltfMeshes.size(); j++) {
+    auto &mesh = meshes[j];
+    mesh.name = gltfMeshes[j].value("name", "");
+    mesh.firstPrimitive = uint32_t(gltfPrimitives.size());
+    for (auto &gltfPrimitive : getArray(gltfMeshes[j], "primitives")) {
+      uint32_t mode = gltfPrimitive.value("mode", uint32_t(MODE_TRIANGLES));
+      if (mode < MODE_TRIANGLES || mode > MODE_TRIANGLE_FAN)
+        continue;
+      gltfPrimitives.push_back(&gltfPrimitive);
+    }
+    mesh.numPrimitives = uint32_t(gltfPrimitives.size()) - mesh.firstPrimitive;
+  }
+  primitives.resize(gltfPrimitives.size());
+  for (auto &mesh : meshes) {
+    for (uint32_t j = 0; j < mesh.numPrimitives; j++)
+      primitives[mesh.firstPrimitive + j].mesh = uint32_t(&mesh - &meshes[0]);
+  }
+  // The primitives have very different sizes, so the threads take the
+  // next primitive until there are none left
+  numThreads =
+      ParallelUtil::getNumThreads(numThreads, primitives.size(), 1);
+  std::atomic<uint32_t> nextPrimitive(0);
+  ParallelUtil::parallelFor(
+      numThreads, numThreads, [&](uint32_t, size_t, size_t) {
+        for (uint32_t j = nextPrimitive++; j < primitives.size();
+             j = nextPrimitive++)
+          loadPrimitive(data, *gltfPrimitives[j], primitives[j]);
+      });
+
+  // The instances of the meshes in the default scene
+  auto &nodes = getArray(data.gltf, "nodes");
+  auto &scenes = getArray(data.gltf, "scenes");
+  std::vector<uint32_t> rootNodes;
+  uint32_t scene = data.gltf.value("scene", 0u);
+  if (scene < scenes.size()) {
+    for (auto &node : getArray(scenes[scene], "nodes"))
+      rootNodes.push_back(node.get<uint32_t>());
+  }
+  std::vector<std::pair<uint32_t, mat4>> stack;
+  for (auto it = rootNodes.rbegin(); it != rootNodes.rend(); it++)
+    stack.push_back({*it, mat4(1.0f)});
+  std::vector<bool> visited(nodes.size(), false);
+  while (!stack.empty()) {
+    auto [nodeIndex, parentTransform] = stack.back();
+    stack.pop_back();
+    if (nodeIndex >= nodes.size() || visited[nodeIndex])
+      NGFX_ERR("%s: invalid node hierarchy", file.c_str());
+    visited[nodeIndex] = true;
+    auto &node = nodes[nodeIndex];
+    mat4 transform = parentTransform * getNodeTransform(node);
+    uint32_t mesh = node.value("mesh", ~0u);
+    if (mesh < meshes.size())
+      instances.push_back({mesh, transform});
+    auto &children = getArray(node, "children");
+    for (auto it = children.rbegin(); it != children.rend(); it++)
+      stack.push_back({it->get<uint32_t>(), transform});
+  }
+}
+
+void GLBScene::getMeshData(uint32_t primitive, MeshData &meshData) const {
+  meshData = MeshData();
+  readMesh(primitives[primitive].view, meshData);
+}
@@ -0,0 +1,142 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "ngfx/graphics/GPUProfiler.h"
+#include "ngfx/core/DebugUtil.h"
+#include "ngfx/core/StringUtil.h"
+#include <fstream>
+#include <iomanip>
+using namespace ngfx;
+using namespace std;
+
+void GPUProfiler::init(uint32_t numFrames, uint32_t maxRegions) {
+  frames.resize(numFrames);
+  maxQueries = 2 * maxRegions;
+}
+
+void GPUProfiler::beginFrame(CommandBuffer *commandBuffer) {
+  if (!enabled)
+    return;
+  uint32_t frameSlot = uint32_t(frameIndex % frames.size());
+  resolveFrame(frameSlot);
+  auto &frame = frames[frameSlot];
+  frame.index = frameIndex++;
+  frame.regions.clear();
+  frame.numQueries = 0;
+  resetQueries(commandBuffer, frameSlot);
+  regionStack.clear();
+  currentFrameSlot = int32_t(frameSlot);
+}
+
+void GPUProfiler::beginRegion(CommandBuffer *commandBuffer,
+                              const std::string &name) {
+  if (!enabled || currentFrameSlot == -1)
+    return;
+  auto &frame = frames[currentFrameSlot];
+  if (frame.numQueries + 2 > maxQueries) {
+    regionStack.push_back(UINT32_MAX);
+    return;
+  }
+  uint32_t beginQuery = frame.numQueries;
+  frame.numQueries += 2;
+  writeTimestamp(commandBuffer, uint32_t(currentFrameSlot), beginQuery, true);
+  regionStack.push_back(uint32_t(frame.regions.size()));
+  frame.regions.push_back({name, uint32_t(regionStack.size() - 1), beginQuery,
+                           UINT32_MAX});
+}
+
+void GPUProfiler::endRegion(CommandBuffer *commandBuffer) {
+  if (!enabled || currentFrameSlot == -1)
+    return;
+  if (regionStack.empty())
+    NGFX_ERR("endRegion called without a matching beginRegion");
+  uint32_t regionIndex = regionStack.back();
+  regionStack.pop_back();
+  if (regionIndex == UINT32_MAX)
+    return;
+  auto &region = frames[currentFrameSlot].regions[regionIndex];
+  region.endQuery = region.beginQuery + 1;
+  writeTimestamp(commandBuffer, uint32_t(currentFrameSlot), region.endQuery,
+                 false);
+}
+
+void GPUProfiler::resolveFrame(uint32_t frameSlot) {
+  auto &frame = frames[frameSlot];
+  if (frame.regions.empty())
+    return;
+  vector<uint64_t> timestamps;
+  vector<bool> available;
+  getTimestamps(frameSlot, frame.numQueries, timestamps, available);
+  // Regions that were still open at the end of the frame are ignored,
+  // their end timestamp is never written
+  vector<const PendingRegion *> closedRegions;
+  for (auto &region : frame.regions) {
+    if (region.endQuery == UINT32_MAX)
+      continue;
+    if (!available[region.beginQuery] || !available[region.endQuery]) {
+      numDroppedFrames++;
+      return;
+    }
+    closedRegions.push_back(&region);
+  }
+  if (closedRegions.empty())
+    return;
+  // The other timestamps of the frame follow its first one, so they are
+  // unwrapped with their difference to it, modulo the valid bits
+  uint64_t frameStart = timestamps[closedRegions[0]->beginQuery];
+  if (!timelineStarted) {
+    lastFrameStart = frameStart;
+    timelineStarted = true;
+  }
+  lastFrameOffset += (frameStart - lastFrameStart) & timestampMask;
+  lastFrameStart = frameStart;
+  auto toMs = [&](uint64_t ticks) {
+    return double(ticks) * timestampPeriod * 1e-6;
+  };
+  results.clear();
+  for (auto region : closedRegions) {
+    uint64_t t0 = (timestamps[region->beginQuery] - frameStart) & timestampMask,
+             t1 = (timestamps[region->endQuery] - frameStart) & timestampMask;
+    results.push_back({region->name, region->depth, frame.index,
+                       toMs(lastFrameOffset + t0), toMs(t1 - t0)});
+  }
+  if (enableTrace)
+    trace.insert(trace.end(), results.begin(), results.end());
+}
+
+void GPUProfiler::exportChromeTrace(const std::string &filename) {
+  ofstream out(filename);
+  if (!out.is_open())
+    NGFX_ERR("cannot open file: %s", filename.c_str());
+  // Complete events ("ph":"X"), with the timestamps in microseconds.
+  // Nested regions are displayed as a stack on the same track.
+  out << fixed << setprecision(3) << "{\"traceEvents\":[";
+  for (uint32_t j = 0; j < trace.size(); j++) {
+    auto &region = trace[j];
+    out << (j == 0 ? "\n" : ",\n") << "{\"name\":\""
+        << StringUtil::escapeJSON(region.name)
+        << "\",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":0,\"tid\":0"
+        << ",\"ts\":" << region.start * 1000.0
+        << ",\"dur\":" << region.duration * 1000.0
+        << ",\"args\":{\"frame\":" << region.frame << "}}";
+  }
+  out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+  out.close();
+}
@@ -19,6 +19,8 @@
  * under the License.
  */
 #include "ngfx/graphics/GraphicsPipeline.h"
+#include "ngfx/core/DebugUtil.h"
+#include <algorithm>
 #include <set>
 using namespace ngfx;
 
@@ -30,3 +32,40 @@ void GraphicsPipeline::getBindings(
   for (uint32_t j = 0; j < pVertexAttribBindings.size(); j++)
     *pVertexAttribBindings[j] = vertexAttributeBindings[j];
 }
+
+std::vector<GraphicsPipeline::VertexInput> GraphicsPipeline::getVertexInputs(
+    VertexShaderModule *vs,
+    const std::vector<VertexBufferLayout> &vertexBufferLayouts) {
+  auto &attributes = vs->attributes;
+  std::vector<VertexInput> vertexInputs(attributes.size());
+  std::vector<bool> interleaved(attributes.size(), false);
+  auto findAttribute = [&](const std::string &name) -> int32_t {
+    for (uint32_t j = 0; j < attributes.size(); j++)
+      if (attributes[j].name == name)
+        return int32_t(j);
+    return -1;
+  };
+  for (auto &layout : vertexBufferLayouts) {
+    uint32_t binding = UINT32_MAX;
+    std::vector<int32_t> indices;
+    for (auto &attr : layout.attributes) {
+      int32_t index = findAttribute(attr.name);
+      if (index == -1)
+        NGFX_ERR("vertex attribute %s not found", attr.name.c_str());
+      binding = std::min(binding, attributes[index].location);
+      indices.push_back(index);
+    }
+    for (uint32_t j = 0; j < indices.size(); j++) {
+      vertexInputs[indices[j]] = {binding, layout.attributes[j].offset,
+                                  layout.stride};
+      interleaved[indices[j]] = true;
+    }
+  }
+  for (uint32_t j = 0; j < attributes.size(); j++) {
+    if (interleaved[j])
+      continue;
+    auto &attr = attributes[j];
+    vertexInputs[j] = {attr.location, 0, attr.elementSize * attr.count};
+  }
+  return vertexInputs;
+}
@@ -0,0 +1,193 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "ngfx/graphics/ImageWriter.h"
+#include "ngfx/core/DebugUtil.h"
+#include "ngfx/core/Trace.h"
+#include <algorithm>
+#include <cctype>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+using namespace ngfx;
+using namespace std;
+using namespace std::chrono;
+
+// Rewrite the integer conversion of the pattern for a uint64_t argument,
+// keeping its flags and width, e.g. "frame_%05d.png" -> "frame_%05" PRIu64
+// ".png". The pattern must have exactly one conversion
+static string getFilenameFormat(const string &pattern) {
+  string format;
+  uint32_t numConversions = 0;
+  for (size_t j = 0; j < pattern.size(); j++) {
+    format += pattern[j];
+    if (pattern[j] != '%')
+      continue;
+    if (j + 1 < pattern.size() && pattern[j + 1] == '%') {
+      format += pattern[++j];
+      continue;
+    }
+    j++;
+    while (j < pattern.size() && strchr("0-+ ", pattern[j]))
+      format += pattern[j++];
+    while (j < pattern.size() && isdigit((unsigned char)pattern[j]))
+      format += pattern[j++];
+    while (j < pattern.size() && strchr("hljz", pattern[j]))
+      j++;
+    if (j == pattern.size() || !strchr("diu", pattern[j]))
+      NGFX_ERR("invalid filename pattern: %s", pattern.c_str());
+    format += PRIu64;
+    numConversions++;
+  }
+  if (numConversions != 1)
+    NGFX_ERR("filename pattern needs one frame index specifier: %s",
+             pattern.c_str());
+  return format;
+}
+
+ImageWriter::ImageWriter(const std::string &filenamePattern,
+                         FileFormat fileFormat, uint32_t numThreads,
+                         uint32_t maxQueuedFrames)
+    : filenamePattern(filenamePattern),
+      filenameFormat(getFilenameFormat(filenamePattern)),
+      fileFormat(fileFormat), maxQueuedFrames(maxQueuedFrames) {
+  if (numThreads == 0)
+    numThreads = std::max(thread::hardware_concurrency(), 1u);
+  t0 = steady_clock::now();
+  for (uint32_t j = 0; j < numThreads; j++)
+    workers.emplace_back(&ImageWriter::run, this);
+}
+
+ImageWriter::~ImageWriter() {
+  finish();
+  {
+    lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  jobAvailable.notify_all();
+  for (auto &worker : workers)
+    worker.join();
+}
+
+void ImageWriter::write(uint64_t frameIndex, const void *data, uint32_t w,
+                        uint32_t h) {
+  NGFX_TRACE_SCOPE("ImageWriter::write");
+  uint32_t size = w * h * 4;
+  Job job = {frameIndex, w, h, {}};
+  {
+    unique_lock<std::mutex> lock(mutex);
+    auto t = steady_clock::now();
+    slotAvailable.wait(lock, [&] {
+      return (jobs.size() + numActiveJobs) < maxQueuedFrames;
+    });
+    stats.waitTime +=
+        duration_cast<duration<double>>(steady_clock::now() - t).count();
+    if (!freeBuffers.empty()) {
+      job.data = std::move(freeBuffers.back());
+      freeBuffers.pop_back();
+    }
+  }
+  // Copy outside of the lock, the workers can make progress meanwhile
+  job.data.resize(size);
+  memcpy(job.data.data(), data, size);
+  {
+    lock_guard<std::mutex> lock(mutex);
+    jobs.emplace_back(std::move(job));
+  }
+  jobAvailable.notify_one();
+}
+
+void ImageWriter::finish() {
+  unique_lock<std::mutex> lock(mutex);
+  jobsDone.wait(lock, [&] { return jobs.empty() && numActiveJobs == 0; });
+}
+
+ImageWriter::Stats ImageWriter::getStats() {
+  lock_guard<std::mutex> lock(mutex);
+  Stats result = stats;
+  result.elapsed =
+      duration_cast<duration<double>>(steady_clock::now() - t0).count();
+  return result;
+}
+
+void ImageWriter::run() {
+  Trace::setThreadName("ImageWriter");
+  while (true) {
+    Job job;
+    {
+      unique_lock<std::mutex> lock(mutex);
+      jobAvailable.wait(lock, [&] { return stopping || !jobs.empty(); });
+      if (jobs.empty())
+        return;
+      job = std::move(jobs.front());
+      jobs.pop_front();
+      numActiveJobs++;
+    }
+    auto t = steady_clock::now();
+    encode(job);
+    double encodeTime =
+        duration_cast<duration<double>>(steady_clock::now() - t).count();
+    {
+      lock_guard<std::mutex> lock(mutex);
+      numActiveJobs--;
+      stats.numFramesWritten++;
+      stats.numBytesWritten += job.data.size();
+      stats.encodeTime += encodeTime;
+      freeBuffers.emplace_back(std::move(job.data));
+    }
+    slotAvailable.notify_one();
+    jobsDone.notify_all();
+  }
+}
+
+void ImageWriter::encode(const Job &job) {
+  NGFX_TRACE_SCOPE("ImageWriter::encode");
+  char filename[1024];
+  if (snprintf(filename, sizeof(filename), filenameFormat.c_str(),
+               job.frameIndex) >= int(sizeof(filename)))
+    NGFX_ERR("filename is too long: %s", filenamePattern.c_str());
+  uint32_t w = job.w, h = job.h;
+  const uint8_t *data = job.data.data();
+  if (fileFormat == FILE_FORMAT_PNG) {
+    if (!stbi_write_png(filename, int(w), int(h), 4, data, int(w * 4)))
+      NGFX_ERR("cannot write file: %s", filename);
+    return;
+  }
+  ofstream out(filename, ios::binary);
+  if (!out.is_open())
+    NGFX_ERR("cannot open file: %s", filename);
+  if (fileFormat == FILE_FORMAT_PPM) {
+    // PPM doesn't support an alpha channel
+    out << "P6\n" << w << " " << h << "\n255\n";
+    vector<uint8_t> rgb(w * h * 3);
+    for (uint32_t j = 0; j < w * h; j++) {
+      rgb[3 * j] = data[4 * j];
+      rgb[3 * j + 1] = data[4 * j + 1];
+      rgb[3 * j + 2] = data[4 * j + 2];
+    }
+    out.write((const char *)rgb.data(), rgb.size());
+  } else {
+    out.write((const char *)data, job.data.size());
+  }
+  out.close();
+}
@@ -0,0 +1,370 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "ngfx/graphics/KTXFile.h"
+#include "ngfx/core/DebugUtil.h"
+#include "ngfx/core/MappedFile.h"
+#include "ngfx/graphics/PixelFormatUtil.h"
+#include "ngfx/graphics/TextureCodec.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+using namespace ngfx;
+using namespace std;
+
+static const uint8_t KTX2_IDENTIFIER[12] = {0xAB, 0x4B, 0x54, 0x58,
+                                            0x20, 0x32, 0x30, 0xBB,
+                                            0x0D, 0x0A, 0x1A, 0x0A};
+namespace {
+struct KTXHeader {
+  uint8_t identifier[12];
+  uint32_t vkFormat, typeSize, pixelWidth, pixelHeight, pixelDepth,
+      layerCount, faceCount, levelCount, supercompressionScheme;
+  uint32_t dfdByteOffset, dfdByteLength, kvdByteOffset, kvdByteLength;
+  uint64_t sgdByteOffset, sgdByteLength;
+};
+struct KTXLevelIndex {
+  uint64_t byteOffset, byteLength, uncompressedByteLength;
+};
+/** A sample of the basic data format descriptor */
+struct DFDSample {
+  uint8_t channelType;
+  uint16_t bitOffset, bitLength;
+  uint32_t sampleLower, sampleUpper;
+};
+} // namespace
+static_assert(sizeof(KTXHeader) == 80, "invalid KTX2 header");
+
+// Data format descriptor constants, from the Khronos data format
+// specification
+#define KHR_DF_MODEL_RGBSDA 1
+#define KHR_DF_MODEL_BC1A 128
+#define KHR_DF_MODEL_BC3 130
+#define KHR_DF_MODEL_BC4 131
+#define KHR_DF_MODEL_BC5 132
+#define KHR_DF_MODEL_BC7 134
+#define KHR_DF_MODEL_ETC2 161
+#define KHR_DF_MODEL_ASTC 162
+#define KHR_DF_CHANNEL_ALPHA 15
+#define KHR_DF_SAMPLE_DATATYPE_SIGNED 0x40
+#define KHR_DF_SAMPLE_DATATYPE_FLOAT 0x80
+#define KHR_DF_PRIMARIES_BT709 1
+#define KHR_DF_TRANSFER_LINEAR 1
+#define KHR_DF_TRANSFER_SRGB 2
+
+static void getDFD(const PixelFormatUtil::FormatInfo *formatInfo,
+                   uint8_t &colorModel, vector<DFDSample> &samples) {
+  auto format = formatInfo->format;
+  uint16_t blockBits = uint16_t(formatInfo->blockSize * 8);
+  samples.clear();
+  switch (format) {
+  case PIXELFORMAT_BC1_RGBA_UNORM:
+  case PIXELFORMAT_BC1_RGBA_SRGB:
+    // The channel 1 of the BC1A model means that alpha is present
+    colorModel = KHR_DF_MODEL_BC1A;
+    samples = {{1, 0, 64, 0, UINT32_MAX}};
+    return;
+  case PIXELFORMAT_BC3_UNORM:
+  case PIXELFORMAT_BC3_SRGB:
+    colorModel = KHR_DF_MODEL_BC3;
+    samples = {{KHR_DF_CHANNEL_ALPHA, 0, 64, 0, UINT32_MAX},
+               {0, 64, 64, 0, UINT32_MAX}};
+    return;
+  case PIXELFORMAT_BC4_UNORM:
+    colorModel = KHR_DF_MODEL_BC4;
+    samples = {{0, 0, 64, 0, UINT32_MAX}};
+    return;
+  case PIXELFORMAT_BC5_UNORM:
+    colorModel = KHR_DF_MODEL_BC5;
+    samples = {{0, 0, 64, 0, UINT32_MAX}, {1, 64, 64, 0, UINT32_MAX}};
+    return;
+  case PIXELFORMAT_BC7_UNORM:
+  case PIXELFORMAT_BC7_SRGB:
+    colorModel = KHR_DF_MODEL_BC7;
+    samples = {{0, 0, 128, 0, UINT32_MAX}};
+    return;
+  case PIXELFORMAT_ETC2_RGB8_UNORM:
+  case PIXELFORMAT_ETC2_RGB8_SRGB:
+    colorModel = KHR_DF_MODEL_ETC2;
+    samples = {{0, 0, 64, 0, UINT32_MAX}};
+    return;
+  case PIXELFORMAT_ETC2_RGBA8_UNORM:
+  case PIXELFORMAT_ETC2_RGBA8_SRGB:
+    // The channel 2 of the ETC2 model is the color
+    colorModel = KHR_DF_MODEL_ETC2;
+    samples = {{KHR_DF_CHANNEL_ALPHA, 0, 64, 0, UINT32_MAX},
+               {2, 64, 64, 0, UINT32_MAX}};
+    return;
+  case PIXELFORMAT_ASTC_4X4_UNORM:
+  case PIXELFORMAT_ASTC_4X4_SRGB:
+    colorModel = KHR_DF_MODEL_ASTC;
+    samples = {{0, 0, 128, 0, UINT32_MAX}};
+    return;
+  default:
+    break;
+  }
+  colorModel = KHR_DF_MODEL_RGBSDA;
+  uint32_t numChannels;
+  switch (format) {
+  case PIXELFORMAT_R8_UNORM:
+  case PIXELFORMAT_R16_UINT:
+  case PIXELFORMAT_R16_SFLOAT:
+  case PIXELFORMAT_R32_UINT:
+  case PIXELFORMAT_R32_SFLOAT:
+    numChannels = 1;
+    break;
+  case PIXELFORMAT_RG8_UNORM:
+  case PIXELFORMAT_RG16_UINT:
+  case PIXELFORMAT_RG16_SFLOAT:
+  case PIXELFORMAT_RG32_UINT:
+  case PIXELFORMAT_RG32_SFLOAT:
+    numChannels = 2;
+    break;
+  default:
+    numChannels = 4;
+    break;
+  }
+  bool isFloat = format == PIXELFORMAT_R16_SFLOAT ||
+                 format == PIXELFORMAT_RG16_SFLOAT ||
+                 format == PIXELFORMAT_RGBA16_SFLOAT ||
+                 format == PIXELFORMAT_R32_SFLOAT ||
+                 format == PIXELFORMAT_RG32_SFLOAT ||
+                 format == PIXELFORMAT_RGBA32_SFLOAT;
+  bool isInteger = format == PIXELFORMAT_R16_UINT ||
+                   format == PIXELFORMAT_RG16_UINT ||
+                   format == PIXELFORMAT_RGBA16_UINT ||
+                   format == PIXELFORMAT_R32_UINT ||
+                   format == PIXELFORMAT_RG32_UINT ||
+                   format == PIXELFORMAT_RGBA32_UINT;
+  const uint8_t rgbaChannels[4] = {0, 1, 2, KHR_DF_CHANNEL_ALPHA},
+                bgraChannels[4] = {2, 1, 0, KHR_DF_CHANNEL_ALPHA};
+  const uint8_t *channels =
+      (format == PIXELFORMAT_BGRA8_UNORM) ? bgraChannels : rgbaChannels;
+  uint16_t bitLength = uint16_t(blockBits / numChannels);
+  for (uint32_t j = 0; j < numChannels; j++) {
+    DFDSample sample = {channels[j], uint16_t(j * bitLength), bitLength, 0,
+                        0};
+    if (isFloat) {
+      // The bounds of the float channels are -1.0 and 1.0
+      sample.channelType |=
+          KHR_DF_SAMPLE_DATATYPE_FLOAT | KHR_DF_SAMPLE_DATATYPE_SIGNED;
+      sample.sampleLower = 0xBF800000;
+      sample.sampleUpper = 0x3F800000;
+    } else if (isInteger) {
+      sample.sampleUpper = 1;
+    } else {
+      sample.sampleUpper = (1u << bitLength) - 1;
+    }
+    samples.push_back(sample);
+  }
+}
+
+static uint32_t getLevelAlignment(uint32_t blockSize) {
+  // The least common multiple of the block size and 4
+  uint32_t alignment = blockSize;
+  while (alignment % 4 != 0)
+    alignment += blockSize;
+  return alignment;
+}
+
+uint32_t KTXFile::getLevelSize(uint32_t level) const {
+  return PixelFormatUtil::getLevelSize(format, w, h, d, arrayLayers * numFaces,
+                                       level);
+}
+
+uint32_t KTXFile::getLevelOffset(uint32_t level) const {
+  uint64_t offset = 0;
+  for (uint32_t j = 0; j < level; j++) {
+    offset += getLevelSize(j);
+    if (offset > UINT32_MAX)
+      NGFX_ERR("level offset is too large: level %u", level);
+  }
+  return uint32_t(offset);
+}
+
+void KTXFile::load(const std::string &filename) {
+  MappedFile file;
+  file.open(filename);
+  KTXHeader header;
+  if (file.size < sizeof(header) ||
+      memcmp(file.data, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0)
+    NGFX_ERR("%s: not a KTX2 file", filename.c_str());
+  memcpy(&header, file.data, sizeof(header));
+  if (header.supercompressionScheme != 0)
+    NGFX_ERR("%s: supercompressed files are not supported", filename.c_str());
+  auto formatInfo = PixelFormatUtil::getFormatInfoFromVkFormat(header.vkFormat);
+  if (!formatInfo)
+    NGFX_ERR("%s: unsupported format: %u", filename.c_str(), header.vkFormat);
+  // A 3D image has a height, a cube map is square, 2D and
+  // can't be a 3D image, and the arrays of 3D images are not supported
+  if (header.pixelWidth == 0 ||
+      (header.pixelDepth != 0 && header.pixelHeight == 0) ||
+      (header.faceCount != 1 && header.faceCount != 6) ||
+      (header.faceCount == 6 && (header.pixelWidth != header.pixelHeight ||
+                                 header.pixelDepth != 0)) ||
+      (header.pixelDepth != 0 && header.layerCount != 0))
+    NGFX_ERR("%s: invalid dimensions", filename.c_str());
+  format = formatInfo->format;
+  w = header.pixelWidth;
+  h = std::max(header.pixelHeight, 1u);
+  d = std::max(header.pixelDepth, 1u);
+  arrayLayers = std::max(header.layerCount, 1u);
+  numFaces = header.faceCount;
+  // A level count of 0 requests the generation of the mipmaps by the
+  // application, the file only has the first level
+  mipLevels = std::max(header.levelCount, 1u);
+  if (mipLevels > PixelFormatUtil::getMaxMipLevels(w, h, d))
+    NGFX_ERR("%s: invalid level count: %u", filename.c_str(),
+             header.levelCount);
+  // The level data is validated against the file size before it's allocated,
+  // getLevelOffset fails if the total size doesn't fit in 32 bits
+  uint32_t dataSize = getLevelOffset(mipLevels);
+  if (dataSize > file.size)
+    NGFX_ERR("%s: truncated level data", filename.c_str());
+  if (sizeof(header) + mipLevels * sizeof(KTXLevelIndex) > file.size)
+    NGFX_ERR("%s: truncated level index", filename.c_str());
+  const KTXLevelIndex *levelIndex =
+      (const KTXLevelIndex *)&file.data[sizeof(header)];
+  data.resize(dataSize);
+  for (uint32_t level = 0; level < mipLevels; level++) {
+    KTXLevelIndex levelIndexEntry;
+    memcpy(&levelIndexEntry, &levelIndex[level], sizeof(levelIndexEntry));
+    uint32_t levelSize = getLevelSize(level);
+    if (levelIndexEntry.byteLength != levelSize)
+      NGFX_ERR("%s: level %u: invalid size", filename.c_str(), level);
+    if (levelIndexEntry.byteOffset > file.size ||
+        levelSize > file.size - levelIndexEntry.byteOffset)
+      NGFX_ERR("%s: level %u is out of bounds", filename.c_str(), level);
+    memcpy(&data[getLevelOffset(level)],
+           &file.data[levelIndexEntry.byteOffset], levelSize);
+  }
+}
+
+void KTXFile::save(const std::string &filename) const {
+  auto formatInfo = PixelFormatUtil::getFormatInfo(format);
+  if (!formatInfo)
+    NGFX_ERR("%s: unsupported format: %d", filename.c_str(), format);
+  vector<uint8_t> fileData;
+  auto write = [&](const void *p, size_t size) {
+    fileData.insert(fileData.end(), (const uint8_t *)p,
+                    (const uint8_t *)p + size);
+  };
+  auto writeU8 = [&](uint8_t v) { write(&v, sizeof(v)); };
+  auto writeU16 = [&](uint16_t v) { write(&v, sizeof(v)); };
+  auto writeU32 = [&](uint32_t v) { write(&v, sizeof(v)); };
+  auto align = [&](uint32_t alignment) {
+    fileData.resize((fileData.size() + alignment - 1) / alignment * alignment);
+  };
+
+  KTXHeader header = {};
+  memcpy(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER));
+  header.vkFormat = formatInfo->vkFormat;
+  header.pixelWidth = w;
+  header.pixelHeight = h;
+  header.pixelDepth = (d > 1) ? d : 0;
+  header.layerCount = (arrayLayers > 1) ? arrayLayers : 0;
+  header.faceCount = numFaces;
+  header.levelCount = mipLevels;
+  fileData.resize(sizeof(header) + mipLevels * sizeof(KTXLevelIndex));
+
+  // Basic data format descriptor block
+  uint8_t colorModel;
+  vector<DFDSample> samples;
+  getDFD(formatInfo, colorModel, samples);
+  // The type size is the size of a channel, and 1 for the compressed
+  // formats
+  header.typeSize = (colorModel == KHR_DF_MODEL_RGBSDA)
+                        ? uint32_t(samples[0].bitLength / 8)
+                        : 1;
+  uint32_t dfdBlockSize = 24 + 16 * uint32_t(samples.size());
+  header.dfdByteOffset = uint32_t(fileData.size());
+  header.dfdByteLength = 4 + dfdBlockSize;
+  writeU32(header.dfdByteLength);
+  writeU32(0);
+  writeU16(2);
+  writeU16(uint16_t(dfdBlockSize));
+  writeU8(colorModel);
+  writeU8(KHR_DF_PRIMARIES_BT709);
+  writeU8(formatInfo->srgb ? KHR_DF_TRANSFER_SRGB : KHR_DF_TRANSFER_LINEAR);
+  writeU8(0);
+  writeU32((formatInfo->blockWidth - 1) | ((formatInfo->blockHeight - 1) << 8));
+  writeU32(formatInfo->blockSize);
+  writeU32(0);
+  for (auto &sample : samples) {
+    writeU16(sample.bitOffset);
+    writeU8(uint8_t(sample.bitLength - 1));
+    writeU8(sample.channelType);
+    writeU32(0);
+    writeU32(sample.sampleLower);
+    writeU32(sample.sampleUpper);
+  }
+
+  // Key/value data
+  const char kvd[] = "KTXwriter\0ngfx";
+  header.kvdByteOffset = uint32_t(fileData.size());
+  writeU32(sizeof(kvd));
+  write(kvd, sizeof(kvd));
+  align(4);
+  header.kvdByteLength = uint32_t(fileData.size()) - header.kvdByteOffset;
+
+  // The levels are stored from the smallest to the largest
+  uint32_t levelAlignment = getLevelAlignment(formatInfo->blockSize);
+  vector<KTXLevelIndex> levelIndex(mipLevels);
+  for (int32_t level = int32_t(mipLevels) - 1; level >= 0; level--) {
+    align(levelAlignment);
+    uint32_t levelSize = getLevelSize(level);
+    levelIndex[level] = {fileData.size(), levelSize, levelSize};
+    write(&data[getLevelOffset(level)], levelSize);
+  }
+  memcpy(fileData.data(), &header, sizeof(header));
+  memcpy(&fileData[sizeof(header)], levelIndex.data(),
+         levelIndex.size() * sizeof(KTXLevelIndex));
+
+  ofstream out(filename, ios::binary);
+  if (!out.is_open())
+    NGFX_ERR("cannot open file: %s", filename.c_str());
+  out.write((const char *)fileData.data(), fileData.size());
+  out.close();
+}
+
+void KTXFile::decode(uint32_t numThreads) {
+  if (!TextureCodec::isSupported(format))
+    NGFX_ERR("cannot decode format: %d", format);
+  auto decodedFormat = PixelFormatUtil::getDecodedFormat(format);
+  uint32_t decodedSize = 0;
+  for (uint32_t level = 0; level < mipLevels; level++)
+    decodedSize += PixelFormatUtil::getLevelSize(
+        decodedFormat, w, h, d, arrayLayers * numFaces, level);
+  vector<uint8_t> decodedData(decodedSize);
+  const uint8_t *src = data.data();
+  uint8_t *dst = decodedData.data();
+  for (uint32_t level = 0; level < mipLevels; level++) {
+    uint32_t levelW = std::max(w >> level, 1u),
+             levelH = std::max(h >> level, 1u);
+    uint32_t numImages = arrayLayers * numFaces * std::max(d >> level, 1u);
+    for (uint32_t j = 0; j < numImages; j++) {
+      TextureCodec::decode(format, src, levelW, levelH, dst, numThreads);
+      src += PixelFormatUtil::getImageSize(format, levelW, levelH);
+      dst += levelW * levelH * 4;
+    }
+  }
+  data = std::move(decodedData);
+  format = decodedFormat;
+}
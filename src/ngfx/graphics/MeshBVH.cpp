@@ -0,0 +1,624 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "ngfx/graphics/MeshBVH.h"
+#include "ngfx/core/DebugUtil.h"
+#include "ngfx/core/ParallelUtil.h"
+#include "ngfx/core/SIMD.h"
+#include "ngfx/core/Util.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+using namespace ngfx;
+using namespace std;
+
+static const char BVH_MAGIC[8] = {'N', 'G', 'F', 'X', 'B', 'V', 'H', '4'};
+static const uint32_t BVH_VERSION = 2;
+// The subtrees with at most this number of triangles are built by
+// a single thread. The value doesn't depend on the number of threads,
+// so neither does the hierarchy
+static const uint32_t TASK_SIZE = 16384;
+// The nodes with at least this number of triangles are binned in parallel
+static const uint32_t PARALLEL_BINNING_SIZE = 65536;
+// Below this depth, the nodes are split at the median, which bounds
+// the depth of the hierarchy
+static const uint32_t MAX_SAH_DEPTH = 24;
+// A node pushes at most 4 children and pops 1, so the stack holds
+// at most 3 entries per level
+static const uint32_t STACK_SIZE = 256;
+
+namespace {
+struct AABB {
+  void grow(const vec3 &p) {
+    min = glm::min(min, p);
+    max = glm::max(max, p);
+  }
+  void grow(const AABB &b) {
+    min = glm::min(min, b.min);
+    max = glm::max(max, b.max);
+  }
+  float area() const {
+    vec3 d = max - min;
+    if (d.x < 0.0f)
+      return 0.0f;
+    return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+  }
+  vec3 min = vec3(FLT_MAX), max = vec3(-FLT_MAX);
+};
+
+struct Bin {
+  AABB bounds, centroidBounds;
+  uint32_t count = 0;
+};
+
+// A range of triangles, with the bounds of the triangles and of their
+// centroids
+struct Range {
+  uint32_t count() const { return end - begin; }
+  uint32_t begin = 0, end = 0;
+  AABB bounds, centroidBounds;
+};
+
+// A subtree whose construction is deferred
+struct Task {
+  Range range;
+  uint32_t parent, slot, depth;
+};
+
+class Builder {
+public:
+  Builder(const MeshData &meshData, const MeshLOD &faceRange,
+          const MeshBVH::BuildOptions &options, vector<uint32_t> &refs);
+  uint32_t buildNode(vector<MeshBVH::Node> &nodes, const Range &range,
+                     uint32_t depth, vector<Task> *tasks);
+  Range root;
+
+private:
+  void binRange(const Range &range, vector<Bin> &bins);
+  void split(const Range &range, uint32_t depth, Range &left, Range &right);
+  void splitMedian(const Range &range, Range &left, Range &right);
+  const MeshBVH::BuildOptions &options;
+  vector<uint32_t> &refs;
+  vector<AABB> faceBounds;
+  vector<vec3> centroids;
+};
+} // namespace
+
+Builder::Builder(const MeshData &meshData, const MeshLOD &faceRange,
+                 const MeshBVH::BuildOptions &options, vector<uint32_t> &refs)
+    : options(options), refs(refs) {
+  auto &pos = meshData.pos;
+  const ivec3 *faces = &meshData.faces[faceRange.firstFace];
+  size_t numFaces = faceRange.numFaces;
+  uint32_t numThreads = ParallelUtil::getNumThreads(options.numThreads,
+                                                    numFaces);
+  faceBounds.resize(numFaces);
+  centroids.resize(numFaces);
+  refs.resize(numFaces);
+  vector<Range> threadRanges(numThreads);
+  ParallelUtil::parallelFor(
+      numThreads, numFaces, [&](uint32_t thread, size_t begin, size_t end) {
+        auto &range = threadRanges[thread];
+        for (size_t j = begin; j < end; j++) {
+          auto &face = faces[j];
+          AABB &bounds = faceBounds[j];
+          for (uint32_t k = 0; k < 3; k++)
+            bounds.grow(pos[face[k]]);
+          centroids[j] = (bounds.min + bounds.max) * 0.5f;
+          refs[j] = uint32_t(j);
+          range.bounds.grow(bounds);
+          range.centroidBounds.grow(centroids[j]);
+        }
+      });
+  root.end = uint32_t(numFaces);
+  for (auto &range : threadRanges) {
+    root.bounds.grow(range.bounds);
+    root.centroidBounds.grow(range.centroidBounds);
+  }
+}
+
+void Builder::binRange(const Range &range, vector<Bin> &bins) {
+  uint32_t numBins = options.numBins;
+  vec3 origin = range.centroidBounds.min,
+       extent = range.centroidBounds.max - origin, scale;
+  for (uint32_t k = 0; k < 3; k++)
+    scale[k] = extent[k] > 0.0f ? float(numBins) / extent[k] : 0.0f;
+  auto binFaces = [&](vector<Bin> &bins, size_t begin, size_t end) {
+    for (size_t j = begin; j < end; j++) {
+      uint32_t face = refs[j];
+      const vec3 &c = centroids[face];
+      for (uint32_t k = 0; k < 3; k++) {
+        uint32_t binIndex =
+            std::min(uint32_t((c[k] - origin[k]) * scale[k]), numBins - 1);
+        Bin &bin = bins[k * numBins + binIndex];
+        bin.bounds.grow(faceBounds[face]);
+        bin.centroidBounds.grow(c);
+        bin.count++;
+      }
+    }
+  };
+  bins.assign(3 * numBins, Bin());
+  uint32_t numThreads = 1;
+  if (range.count() >= PARALLEL_BINNING_SIZE)
+    numThreads = ParallelUtil::getNumThreads(options.numThreads, range.count());
+  if (numThreads == 1) {
+    binFaces(bins, range.begin, range.end);
+    return;
+  }
+  // The bins of each thread are merged in order. The bounds and the counts
+  // are exact, so the result doesn't depend on the number of threads
+  vector<vector<Bin>> threadBins(numThreads, bins);
+  ParallelUtil::parallelFor(numThreads, range.count(),
+                            [&](uint32_t thread, size_t begin, size_t end) {
+                              binFaces(threadBins[thread], range.begin + begin,
+                                       range.begin + end);
+                            });
+  for (auto &b : threadBins) {
+    for (uint32_t j = 0; j < bins.size(); j++) {
+      bins[j].bounds.grow(b[j].bounds);
+      bins[j].centroidBounds.grow(b[j].centroidBounds);
+      bins[j].count += b[j].count;
+    }
+  }
+}
+
+void Builder::split(const Range &range, uint32_t depth, Range &left,
+                    Range &right) {
+  if (depth >= MAX_SAH_DEPTH) {
+    splitMedian(range, left, right);
+    return;
+  }
+  uint32_t numBins = options.numBins;
+  vector<Bin> bins;
+  binRange(range, bins);
+  // Evaluate the cost of splitting between each pair of adjacent bins:
+  // the surface area times the number of triangles of each side
+  vec3 origin = range.centroidBounds.min,
+       extent = range.centroidBounds.max - origin;
+  float bestCost = FLT_MAX;
+  int32_t bestAxis = -1;
+  uint32_t bestBin = 0;
+  vector<float> rightArea(numBins);
+  vector<uint32_t> rightCount(numBins);
+  for (uint32_t k = 0; k < 3; k++) {
+    if (extent[k] <= 0.0f)
+      continue;
+    const Bin *axisBins = &bins[k * numBins];
+    AABB bounds;
+    uint32_t count = 0;
+    for (uint32_t j = numBins - 1; j > 0; j--) {
+      bounds.grow(axisBins[j].bounds);
+      count += axisBins[j].count;
+      rightArea[j] = bounds.area();
+      rightCount[j] = count;
+    }
+    bounds = AABB();
+    count = 0;
+    for (uint32_t j = 0; j < numBins - 1; j++) {
+      bounds.grow(axisBins[j].bounds);
+      count += axisBins[j].count;
+      if (count == 0 || rightCount[j + 1] == 0)
+        continue;
+      float cost =
+          bounds.area() * count + rightArea[j + 1] * rightCount[j + 1];
+      if (cost < bestCost) {
+        bestCost = cost;
+        bestAxis = int32_t(k);
+        bestBin = j;
+      }
+    }
+  }
+  // All the centroids are in the same bin
+  if (bestAxis == -1) {
+    splitMedian(range, left, right);
+    return;
+  }
+  uint32_t axis = uint32_t(bestAxis);
+  float scale = float(numBins) / extent[axis];
+  auto it = std::partition(
+      refs.begin() + range.begin, refs.begin() + range.end, [&](uint32_t face) {
+        float c = centroids[face][axis];
+        uint32_t binIndex =
+            std::min(uint32_t((c - origin[axis]) * scale), numBins - 1);
+        return binIndex <= bestBin;
+      });
+  left = right = Range();
+  left.begin = range.begin;
+  left.end = right.begin = uint32_t(it - refs.begin());
+  right.end = range.end;
+  for (uint32_t j = 0; j < numBins; j++) {
+    const Bin &bin = bins[axis * numBins + j];
+    Range &r = (j <= bestBin) ? left : right;
+    r.bounds.grow(bin.bounds);
+    r.centroidBounds.grow(bin.centroidBounds);
+  }
+}
+
+void Builder::splitMedian(const Range &range, Range &left, Range &right) {
+  vec3 extent = range.centroidBounds.max - range.centroidBounds.min;
+  uint32_t axis = (extent.x >= extent.y && extent.x >= extent.z) ? 0
+                  : (extent.y >= extent.z)                       ? 1
+                                                                 : 2;
+  uint32_t middle = range.begin + range.count() / 2;
+  std::nth_element(refs.begin() + range.begin, refs.begin() + middle,
+                   refs.begin() + range.end, [&](uint32_t f0, uint32_t f1) {
+                     float c0 = centroids[f0][axis], c1 = centroids[f1][axis];
+                     return c0 < c1 || (c0 == c1 && f0 < f1);
+                   });
+  left = right = Range();
+  left.begin = range.begin;
+  left.end = right.begin = middle;
+  right.end = range.end;
+  for (Range *r : {&left, &right}) {
+    for (uint32_t j = r->begin; j < r->end; j++) {
+      r->bounds.grow(faceBounds[refs[j]]);
+      r->centroidBounds.grow(centroids[refs[j]]);
+    }
+  }
+}
+
+uint32_t Builder::buildNode(vector<MeshBVH::Node> &nodes, const Range &range,
+                            uint32_t depth, vector<Task> *tasks) {
+  // Split the child with the largest surface area until there are
+  // 4 children, or until all the children are leaves
+  uint32_t maxLeafSize = options.maxLeafSize, numChildren = 1;
+  Range children[4];
+  children[0] = range;
+  while (numChildren < 4) {
+    int32_t bestChild = -1;
+    float bestArea = -1.0f;
+    for (uint32_t j = 0; j < numChildren; j++) {
+      float area = children[j].bounds.area();
+      if (children[j].count() > maxLeafSize && area > bestArea) {
+        bestChild = int32_t(j);
+        bestArea = area;
+      }
+    }
+    if (bestChild == -1)
+      break;
+    Range left, right;
+    split(children[bestChild], depth, left, right);
+    children[bestChild] = left;
+    children[numChildren++] = right;
+  }
+
+  MeshBVH::Node node;
+  for (uint32_t j = 0; j < 4; j++) {
+    AABB bounds = (j < numChildren) ? children[j].bounds : AABB();
+    node.minX[j] = bounds.min.x;
+    node.minY[j] = bounds.min.y;
+    node.minZ[j] = bounds.min.z;
+    node.maxX[j] = bounds.max.x;
+    node.maxY[j] = bounds.max.y;
+    node.maxZ[j] = bounds.max.z;
+    node.children[j] = MeshBVH::INVALID_INDEX;
+    node.numFaces[j] = 0;
+    if (j < numChildren && children[j].count() <= maxLeafSize) {
+      node.children[j] = children[j].begin;
+      node.numFaces[j] = children[j].count();
+    }
+  }
+  uint32_t nodeIndex = uint32_t(nodes.size());
+  nodes.push_back(node);
+  for (uint32_t j = 0; j < numChildren; j++) {
+    uint32_t count = children[j].count();
+    if (count <= maxLeafSize)
+      continue;
+    if (tasks && count <= TASK_SIZE) {
+      tasks->push_back({children[j], nodeIndex, j, depth + 1});
+      continue;
+    }
+    uint32_t childIndex = buildNode(nodes, children[j], depth + 1, tasks);
+    nodes[nodeIndex].children[j] = childIndex;
+  }
+  return nodeIndex;
+}
+
+MeshLOD MeshBVH::getFaceRange(const MeshData &meshData) {
+  if (!meshData.lods.empty())
+    return meshData.lods[0];
+  MeshLOD faceRange;
+  faceRange.numFaces = uint32_t(meshData.faces.size());
+  return faceRange;
+}
+
+uint64_t MeshBVH::getMeshHash(const MeshData &meshData) {
+  MeshLOD faceRange = getFaceRange(meshData);
+  uint64_t hash = meshData.pos.size();
+  for (uint32_t j = 0; j < faceRange.numFaces; j++) {
+    auto &face = meshData.faces[faceRange.firstFace + j];
+    Util::hashCombine(hash, uint64_t(uint32_t(face[0])) |
+                                (uint64_t(uint32_t(face[1])) << 32));
+    Util::hashCombine(hash, uint32_t(face[2]));
+  }
+  return hash;
+}
+
+void MeshBVH::build(const MeshData &meshData, const BuildOptions &options) {
+  nodes.clear();
+  faceIndices.clear();
+  triangles.clear();
+  meshHash = getMeshHash(meshData);
+  MeshLOD faceRange = getFaceRange(meshData);
+  if (faceRange.numFaces == 0)
+    return;
+  if (options.maxLeafSize == 0 || options.numBins < 2)
+    NGFX_ERR("invalid build options: maxLeafSize: %u, numBins: %u",
+             options.maxLeafSize, options.numBins);
+  Builder builder(meshData, faceRange, options, faceIndices);
+  // Build the top of the hierarchy, binning the large nodes in parallel,
+  // then build the subtrees below it in parallel
+  vector<Task> tasks;
+  builder.buildNode(nodes, builder.root, 0, &tasks);
+  vector<vector<Node>> taskNodes(tasks.size());
+  uint32_t numThreads = ParallelUtil::getNumThreads(options.numThreads,
+                                                    tasks.size(), 1);
+  atomic<uint32_t> nextTask(0);
+  ParallelUtil::parallelFor(
+      numThreads, numThreads, [&](uint32_t, size_t, size_t) {
+        for (uint32_t j = nextTask++; j < tasks.size(); j = nextTask++)
+          builder.buildNode(taskNodes[j], tasks[j].range, tasks[j].depth,
+                            nullptr);
+      });
+  // Append the subtrees in the order of the tasks
+  for (uint32_t j = 0; j < tasks.size(); j++) {
+    uint32_t offset = uint32_t(nodes.size());
+    for (auto &node : taskNodes[j]) {
+      for (uint32_t k = 0; k < 4; k++) {
+        if (node.numFaces[k] == 0 && node.children[k] != INVALID_INDEX)
+          node.children[k] += offset;
+      }
+      nodes.push_back(node);
+    }
+    nodes[tasks[j].parent].children[tasks[j].slot] = offset;
+  }
+  for (auto &face : faceIndices)
+    face += faceRange.firstFace;
+  gatherTriangles(meshData);
+}
+
+void MeshBVH::gatherTriangles(const MeshData &meshData) {
+  auto &pos = meshData.pos;
+  auto &faces = meshData.faces;
+  triangles.resize(faceIndices.size());
+  uint32_t numThreads = ParallelUtil::getNumThreads(0, triangles.size());
+  ParallelUtil::parallelFor(
+      numThreads, triangles.size(), [&](uint32_t, size_t begin, size_t end) {
+        for (size_t j = begin; j < end; j++) {
+          auto &face = faces[faceIndices[j]];
+          vec3 v0 = pos[face[0]];
+          triangles[j] = {v0, pos[face[1]] - v0, pos[face[2]] - v0};
+        }
+      });
+}
+
+// Moller-Trumbore ray triangle intersection
+static inline bool intersectTriangle(const vec3 &v0, const vec3 &e1,
+                                     const vec3 &e2, const Ray &ray,
+                                     float tMax, float &t, float &u,
+                                     float &v) {
+  vec3 p = cross(ray.dir, e2);
+  float det = dot(e1, p);
+  if (det == 0.0f)
+    return false;
+  float invDet = 1.0f / det;
+  vec3 s = ray.origin - v0;
+  u = dot(s, p) * invDet;
+  if (u < 0.0f || u > 1.0f)
+    return false;
+  vec3 q = cross(s, e1);
+  v = dot(ray.dir, q) * invDet;
+  if (v < 0.0f || (u + v) > 1.0f)
+    return false;
+  t = dot(e2, q) * invDet;
+  return t >= ray.tMin && t < tMax;
+}
+
+template <bool anyHit>
+bool MeshBVH::traverse(const Ray &ray, Hit &hit) const {
+  if (nodes.empty())
+    return false;
+  // The planes of the child bounds that the ray enters and exits are
+  // selected by the sign of the direction. An empty child has inverted
+  // bounds, so the ray never enters it
+  vec3 invDir;
+  for (uint32_t k = 0; k < 3; k++) {
+    float d = ray.dir[k];
+    invDir[k] = 1.0f / (std::abs(d) > 1e-20f ? d : std::copysign(1e-20f, d));
+  }
+  bool negX = invDir.x < 0.0f, negY = invDir.y < 0.0f, negZ = invDir.z < 0.0f;
+  float4 originX(ray.origin.x), originY(ray.origin.y), originZ(ray.origin.z);
+  float4 invDirX(invDir.x), invDirY(invDir.y), invDirZ(invDir.z);
+  float4 tMin4(ray.tMin);
+  float tMax = ray.tMax;
+  bool found = false;
+  uint32_t stack[STACK_SIZE], stackSize = 0;
+  stack[stackSize++] = 0;
+  while (stackSize) {
+    const Node &node = nodes[stack[--stackSize]];
+    float4 nearX = (float4::load(negX ? node.maxX : node.minX) - originX) *
+                   invDirX,
+           nearY = (float4::load(negY ? node.maxY : node.minY) - originY) *
+                   invDirY,
+           nearZ = (float4::load(negZ ? node.maxZ : node.minZ) - originZ) *
+                   invDirZ,
+           farX = (float4::load(negX ? node.minX : node.maxX) - originX) *
+                  invDirX,
+           farY = (float4::load(negY ? node.minY : node.maxY) - originY) *
+                  invDirY,
+           farZ = (float4::load(negZ ? node.minZ : node.maxZ) - originZ) *
+                  invDirZ;
+    float4 tNear = float4::max(float4::max(nearX, nearY),
+                               float4::max(nearZ, tMin4)),
+           tFar = float4::min(float4::min(farX, farY),
+                              float4::min(farZ, float4(tMax)));
+    int mask = (tNear <= tFar).movemask();
+    if (!mask)
+      continue;
+    float dist[4];
+    tNear.store(dist);
+    // Intersect the leaves, then push the child nodes from the farthest
+    // to the nearest, so the nearest one is visited first
+    uint32_t order[4], numChildNodes = 0;
+    for (uint32_t j = 0; j < 4; j++) {
+      if (!(mask & (1 << j)))
+        continue;
+      uint32_t numFaces = node.numFaces[j];
+      if (numFaces == 0) {
+        uint32_t k = numChildNodes++;
+        for (; k > 0 && dist[order[k - 1]] < dist[j]; k--)
+          order[k] = order[k - 1];
+        order[k] = j;
+        continue;
+      }
+      for (uint32_t k = node.children[j], end = k + numFaces; k < end; k++) {
+        auto &tri = triangles[k];
+        float t, u, v;
+        if (!intersectTriangle(tri.v0, tri.e1, tri.e2, ray, tMax, t, u, v))
+          continue;
+        tMax = t;
+        hit.t = t;
+        hit.face = faceIndices[k];
+        hit.barycentrics = vec2(u, v);
+        found = true;
+        if (anyHit)
+          return true;
+      }
+    }
+    for (uint32_t k = 0; k < numChildNodes; k++) {
+      uint32_t j = order[k];
+      if (dist[j] <= tMax)
+        stack[stackSize++] = node.children[j];
+    }
+  }
+  return found;
+}
+
+bool MeshBVH::intersect(const Ray &ray, Hit &hit) const {
+  return traverse<false>(ray, hit);
+}
+
+bool MeshBVH::intersectAny(const Ray &ray) const {
+  Hit hit;
+  return traverse<true>(ray, hit);
+}
+
+void MeshBVH::save(const std::string &file) const {
+  ofstream out(file, ios::binary);
+  if (!out.is_open())
+    NGFX_ERR("cannot open file: %s", file.c_str());
+  uint32_t numFaces = uint32_t(faceIndices.size()),
+           numNodes = uint32_t(nodes.size());
+  out.write(BVH_MAGIC, sizeof(BVH_MAGIC));
+  out.write((const char *)&BVH_VERSION, sizeof(BVH_VERSION));
+  out.write((const char *)&numFaces, sizeof(numFaces));
+  out.write((const char *)&numNodes, sizeof(numNodes));
+  out.write((const char *)&meshHash, sizeof(meshHash));
+  out.write((const char *)nodes.data(), nodes.size() * sizeof(nodes[0]));
+  out.write((const char *)faceIndices.data(),
+            faceIndices.size() * sizeof(faceIndices[0]));
+  out.close();
+}
+
+void MeshBVH::load(const std::string &file, const MeshData &meshData) {
+  ifstream in(file, ios::binary);
+  if (!in.is_open())
+    NGFX_ERR("cannot open file: %s", file.c_str());
+  char magic[sizeof(BVH_MAGIC)] = {};
+  uint32_t version = 0, numFaces = 0, numNodes = 0;
+  in.read(magic, sizeof(magic));
+  if (memcmp(magic, BVH_MAGIC, sizeof(BVH_MAGIC)) != 0)
+    NGFX_ERR("%s: not a BVH file", file.c_str());
+  in.read((char *)&version, sizeof(version));
+  if (version != BVH_VERSION)
+    NGFX_ERR("%s: unsupported version: %d", file.c_str(), version);
+  in.read((char *)&numFaces, sizeof(numFaces));
+  in.read((char *)&numNodes, sizeof(numNodes));
+  in.read((char *)&meshHash, sizeof(meshHash));
+  if (!in.good())
+    NGFX_ERR("%s: unexpected end of file", file.c_str());
+  MeshLOD faceRange = getFaceRange(meshData);
+  if (numFaces != faceRange.numFaces)
+    NGFX_ERR("%s: the hierarchy has %u faces, the mesh has %u", file.c_str(),
+             numFaces, faceRange.numFaces);
+  if (meshHash != getMeshHash(meshData))
+    NGFX_ERR("%s: the hierarchy was built for another mesh", file.c_str());
+  // Check the sizes of the tables before allocating them
+  auto offset = in.tellg();
+  in.seekg(0, ios::end);
+  uint64_t remainingSize = uint64_t(in.tellg() - offset);
+  in.seekg(offset);
+  if (uint64_t(numNodes) * sizeof(Node) + uint64_t(numFaces) * 4 !=
+      remainingSize)
+    NGFX_ERR("%s: invalid node count: %u", file.c_str(), numNodes);
+  nodes.resize(numNodes);
+  faceIndices.resize(numFaces);
+  in.read((char *)nodes.data(), nodes.size() * sizeof(nodes[0]));
+  in.read((char *)faceIndices.data(),
+          faceIndices.size() * sizeof(faceIndices[0]));
+  if (!in.good())
+    NGFX_ERR("%s: unexpected end of file", file.c_str());
+  in.close();
+  for (uint32_t face : faceIndices) {
+    if (face < faceRange.firstFace ||
+        face >= (faceRange.firstFace + faceRange.numFaces))
+      NGFX_ERR("%s: invalid face index: %u", file.c_str(), face);
+  }
+  checkNodes(file);
+  gatherTriangles(meshData);
+}
+
+void MeshBVH::checkNodes(const std::string &file) const {
+  // There is a root if there are faces, and each node is the child of
+  // a single node with a lower index, so the nodes form a tree. Its depth
+  // is bounded by the traversal stack
+  if (nodes.empty() != faceIndices.empty())
+    NGFX_ERR("%s: invalid node count: %zu", file.c_str(), nodes.size());
+  vector<uint32_t> depths(nodes.size(), 0);
+  vector<bool> referenced(nodes.size(), false);
+  for (uint32_t j = 0; j < nodes.size(); j++) {
+    if (j != 0 && !referenced[j])
+      NGFX_ERR("%s: node %u is unreferenced", file.c_str(), j);
+    auto &node = nodes[j];
+    for (uint32_t k = 0; k < 4; k++) {
+      uint32_t child = node.children[k], numFaces = node.numFaces[k];
+      if (numFaces != 0) {
+        if (uint64_t(child) + numFaces > faceIndices.size())
+          NGFX_ERR("%s: node %u: leaf %u is out of range", file.c_str(), j,
+                   k);
+        continue;
+      }
+      // An unused child has empty bounds, the traversal never enters it
+      if (child == INVALID_INDEX) {
+        if (!(node.minX[k] > node.maxX[k]))
+          NGFX_ERR("%s: node %u: child %u is missing", file.c_str(), j, k);
+        continue;
+      }
+      if (child <= j || child >= nodes.size() || referenced[child])
+        NGFX_ERR("%s: node %u: invalid child: %u", file.c_str(), j, child);
+      referenced[child] = true;
+      depths[child] = depths[j] + 1;
+      if ((depths[child] + 1) * 3 + 1 > STACK_SIZE)
+        NGFX_ERR("%s: the hierarchy is too deep", file.c_str());
+    }
+  }
+}
@@ -0,0 +1,834 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "ngfx/graphics/MeshOptimizer.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <queue>
+#include <unordered_map>
+using namespace ngfx;
+
+namespace {
+// The LRU cache size used by the vertex cache optimizer
+const uint32_t MAX_CACHE_SIZE = 32;
+const float CACHE_DECAY_POWER = 1.5f, LAST_TRIANGLE_SCORE = 0.75f,
+            VALENCE_BOOST_SCALE = 2.0f, VALENCE_BOOST_POWER = 0.5f;
+
+// Vertices in the cache score higher, as do vertices with few remaining
+// triangles, so that the lone triangles are not left behind
+float vertexScore(int32_t cachePos, uint32_t numActiveTriangles) {
+  if (numActiveTriangles == 0)
+    return -1.0f;
+  float score = 0.0f;
+  if (cachePos >= 0) {
+    if (cachePos < 3)
+      score = LAST_TRIANGLE_SCORE;
+    else
+      score = powf(1.0f - float(cachePos - 3) / float(MAX_CACHE_SIZE - 3),
+                   CACHE_DECAY_POWER);
+  }
+  return score + VALENCE_BOOST_SCALE *
+                     powf(float(numActiveTriangles), -VALENCE_BOOST_POWER);
+}
+
+// Count the cache misses of each triangle with a FIFO cache
+struct FifoCache {
+  FifoCache(uint32_t numVerts, uint32_t cacheSize)
+      : timestamps(numVerts, 0), cacheSize(cacheSize), time(cacheSize + 1) {}
+  uint32_t misses(const ivec3 &face) {
+    uint32_t numMisses = 0;
+    for (int k = 0; k < 3; k++) {
+      uint32_t &timestamp = timestamps[face[k]];
+      if ((time - timestamp) > cacheSize) {
+        timestamp = time++;
+        numMisses++;
+      }
+    }
+    return numMisses;
+  }
+  void flush() { time += cacheSize + 1; }
+  std::vector<uint32_t> timestamps;
+  uint32_t cacheSize, time;
+};
+} // namespace
+
+MeshOptimizer::VertexCacheStats
+MeshOptimizer::analyzeVertexCache(const MeshData &meshData,
+                                  uint32_t cacheSize) {
+  VertexCacheStats stats;
+  auto &faces = meshData.faces;
+  // With LODs, only the full resolution LOD is analyzed
+  uint32_t firstFace = 0, numFaces = uint32_t(faces.size());
+  if (!meshData.lods.empty()) {
+    firstFace = meshData.lods[0].firstFace;
+    numFaces = meshData.lods[0].numFaces;
+  }
+  if (numFaces == 0)
+    return stats;
+  FifoCache cache(uint32_t(meshData.pos.size()), cacheSize);
+  uint32_t numMisses = 0;
+  for (uint32_t j = firstFace; j < firstFace + numFaces; j++)
+    numMisses += cache.misses(faces[j]);
+  stats.acmr = float(numMisses) / float(numFaces);
+  stats.atvr = float(numMisses) / float(meshData.pos.size());
+  return stats;
+}
+
+static void sortFacesForVertexCache(uint32_t numVerts,
+                                    std::vector<ivec3> &faces) {
+  uint32_t numFaces = uint32_t(faces.size());
+  if (numFaces == 0)
+    return;
+  // The triangles of each vertex. The active (not yet emitted) triangles
+  // are kept at the start of each vertex's range
+  std::vector<uint32_t> triangleOffsets(numVerts + 1, 0),
+      numActiveTriangles(numVerts, 0), triangles(numFaces * 3);
+  for (auto &face : faces)
+    for (int k = 0; k < 3; k++)
+      numActiveTriangles[face[k]]++;
+  for (uint32_t j = 0; j < numVerts; j++)
+    triangleOffsets[j + 1] = triangleOffsets[j] + numActiveTriangles[j];
+  std::vector<uint32_t> cursor(triangleOffsets.begin(),
+                               triangleOffsets.end() - 1);
+  for (uint32_t j = 0; j < numFaces; j++)
+    for (int k = 0; k < 3; k++)
+      triangles[cursor[faces[j][k]]++] = j;
+
+  std::vector<int32_t> cachePos(numVerts, -1);
+  std::vector<float> vertexScores(numVerts), triangleScores(numFaces, 0.0f);
+  for (uint32_t j = 0; j < numVerts; j++)
+    vertexScores[j] = vertexScore(-1, numActiveTriangles[j]);
+  for (uint32_t j = 0; j < numFaces; j++)
+    for (int k = 0; k < 3; k++)
+      triangleScores[j] += vertexScores[faces[j][k]];
+  std::vector<bool> emitted(numFaces, false);
+  std::vector<ivec3> sortedFaces;
+  sortedFaces.reserve(numFaces);
+  std::vector<uint32_t> cache, newCache;
+  cache.reserve(MAX_CACHE_SIZE + 3);
+  newCache.reserve(MAX_CACHE_SIZE + 3);
+
+  int32_t bestTriangle = int32_t(
+      std::max_element(triangleScores.begin(), triangleScores.end()) -
+      triangleScores.begin());
+  uint32_t nextTriangle = 0;
+  while (sortedFaces.size() < numFaces) {
+    if (bestTriangle < 0) {
+      // None of the cached vertices has an active triangle left,
+      // restart from the next triangle in the input order
+      while (emitted[nextTriangle])
+        nextTriangle++;
+      bestTriangle = int32_t(nextTriangle);
+    }
+    const ivec3 &face = faces[bestTriangle];
+    emitted[bestTriangle] = true;
+    sortedFaces.push_back(face);
+    for (int k = 0; k < 3; k++) {
+      uint32_t v = face[k];
+      uint32_t *vertexTriangles = &triangles[triangleOffsets[v]];
+      uint32_t &numActive = numActiveTriangles[v];
+      for (uint32_t i = 0; i < numActive; i++) {
+        if (vertexTriangles[i] == uint32_t(bestTriangle)) {
+          std::swap(vertexTriangles[i], vertexTriangles[numActive - 1]);
+          break;
+        }
+      }
+      numActive--;
+    }
+    // Move the triangle's vertices to the front of the LRU cache
+    newCache.assign({uint32_t(face[0]), uint32_t(face[1]), uint32_t(face[2])});
+    for (uint32_t v : cache)
+      if (v != newCache[0] && v != newCache[1] && v != newCache[2])
+        newCache.push_back(v);
+    // Update the scores of the cached and evicted vertices,
+    // and find the best triangle among their active triangles
+    bestTriangle = -1;
+    float bestScore = -1.0f;
+    for (uint32_t j = 0; j < newCache.size(); j++) {
+      uint32_t v = newCache[j];
+      cachePos[v] = (j < MAX_CACHE_SIZE) ? int32_t(j) : -1;
+      float score = vertexScore(cachePos[v], numActiveTriangles[v]);
+      float scoreDelta = score - vertexScores[v];
+      vertexScores[v] = score;
+      uint32_t *vertexTriangles = &triangles[triangleOffsets[v]];
+      for (uint32_t i = 0; i < numActiveTriangles[v]; i++) {
+        uint32_t t = vertexTriangles[i];
+        triangleScores[t] += scoreDelta;
+        if (j < MAX_CACHE_SIZE && triangleScores[t] > bestScore) {
+          bestScore = triangleScores[t];
+          bestTriangle = int32_t(t);
+        }
+      }
+    }
+    if (newCache.size() > MAX_CACHE_SIZE)
+      newCache.resize(MAX_CACHE_SIZE);
+    std::swap(cache, newCache);
+  }
+  faces = std::move(sortedFaces);
+}
+
+static void sortClustersForOverdraw(const std::vector<vec3> &pos,
+                                    std::vector<ivec3> &faces,
+                                    float threshold) {
+  const uint32_t cacheSize = 16;
+  uint32_t numVerts = uint32_t(pos.size()),
+           numFaces = uint32_t(faces.size());
+  if (numFaces == 0)
+    return;
+  // Hard boundaries: the triangles whose three vertices miss the cache
+  std::vector<uint32_t> hardClusters;
+  FifoCache cache(numVerts, cacheSize);
+  for (uint32_t j = 0; j < numFaces; j++) {
+    if (cache.misses(faces[j]) == 3)
+      hardClusters.push_back(j);
+  }
+  if (hardClusters.empty() || hardClusters[0] != 0)
+    hardClusters.insert(hardClusters.begin(), 0);
+  hardClusters.push_back(numFaces);
+  // Soft boundaries: split a cluster as soon as its ACMR is within the
+  // threshold of the ACMR of the hard cluster it belongs to
+  std::vector<uint32_t> clusters;
+  for (uint32_t c = 0; (c + 1) < hardClusters.size(); c++) {
+    uint32_t start = hardClusters[c], end = hardClusters[c + 1];
+    cache.flush();
+    uint32_t clusterMisses = 0;
+    for (uint32_t j = start; j < end; j++)
+      clusterMisses += cache.misses(faces[j]);
+    float clusterThreshold =
+        threshold * float(clusterMisses) / float(end - start);
+    cache.flush();
+    uint32_t subStart = start, subMisses = 0;
+    clusters.push_back(start);
+    for (uint32_t j = start; j < end; j++) {
+      subMisses += cache.misses(faces[j]);
+      if ((j + 1) < end &&
+          float(subMisses) / float(j + 1 - subStart) <= clusterThreshold) {
+        clusters.push_back(j + 1);
+        subStart = j + 1;
+        subMisses = 0;
+        cache.flush();
+      }
+    }
+  }
+  clusters.push_back(numFaces);
+
+  // Sort the clusters by how much they face away from the mesh center,
+  // so that the clusters on the outside are drawn first
+  uint32_t numClusters = uint32_t(clusters.size()) - 1;
+  vec3 meshCenter(0.0f);
+  for (auto &p : pos)
+    meshCenter += p;
+  meshCenter /= float(std::max(numVerts, 1u));
+  std::vector<float> sortKeys(numClusters);
+  for (uint32_t c = 0; c < numClusters; c++) {
+    vec3 centroid(0.0f), normal(0.0f);
+    float area = 0.0f;
+    for (uint32_t j = clusters[c]; j < clusters[c + 1]; j++) {
+      auto &face = faces[j];
+      vec3 p0 = pos[face[0]], p1 = pos[face[1]], p2 = pos[face[2]];
+      vec3 n = cross(p1 - p0, p2 - p0);
+      float triangleArea = length(n);
+      centroid += (p0 + p1 + p2) * (triangleArea / 3.0f);
+      normal += n;
+      area += triangleArea;
+    }
+    float normalLength = length(normal);
+    if (area > 0.0f && normalLength > 0.0f)
+      sortKeys[c] = dot(centroid / area - meshCenter, normal / normalLength);
+    else
+      sortKeys[c] = 0.0f;
+  }
+  std::vector<uint32_t> order(numClusters);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+    return sortKeys[a] > sortKeys[b];
+  });
+  std::vector<ivec3> sortedFaces;
+  sortedFaces.reserve(numFaces);
+  for (uint32_t c : order)
+    sortedFaces.insert(sortedFaces.end(), faces.begin() + clusters[c],
+                       faces.begin() + clusters[c + 1]);
+  faces = std::move(sortedFaces);
+}
+
+// Apply a pass to the faces of each meshlet, or of each LOD, separately,
+// so that the face ranges remain valid
+template <typename Fn> static void forEachFaceRange(MeshData &meshData, Fn fn) {
+  auto apply = [&](std::vector<ivec3> &faces, uint32_t firstFace,
+                   uint32_t numFaces) {
+    auto begin = meshData.faces.begin() + firstFace;
+    faces.assign(begin, begin + numFaces);
+    fn(faces);
+    std::copy(faces.begin(), faces.end(), begin);
+  };
+  std::vector<ivec3> faces;
+  if (!meshData.meshlets.empty()) {
+    for (auto &meshlet : meshData.meshlets)
+      apply(faces, meshlet.firstFace, meshlet.numFaces);
+  } else if (!meshData.lods.empty()) {
+    for (auto &lod : meshData.lods)
+      apply(faces, lod.firstFace, lod.numFaces);
+  } else {
+    fn(meshData.faces);
+  }
+}
+
+void MeshOptimizer::optimizeVertexCache(MeshData &meshData) {
+  uint32_t numVerts = uint32_t(meshData.pos.size());
+  forEachFaceRange(meshData, [&](std::vector<ivec3> &faces) {
+    sortFacesForVertexCache(numVerts, faces);
+  });
+}
+
+void MeshOptimizer::optimizeOverdraw(MeshData &meshData, float threshold) {
+  forEachFaceRange(meshData, [&](std::vector<ivec3> &faces) {
+    sortClustersForOverdraw(meshData.pos, faces, threshold);
+  });
+}
+
+void MeshOptimizer::optimizeVertexFetch(MeshData &meshData) {
+  auto &pos = meshData.pos;
+  auto &normal = meshData.normal;
+  std::vector<int32_t> remap(pos.size(), -1);
+  int32_t numVerts = 0;
+  for (auto &face : meshData.faces) {
+    for (int k = 0; k < 3; k++) {
+      int32_t &index = remap[face[k]];
+      if (index == -1)
+        index = numVerts++;
+      face[k] = index;
+    }
+  }
+  bool hasNormals = (normal.size() == pos.size());
+  std::vector<vec3> newPos(numVerts), newNormal(hasNormals ? numVerts : 0);
+  for (uint32_t j = 0; j < remap.size(); j++) {
+    if (remap[j] == -1)
+      continue;
+    newPos[remap[j]] = pos[j];
+    if (hasNormals)
+      newNormal[remap[j]] = normal[j];
+  }
+  pos = std::move(newPos);
+  if (hasNormals)
+    normal = std::move(newNormal);
+}
+
+namespace {
+// A symmetric 4x4 matrix measuring the sum of the squared distances
+// to a set of planes
+struct Quadric {
+  void addPlane(const dvec3 &n, double d) {
+    a00 += n.x * n.x, a01 += n.x * n.y, a02 += n.x * n.z;
+    a11 += n.y * n.y, a12 += n.y * n.z, a22 += n.z * n.z;
+    b0 += n.x * d, b1 += n.y * d, b2 += n.z * d;
+    c += d * d;
+  }
+  Quadric &operator+=(const Quadric &q) {
+    a00 += q.a00, a01 += q.a01, a02 += q.a02;
+    a11 += q.a11, a12 += q.a12, a22 += q.a22;
+    b0 += q.b0, b1 += q.b1, b2 += q.b2;
+    c += q.c;
+    return *this;
+  }
+  double eval(const vec3 &p) const {
+    double x = p.x, y = p.y, z = p.z;
+    double e = a00 * x * x + a11 * y * y + a22 * z * z +
+               2.0 * (a01 * x * y + a02 * x * z + a12 * y * z) +
+               2.0 * (b0 * x + b1 * y + b2 * z) + c;
+    return std::max(e, 0.0);
+  }
+  double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+  double b0 = 0, b1 = 0, b2 = 0, c = 0;
+};
+
+struct Collapse {
+  bool operator<(const Collapse &rhs) const { return cost > rhs.cost; }
+  double cost;
+  uint32_t from, to, fromVersion, toVersion;
+};
+
+struct PositionHash {
+  size_t operator()(const vec3 &p) const {
+    uint32_t h[3];
+    memcpy(h, &p, sizeof(h));
+    return size_t(h[0] * 73856093u ^ h[1] * 19349663u ^ h[2] * 83492791u);
+  }
+};
+
+inline uint64_t edgeKey(uint32_t a, uint32_t b) {
+  return (uint64_t(std::min(a, b)) << 32) | std::max(a, b);
+}
+
+// Edge collapse simplification, restricted to the input vertices.
+// The vertices with the same position (e.g. on texture or normal seams)
+// are welded, so that the simplification doesn't open cracks
+class Simplifier {
+public:
+  Simplifier(const std::vector<vec3> &pos, const std::vector<ivec3> &faces)
+      : pos(pos), inputFaces(faces) {
+    uint32_t numVerts = uint32_t(pos.size());
+    std::unordered_map<vec3, uint32_t, PositionHash> positionMap;
+    remap.resize(numVerts);
+    for (uint32_t j = 0; j < numVerts; j++)
+      remap[j] = positionMap.emplace(pos[j], j).first->second;
+    this->faces.resize(faces.size());
+    alive.assign(faces.size(), true);
+    vertexFaces.resize(numVerts);
+    for (uint32_t j = 0; j < faces.size(); j++) {
+      auto &face = this->faces[j];
+      face = ivec3(remap[faces[j][0]], remap[faces[j][1]], remap[faces[j][2]]);
+      if (face[0] == face[1] || face[1] == face[2] || face[2] == face[0]) {
+        alive[j] = false;
+        continue;
+      }
+      numFaces++;
+      for (int k = 0; k < 3; k++)
+        vertexFaces[face[k]].push_back(j);
+    }
+    initQuadrics();
+  }
+
+  float simplify(uint32_t targetNumFaces, std::vector<ivec3> &result) {
+    std::vector<uint32_t> neighbors;
+    for (uint32_t v = 0; v < remap.size(); v++) {
+      if (remap[v] != v)
+        continue;
+      getNeighbors(v, neighbors);
+      for (uint32_t w : neighbors)
+        if (v < w)
+          pushCollapse(v, w);
+    }
+    double maxCost = 0.0;
+    while (numFaces > targetNumFaces && !collapses.empty()) {
+      Collapse collapse = collapses.top();
+      collapses.pop();
+      uint32_t from = collapse.from, to = collapse.to;
+      if (removed[from] || removed[to] ||
+          versions[from] != collapse.fromVersion ||
+          versions[to] != collapse.toVersion || !canCollapse(from, to))
+        continue;
+      maxCost = std::max(maxCost, collapse.cost);
+      applyCollapse(from, to);
+      getNeighbors(to, neighbors);
+      for (uint32_t w : neighbors)
+        pushCollapse(to, w);
+    }
+    result.clear();
+    for (uint32_t j = 0; j < faces.size(); j++) {
+      if (!alive[j])
+        continue;
+      ivec3 face;
+      for (int k = 0; k < 3; k++) {
+        // Keep the input vertex (e.g. with its own normal) if its
+        // position wasn't collapsed
+        uint32_t v = inputFaces[j][k];
+        face[k] = (uint32_t(faces[j][k]) == remap[v]) ? int(v) : faces[j][k];
+      }
+      result.push_back(face);
+    }
+    return float(sqrt(maxCost));
+  }
+
+private:
+  void initQuadrics() {
+    uint32_t numVerts = uint32_t(pos.size());
+    quadrics.resize(numVerts);
+    border.assign(numVerts, false);
+    removed.assign(numVerts, false);
+    versions.assign(numVerts, 0);
+    std::unordered_map<uint64_t, uint32_t> edgeFaces;
+    for (uint32_t j = 0; j < faces.size(); j++) {
+      if (!alive[j])
+        continue;
+      auto &face = faces[j];
+      vec3 p0 = pos[face[0]], p1 = pos[face[1]], p2 = pos[face[2]];
+      dvec3 n = dvec3(cross(p1 - p0, p2 - p0));
+      double area = length(n);
+      if (area == 0.0)
+        continue;
+      n /= area;
+      Quadric q;
+      q.addPlane(n, -dot(n, dvec3(p0)));
+      for (int k = 0; k < 3; k++) {
+        quadrics[face[k]] += q;
+        edgeFaces[edgeKey(face[k], face[(k + 1) % 3])]++;
+      }
+    }
+    // Constrain the border edges to stay on the planes perpendicular to
+    // their faces
+    for (uint32_t j = 0; j < faces.size(); j++) {
+      if (!alive[j])
+        continue;
+      auto &face = faces[j];
+      vec3 p0 = pos[face[0]], p1 = pos[face[1]], p2 = pos[face[2]];
+      dvec3 faceNormal = dvec3(cross(p1 - p0, p2 - p0));
+      for (int k = 0; k < 3; k++) {
+        uint32_t a = face[k], b = face[(k + 1) % 3];
+        if (edgeFaces[edgeKey(a, b)] != 1)
+          continue;
+        border[a] = border[b] = true;
+        dvec3 n = cross(dvec3(pos[b] - pos[a]), faceNormal);
+        double nLength = length(n);
+        if (nLength == 0.0)
+          continue;
+        n /= nLength;
+        Quadric q;
+        q.addPlane(n, -dot(n, dvec3(pos[a])));
+        quadrics[a] += q;
+        quadrics[b] += q;
+      }
+    }
+  }
+
+  void getNeighbors(uint32_t v, std::vector<uint32_t> &neighbors) {
+    neighbors.clear();
+    for (uint32_t f : vertexFaces[v]) {
+      for (int k = 0; k < 3; k++) {
+        uint32_t w = faces[f][k];
+        if (w != v &&
+            std::find(neighbors.begin(), neighbors.end(), w) == neighbors.end())
+          neighbors.push_back(w);
+      }
+    }
+  }
+
+  double collapseCost(uint32_t from, uint32_t to) {
+    Quadric q = quadrics[from];
+    q += quadrics[to];
+    return q.eval(pos[to]);
+  }
+
+  void pushCollapse(uint32_t a, uint32_t b) {
+    // A border vertex can only move along the border
+    bool ab = !border[a] || border[b], ba = !border[b] || border[a];
+    if (!ab && !ba)
+      return;
+    double costAB = ab ? collapseCost(a, b) : DBL_MAX,
+           costBA = ba ? collapseCost(b, a) : DBL_MAX;
+    if (costBA < costAB)
+      std::swap(a, b);
+    collapses.push({std::min(costAB, costBA), a, b, versions[a], versions[b]});
+  }
+
+  bool canCollapse(uint32_t from, uint32_t to) {
+    // The link condition: the vertices only share the neighbors of the
+    // faces on their edge, otherwise the collapse changes the topology
+    uint32_t numSharedFaces = 0;
+    for (uint32_t f : vertexFaces[from]) {
+      auto &face = faces[f];
+      if (face[0] == int(to) || face[1] == int(to) || face[2] == int(to))
+        numSharedFaces++;
+    }
+    if (numSharedFaces == 0 || (border[from] && numSharedFaces != 1))
+      return false;
+    auto &fromNeighbors = neighbors0, &toNeighbors = neighbors1;
+    getNeighbors(from, fromNeighbors);
+    getNeighbors(to, toNeighbors);
+    uint32_t numSharedNeighbors = 0;
+    for (uint32_t w : fromNeighbors)
+      if (std::find(toNeighbors.begin(), toNeighbors.end(), w) !=
+          toNeighbors.end())
+        numSharedNeighbors++;
+    if (numSharedNeighbors != numSharedFaces)
+      return false;
+    // Reject the collapses that flip a triangle
+    for (uint32_t f : vertexFaces[from]) {
+      auto &face = faces[f];
+      if (face[0] == int(to) || face[1] == int(to) || face[2] == int(to))
+        continue;
+      vec3 p[3], q[3];
+      for (int k = 0; k < 3; k++) {
+        p[k] = pos[face[k]];
+        q[k] = (uint32_t(face[k]) == from) ? pos[to] : p[k];
+      }
+      vec3 n0 = cross(p[1] - p[0], p[2] - p[0]),
+           n1 = cross(q[1] - q[0], q[2] - q[0]);
+      if (dot(n0, n1) <= 0.0f)
+        return false;
+    }
+    return true;
+  }
+
+  void applyCollapse(uint32_t from, uint32_t to) {
+    removed[from] = true;
+    quadrics[to] += quadrics[from];
+    std::vector<uint32_t> &collapsedVertices = neighbors0;
+    collapsedVertices.assign(1, to);
+    for (uint32_t f : vertexFaces[from]) {
+      auto &face = faces[f];
+      if (face[0] == int(to) || face[1] == int(to) || face[2] == int(to)) {
+        alive[f] = false;
+        numFaces--;
+        for (int k = 0; k < 3; k++)
+          if (uint32_t(face[k]) != from && uint32_t(face[k]) != to)
+            collapsedVertices.push_back(face[k]);
+        continue;
+      }
+      for (int k = 0; k < 3; k++)
+        if (uint32_t(face[k]) == from)
+          face[k] = int(to);
+      vertexFaces[to].push_back(f);
+    }
+    vertexFaces[from].clear();
+    // The collapsed faces are also referenced by the other two vertices
+    for (uint32_t v : collapsedVertices) {
+      auto &vFaces = vertexFaces[v];
+      vFaces.erase(std::remove_if(vFaces.begin(), vFaces.end(),
+                                  [&](uint32_t f) { return !alive[f]; }),
+                   vFaces.end());
+    }
+    versions[to]++;
+  }
+
+  const std::vector<vec3> &pos;
+  const std::vector<ivec3> &inputFaces;
+  std::vector<ivec3> faces;
+  std::vector<bool> alive, border, removed;
+  std::vector<uint32_t> remap, versions;
+  std::vector<std::vector<uint32_t>> vertexFaces;
+  std::vector<Quadric> quadrics;
+  std::priority_queue<Collapse> collapses;
+  std::vector<uint32_t> neighbors0, neighbors1;
+  uint32_t numFaces = 0;
+};
+} // namespace
+
+float MeshOptimizer::simplify(const MeshData &meshData,
+                              const std::vector<ivec3> &faces,
+                              uint32_t targetNumFaces,
+                              std::vector<ivec3> &result) {
+  Simplifier simplifier(meshData.pos, faces);
+  return simplifier.simplify(targetNumFaces, result);
+}
+
+void MeshOptimizer::generateLODs(MeshData &meshData, uint32_t maxLODs,
+                                 float reduction, uint32_t minFaces) {
+  auto &faces = meshData.faces;
+  auto &lods = meshData.lods;
+  if (!lods.empty())
+    faces.resize(lods[0].numFaces);
+  // The meshlets are rebuilt from the new LODs
+  meshData.meshlets.clear();
+  lods.assign(1, {0, uint32_t(faces.size()), 0.0f});
+  std::vector<ivec3> lodFaces(faces), simplifiedFaces;
+  while (lods.size() < maxLODs) {
+    uint32_t numFaces = uint32_t(lodFaces.size()),
+             targetNumFaces = uint32_t(float(numFaces) * reduction);
+    if (targetNumFaces < minFaces)
+      break;
+    float error = simplify(meshData, lodFaces, targetNumFaces, simplifiedFaces);
+    // Stop when the simplification is stuck, e.g. on a mesh made of
+    // many small disconnected parts
+    if (simplifiedFaces.size() > (numFaces + targetNumFaces) / 2)
+      break;
+    // The errors of the successive simplifications add up
+    lods.push_back({uint32_t(faces.size()), uint32_t(simplifiedFaces.size()),
+                    lods.back().error + error});
+    faces.insert(faces.end(), simplifiedFaces.begin(), simplifiedFaces.end());
+    std::swap(lodFaces, simplifiedFaces);
+  }
+}
+
+namespace {
+// Grows each meshlet from a seed face over the face adjacency, adding the
+// face that references the fewest new vertices, and among those the face
+// whose normal is the closest to the meshlet's average normal
+class MeshletBuilder {
+public:
+  MeshletBuilder(const std::vector<vec3> &pos, uint32_t maxVerts,
+                 uint32_t maxFaces, float coneWeight)
+      : pos(pos), maxVerts(maxVerts), maxFaces(maxFaces),
+        coneWeight(coneWeight), vertexTag(pos.size(), 0) {}
+  void build(const std::vector<ivec3> &faces, uint32_t firstFace,
+             std::vector<ivec3> &sortedFaces, std::vector<Meshlet> &meshlets) {
+    uint32_t numFaces = uint32_t(faces.size());
+    // The faces adjacent to each vertex
+    std::vector<uint32_t> offsets(pos.size() + 1, 0);
+    for (auto &face : faces)
+      for (int k = 0; k < 3; k++)
+        offsets[face[k] + 1]++;
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    vertexFaces.resize(offsets.back());
+    vertexFacesBegin = offsets;
+    for (uint32_t j = 0; j < numFaces; j++)
+      for (int k = 0; k < 3; k++)
+        vertexFaces[offsets[faces[j][k]]++] = j;
+    faceNormals.resize(numFaces);
+    for (uint32_t j = 0; j < numFaces; j++) {
+      auto &face = faces[j];
+      vec3 n = cross(pos[face[1]] - pos[face[0]], pos[face[2]] - pos[face[0]]);
+      float area = length(n);
+      faceNormals[j] = (area > 0.0f) ? n / area : vec3(0.0f);
+    }
+    emitted.assign(numFaces, false);
+    uint32_t seed = 0;
+    while (true) {
+      while (seed < numFaces && emitted[seed])
+        seed++;
+      if (seed == numFaces)
+        break;
+      beginMeshlet();
+      addFace(faces, seed);
+      while (meshletFaces.size() < maxFaces) {
+        int32_t next = nextFace(faces);
+        // When the neighbors are exhausted, continue with the next face
+        // in order, e.g. on a mesh made of small disconnected parts
+        if (next == -1) {
+          while (seed < numFaces && emitted[seed])
+            seed++;
+          if (seed < numFaces && fits(faces[seed]))
+            next = int32_t(seed);
+        }
+        if (next == -1)
+          break;
+        addFace(faces, uint32_t(next));
+      }
+      meshlets.push_back(endMeshlet(faces, firstFace + sortedFaces.size()));
+      for (uint32_t j : meshletFaces)
+        sortedFaces.push_back(faces[j]);
+    }
+  }
+
+private:
+  uint32_t countNewVerts(const ivec3 &face) {
+    uint32_t numNewVerts = 0;
+    for (int k = 0; k < 3; k++)
+      numNewVerts += (vertexTag[face[k]] != tag) ? 1 : 0;
+    return numNewVerts;
+  }
+  bool fits(const ivec3 &face) {
+    return meshletVerts.size() + countNewVerts(face) <= maxVerts;
+  }
+  void beginMeshlet() {
+    tag++;
+    meshletVerts.clear();
+    meshletFaces.clear();
+    candidates.clear();
+    normalSum = vec3(0.0f);
+  }
+  void addFace(const std::vector<ivec3> &faces, uint32_t j) {
+    emitted[j] = true;
+    meshletFaces.push_back(j);
+    normalSum += faceNormals[j];
+    for (int k = 0; k < 3; k++) {
+      uint32_t v = faces[j][k];
+      if (vertexTag[v] == tag)
+        continue;
+      vertexTag[v] = tag;
+      meshletVerts.push_back(v);
+      for (uint32_t l = vertexFacesBegin[v]; l < vertexFacesBegin[v + 1]; l++)
+        if (!emitted[vertexFaces[l]])
+          candidates.push_back(vertexFaces[l]);
+    }
+  }
+  int32_t nextFace(const std::vector<ivec3> &faces) {
+    vec3 axis = normalSum;
+    float axisLength = length(axis);
+    if (axisLength > 0.0f)
+      axis /= axisLength;
+    int32_t best = -1;
+    float bestScore = FLT_MAX;
+    for (uint32_t j = 0; j < candidates.size();) {
+      uint32_t face = candidates[j];
+      // The vertex count of the meshlet only grows, so a face that doesn't
+      // fit now will never fit
+      if (emitted[face] || !fits(faces[face])) {
+        candidates[j] = candidates.back();
+        candidates.pop_back();
+        continue;
+      }
+      float score = float(countNewVerts(faces[face])) +
+                    coneWeight * (1.0f - dot(faceNormals[face], axis));
+      if (score < bestScore) {
+        bestScore = score;
+        best = int32_t(face);
+      }
+      j++;
+    }
+    return best;
+  }
+  Meshlet endMeshlet(const std::vector<ivec3> &faces, size_t firstFace) {
+    Meshlet meshlet;
+    meshlet.firstFace = uint32_t(firstFace);
+    meshlet.numFaces = uint32_t(meshletFaces.size());
+    meshlet.numVerts = uint32_t(meshletVerts.size());
+    vec3 boundsMin(FLT_MAX), boundsMax(-FLT_MAX);
+    for (uint32_t v : meshletVerts) {
+      boundsMin = glm::min(boundsMin, pos[v]);
+      boundsMax = glm::max(boundsMax, pos[v]);
+    }
+    vec3 center = 0.5f * (boundsMin + boundsMax);
+    float radius = 0.0f;
+    for (uint32_t v : meshletVerts)
+      radius = std::max(radius, length(pos[v] - center));
+    meshlet.boundingSphere = vec4(center, radius);
+    // The cone contains all the face normals. The meshlet is back facing
+    // when the view direction is within 90 degrees minus the cone angle
+    // of the axis
+    float axisLength = length(normalSum);
+    if (axisLength == 0.0f)
+      return meshlet;
+    vec3 axis = normalSum / axisLength;
+    float minDot = 1.0f;
+    for (uint32_t j : meshletFaces) {
+      if (faceNormals[j] != vec3(0.0f))
+        minDot = std::min(minDot, dot(faceNormals[j], axis));
+    }
+    // Wide cones are almost never back facing
+    if (minDot <= 0.1f)
+      return meshlet;
+    meshlet.normalCone = vec4(axis, sqrtf(1.0f - minDot * minDot));
+    return meshlet;
+  }
+  const std::vector<vec3> &pos;
+  uint32_t maxVerts, maxFaces;
+  float coneWeight;
+  std::vector<uint32_t> vertexTag, vertexFacesBegin, vertexFaces;
+  std::vector<vec3> faceNormals;
+  std::vector<bool> emitted;
+  uint32_t tag = 0;
+  std::vector<uint32_t> meshletVerts, meshletFaces, candidates;
+  vec3 normalSum;
+};
+} // namespace
+
+void MeshOptimizer::buildMeshlets(MeshData &meshData, uint32_t maxVerts,
+                                  uint32_t maxFaces, float coneWeight) {
+  auto &faces = meshData.faces;
+  auto &meshlets = meshData.meshlets;
+  meshlets.clear();
+  MeshletBuilder builder(meshData.pos, maxVerts, maxFaces, coneWeight);
+  std::vector<ivec3> lodFaces, sortedFaces;
+  if (meshData.lods.empty()) {
+    builder.build(faces, 0, sortedFaces, meshlets);
+    faces = std::move(sortedFaces);
+    return;
+  }
+  for (auto &lod : meshData.lods) {
+    auto begin = faces.begin() + lod.firstFace;
+    lodFaces.assign(begin, begin + lod.numFaces);
+    sortedFaces.clear();
+    builder.build(lodFaces, lod.firstFace, sortedFaces, meshlets);
+    std::copy(sortedFaces.begin(), sortedFaces.end(), begin);
+  }
+}
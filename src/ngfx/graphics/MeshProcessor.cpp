@@ -0,0 +1,388 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "ngfx/graphics/MeshProcessor.h"
+#include "ngfx/core/DebugUtil.h"
+#include "ngfx/core/ParallelUtil.h"
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <utility>
+using namespace ngfx;
+using namespace std;
+
+// The maximum distance between the normals of two welded vertices
+static const float NORMAL_WELD_TOLERANCE = 1e-3f;
+
+static void reduceBounds(const vector<vec3> &threadMin,
+                         const vector<vec3> &threadMax, MeshData &meshData) {
+  auto &bounds = meshData.bounds;
+  bounds[0] = vec3(FLT_MAX);
+  bounds[1] = vec3(-FLT_MAX);
+  for (uint32_t j = 0; j < threadMin.size(); j++) {
+    bounds[0] = glm::min(bounds[0], threadMin[j]);
+    bounds[1] = glm::max(bounds[1], threadMax[j]);
+  }
+}
+
+// The hash grid cell of a position. The cell coordinates wrap around,
+// the distant cells with the same key only cost extra comparisons
+static uint64_t getCellKey(const int64_t cell[3]) {
+  const uint64_t mask = (uint64_t(1) << 21) - 1;
+  return (uint64_t(cell[0]) & mask) | ((uint64_t(cell[1]) & mask) << 21) |
+         ((uint64_t(cell[2]) & mask) << 42);
+}
+
+// The hash of a position, for exact welding
+static uint64_t getPositionKey(vec3 p) {
+  // -0 and +0 are the same position
+  p += vec3(0.0f);
+  uint32_t bits[3];
+  memcpy(bits, &p, sizeof(bits));
+  uint64_t key = bits[0];
+  key = key * 0x9E3779B97F4A7C15ull ^ bits[1];
+  key = key * 0x9E3779B97F4A7C15ull ^ bits[2];
+  return key;
+}
+
+uint32_t MeshProcessor::weldVertices(MeshData &meshData, float tolerance,
+                                     uint32_t numThreads) {
+  auto &pos = meshData.pos;
+  auto &normal = meshData.normal;
+  auto &faces = meshData.faces;
+  size_t numVerts = pos.size();
+  bool hasNormals = !normal.empty();
+  if (hasNormals && normal.size() != numVerts)
+    NGFX_ERR("%d vertices, %d normals", int(numVerts), int(normal.size()));
+  numThreads = ParallelUtil::getNumThreads(numThreads, numVerts);
+
+  // With a tolerance, the cells are 4 times larger than the tolerance,
+  // so only the vertices near the border of a cell are compared with
+  // the vertices of the neighbor cells
+  float cellSize = 4.0f * tolerance, tolerance2 = tolerance * tolerance;
+  auto getCell = [&](const vec3 &p, int64_t cell[3], int32_t dir[3]) {
+    for (uint32_t k = 0; k < 3; k++) {
+      double c = double(p[k]) / double(cellSize), cf = std::floor(c);
+      cell[k] = int64_t(cf);
+      dir[k] = (c - cf) < 0.25 ? -1 : (c - cf) > 0.75 ? 1 : 0;
+    }
+  };
+  vector<pair<uint64_t, uint32_t>> cells(numVerts);
+  ParallelUtil::parallelFor(
+      numThreads, numVerts, [&](uint32_t, size_t begin, size_t end) {
+        for (size_t j = begin; j < end; j++) {
+          uint64_t key;
+          if (tolerance > 0.0f) {
+            int64_t cell[3];
+            int32_t dir[3];
+            getCell(pos[j], cell, dir);
+            key = getCellKey(cell);
+          } else
+            key = getPositionKey(pos[j]);
+          cells[j] = {key, uint32_t(j)};
+        }
+      });
+  // Sort the vertices by cell, and by index in a cell
+  ParallelUtil::parallelSort(cells, numThreads);
+  // The first vertex of each cell
+  vector<uint32_t> runs(numVerts + 1);
+  size_t numRuns = ParallelUtil::parallelCompact(
+      numThreads, numVerts,
+      [&](size_t j) { return j == 0 || cells[j].first != cells[j - 1].first; },
+      [&](uint32_t, size_t j, size_t outIndex) {
+        runs[outIndex] = uint32_t(j);
+      });
+  runs[numRuns] = uint32_t(numVerts);
+  runs.resize(numRuns + 1);
+
+  auto canWeld = [&](uint32_t v0, uint32_t v1) {
+    if (tolerance > 0.0f) {
+      vec3 d = pos[v0] - pos[v1];
+      if (dot(d, d) > tolerance2)
+        return false;
+    } else if (pos[v0] != pos[v1])
+      return false;
+    if (!hasNormals)
+      return true;
+    vec3 d = normal[v0] - normal[v1];
+    return dot(d, d) <= NORMAL_WELD_TOLERANCE * NORMAL_WELD_TOLERANCE;
+  };
+  // Find the first vertex in the sorted range [begin, end) of a cell
+  // that can be welded with v, before the current candidate
+  auto findInRange = [&](uint32_t v, size_t begin, size_t end,
+                         uint32_t &target) {
+    for (size_t j = begin; j < end; j++) {
+      uint32_t v1 = cells[j].second;
+      if (v1 >= target || cells[j].first != cells[begin].first)
+        return;
+      if (canWeld(v, v1)) {
+        target = v1;
+        return;
+      }
+    }
+  };
+  // Each vertex is merged into the first vertex that it can be welded
+  // with, including itself
+  vector<uint32_t> target(numVerts);
+  ParallelUtil::parallelFor(
+      numThreads, numRuns, [&](uint32_t, size_t begin, size_t end) {
+        for (size_t r = begin; r < end; r++) {
+          for (uint32_t j = runs[r]; j < runs[r + 1]; j++) {
+            uint32_t v = cells[j].second, t = v;
+            findInRange(v, runs[r], runs[r + 1], t);
+            if (tolerance > 0.0f) {
+              int64_t cell[3];
+              int32_t dir[3];
+              getCell(pos[v], cell, dir);
+              // The neighbor cells within the tolerance
+              for (uint32_t n = 1; n < 8; n++) {
+                int64_t neighborCell[3];
+                bool valid = true;
+                for (uint32_t k = 0; k < 3; k++) {
+                  bool offset = (n >> k) & 1;
+                  valid &= !offset || dir[k] != 0;
+                  neighborCell[k] = cell[k] + (offset ? dir[k] : 0);
+                }
+                if (!valid)
+                  continue;
+                uint64_t key = getCellKey(neighborCell);
+                auto it = std::lower_bound(cells.begin(), cells.end(),
+                                           make_pair(key, uint32_t(0)));
+                if (it != cells.end() && it->first == key)
+                  findInRange(v, size_t(it - cells.begin()), cells.size(), t);
+              }
+            }
+            target[v] = t;
+          }
+        }
+      });
+  cells = {};
+  runs = {};
+
+  // Follow the chains of merged vertices
+  vector<uint32_t> root(numVerts);
+  ParallelUtil::parallelFor(
+      numThreads, numVerts, [&](uint32_t, size_t begin, size_t end) {
+        for (size_t j = begin; j < end; j++) {
+          uint32_t v = uint32_t(j);
+          while (target[v] != v)
+            v = target[v];
+          root[j] = v;
+        }
+      });
+  target = {};
+
+  // Keep the roots, and update the bounds in the same pass
+  size_t numWeldedVerts = ParallelUtil::parallelCompact(
+      numThreads, numVerts, [&](size_t j) { return root[j] == j; },
+      [&](uint32_t, size_t, size_t) {});
+  vector<uint32_t> remap(numVerts);
+  vector<vec3> weldedPos(numWeldedVerts),
+      weldedNormal(hasNormals ? numWeldedVerts : 0);
+  vector<vec3> threadMin(numThreads, vec3(FLT_MAX)),
+      threadMax(numThreads, vec3(-FLT_MAX));
+  ParallelUtil::parallelCompact(
+      numThreads, numVerts, [&](size_t j) { return root[j] == j; },
+      [&](uint32_t thread, size_t j, size_t outIndex) {
+        remap[j] = uint32_t(outIndex);
+        weldedPos[outIndex] = pos[j];
+        if (hasNormals)
+          weldedNormal[outIndex] = normal[j];
+        threadMin[thread] = glm::min(threadMin[thread], pos[j]);
+        threadMax[thread] = glm::max(threadMax[thread], pos[j]);
+      });
+  reduceBounds(threadMin, threadMax, meshData);
+  pos = std::move(weldedPos);
+  normal = std::move(weldedNormal);
+  ParallelUtil::parallelFor(
+      ParallelUtil::getNumThreads(numThreads, faces.size()), faces.size(),
+      [&](uint32_t, size_t begin, size_t end) {
+        for (size_t j = begin; j < end; j++) {
+          auto &face = faces[j];
+          for (uint32_t k = 0; k < 3; k++)
+            face[k] = int(remap[root[face[k]]]);
+        }
+      });
+  return uint32_t(numVerts - numWeldedVerts);
+}
+
+uint32_t MeshProcessor::removeDegenerateFaces(MeshData &meshData,
+                                              uint32_t numThreads) {
+  auto &pos = meshData.pos;
+  auto &faces = meshData.faces;
+  size_t numFaces = faces.size();
+  numThreads = ParallelUtil::getNumThreads(numThreads, numFaces);
+  auto isValid = [&](size_t j) {
+    auto &face = faces[j];
+    if (face[0] == face[1] || face[1] == face[2] || face[2] == face[0])
+      return false;
+    vec3 n = cross(pos[face[1]] - pos[face[0]], pos[face[2]] - pos[face[0]]);
+    return dot(n, n) > 0.0f;
+  };
+  vector<ivec3> validFaces(numFaces);
+  size_t numValidFaces = ParallelUtil::parallelCompact(
+      numThreads, numFaces, isValid,
+      [&](uint32_t, size_t j, size_t outIndex) {
+        validFaces[outIndex] = faces[j];
+      });
+  validFaces.resize(numValidFaces);
+  faces = std::move(validFaces);
+  return uint32_t(numFaces - numValidFaces);
+}
+
+void MeshProcessor::generateNormals(MeshData &meshData,
+                                    NormalWeighting weighting,
+                                    uint32_t numThreads) {
+  auto &pos = meshData.pos;
+  auto &normal = meshData.normal;
+  auto &faces = meshData.faces;
+  size_t numVerts = pos.size(), numFaces = faces.size();
+  if (numFaces > UINT32_MAX / 3)
+    NGFX_ERR("too many faces: %zu", numFaces);
+  numThreads =
+      ParallelUtil::getNumThreads(numThreads, std::max(numVerts, numFaces));
+
+  // The triangle corners adjacent to each vertex, in compressed sparse
+  // row format. Each thread then gathers the normals of its own vertices,
+  // without atomics or per-thread accumulation buffers
+  unique_ptr<atomic<uint32_t>[]> counts(new atomic<uint32_t>[numVerts]);
+  ParallelUtil::parallelFor(
+      numThreads, numVerts, [&](uint32_t, size_t begin, size_t end) {
+        for (size_t j = begin; j < end; j++)
+          counts[j].store(0, memory_order_relaxed);
+      });
+  ParallelUtil::parallelFor(
+      numThreads, numFaces, [&](uint32_t, size_t begin, size_t end) {
+        for (size_t j = begin; j < end; j++) {
+          for (uint32_t k = 0; k < 3; k++)
+            counts[faces[j][k]].fetch_add(1, memory_order_relaxed);
+        }
+      });
+  vector<uint32_t> offsets(numVerts + 1);
+  vector<uint32_t> threadOffsets(numThreads + 1, 0);
+  ParallelUtil::parallelFor(
+      numThreads, numVerts, [&](uint32_t thread, size_t begin, size_t end) {
+        uint32_t sum = 0;
+        for (size_t j = begin; j < end; j++)
+          sum += counts[j].load(memory_order_relaxed);
+        threadOffsets[thread + 1] = sum;
+      });
+  for (uint32_t j = 0; j < numThreads; j++)
+    threadOffsets[j + 1] += threadOffsets[j];
+  ParallelUtil::parallelFor(
+      numThreads, numVerts, [&](uint32_t thread, size_t begin, size_t end) {
+        uint32_t offset = threadOffsets[thread];
+        for (size_t j = begin; j < end; j++) {
+          offsets[j] = offset;
+          offset += counts[j].load(memory_order_relaxed);
+          counts[j].store(offsets[j], memory_order_relaxed);
+        }
+      });
+  offsets[numVerts] = uint32_t(3 * numFaces);
+  vector<uint32_t> corners(3 * numFaces);
+  ParallelUtil::parallelFor(
+      numThreads, numFaces, [&](uint32_t, size_t begin, size_t end) {
+        for (size_t j = begin; j < end; j++) {
+          for (uint32_t k = 0; k < 3; k++) {
+            uint32_t index = counts[faces[j][k]].fetch_add(
+                1, memory_order_relaxed);
+            corners[index] = uint32_t(3 * j + k);
+          }
+        }
+      });
+  counts.reset();
+
+  normal.resize(numVerts);
+  ParallelUtil::parallelFor(
+      numThreads, numVerts, [&](uint32_t, size_t begin, size_t end) {
+        for (size_t j = begin; j < end; j++) {
+          // Sum in a fixed order, so that the normals don't depend on
+          // the thread scheduling
+          auto first = corners.begin() + offsets[j],
+               last = corners.begin() + offsets[j + 1];
+          std::sort(first, last);
+          vec3 n(0.0f);
+          for (auto it = first; it != last; it++) {
+            auto &face = faces[*it / 3];
+            uint32_t k = *it % 3;
+            const vec3 &p0 = pos[face[k]], &p1 = pos[face[(k + 1) % 3]],
+                       &p2 = pos[face[(k + 2) % 3]];
+            vec3 e1 = p1 - p0, e2 = p2 - p0;
+            // The length of the cross product is twice the area
+            vec3 faceNormal = cross(e1, e2);
+            if (weighting != NORMAL_WEIGHTING_AREA) {
+              float l = length(e1) * length(e2), area = length(faceNormal);
+              if (l == 0.0f || area == 0.0f)
+                continue;
+              float angle = acos(glm::clamp(dot(e1, e2) / l, -1.0f, 1.0f));
+              if (weighting == NORMAL_WEIGHTING_ANGLE)
+                faceNormal /= area;
+              faceNormal *= angle;
+            }
+            n += faceNormal;
+          }
+          float l = length(n);
+          normal[j] = (l > 0.0f) ? n / l : vec3(0.0f, 0.0f, 1.0f);
+        }
+      });
+}
+
+void MeshProcessor::updateBounds(MeshData &meshData, uint32_t numThreads) {
+  auto &pos = meshData.pos;
+  numThreads = ParallelUtil::getNumThreads(numThreads, pos.size());
+  vector<vec3> threadMin(numThreads, vec3(FLT_MAX)),
+      threadMax(numThreads, vec3(-FLT_MAX));
+  ParallelUtil::parallelFor(
+      numThreads, pos.size(), [&](uint32_t thread, size_t begin, size_t end) {
+        vec3 boundsMin(FLT_MAX), boundsMax(-FLT_MAX);
+        for (size_t j = begin; j < end; j++) {
+          boundsMin = glm::min(boundsMin, pos[j]);
+          boundsMax = glm::max(boundsMax, pos[j]);
+        }
+        threadMin[thread] = boundsMin;
+        threadMax[thread] = boundsMax;
+      });
+  reduceBounds(threadMin, threadMax, meshData);
+}
+
+MeshProcessor::Stats MeshProcessor::process(MeshData &meshData,
+                                            const Options &options) {
+  Stats stats;
+  meshData.lods.clear();
+  meshData.meshlets.clear();
+  bool computeNormals = options.generateNormals || meshData.normal.empty();
+  // The normals that are replaced don't prevent welding
+  if (computeNormals)
+    meshData.normal.clear();
+  if (options.weldVertices)
+    stats.numWeldedVerts =
+        weldVertices(meshData, options.weldTolerance, options.numThreads);
+  else
+    updateBounds(meshData, options.numThreads);
+  if (options.removeDegenerateFaces)
+    stats.numDegenerateFaces =
+        removeDegenerateFaces(meshData, options.numThreads);
+  if (computeNormals)
+    generateNormals(meshData, options.normalWeighting, options.numThreads);
+  return stats;
+}
@@ -20,31 +20,190 @@
  */
 #include "ngfx/graphics/MeshUtil.h"
 #include "ngfx/core/DebugUtil.h"
+#include <cstring>
 #include <fstream>
+#include <glm/gtc/packing.hpp>
 #include <glm/gtc/type_ptr.hpp>
 using namespace ngfx;
 using namespace std;
 
-void MeshUtil::importMesh(const std::string &file, MeshData &meshData) {
-  ifstream in(file, ios::binary);
-  if (!in.is_open())
-    NGFX_ERR("cannot open file: %s", file.c_str());
+// Quantized mesh files start with a header, float mesh files start
+// with the vertex count
+static const char QUANTIZED_MESH_MAGIC[8] = {'N', 'G', 'F', 'X',
+                                             'Q', 'M', 'S', 'H'};
+// Version 2 adds the LOD table, version 3 adds the meshlet table
+static const uint32_t QUANTIZED_MESH_VERSION = 3;
+// Float mesh files end with an optional trailer, with the LOD table
+// and the meshlet table
+static const char MESH_TRAILER_MAGIC[8] = {'N', 'G', 'F', 'X',
+                                           'M', 'E', 'X', 'T'};
+static const uint32_t MESH_TRAILER_VERSION = 1;
+
+static bool isQuantizedMesh(ifstream &in) {
+  char magic[sizeof(QUANTIZED_MESH_MAGIC)] = {};
+  in.read(magic, sizeof(magic));
+  bool quantized = in.good() && memcmp(magic, QUANTIZED_MESH_MAGIC,
+                                       sizeof(QUANTIZED_MESH_MAGIC)) == 0;
+  in.clear();
+  in.seekg(0);
+  return quantized;
+}
+
+static size_t getFileSize(ifstream &in) {
+  auto offset = in.tellg();
+  in.seekg(0, ios::end);
+  size_t fileSize = size_t(in.tellg());
+  in.seekg(offset);
+  return fileSize;
+}
+
+// Read the number of elements of a table, and check that the table fits
+// in the rest of the file
+template <typename T>
+static T readCount(ifstream &in, const std::string &file, size_t fileSize,
+                   size_t elementSize) {
+  T count = 0;
+  in.read((char *)&count, sizeof(count));
+  if (!in.good())
+    NGFX_ERR("%s: unexpected end of file", file.c_str());
+  size_t remainingSize = fileSize - size_t(in.tellg());
+  if (uint64_t(count) > remainingSize / elementSize)
+    NGFX_ERR("%s: invalid element count: %llu", file.c_str(),
+             (unsigned long long)count);
+  return count;
+}
+
+template <typename T>
+static void checkRanges(const std::string &file, const T &meshData,
+                        size_t numFaces) {
+  for (uint32_t j = 0; j < meshData.lods.size(); j++) {
+    auto &lod = meshData.lods[j];
+    if (uint64_t(lod.firstFace) + lod.numFaces > numFaces)
+      NGFX_ERR("%s: LOD %u is out of range", file.c_str(), j);
+  }
+  for (uint32_t j = 0; j < meshData.meshlets.size(); j++) {
+    auto &meshlet = meshData.meshlets[j];
+    if (uint64_t(meshlet.firstFace) + meshlet.numFaces > numFaces)
+      NGFX_ERR("%s: meshlet %u is out of range", file.c_str(), j);
+  }
+}
+
+static void readMesh(ifstream &in, const std::string &file,
+                     MeshData &meshData) {
+  size_t fileSize = getFileSize(in);
   auto &bounds = meshData.bounds;
   auto &pos = meshData.pos;
   auto &normals = meshData.normal;
   auto &faces = meshData.faces;
-  size_t numVerts, numNormals, numFaces;
-  in.read((char *)&numVerts, sizeof(numVerts));
+  size_t numVerts = readCount<size_t>(in, file, fileSize, sizeof(pos[0]));
   pos.resize(numVerts);
   in.read((char *)value_ptr(bounds[0]), sizeof(bounds[0]));
   in.read((char *)value_ptr(bounds[1]), sizeof(bounds[1]));
   in.read((char *)pos.data(), pos.size() * sizeof(pos[0]));
-  in.read((char *)&numNormals, sizeof(numNormals));
+  size_t numNormals =
+      readCount<size_t>(in, file, fileSize, sizeof(normals[0]));
   normals.resize(numNormals);
   in.read((char *)normals.data(), normals.size() * sizeof(normals[0]));
-  in.read((char *)&numFaces, sizeof(numFaces));
+  size_t numFaces = readCount<size_t>(in, file, fileSize, sizeof(faces[0]));
   faces.resize(numFaces);
   in.read((char *)faces.data(), faces.size() * sizeof(faces[0]));
+  if (!in.good())
+    NGFX_ERR("%s: unexpected end of file", file.c_str());
+  // The trailer is optional, so that the files without LODs and meshlets
+  // remain valid
+  meshData.lods.clear();
+  meshData.meshlets.clear();
+  if (size_t(in.tellg()) == fileSize)
+    return;
+  char magic[sizeof(MESH_TRAILER_MAGIC)] = {};
+  uint32_t version = 0;
+  in.read(magic, sizeof(magic));
+  in.read((char *)&version, sizeof(version));
+  if (!in.good() ||
+      memcmp(magic, MESH_TRAILER_MAGIC, sizeof(MESH_TRAILER_MAGIC)) != 0)
+    NGFX_ERR("%s: invalid mesh trailer", file.c_str());
+  if (version < 1 || version > MESH_TRAILER_VERSION)
+    NGFX_ERR("%s: unsupported mesh trailer version: %u", file.c_str(),
+             version);
+  size_t numLods =
+      readCount<size_t>(in, file, fileSize, sizeof(meshData.lods[0]));
+  meshData.lods.resize(numLods);
+  in.read((char *)meshData.lods.data(),
+          meshData.lods.size() * sizeof(meshData.lods[0]));
+  size_t numMeshlets =
+      readCount<size_t>(in, file, fileSize, sizeof(meshData.meshlets[0]));
+  meshData.meshlets.resize(numMeshlets);
+  in.read((char *)meshData.meshlets.data(),
+          meshData.meshlets.size() * sizeof(meshData.meshlets[0]));
+  if (!in.good())
+    NGFX_ERR("%s: unexpected end of file", file.c_str());
+  checkRanges(file, meshData, numFaces);
+}
+
+static void readQuantizedMesh(ifstream &in, const std::string &file,
+                              QuantizedMeshData &meshData) {
+  size_t fileSize = getFileSize(in);
+  char magic[sizeof(QUANTIZED_MESH_MAGIC)];
+  uint32_t version;
+  in.read(magic, sizeof(magic));
+  in.read((char *)&version, sizeof(version));
+  if (version < 1 || version > QUANTIZED_MESH_VERSION)
+    NGFX_ERR("%s: unsupported version: %d", file.c_str(), version);
+  in.read((char *)&meshData.posEncoding, sizeof(meshData.posEncoding));
+  in.read((char *)&meshData.normalEncoding, sizeof(meshData.normalEncoding));
+  in.read((char *)&meshData.indexSize, sizeof(meshData.indexSize));
+  in.read((char *)&meshData.numVerts, sizeof(meshData.numVerts));
+  in.read((char *)&meshData.numNormals, sizeof(meshData.numNormals));
+  in.read((char *)&meshData.numFaces, sizeof(meshData.numFaces));
+  in.read((char *)value_ptr(meshData.bounds[0]), sizeof(meshData.bounds[0]));
+  in.read((char *)value_ptr(meshData.bounds[1]), sizeof(meshData.bounds[1]));
+  if (!in.good())
+    NGFX_ERR("%s: unexpected end of file", file.c_str());
+  // The strides are looked up by encoding, check the encodings first
+  if (meshData.posEncoding > POSITION_ENCODING_UNORM16 ||
+      meshData.normalEncoding > NORMAL_ENCODING_OCT8 ||
+      (meshData.indexSize != 2 && meshData.indexSize != 4))
+    NGFX_ERR("%s: invalid encodings", file.c_str());
+  uint64_t dataSize = uint64_t(meshData.numVerts) * meshData.posStride() +
+                      uint64_t(meshData.numNormals) * meshData.normalStride() +
+                      uint64_t(meshData.numFaces) * 3 * meshData.indexSize;
+  if (dataSize > fileSize - size_t(in.tellg()))
+    NGFX_ERR("%s: invalid element counts", file.c_str());
+  meshData.pos.resize(meshData.numVerts * meshData.posStride());
+  meshData.normal.resize(meshData.numNormals * meshData.normalStride());
+  meshData.indices.resize(meshData.numFaces * 3 * meshData.indexSize);
+  in.read((char *)meshData.pos.data(), meshData.pos.size());
+  in.read((char *)meshData.normal.data(), meshData.normal.size());
+  in.read((char *)meshData.indices.data(), meshData.indices.size());
+  uint32_t numLods = 0, numMeshlets = 0;
+  if (version >= 2)
+    numLods = readCount<uint32_t>(in, file, fileSize,
+                                  sizeof(meshData.lods[0]));
+  meshData.lods.resize(numLods);
+  in.read((char *)meshData.lods.data(),
+          meshData.lods.size() * sizeof(meshData.lods[0]));
+  if (version >= 3)
+    numMeshlets = readCount<uint32_t>(in, file, fileSize,
+                                      sizeof(meshData.meshlets[0]));
+  meshData.meshlets.resize(numMeshlets);
+  in.read((char *)meshData.meshlets.data(),
+          meshData.meshlets.size() * sizeof(meshData.meshlets[0]));
+  if (!in.good())
+    NGFX_ERR("%s: unexpected end of file", file.c_str());
+  checkRanges(file, meshData, meshData.numFaces);
+}
+
+void MeshUtil::importMesh(const std::string &file, MeshData &meshData) {
+  ifstream in(file, ios::binary);
+  if (!in.is_open())
+    NGFX_ERR("cannot open file: %s", file.c_str());
+  if (isQuantizedMesh(in)) {
+    QuantizedMeshData quantizedMeshData;
+    readQuantizedMesh(in, file, quantizedMeshData);
+    dequantizeMesh(quantizedMeshData, meshData);
+  } else {
+    readMesh(in, file, meshData);
+  }
   in.close();
 }
 
@@ -66,5 +225,273 @@ void MeshUtil::exportMesh(const std::string &file, MeshData &meshData) {
   out.write((const char *)normals.data(), normals.size() * sizeof(normals[0]));
   out.write((const char *)&numFaces, sizeof(numFaces));
   out.write((const char *)faces.data(), faces.size() * sizeof(faces[0]));
+  auto &lods = meshData.lods;
+  auto &meshlets = meshData.meshlets;
+  if (!lods.empty() || !meshlets.empty()) {
+    out.write(MESH_TRAILER_MAGIC, sizeof(MESH_TRAILER_MAGIC));
+    out.write((const char *)&MESH_TRAILER_VERSION,
+              sizeof(MESH_TRAILER_VERSION));
+    size_t numLods = lods.size(), numMeshlets = meshlets.size();
+    out.write((const char *)&numLods, sizeof(numLods));
+    out.write((const char *)lods.data(), lods.size() * sizeof(lods[0]));
+    out.write((const char *)&numMeshlets, sizeof(numMeshlets));
+    out.write((const char *)meshlets.data(),
+              meshlets.size() * sizeof(meshlets[0]));
+  }
   out.close();
 }
+
+void MeshUtil::importMesh(const std::string &file,
+                          QuantizedMeshData &meshData) {
+  ifstream in(file, ios::binary);
+  if (!in.is_open())
+    NGFX_ERR("cannot open file: %s", file.c_str());
+  if (isQuantizedMesh(in)) {
+    readQuantizedMesh(in, file, meshData);
+  } else {
+    MeshData floatMeshData;
+    readMesh(in, file, floatMeshData);
+    quantizeMesh(floatMeshData, meshData, POSITION_ENCODING_FLOAT3,
+                 NORMAL_ENCODING_FLOAT3);
+  }
+  in.close();
+}
+
+void MeshUtil::exportMesh(const std::string &file,
+                          QuantizedMeshData &meshData) {
+  ofstream out(file, ios::binary);
+  if (!out.is_open())
+    NGFX_ERR("cannot open file: %s", file.c_str());
+  out.write(QUANTIZED_MESH_MAGIC, sizeof(QUANTIZED_MESH_MAGIC));
+  out.write((const char *)&QUANTIZED_MESH_VERSION,
+            sizeof(QUANTIZED_MESH_VERSION));
+  out.write((const char *)&meshData.posEncoding, sizeof(meshData.posEncoding));
+  out.write((const char *)&meshData.normalEncoding,
+            sizeof(meshData.normalEncoding));
+  out.write((const char *)&meshData.indexSize, sizeof(meshData.indexSize));
+  out.write((const char *)&meshData.numVerts, sizeof(meshData.numVerts));
+  out.write((const char *)&meshData.numNormals, sizeof(meshData.numNormals));
+  out.write((const char *)&meshData.numFaces, sizeof(meshData.numFaces));
+  out.write((const char *)value_ptr(meshData.bounds[0]),
+            sizeof(meshData.bounds[0]));
+  out.write((const char *)value_ptr(meshData.bounds[1]),
+            sizeof(meshData.bounds[1]));
+  out.write((const char *)meshData.pos.data(), meshData.pos.size());
+  out.write((const char *)meshData.normal.data(), meshData.normal.size());
+  out.write((const char *)meshData.indices.data(), meshData.indices.size());
+  uint32_t numLods = uint32_t(meshData.lods.size());
+  out.write((const char *)&numLods, sizeof(numLods));
+  out.write((const char *)meshData.lods.data(),
+            meshData.lods.size() * sizeof(meshData.lods[0]));
+  uint32_t numMeshlets = uint32_t(meshData.meshlets.size());
+  out.write((const char *)&numMeshlets, sizeof(numMeshlets));
+  out.write((const char *)meshData.meshlets.data(),
+            meshData.meshlets.size() * sizeof(meshData.meshlets[0]));
+  out.close();
+}
+
+static vec2 octEncode(vec3 n) {
+  float sum = abs(n.x) + abs(n.y) + abs(n.z);
+  if (sum == 0.0f)
+    return vec2(0.0f);
+  n /= sum;
+  vec2 p(n.x, n.y);
+  if (n.z < 0.0f) {
+    vec2 s(p.x >= 0.0f ? 1.0f : -1.0f, p.y >= 0.0f ? 1.0f : -1.0f);
+    p = (1.0f - abs(vec2(p.y, p.x))) * s;
+  }
+  return p;
+}
+
+static vec3 octDecode(vec2 p) {
+  vec3 n(p.x, p.y, 1.0f - abs(p.x) - abs(p.y));
+  float t = glm::max(-n.z, 0.0f);
+  n.x += (n.x >= 0.0f) ? -t : t;
+  n.y += (n.y >= 0.0f) ? -t : t;
+  return normalize(n);
+}
+
+template <typename T>
+static void writeValue(uint8_t *dst, const T &value) {
+  memcpy(dst, &value, sizeof(value));
+}
+
+template <typename T> static T readValue(const uint8_t *src) {
+  T value;
+  memcpy(&value, src, sizeof(value));
+  return value;
+}
+
+void MeshUtil::quantizeMesh(const MeshData &meshData,
+                            QuantizedMeshData &quantizedMeshData,
+                            PositionEncoding posEncoding,
+                            NormalEncoding normalEncoding) {
+  auto &q = quantizedMeshData;
+  q.posEncoding = posEncoding;
+  q.normalEncoding = normalEncoding;
+  q.numVerts = uint32_t(meshData.pos.size());
+  q.numNormals = uint32_t(meshData.normal.size());
+  q.numFaces = uint32_t(meshData.faces.size());
+  q.lods = meshData.lods;
+  q.meshlets = meshData.meshlets;
+  q.bounds[0] = vec3(FLT_MAX);
+  q.bounds[1] = vec3(-FLT_MAX);
+  for (auto &p : meshData.pos) {
+    q.bounds[0] = glm::min(q.bounds[0], p);
+    q.bounds[1] = glm::max(q.bounds[1], p);
+  }
+  if (q.numVerts == 0)
+    q.bounds[0] = q.bounds[1] = vec3(0.0f);
+  vec3 scale = 1.0f / glm::max(q.bounds[1] - q.bounds[0], vec3(FLT_MIN));
+
+  uint32_t posStride = q.posStride();
+  q.pos.resize(q.numVerts * posStride);
+  for (uint32_t j = 0; j < q.numVerts; j++) {
+    const vec3 &p = meshData.pos[j];
+    uint8_t *dst = &q.pos[j * posStride];
+    if (posEncoding == POSITION_ENCODING_FLOAT3)
+      writeValue(dst, p);
+    else if (posEncoding == POSITION_ENCODING_HALF4)
+      writeValue(dst, packHalf4x16(vec4(p, 1.0f)));
+    else
+      writeValue(dst,
+                 packUnorm4x16(vec4((p - q.bounds[0]) * scale, 0.0f)));
+  }
+
+  uint32_t normalStride = q.normalStride();
+  q.normal.resize(q.numNormals * normalStride);
+  for (uint32_t j = 0; j < q.numNormals; j++) {
+    vec3 n = meshData.normal[j];
+    float length = glm::length(n);
+    if (length > 0.0f)
+      n /= length;
+    uint8_t *dst = &q.normal[j * normalStride];
+    switch (normalEncoding) {
+    case NORMAL_ENCODING_FLOAT3:
+      writeValue(dst, n);
+      break;
+    case NORMAL_ENCODING_HALF4:
+      writeValue(dst, packHalf4x16(vec4(n, 0.0f)));
+      break;
+    case NORMAL_ENCODING_SNORM8:
+      writeValue(dst, packSnorm4x8(vec4(n, 0.0f)));
+      break;
+    case NORMAL_ENCODING_UNORM10:
+      writeValue(dst, packUnorm3x10_1x2(vec4(n * 0.5f + 0.5f, 0.0f)));
+      break;
+    case NORMAL_ENCODING_OCT16:
+      writeValue(dst, packSnorm2x16(octEncode(n)));
+      break;
+    case NORMAL_ENCODING_OCT8:
+      writeValue(dst, packSnorm2x8(octEncode(n)));
+      break;
+    }
+  }
+
+  q.indexSize = (q.numVerts <= 65536) ? 2 : 4;
+  q.indices.resize(q.numFaces * 3 * q.indexSize);
+  for (uint32_t j = 0; j < q.numFaces; j++) {
+    for (uint32_t k = 0; k < 3; k++) {
+      uint32_t index = uint32_t(meshData.faces[j][k]);
+      uint8_t *dst = &q.indices[(j * 3 + k) * q.indexSize];
+      if (q.indexSize == 2)
+        writeValue(dst, uint16_t(index));
+      else
+        writeValue(dst, index);
+    }
+  }
+}
+
+void MeshUtil::dequantizeMesh(const QuantizedMeshData &quantizedMeshData,
+                              MeshData &meshData) {
+  auto &q = quantizedMeshData;
+  meshData.lods = q.lods;
+  meshData.meshlets = q.meshlets;
+  meshData.bounds[0] = q.bounds[0];
+  meshData.bounds[1] = q.bounds[1];
+  vec3 extent = q.bounds[1] - q.bounds[0];
+
+  uint32_t posStride = q.posStride();
+  meshData.pos.resize(q.numVerts);
+  for (uint32_t j = 0; j < q.numVerts; j++) {
+    const uint8_t *src = &q.pos[j * posStride];
+    vec3 &p = meshData.pos[j];
+    if (q.posEncoding == POSITION_ENCODING_FLOAT3)
+      p = readValue<vec3>(src);
+    else if (q.posEncoding == POSITION_ENCODING_HALF4)
+      p = vec3(unpackHalf4x16(readValue<uint64_t>(src)));
+    else
+      p = q.bounds[0] +
+          vec3(unpackUnorm4x16(readValue<uint64_t>(src))) * extent;
+  }
+
+  uint32_t normalStride = q.normalStride();
+  meshData.normal.resize(q.numNormals);
+  for (uint32_t j = 0; j < q.numNormals; j++) {
+    const uint8_t *src = &q.normal[j * normalStride];
+    vec3 &n = meshData.normal[j];
+    switch (q.normalEncoding) {
+    case NORMAL_ENCODING_FLOAT3:
+      n = readValue<vec3>(src);
+      break;
+    case NORMAL_ENCODING_HALF4:
+      n = vec3(unpackHalf4x16(readValue<uint64_t>(src)));
+      break;
+    case NORMAL_ENCODING_SNORM8:
+      n = vec3(unpackSnorm4x8(readValue<uint32_t>(src)));
+      break;
+    case NORMAL_ENCODING_UNORM10:
+      n = vec3(unpackUnorm3x10_1x2(readValue<uint32_t>(src))) * 2.0f -
+          1.0f;
+      break;
+    case NORMAL_ENCODING_OCT16:
+      n = octDecode(unpackSnorm2x16(readValue<uint32_t>(src)));
+      break;
+    case NORMAL_ENCODING_OCT8:
+      n = octDecode(unpackSnorm2x8(readValue<uint16_t>(src)));
+      break;
+    }
+  }
+
+  meshData.faces.resize(q.numFaces);
+  for (uint32_t j = 0; j < q.numFaces; j++) {
+    for (uint32_t k = 0; k < 3; k++) {
+      const uint8_t *src = &q.indices[(j * 3 + k) * q.indexSize];
+      meshData.faces[j][k] = (q.indexSize == 2)
+                                 ? int(readValue<uint16_t>(src))
+                                 : int(readValue<uint32_t>(src));
+    }
+  }
+}
+
+uint32_t MeshUtil::interleaveVertices(const MeshData &meshData,
+                                      std::vector<uint8_t> &vertices) {
+  uint32_t numVerts = uint32_t(meshData.pos.size());
+  if (meshData.normal.size() != numVerts)
+    NGFX_ERR("%d vertices, %d normals", numVerts, int(meshData.normal.size()));
+  const uint32_t stride = 2 * sizeof(vec3);
+  vertices.resize(numVerts * stride);
+  for (uint32_t j = 0; j < numVerts; j++) {
+    uint8_t *dst = &vertices[j * stride];
+    writeValue(dst, meshData.pos[j]);
+    writeValue(dst + sizeof(vec3), meshData.normal[j]);
+  }
+  return stride;
+}
+
+uint32_t MeshUtil::interleaveVertices(const QuantizedMeshData &meshData,
+                                      std::vector<uint8_t> &vertices) {
+  uint32_t numVerts = meshData.numVerts;
+  if (meshData.numNormals != numVerts)
+    NGFX_ERR("%d vertices, %d normals", numVerts, meshData.numNormals);
+  uint32_t posStride = meshData.posStride(),
+           normalStride = meshData.normalStride();
+  uint32_t stride = (posStride + normalStride + 3) & ~3u;
+  vertices.assign(numVerts * stride, 0);
+  for (uint32_t j = 0; j < numVerts; j++) {
+    uint8_t *dst = &vertices[j * stride];
+    memcpy(dst, &meshData.pos[j * posStride], posStride);
+    memcpy(dst + posStride, &meshData.normal[j * normalStride], normalStride);
+  }
+  return stride;
+}
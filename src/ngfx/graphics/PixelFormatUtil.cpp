@@ -0,0 +1,145 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "ngfx/graphics/PixelFormatUtil.h"
+#include "ngfx/core/DebugUtil.h"
+#include <algorithm>
+using namespace ngfx;
+
+#define UNCOMPRESSED(format, vkFormat, size)                                   \
+  { format, vkFormat, 1, 1, size, PIXELFORMAT_COMPRESSION_NONE, false }
+static const PixelFormatUtil::FormatInfo formatInfos[] = {
+    UNCOMPRESSED(PIXELFORMAT_R8_UNORM, 9, 1),
+    UNCOMPRESSED(PIXELFORMAT_RG8_UNORM, 16, 2),
+    UNCOMPRESSED(PIXELFORMAT_RGBA8_UNORM, 37, 4),
+    UNCOMPRESSED(PIXELFORMAT_R16_UINT, 74, 2),
+    UNCOMPRESSED(PIXELFORMAT_RG16_UINT, 81, 4),
+    UNCOMPRESSED(PIXELFORMAT_RGBA16_UINT, 95, 8),
+    UNCOMPRESSED(PIXELFORMAT_R16_SFLOAT, 76, 2),
+    UNCOMPRESSED(PIXELFORMAT_RG16_SFLOAT, 83, 4),
+    UNCOMPRESSED(PIXELFORMAT_RGBA16_SFLOAT, 97, 8),
+    UNCOMPRESSED(PIXELFORMAT_R32_UINT, 98, 4),
+    UNCOMPRESSED(PIXELFORMAT_RG32_UINT, 101, 8),
+    UNCOMPRESSED(PIXELFORMAT_RGBA32_UINT, 107, 16),
+    UNCOMPRESSED(PIXELFORMAT_R32_SFLOAT, 100, 4),
+    UNCOMPRESSED(PIXELFORMAT_RG32_SFLOAT, 103, 8),
+    UNCOMPRESSED(PIXELFORMAT_RGBA32_SFLOAT, 109, 16),
+    UNCOMPRESSED(PIXELFORMAT_BGRA8_UNORM, 44, 4),
+    {PIXELFORMAT_RGBA8_SRGB, 43, 1, 1, 4, PIXELFORMAT_COMPRESSION_NONE, true},
+    {PIXELFORMAT_BC1_RGBA_UNORM, 133, 4, 4, 8, PIXELFORMAT_COMPRESSION_BC,
+     false},
+    {PIXELFORMAT_BC1_RGBA_SRGB, 134, 4, 4, 8, PIXELFORMAT_COMPRESSION_BC, true},
+    {PIXELFORMAT_BC3_UNORM, 137, 4, 4, 16, PIXELFORMAT_COMPRESSION_BC, false},
+    {PIXELFORMAT_BC3_SRGB, 138, 4, 4, 16, PIXELFORMAT_COMPRESSION_BC, true},
+    {PIXELFORMAT_BC4_UNORM, 139, 4, 4, 8, PIXELFORMAT_COMPRESSION_BC, false},
+    {PIXELFORMAT_BC5_UNORM, 141, 4, 4, 16, PIXELFORMAT_COMPRESSION_BC, false},
+    {PIXELFORMAT_BC7_UNORM, 145, 4, 4, 16, PIXELFORMAT_COMPRESSION_BC, false},
+    {PIXELFORMAT_BC7_SRGB, 146, 4, 4, 16, PIXELFORMAT_COMPRESSION_BC, true},
+    {PIXELFORMAT_ETC2_RGB8_UNORM, 147, 4, 4, 8, PIXELFORMAT_COMPRESSION_ETC2,
+     false},
+    {PIXELFORMAT_ETC2_RGB8_SRGB, 148, 4, 4, 8, PIXELFORMAT_COMPRESSION_ETC2,
+     true},
+    {PIXELFORMAT_ETC2_RGBA8_UNORM, 151, 4, 4, 16,
+     PIXELFORMAT_COMPRESSION_ETC2, false},
+    {PIXELFORMAT_ETC2_RGBA8_SRGB, 152, 4, 4, 16, PIXELFORMAT_COMPRESSION_ETC2,
+     true},
+    {PIXELFORMAT_ASTC_4X4_UNORM, 157, 4, 4, 16, PIXELFORMAT_COMPRESSION_ASTC,
+     false},
+    {PIXELFORMAT_ASTC_4X4_SRGB, 158, 4, 4, 16, PIXELFORMAT_COMPRESSION_ASTC,
+     true}};
+#undef UNCOMPRESSED
+
+const PixelFormatUtil::FormatInfo *
+PixelFormatUtil::getFormatInfo(PixelFormat format) {
+  for (auto &formatInfo : formatInfos) {
+    if (formatInfo.format == format)
+      return &formatInfo;
+  }
+  return nullptr;
+}
+
+const PixelFormatUtil::FormatInfo *
+PixelFormatUtil::getFormatInfoFromVkFormat(uint32_t vkFormat) {
+  for (auto &formatInfo : formatInfos) {
+    if (formatInfo.vkFormat == vkFormat)
+      return &formatInfo;
+  }
+  return nullptr;
+}
+
+bool PixelFormatUtil::isCompressed(PixelFormat format) {
+  auto formatInfo = getFormatInfo(format);
+  return formatInfo &&
+         formatInfo->compression != PIXELFORMAT_COMPRESSION_NONE;
+}
+
+PixelFormat PixelFormatUtil::getDecodedFormat(PixelFormat format) {
+  auto formatInfo = getFormatInfo(format);
+  return (formatInfo && formatInfo->srgb) ? PIXELFORMAT_RGBA8_SRGB
+                                          : PIXELFORMAT_RGBA8_UNORM;
+}
+
+uint32_t PixelFormatUtil::getRowPitch(PixelFormat format, uint32_t w) {
+  auto formatInfo = getFormatInfo(format);
+  if (!formatInfo)
+    NGFX_ERR("unknown pixel format: %d", format);
+  uint32_t blocksX = (w + formatInfo->blockWidth - 1) / formatInfo->blockWidth;
+  return blocksX * formatInfo->blockSize;
+}
+
+uint32_t PixelFormatUtil::getImageSize(PixelFormat format, uint32_t w,
+                                       uint32_t h, uint32_t d,
+                                       uint32_t arrayLayers) {
+  auto formatInfo = getFormatInfo(format);
+  if (!formatInfo)
+    NGFX_ERR("unknown pixel format: %d", format);
+  uint64_t blocksX =
+      (uint64_t(w) + formatInfo->blockWidth - 1) / formatInfo->blockWidth;
+  uint64_t blocksY =
+      (uint64_t(h) + formatInfo->blockHeight - 1) / formatInfo->blockHeight;
+  // Check each product, the product of all the factors may not fit in 64 bits
+  uint64_t size = blocksX;
+  for (uint64_t factor : {uint64_t(formatInfo->blockSize), blocksY,
+                          uint64_t(d), uint64_t(arrayLayers)}) {
+    if (factor && size > UINT32_MAX / factor)
+      NGFX_ERR("image size is too large: %ux%ux%u, %u layers", w, h, d,
+               arrayLayers);
+    size *= factor;
+  }
+  return uint32_t(size);
+}
+
+uint32_t PixelFormatUtil::getLevelSize(PixelFormat format, uint32_t w,
+                                       uint32_t h, uint32_t d,
+                                       uint32_t arrayLayers, uint32_t level) {
+  if (level >= 32)
+    NGFX_ERR("invalid mip level: %u", level);
+  return getImageSize(format, std::max(w >> level, 1u),
+                      std::max(h >> level, 1u), std::max(d >> level, 1u),
+                      arrayLayers);
+}
+
+uint32_t PixelFormatUtil::getMaxMipLevels(uint32_t w, uint32_t h,
+                                          uint32_t d) {
+  uint32_t size = std::max({w, h, d}), numLevels = 1;
+  while (size >>= 1)
+    numLevels++;
+  return numLevels;
+}
@@ -20,8 +20,11 @@
  */
 #include "ngfx/graphics/ShaderModule.h"
 #include "ngfx/core/DebugUtil.h"
+#include <algorithm>
+#include <cstdint>
 #include <fstream>
 #include <map>
+#include <sstream>
 using namespace ngfx;
 using namespace std;
 
@@ -38,6 +41,15 @@ static const map<string, VertexFormatInfo> vertexFormatMap = {
     VF_ITEM(VERTEXFORMAT_FLOAT2, 1, 8),
     VF_ITEM(VERTEXFORMAT_FLOAT3, 1, 12),
     VF_ITEM(VERTEXFORMAT_FLOAT4, 1, 16),
+    VF_ITEM(VERTEXFORMAT_HALF2, 1, 4),
+    VF_ITEM(VERTEXFORMAT_HALF4, 1, 8),
+    VF_ITEM(VERTEXFORMAT_SHORT2_NORM, 1, 4),
+    VF_ITEM(VERTEXFORMAT_SHORT4_NORM, 1, 8),
+    VF_ITEM(VERTEXFORMAT_USHORT4_NORM, 1, 8),
+    VF_ITEM(VERTEXFORMAT_CHAR2_NORM, 1, 2),
+    VF_ITEM(VERTEXFORMAT_CHAR4_NORM, 1, 4),
+    VF_ITEM(VERTEXFORMAT_UINT1010102_NORM, 1, 4),
+    VF_ITEM(VERTEXFORMAT_UINT, 1, 4),
     {"VERTEXFORMAT_MAT4", {VERTEXFORMAT_FLOAT4, 4, 16}}};
 
 #define ITEM(s)                                                                \
@@ -79,9 +91,16 @@ static void parseDescriptors(ifstream &in,
   descs.resize(numDescriptors);
   for (uint32_t j = 0; j < uint32_t(numDescriptors); j++) {
     auto &desc = descs[j];
-    string descriptorTypeStr;
-    in >> desc.name >> descriptorTypeStr >> desc.set;
+    string line, descriptorTypeStr, flags;
+    while (line.empty() && getline(in, line)) {
+      if (line.find_first_not_of(" \t\r") == string::npos)
+        line.clear();
+    }
+    // The optional last column flags the bindless descriptors
+    istringstream lineStream(line);
+    lineStream >> desc.name >> descriptorTypeStr >> desc.set >> flags;
     desc.type = descriptorTypeMap.at(descriptorTypeStr);
+    desc.bindless = (flags == "BINDLESS");
   }
 }
 
@@ -124,6 +143,20 @@ void ShaderModule::initBindings(std::ifstream &in,
                    shaderStages);
   parseBufferInfos(in, "SHADER_STORAGE_BUFFER_INFOS", shaderStorageBufferInfos,
                    shaderStages);
+  parseBufferInfos(in, "PUSH_CONSTANT_INFOS", pushConstantInfos, shaderStages);
+  uint32_t begin = UINT32_MAX, end = 0;
+  for (auto &it : pushConstantInfos) {
+    for (auto &memberIt : it.second.memberInfos) {
+      auto &memberInfo = memberIt.second;
+      uint32_t size = memberInfo.arrayCount
+                          ? memberInfo.arrayCount * memberInfo.arrayStride
+                          : memberInfo.size;
+      begin = std::min(begin, memberInfo.offset);
+      end = std::max(end, memberInfo.offset + size);
+    }
+  }
+  if (end > begin)
+    pushConstantRange = {begin, end - begin};
 }
 
 void ShaderModule::initBindings(const std::string &filename,
@@ -143,3 +176,19 @@ void VertexShaderModule::initBindings(const std::string &filename) {
   ShaderModule::initBindings(in, SHADER_STAGE_VERTEX_BIT);
   in.close();
 }
+
+void VertexShaderModule::setAttributeFormat(const std::string &name,
+                                            VertexFormat format) {
+  auto attr = findAttribute(name);
+  if (!attr)
+    NGFX_ERR("cannot find attribute: %s", name.c_str());
+  for (auto &it : vertexFormatMap) {
+    auto &formatInfo = it.second;
+    if (formatInfo.format != format || formatInfo.count != 1)
+      continue;
+    attr->format = format;
+    attr->elementSize = formatInfo.elementSize;
+    return;
+  }
+  NGFX_ERR("unsupported vertex format: %d", int(format));
+}
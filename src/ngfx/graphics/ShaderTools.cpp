@@ -23,6 +23,7 @@
 #include "ngfx/core/DebugUtil.h"
 #include "ngfx/core/FileUtil.h"
 #include "ngfx/core/StringUtil.h"
+#include "ngfx/core/Trace.h"
 #include <cctype>
 #include <filesystem>
 #include <fstream>
@@ -122,6 +123,7 @@ int ShaderTools::compileShaderGLSL (
     const MacroDefinitions &defines, string &spv, bool verbose,
     shaderc_optimization_level optimizationLevel )
 {
+    NGFX_TRACE_SCOPE ( "ShaderTools::compileShaderGLSL" );
     shaderc::Compiler compiler;
     shaderc::CompileOptions compileOptions;
     for ( const MacroDefinition &define : defines ) {
@@ -218,6 +220,7 @@ int ShaderTools::compileShaderMSL ( const string &file,
                                     const MacroDefinitions &defines,
                                     string outDir, vector<string> &outFiles )
 {
+    NGFX_TRACE_SCOPE ( "ShaderTools::compileShaderMSL" );
     string strippedFilename =
         FileUtil::splitExt ( fs::path ( file ).filename().string() ) [0];
     string inFileName = fs::path ( outDir + "/" + strippedFilename + ".metal" )
@@ -249,6 +252,7 @@ int ShaderTools::compileShaderHLSL ( const string &file,
                                      const MacroDefinitions &defines,
                                      string outDir, vector<string> &outFiles )
 {
+    NGFX_TRACE_SCOPE ( "ShaderTools::compileShaderHLSL" );
     string strippedFilename =
         FileUtil::splitExt ( fs::path ( file ).filename().string() ) [0];
     string inFileName = fs::path ( outDir + "/" + strippedFilename + ".hlsl" )
@@ -551,7 +555,8 @@ string ShaderTools::parseReflectionData ( const json &reflectData, string ext )
             if ( input.find ( "semantic" ) != input.end() )
                 inputSemantic = input["semantic"];
             map<string, string> inputTypeMap = {
-                {"float", "VERTEXFORMAT_FLOAT"}, {"vec2", "VERTEXFORMAT_FLOAT2"},
+                {"float", "VERTEXFORMAT_FLOAT"}, {"uint", "VERTEXFORMAT_UINT"},
+                {"vec2", "VERTEXFORMAT_FLOAT2"},
                 {"vec3", "VERTEXFORMAT_FLOAT3"}, {"vec4", "VERTEXFORMAT_FLOAT4"},
                 {"ivec2", "VERTEXFORMAT_INT2"},  {"ivec3", "VERTEXFORMAT_INT3"},
                 {"ivec4", "VERTEXFORMAT_INT4"},  {"mat2", "VERTEXFORMAT_MAT2"},
@@ -623,6 +628,11 @@ string ShaderTools::parseReflectionData ( const json &reflectData, string ext )
     if ( ssbos )
         parseBuffers ( *ssbos, shaderStorageBufferInfos );
 
+    // Unsized descriptor arrays are bound to the bindless descriptor heap
+    auto isUnsizedArray = [] ( const json &desc ) -> bool {
+        auto array = desc.find ( "array" );
+        return array != desc.end() && ( *array ) [0].get<int>() == 0;
+    };
     json textureDescriptors = {};
     json bufferDescriptors = {};
     if ( textures )
@@ -631,7 +641,8 @@ string ShaderTools::parseReflectionData ( const json &reflectData, string ext )
                 {"type", texture["type"]},
                 {"name", texture["name"]},
                 {"set", texture["set"]},
-                {"binding", texture["binding"]}
+                {"binding", texture["binding"]},
+                {"bindless", isUnsizedArray ( texture )}
             };
         }
     if ( images )
@@ -640,7 +651,8 @@ string ShaderTools::parseReflectionData ( const json &reflectData, string ext )
                 {"type", image["type"]},
                 {"name", image["name"]},
                 {"set", image["set"]},
-                {"binding", image["binding"]}
+                {"binding", image["binding"]},
+                {"bindless", isUnsizedArray ( image )}
             };
         }
     if ( ubos )
@@ -658,7 +670,8 @@ string ShaderTools::parseReflectionData ( const json &reflectData, string ext )
                 {"type", "shaderStorageBuffer"},
                 {"name", ssbo["name"]},
                 {"set", ssbo["set"]},
-                {"binding", ssbo["binding"]}
+                {"binding", ssbo["binding"]},
+                {"bindless", isUnsizedArray ( ssbo )}
             };
         }
     contents += "DESCRIPTORS " +
@@ -669,18 +682,23 @@ string ShaderTools::parseReflectionData ( const json &reflectData, string ext )
         {"sampler3D", "DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER"},
         {"samplerCube", "DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER"},
         {"image2D", "DESCRIPTOR_TYPE_STORAGE_IMAGE"},
+        {"image2DArray", "DESCRIPTOR_TYPE_STORAGE_IMAGE"},
         {"uniformBuffer", "DESCRIPTOR_TYPE_UNIFORM_BUFFER"},
         {"shaderStorageBuffer", "DESCRIPTOR_TYPE_STORAGE_BUFFER"}
     };
+    auto bindlessFlag = [] ( const json &val ) -> string {
+        auto bindless = val.find ( "bindless" );
+        return ( bindless != val.end() && bindless->get<bool>() ) ? " BINDLESS" : "";
+    };
     for ( auto &[key, val] : textureDescriptors.items() ) {
         string descriptorType = descriptorTypeMap[val["type"]];
         contents += "\t" + val["name"].get<string>() + " " + descriptorType + " " +
-                    to_string ( val["set"].get<int>() ) + "\n";
+                    to_string ( val["set"].get<int>() ) + bindlessFlag ( val ) + "\n";
     }
     for ( auto &[key, val] : bufferDescriptors.items() ) {
         string descriptorType = descriptorTypeMap[val["type"]];
         contents += "\t" + val["name"].get<string>() + " " + descriptorType + " " +
-                    to_string ( val["set"].get<int>() ) + "\n";
+                    to_string ( val["set"].get<int>() ) + bindlessFlag ( val ) + "\n";
     }
     auto processBufferInfos = [&] ( const json &bufferInfo ) -> string {
         string contents = "";
@@ -709,6 +727,27 @@ string ShaderTools::parseReflectionData ( const json &reflectData, string ext )
     for ( const json &bufferInfo : shaderStorageBufferInfos ) {
         contents += processBufferInfos ( bufferInfo );
     }
+
+    // Push constant blocks don't have a descriptor set
+    json *pushConstants = getEntry ( reflectData, "push_constants" );
+    json pushConstantInfos;
+    if ( pushConstants )
+        for ( const json &pushConstant : *pushConstants ) {
+            const json &blockType =
+                ( *types ) [pushConstant["type"].get<string>()];
+            json blockMembers = {};
+            parseMembers ( blockType["members"], blockMembers, 0, "" );
+            pushConstantInfos.push_back ( {
+                {"name", pushConstant["name"].get<string>() },
+                {"set", 0},
+                {"members", blockMembers}
+            } );
+        }
+    contents += "PUSH_CONSTANT_INFOS " +
+                to_string ( pushConstantInfos.size() ) + "\n";
+    for ( const json &bufferInfo : pushConstantInfos ) {
+        contents += processBufferInfos ( bufferInfo );
+    }
     return contents;
 }
 
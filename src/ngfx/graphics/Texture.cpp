@@ -19,16 +19,36 @@
  * under the License.
  */
 #include "ngfx/graphics/Texture.h"
+#include "ngfx/core/StringUtil.h"
+#include "ngfx/graphics/KTXFile.h"
+#include "ngfx/graphics/PixelFormatUtil.h"
 #define STB_IMAGE_IMPLEMENTATION
+#include <filesystem>
 #include <memory>
 #include <stb_image.h>
 using namespace ngfx;
+namespace fs = std::filesystem;
 
 Texture *Texture::create(GraphicsContext *ctx, Graphics *graphics,
                          const char *filename, ImageUsageFlags imageUsageFlags,
                          TextureType textureType, bool genMipmaps,
                          FilterMode minFilter, FilterMode magFilter,
                          FilterMode mipFilter, uint32_t numSamples) {
+  if (StringUtil::toLower(fs::path(filename).extension().string()) ==
+      ".ktx2") {
+    KTXFile ktxFile;
+    ktxFile.load(filename);
+    if (!isFormatSupported(ctx, ktxFile.format))
+      ktxFile.decode();
+    // The compressed levels can't be generated by the device
+    genMipmaps = genMipmaps && ktxFile.mipLevels == 1 &&
+                 !PixelFormatUtil::isCompressed(ktxFile.format);
+    return create(ctx, graphics, ktxFile.data.data(), ktxFile.format,
+                  uint32_t(ktxFile.data.size()), ktxFile.w, ktxFile.h,
+                  ktxFile.d, ktxFile.arrayLayers * ktxFile.numFaces,
+                  imageUsageFlags, textureType, genMipmaps, minFilter,
+                  magFilter, mipFilter, numSamples, ktxFile.mipLevels);
+  }
   int w, h, channels;
   std::unique_ptr<stbi_uc> data(stbi_load(filename, &w, &h, &channels, 4));
   assert(data);
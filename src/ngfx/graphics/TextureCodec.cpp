@@ -0,0 +1,706 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "ngfx/graphics/TextureCodec.h"
+#include "ngfx/core/DebugUtil.h"
+#include "ngfx/core/ParallelUtil.h"
+#include "ngfx/graphics/PixelFormatUtil.h"
+#include <algorithm>
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <cstring>
+using namespace ngfx;
+
+// The blocks are decoded to (and encoded from) 4x4 RGBA8 texels,
+// stored row by row
+static inline int clamp255(int v) { return std::min(std::max(v, 0), 255); }
+
+static int getColorError(const uint8_t *c0, const uint8_t *c1) {
+  int error = 0;
+  for (uint32_t k = 0; k < 3; k++) {
+    int diff = int(c0[k]) - int(c1[k]);
+    error += diff * diff;
+  }
+  return error;
+}
+
+// BC1 color block: two RGB565 endpoints and 2-bit indices.
+// The BC1 blocks with c0 <= c1 have 3 colors and a transparent black,
+// the color blocks of BC3 always have 4 colors
+static void unpack565(uint16_t c, uint8_t *rgb) {
+  int r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+  rgb[0] = uint8_t((r << 3) | (r >> 2));
+  rgb[1] = uint8_t((g << 2) | (g >> 4));
+  rgb[2] = uint8_t((b << 3) | (b >> 2));
+}
+
+static uint16_t pack565(const float *rgb) {
+  auto quantize = [](float v, int maxValue) {
+    return std::min(std::max(int(v * maxValue / 255.0f + 0.5f), 0), maxValue);
+  };
+  return uint16_t((quantize(rgb[0], 31) << 11) | (quantize(rgb[1], 63) << 5) |
+                  quantize(rgb[2], 31));
+}
+
+static void getBC1Palette(uint16_t c0, uint16_t c1, bool fourColors,
+                          uint8_t *palette) {
+  unpack565(c0, &palette[0]);
+  unpack565(c1, &palette[4]);
+  palette[3] = palette[7] = palette[11] = 255;
+  if (fourColors || c0 > c1) {
+    for (uint32_t k = 0; k < 3; k++) {
+      palette[8 + k] = uint8_t((2 * palette[k] + palette[4 + k] + 1) / 3);
+      palette[12 + k] = uint8_t((palette[k] + 2 * palette[4 + k] + 1) / 3);
+    }
+    palette[15] = 255;
+  } else {
+    for (uint32_t k = 0; k < 3; k++)
+      palette[8 + k] = uint8_t((palette[k] + palette[4 + k] + 1) / 2);
+    memset(&palette[12], 0, 4);
+  }
+}
+
+static void decodeBC1Block(const uint8_t *block, uint8_t *texels,
+                           bool fourColors) {
+  uint16_t c0 = uint16_t(block[0] | (block[1] << 8)),
+           c1 = uint16_t(block[2] | (block[3] << 8));
+  uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) |
+                     (uint32_t(block[7]) << 24);
+  uint8_t palette[16];
+  getBC1Palette(c0, c1, fourColors, palette);
+  for (uint32_t j = 0; j < 16; j++)
+    memcpy(&texels[j * 4], &palette[((indices >> (2 * j)) & 3) * 4], 4);
+}
+
+static void encodeBC1Block(const uint8_t *texels, uint8_t *block,
+                           bool fourColors) {
+  // The texels with alpha < 128 are encoded as transparent,
+  // with the 3 color mode
+  bool transparent = false;
+  float mean[3] = {0.0f, 0.0f, 0.0f};
+  uint32_t numOpaqueTexels = 0;
+  auto isTransparent = [&](uint32_t j) {
+    return !fourColors && texels[j * 4 + 3] < 128;
+  };
+  for (uint32_t j = 0; j < 16; j++) {
+    if (isTransparent(j)) {
+      transparent = true;
+      continue;
+    }
+    for (uint32_t k = 0; k < 3; k++)
+      mean[k] += texels[j * 4 + k];
+    numOpaqueTexels++;
+  }
+  if (numOpaqueTexels == 0) {
+    memset(block, 0, 4);
+    memset(&block[4], 0xFF, 4);
+    return;
+  }
+  for (uint32_t k = 0; k < 3; k++)
+    mean[k] /= numOpaqueTexels;
+
+  // The endpoints are the extremes of the texels projected on the
+  // principal axis, found by power iteration
+  float covariance[3][3] = {};
+  for (uint32_t j = 0; j < 16; j++) {
+    if (isTransparent(j))
+      continue;
+    float d[3];
+    for (uint32_t k = 0; k < 3; k++)
+      d[k] = texels[j * 4 + k] - mean[k];
+    for (uint32_t k0 = 0; k0 < 3; k0++)
+      for (uint32_t k1 = 0; k1 < 3; k1++)
+        covariance[k0][k1] += d[k0] * d[k1];
+  }
+  float axis[3] = {1.0f, 1.0f, 1.0f};
+  for (uint32_t iteration = 0; iteration < 8; iteration++) {
+    float v[3];
+    for (uint32_t k = 0; k < 3; k++)
+      v[k] = covariance[k][0] * axis[0] + covariance[k][1] * axis[1] +
+             covariance[k][2] * axis[2];
+    float norm = std::max({fabsf(v[0]), fabsf(v[1]), fabsf(v[2])});
+    if (norm < 1e-6f) {
+      axis[0] = axis[1] = axis[2] = 0.0f;
+      break;
+    }
+    for (uint32_t k = 0; k < 3; k++)
+      axis[k] = v[k] / norm;
+  }
+  float axisLengthSq =
+      axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+  float tMin = 0.0f, tMax = 0.0f;
+  if (axisLengthSq > 0.0f) {
+    tMin = FLT_MAX;
+    tMax = -FLT_MAX;
+    for (uint32_t j = 0; j < 16; j++) {
+      if (isTransparent(j))
+        continue;
+      float t = 0.0f;
+      for (uint32_t k = 0; k < 3; k++)
+        t += (texels[j * 4 + k] - mean[k]) * axis[k];
+      t /= axisLengthSq;
+      tMin = std::min(tMin, t);
+      tMax = std::max(tMax, t);
+    }
+  }
+  float e0[3], e1[3];
+  for (uint32_t k = 0; k < 3; k++) {
+    e0[k] = mean[k] + axis[k] * tMax;
+    e1[k] = mean[k] + axis[k] * tMin;
+  }
+  uint16_t c0 = pack565(e0), c1 = pack565(e1);
+  // The 4 color mode requires c0 > c1, the 3 color mode c0 <= c1
+  if ((transparent && c0 > c1) || (!transparent && c0 < c1))
+    std::swap(c0, c1);
+  bool paletteFourColors = fourColors || c0 > c1;
+  uint8_t palette[16];
+  getBC1Palette(c0, c1, fourColors, palette);
+  uint32_t indices = 0;
+  for (uint32_t j = 0; j < 16; j++) {
+    uint32_t index = 3;
+    if (!isTransparent(j)) {
+      int minError = INT_MAX;
+      for (uint32_t i = 0; i < (paletteFourColors ? 4u : 3u); i++) {
+        int error = getColorError(&texels[j * 4], &palette[i * 4]);
+        if (error < minError) {
+          minError = error;
+          index = i;
+        }
+      }
+    }
+    indices |= index << (2 * j);
+  }
+  block[0] = uint8_t(c0);
+  block[1] = uint8_t(c0 >> 8);
+  block[2] = uint8_t(c1);
+  block[3] = uint8_t(c1 >> 8);
+  for (uint32_t j = 0; j < 4; j++)
+    block[4 + j] = uint8_t(indices >> (8 * j));
+}
+
+// BC4 channel block: two 8-bit endpoints and 3-bit indices.
+// It's also the alpha block of BC3, and each half of a BC5 block
+static void getBC4Palette(uint8_t r0, uint8_t r1, uint8_t *palette) {
+  palette[0] = r0;
+  palette[1] = r1;
+  if (r0 > r1) {
+    for (uint32_t j = 1; j < 7; j++)
+      palette[j + 1] = uint8_t(((7 - j) * r0 + j * r1 + 3) / 7);
+  } else {
+    for (uint32_t j = 1; j < 5; j++)
+      palette[j + 1] = uint8_t(((5 - j) * r0 + j * r1 + 2) / 5);
+    palette[6] = 0;
+    palette[7] = 255;
+  }
+}
+
+static void decodeBC4Block(const uint8_t *block, uint8_t *texels,
+                           uint32_t channel) {
+  uint8_t palette[8];
+  getBC4Palette(block[0], block[1], palette);
+  uint64_t indices = 0;
+  for (uint32_t j = 0; j < 6; j++)
+    indices |= uint64_t(block[2 + j]) << (8 * j);
+  for (uint32_t j = 0; j < 16; j++)
+    texels[j * 4 + channel] = palette[(indices >> (3 * j)) & 7];
+}
+
+static void encodeBC4Block(const uint8_t *texels, uint8_t *block,
+                           uint32_t channel) {
+  uint8_t r0 = 0, r1 = 255;
+  for (uint32_t j = 0; j < 16; j++) {
+    r0 = std::max(r0, texels[j * 4 + channel]);
+    r1 = std::min(r1, texels[j * 4 + channel]);
+  }
+  uint8_t palette[8];
+  getBC4Palette(r0, r1, palette);
+  uint64_t indices = 0;
+  for (uint32_t j = 0; j < 16; j++) {
+    uint32_t index = 0;
+    int minError = INT_MAX;
+    for (uint32_t i = 0; i < 8; i++) {
+      int error = abs(int(texels[j * 4 + channel]) - int(palette[i]));
+      if (error < minError) {
+        minError = error;
+        index = i;
+      }
+    }
+    indices |= uint64_t(index) << (3 * j);
+  }
+  block[0] = r0;
+  block[1] = r1;
+  for (uint32_t j = 0; j < 6; j++)
+    block[2 + j] = uint8_t(indices >> (8 * j));
+}
+
+// ETC2 color block: a 64-bit big endian word.
+// The texel (x, y) is the bit x * 4 + y of the index planes
+static const int etc1Modifiers[8][2] = {{2, 8},   {5, 17},  {9, 29},
+                                        {13, 42}, {18, 60}, {24, 80},
+                                        {33, 106}, {47, 183}};
+static const int etc2Distances[8] = {3, 6, 11, 16, 23, 32, 41, 64};
+static const int eacModifiers[16][8] = {
+    {-3, -6, -9, -15, 2, 5, 8, 14},  {-3, -7, -10, -13, 2, 6, 9, 12},
+    {-2, -5, -8, -13, 1, 4, 7, 12},  {-2, -4, -6, -13, 1, 3, 5, 12},
+    {-3, -6, -8, -12, 2, 5, 7, 11},  {-3, -7, -9, -11, 2, 6, 8, 10},
+    {-4, -7, -8, -11, 3, 6, 7, 10},  {-3, -5, -8, -11, 2, 4, 7, 10},
+    {-2, -6, -8, -10, 1, 5, 7, 9},   {-2, -5, -8, -10, 1, 4, 7, 9},
+    {-2, -4, -8, -10, 1, 3, 7, 9},   {-2, -5, -7, -10, 1, 4, 6, 9},
+    {-3, -4, -7, -10, 2, 3, 6, 9},   {-1, -2, -3, -10, 0, 1, 2, 9},
+    {-4, -6, -8, -9, 3, 5, 7, 8},    {-3, -5, -7, -9, 2, 4, 6, 8}};
+
+static uint64_t readBigEndian64(const uint8_t *p) {
+  uint64_t v = 0;
+  for (uint32_t j = 0; j < 8; j++)
+    v = (v << 8) | p[j];
+  return v;
+}
+
+static void writeBigEndian64(uint64_t v, uint8_t *p) {
+  for (uint32_t j = 0; j < 8; j++)
+    p[j] = uint8_t(v >> (56 - 8 * j));
+}
+
+static inline int getBits(uint64_t v, uint32_t hi, uint32_t lo) {
+  return int((v >> lo) & ((uint64_t(1) << (hi - lo + 1)) - 1));
+}
+
+static inline int extend4(int v) { return (v << 4) | v; }
+static inline int extend5(int v) { return (v << 3) | (v >> 2); }
+static inline int extend6(int v) { return (v << 2) | (v >> 4); }
+static inline int extend7(int v) { return (v << 1) | (v >> 6); }
+
+static void decodeETC2Block(const uint8_t *block, uint8_t *texels) {
+  uint64_t v = readBigEndian64(block);
+  auto getIndex = [v](uint32_t x, uint32_t y) {
+    uint32_t i = x * 4 + y;
+    return int((((v >> (16 + i)) & 1) << 1) | ((v >> i) & 1));
+  };
+  auto setTexel = [texels](uint32_t x, uint32_t y, const int *rgb) {
+    uint8_t *texel = &texels[(y * 4 + x) * 4];
+    for (uint32_t k = 0; k < 3; k++)
+      texel[k] = uint8_t(clamp255(rgb[k]));
+    texel[3] = 255;
+  };
+  int base[2][3];
+  bool diff = (v >> 33) & 1;
+  if (diff) {
+    int c[3] = {getBits(v, 63, 59), getBits(v, 55, 51), getBits(v, 47, 43)};
+    int d[3] = {getBits(v, 58, 56), getBits(v, 50, 48), getBits(v, 42, 40)};
+    for (uint32_t k = 0; k < 3; k++)
+      d[k] = (d[k] >= 4) ? d[k] - 8 : d[k];
+    // The overflow of a differential color selects the ETC2 modes:
+    // T for red, H for green and planar for blue
+    if (c[0] + d[0] < 0 || c[0] + d[0] > 31) {
+      int c0[3] = {extend4((getBits(v, 60, 59) << 2) | getBits(v, 57, 56)),
+                   extend4(getBits(v, 55, 52)), extend4(getBits(v, 51, 48))};
+      int c1[3] = {extend4(getBits(v, 47, 44)), extend4(getBits(v, 43, 40)),
+                   extend4(getBits(v, 39, 36))};
+      int distance =
+          etc2Distances[(getBits(v, 35, 34) << 1) | getBits(v, 32, 32)];
+      int paint[4][3];
+      for (uint32_t k = 0; k < 3; k++) {
+        paint[0][k] = c0[k];
+        paint[1][k] = clamp255(c1[k] + distance);
+        paint[2][k] = c1[k];
+        paint[3][k] = clamp255(c1[k] - distance);
+      }
+      for (uint32_t y = 0; y < 4; y++)
+        for (uint32_t x = 0; x < 4; x++)
+          setTexel(x, y, paint[getIndex(x, y)]);
+      return;
+    }
+    if (c[1] + d[1] < 0 || c[1] + d[1] > 31) {
+      int c0[3] = {getBits(v, 62, 59),
+                   (getBits(v, 58, 56) << 1) | getBits(v, 52, 52),
+                   (getBits(v, 51, 51) << 3) | getBits(v, 49, 47)};
+      int c1[3] = {getBits(v, 46, 43), getBits(v, 42, 39), getBits(v, 38, 35)};
+      int order = ((c0[0] << 8) | (c0[1] << 4) | c0[2]) >=
+                  ((c1[0] << 8) | (c1[1] << 4) | c1[2]);
+      int distance = etc2Distances[(getBits(v, 34, 34) << 2) |
+                                   (getBits(v, 32, 32) << 1) | order];
+      int paint[4][3];
+      for (uint32_t k = 0; k < 3; k++) {
+        paint[0][k] = clamp255(extend4(c0[k]) + distance);
+        paint[1][k] = clamp255(extend4(c0[k]) - distance);
+        paint[2][k] = clamp255(extend4(c1[k]) + distance);
+        paint[3][k] = clamp255(extend4(c1[k]) - distance);
+      }
+      for (uint32_t y = 0; y < 4; y++)
+        for (uint32_t x = 0; x < 4; x++)
+          setTexel(x, y, paint[getIndex(x, y)]);
+      return;
+    }
+    if (c[2] + d[2] < 0 || c[2] + d[2] > 31) {
+      int o[3] = {extend6(getBits(v, 62, 57)),
+                  extend7((getBits(v, 56, 56) << 6) | getBits(v, 54, 49)),
+                  extend6((getBits(v, 48, 48) << 5) |
+                          (getBits(v, 44, 43) << 3) | getBits(v, 41, 39))};
+      int h[3] = {extend6((getBits(v, 38, 34) << 1) | getBits(v, 32, 32)),
+                  extend7(getBits(v, 31, 25)), extend6(getBits(v, 24, 19))};
+      int vv[3] = {extend6(getBits(v, 18, 13)), extend7(getBits(v, 12, 6)),
+                   extend6(getBits(v, 5, 0))};
+      for (uint32_t y = 0; y < 4; y++) {
+        for (uint32_t x = 0; x < 4; x++) {
+          int rgb[3];
+          for (uint32_t k = 0; k < 3; k++)
+            rgb[k] = (int(x) * (h[k] - o[k]) + int(y) * (vv[k] - o[k]) +
+                      4 * o[k] + 2) >> 2;
+          setTexel(x, y, rgb);
+        }
+      }
+      return;
+    }
+    for (uint32_t k = 0; k < 3; k++) {
+      base[0][k] = extend5(c[k]);
+      base[1][k] = extend5(c[k] + d[k]);
+    }
+  } else {
+    for (uint32_t k = 0; k < 3; k++) {
+      base[0][k] = extend4(getBits(v, 63 - 8 * k, 60 - 8 * k));
+      base[1][k] = extend4(getBits(v, 59 - 8 * k, 56 - 8 * k));
+    }
+  }
+  int tables[2] = {getBits(v, 39, 37), getBits(v, 36, 34)};
+  bool flip = (v >> 32) & 1;
+  for (uint32_t y = 0; y < 4; y++) {
+    for (uint32_t x = 0; x < 4; x++) {
+      uint32_t subblock = flip ? (y >= 2) : (x >= 2);
+      int index = getIndex(x, y);
+      int modifier = etc1Modifiers[tables[subblock]][index & 1];
+      if (index & 2)
+        modifier = -modifier;
+      int rgb[3];
+      for (uint32_t k = 0; k < 3; k++)
+        rgb[k] = base[subblock][k] + modifier;
+      setTexel(x, y, rgb);
+    }
+  }
+}
+
+// Get the best table and indices of an ETC1 subblock
+static int encodeETC1Subblock(const uint8_t *texels, const int *base,
+                              bool flip, uint32_t subblock, int &table,
+                              uint32_t *indices) {
+  int minTableError = INT_MAX;
+  for (int t = 0; t < 8; t++) {
+    int tableError = 0;
+    uint32_t tableIndices[16];
+    for (uint32_t y = 0; y < 4; y++) {
+      for (uint32_t x = 0; x < 4; x++) {
+        if ((flip ? (y >= 2) : (x >= 2)) != subblock)
+          continue;
+        const uint8_t *texel = &texels[(y * 4 + x) * 4];
+        int minError = INT_MAX;
+        for (uint32_t index = 0; index < 4; index++) {
+          int modifier = etc1Modifiers[t][index & 1];
+          if (index & 2)
+            modifier = -modifier;
+          uint8_t color[3];
+          for (uint32_t k = 0; k < 3; k++)
+            color[k] = uint8_t(clamp255(base[k] + modifier));
+          int error = getColorError(texel, color);
+          if (error < minError) {
+            minError = error;
+            tableIndices[x * 4 + y] = index;
+          }
+        }
+        tableError += minError;
+      }
+    }
+    if (tableError < minTableError) {
+      minTableError = tableError;
+      table = t;
+      for (uint32_t y = 0; y < 4; y++)
+        for (uint32_t x = 0; x < 4; x++)
+          if ((flip ? (y >= 2) : (x >= 2)) == subblock)
+            indices[x * 4 + y] = tableIndices[x * 4 + y];
+    }
+  }
+  return minTableError;
+}
+
+// Only the ETC1 compatible modes are encoded: individual and differential
+static void encodeETC2Block(const uint8_t *texels, uint8_t *block) {
+  int minError = INT_MAX;
+  uint64_t bestBlock = 0;
+  for (uint32_t flip = 0; flip < 2; flip++) {
+    float mean[2][3] = {};
+    for (uint32_t y = 0; y < 4; y++)
+      for (uint32_t x = 0; x < 4; x++)
+        for (uint32_t k = 0; k < 3; k++)
+          mean[flip ? (y >= 2) : (x >= 2)][k] +=
+              texels[(y * 4 + x) * 4 + k] / 8.0f;
+    for (uint32_t differential = 0; differential < 2; differential++) {
+      int c[2][3], base[2][3];
+      int maxValue = differential ? 31 : 15;
+      for (uint32_t j = 0; j < 2; j++)
+        for (uint32_t k = 0; k < 3; k++) {
+          c[j][k] = std::min(int(mean[j][k] * maxValue / 255.0f + 0.5f),
+                             maxValue);
+          base[j][k] = differential ? extend5(c[j][k]) : extend4(c[j][k]);
+        }
+      if (differential) {
+        bool valid = true;
+        for (uint32_t k = 0; k < 3; k++) {
+          int d = c[1][k] - c[0][k];
+          valid = valid && d >= -4 && d <= 3;
+        }
+        if (!valid)
+          continue;
+      }
+      int tables[2];
+      uint32_t indices[16];
+      int error = encodeETC1Subblock(texels, base[0], flip, 0, tables[0],
+                                     indices) +
+                  encodeETC1Subblock(texels, base[1], flip, 1, tables[1],
+                                     indices);
+      if (error >= minError)
+        continue;
+      minError = error;
+      uint64_t v = 0;
+      for (uint32_t k = 0; k < 3; k++) {
+        if (differential)
+          v |= (uint64_t(c[0][k]) << (59 - 8 * k)) |
+               (uint64_t((c[1][k] - c[0][k]) & 7) << (56 - 8 * k));
+        else
+          v |= (uint64_t(c[0][k]) << (60 - 8 * k)) |
+               (uint64_t(c[1][k]) << (56 - 8 * k));
+      }
+      v |= (uint64_t(tables[0]) << 37) | (uint64_t(tables[1]) << 34) |
+           (uint64_t(differential) << 33) | (uint64_t(flip) << 32);
+      for (uint32_t i = 0; i < 16; i++)
+        v |= (uint64_t(indices[i] >> 1) << (16 + i)) |
+             (uint64_t(indices[i] & 1) << i);
+      bestBlock = v;
+    }
+  }
+  writeBigEndian64(bestBlock, block);
+}
+
+// EAC alpha block: base, multiplier, table and 3-bit indices,
+// in a 64-bit big endian word
+static void decodeEACBlock(const uint8_t *block, uint8_t *texels) {
+  uint64_t v = readBigEndian64(block);
+  int base = getBits(v, 63, 56), multiplier = getBits(v, 55, 52);
+  const int *modifiers = eacModifiers[getBits(v, 51, 48)];
+  for (uint32_t i = 0; i < 16; i++) {
+    int index = getBits(v, 47 - 3 * i, 45 - 3 * i);
+    uint32_t x = i / 4, y = i % 4;
+    texels[(y * 4 + x) * 4 + 3] =
+        uint8_t(clamp255(base + modifiers[index] * multiplier));
+  }
+}
+
+static void encodeEACBlock(const uint8_t *texels, uint8_t *block) {
+  int minAlpha = 255, maxAlpha = 0;
+  for (uint32_t j = 0; j < 16; j++) {
+    minAlpha = std::min(minAlpha, int(texels[j * 4 + 3]));
+    maxAlpha = std::max(maxAlpha, int(texels[j * 4 + 3]));
+  }
+  // For each table, fit the modifier range to the alpha range,
+  // and try the neighbouring bases and multipliers
+  int minError = INT_MAX;
+  uint64_t bestBlock = 0;
+  for (int table = 0; table < 16; table++) {
+    const int *modifiers = eacModifiers[table];
+    int range = modifiers[7] - modifiers[3];
+    int fitMultiplier = std::min(
+        std::max((maxAlpha - minAlpha + range / 2) / range, 1), 15);
+    for (int multiplier = std::max(fitMultiplier - 1, 1);
+         multiplier <= std::min(fitMultiplier + 1, 15); multiplier++) {
+      int fitBase = clamp255(minAlpha - modifiers[3] * multiplier);
+      for (int base = std::max(fitBase - 1, 0);
+           base <= std::min(fitBase + 1, 255); base++) {
+        int error = 0;
+        uint64_t v = (uint64_t(base) << 56) | (uint64_t(multiplier) << 52) |
+                     (uint64_t(table) << 48);
+        for (uint32_t i = 0; i < 16; i++) {
+          int alpha = texels[((i % 4) * 4 + i / 4) * 4 + 3];
+          int minTexelError = INT_MAX, bestIndex = 0;
+          for (int index = 0; index < 8; index++) {
+            int diff = clamp255(base + modifiers[index] * multiplier) - alpha;
+            if (diff * diff < minTexelError) {
+              minTexelError = diff * diff;
+              bestIndex = index;
+            }
+          }
+          error += minTexelError;
+          v |= uint64_t(bestIndex) << (45 - 3 * i);
+        }
+        if (error < minError) {
+          minError = error;
+          bestBlock = v;
+        }
+      }
+    }
+  }
+  writeBigEndian64(bestBlock, block);
+}
+
+namespace {
+struct Codec {
+  PixelFormat format;
+  void (*decodeBlock)(const uint8_t *block, uint8_t *texels);
+  void (*encodeBlock)(const uint8_t *texels, uint8_t *block);
+};
+} // namespace
+
+static const Codec codecs[] = {
+    {PIXELFORMAT_BC1_RGBA_UNORM,
+     [](const uint8_t *block, uint8_t *texels) {
+       decodeBC1Block(block, texels, false);
+     },
+     [](const uint8_t *texels, uint8_t *block) {
+       encodeBC1Block(texels, block, false);
+     }},
+    {PIXELFORMAT_BC1_RGBA_SRGB,
+     [](const uint8_t *block, uint8_t *texels) {
+       decodeBC1Block(block, texels, false);
+     },
+     [](const uint8_t *texels, uint8_t *block) {
+       encodeBC1Block(texels, block, false);
+     }},
+    {PIXELFORMAT_BC3_UNORM,
+     [](const uint8_t *block, uint8_t *texels) {
+       decodeBC1Block(&block[8], texels, true);
+       decodeBC4Block(block, texels, 3);
+     },
+     [](const uint8_t *texels, uint8_t *block) {
+       encodeBC4Block(texels, block, 3);
+       encodeBC1Block(texels, &block[8], true);
+     }},
+    {PIXELFORMAT_BC3_SRGB,
+     [](const uint8_t *block, uint8_t *texels) {
+       decodeBC1Block(&block[8], texels, true);
+       decodeBC4Block(block, texels, 3);
+     },
+     [](const uint8_t *texels, uint8_t *block) {
+       encodeBC4Block(texels, block, 3);
+       encodeBC1Block(texels, &block[8], true);
+     }},
+    {PIXELFORMAT_BC4_UNORM,
+     [](const uint8_t *block, uint8_t *texels) {
+       decodeBC4Block(block, texels, 0);
+     },
+     [](const uint8_t *texels, uint8_t *block) {
+       encodeBC4Block(texels, block, 0);
+     }},
+    {PIXELFORMAT_BC5_UNORM,
+     [](const uint8_t *block, uint8_t *texels) {
+       decodeBC4Block(block, texels, 0);
+       decodeBC4Block(&block[8], texels, 1);
+     },
+     [](const uint8_t *texels, uint8_t *block) {
+       encodeBC4Block(texels, block, 0);
+       encodeBC4Block(texels, &block[8], 1);
+     }},
+    {PIXELFORMAT_ETC2_RGB8_UNORM, decodeETC2Block, encodeETC2Block},
+    {PIXELFORMAT_ETC2_RGB8_SRGB, decodeETC2Block, encodeETC2Block},
+    {PIXELFORMAT_ETC2_RGBA8_UNORM,
+     [](const uint8_t *block, uint8_t *texels) {
+       decodeETC2Block(&block[8], texels);
+       decodeEACBlock(block, texels);
+     },
+     [](const uint8_t *texels, uint8_t *block) {
+       encodeEACBlock(texels, block);
+       encodeETC2Block(texels, &block[8]);
+     }},
+    {PIXELFORMAT_ETC2_RGBA8_SRGB,
+     [](const uint8_t *block, uint8_t *texels) {
+       decodeETC2Block(&block[8], texels);
+       decodeEACBlock(block, texels);
+     },
+     [](const uint8_t *texels, uint8_t *block) {
+       encodeEACBlock(texels, block);
+       encodeETC2Block(texels, &block[8]);
+     }}};
+
+static const Codec *getCodec(PixelFormat format) {
+  for (auto &codec : codecs) {
+    if (codec.format == format)
+      return &codec;
+  }
+  return nullptr;
+}
+
+bool TextureCodec::isSupported(PixelFormat format) {
+  return getCodec(format) != nullptr;
+}
+
+void TextureCodec::decode(PixelFormat format, const uint8_t *data, uint32_t w,
+                          uint32_t h, uint8_t *rgba, uint32_t numThreads) {
+  auto codec = getCodec(format);
+  if (!codec)
+    NGFX_ERR("unsupported format: %d", format);
+  uint32_t blockSize = PixelFormatUtil::getFormatInfo(format)->blockSize;
+  uint32_t blocksX = (w + 3) / 4, blocksY = (h + 3) / 4;
+  numThreads = ParallelUtil::getNumThreads(numThreads, blocksY, 16);
+  ParallelUtil::parallelFor(
+      numThreads, blocksY, [&](uint32_t, size_t begin, size_t end) {
+        for (uint32_t by = uint32_t(begin); by < end; by++) {
+          for (uint32_t bx = 0; bx < blocksX; bx++) {
+            // The channels that the format doesn't store are 0,
+            // and alpha is 255
+            uint8_t texels[64];
+            for (uint32_t j = 0; j < 16; j++) {
+              memset(&texels[j * 4], 0, 3);
+              texels[j * 4 + 3] = 255;
+            }
+            codec->decodeBlock(&data[size_t(by * blocksX + bx) * blockSize],
+                               texels);
+            for (uint32_t y = 0; y < 4 && by * 4 + y < h; y++) {
+              uint32_t numTexels = std::min(4u, w - bx * 4);
+              memcpy(&rgba[(size_t(by * 4 + y) * w + bx * 4) * 4],
+                     &texels[y * 16], numTexels * 4);
+            }
+          }
+        }
+      });
+}
+
+void TextureCodec::encode(PixelFormat format, const uint8_t *rgba, uint32_t w,
+                          uint32_t h, uint8_t *data, uint32_t numThreads) {
+  auto codec = getCodec(format);
+  if (!codec)
+    NGFX_ERR("unsupported format: %d", format);
+  uint32_t blockSize = PixelFormatUtil::getFormatInfo(format)->blockSize;
+  uint32_t blocksX = (w + 3) / 4, blocksY = (h + 3) / 4;
+  numThreads = ParallelUtil::getNumThreads(numThreads, blocksY, 4);
+  ParallelUtil::parallelFor(
+      numThreads, blocksY, [&](uint32_t, size_t begin, size_t end) {
+        for (uint32_t by = uint32_t(begin); by < end; by++) {
+          for (uint32_t bx = 0; bx < blocksX; bx++) {
+            uint8_t texels[64];
+            for (uint32_t y = 0; y < 4; y++) {
+              for (uint32_t x = 0; x < 4; x++) {
+                uint32_t px = std::min(bx * 4 + x, w - 1),
+                         py = std::min(by * 4 + y, h - 1);
+                memcpy(&texels[(y * 4 + x) * 4],
+                       &rgba[(size_t(py) * w + px) * 4], 4);
+              }
+            }
+            codec->encodeBlock(texels,
+                               &data[size_t(by * blocksX + bx) * blockSize]);
+          }
+        }
+      });
+}
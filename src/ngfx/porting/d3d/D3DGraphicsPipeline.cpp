@@ -199,9 +199,11 @@ GraphicsPipeline::create(GraphicsContext *graphicsContext, const State &state,
     uint32_t index;
   };
   std::vector<SemanticData> semanticData(vs->attributes.size());
+  auto vertexInputs = getVertexInputs(vs, state.vertexBufferLayouts);
   for (int j = 0; j < vs->attributes.size(); j++) {
     const auto &va = vs->attributes[j];
-    uint32_t binding = va.location, offset = 0; // TODO: va.count
+    uint32_t binding = vertexInputs[j].binding,
+             offset = vertexInputs[j].offset; // TODO: va.count
     D3D12_INPUT_CLASSIFICATION inputRate =
         D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA;
     if (instanceAttributes.find(va.name) != instanceAttributes.end())
@@ -227,7 +229,7 @@ GraphicsPipeline::create(GraphicsContext *graphicsContext, const State &state,
         inputRate,
         (inputRate == D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA) ? UINT(0)
                                                                   : UINT(1)};
-    vertexAttributeBindings[j] = j;
+    vertexAttributeBindings[j] = binding;
   }
 
   D3DGraphicsPipeline::Shaders shaders;
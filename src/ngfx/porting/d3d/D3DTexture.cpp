@@ -20,6 +20,7 @@
  */
 #include "ngfx/porting/d3d/D3DTexture.h"
 #include "ngfx/core/DebugUtil.h"
+#include "ngfx/graphics/PixelFormatUtil.h"
 #include "ngfx/porting/d3d/D3DBlitOp.h"
 #include "ngfx/porting/d3d/D3DBuffer.h"
 #include "ngfx/porting/d3d/D3DDebugUtil.h"
@@ -32,7 +33,8 @@ void D3DTexture::create(D3DGraphicsContext *ctx, D3DGraphics *graphics,
                         uint32_t d, uint32_t arrayLayers, DXGI_FORMAT format,
                         ImageUsageFlags usageFlags, TextureType textureType,
                         bool genMipmaps, uint32_t numSamples,
-                        const D3DSamplerDesc &samplerDesc) {
+                        const D3DSamplerDesc &samplerDesc,
+                        uint32_t mipLevels) {
   this->ctx = ctx;
   this->graphics = graphics;
   this->w = w;
@@ -43,12 +45,14 @@ void D3DTexture::create(D3DGraphicsContext *ctx, D3DGraphics *graphics,
   this->format = PixelFormat(format);
   this->textureType = textureType;
   this->mipLevels =
-      genMipmaps ? uint32_t(floor(log2(float(glm::min(w, h))))) + 1 : 1;
+      genMipmaps ? uint32_t(floor(log2(float(glm::min(w, h))))) + 1
+                 : mipLevels;
+  this->genMipmaps = genMipmaps;
   if (genMipmaps)
     usageFlags |= IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
   this->imageUsageFlags = usageFlags;
   this->numSamples = numSamples;
-  numSubresources = arrayLayers * mipLevels;
+  numSubresources = arrayLayers * this->mipLevels;
   currentResourceState.resize(numSubresources);
 
   HRESULT hResult;
@@ -71,7 +75,8 @@ void D3DTexture::create(D3DGraphicsContext *ctx, D3DGraphics *graphics,
       texFormat = DXGI_FORMAT_R24G8_TYPELESS;
     resourceDesc =
         CD3DX12_RESOURCE_DESC::Tex2D(texFormat, w, h, d * arrayLayers,
-                                     mipLevels, numSamples, 0, resourceFlags);
+                                     this->mipLevels, numSamples, 0,
+                                     resourceFlags);
   }
   bool isRenderTarget =
       (resourceFlags & D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET);
@@ -86,7 +91,7 @@ void D3DTexture::create(D3DGraphicsContext *ctx, D3DGraphics *graphics,
     s = D3D12_RESOURCE_STATE_COPY_DEST;
 
   if (imageUsageFlags & IMAGE_USAGE_SAMPLED_BIT) {
-    defaultSrvDescriptor = getSrvDescriptor(0, mipLevels);
+    defaultSrvDescriptor = getSrvDescriptor(0, this->mipLevels);
     defaultSamplerDescriptor = getSamplerDescriptor(samplerDesc.Filter);
   }
 
@@ -282,9 +287,15 @@ void D3DTexture::upload(void *data, uint32_t size, uint32_t x, uint32_t y,
   if (arrayLayers == -1)
     arrayLayers = this->arrayLayers;
   if (data) {
-    uint64_t stagingBufferSize;
-    D3D_TRACE(stagingBufferSize =
-                  GetRequiredIntermediateSize(v.Get(), 0, arrayLayers));
+    // The layers are copied separately, their subresources aren't
+    // contiguous when only the first level is uploaded
+    uint32_t numLevels = getNumUploadLevels(x, y, z, w, h, d, arrayLayers);
+    uint64_t layerSize;
+    D3D_TRACE(layerSize = GetRequiredIntermediateSize(v.Get(), 0, numLevels));
+    layerSize = (layerSize + D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1) /
+                D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT *
+                D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT;
+    uint64_t stagingBufferSize = layerSize * arrayLayers;
     stagingBuffer.reset(new D3DBuffer());
     stagingBuffer->create(ctx, nullptr, uint32_t(stagingBufferSize),
                           D3D12_HEAP_TYPE_UPLOAD);
@@ -302,7 +313,7 @@ void D3DTexture::upload(void *data, uint32_t size, uint32_t x, uint32_t y,
   ctx->d3dCommandQueue.submit(copyCommandList.v.Get(), nullptr);
   ctx->d3dCommandQueue.waitIdle();
 
-  if (data && mipLevels != 1) {
+  if (data && genMipmaps && mipLevels != 1) {
     D3DCommandList cmdList;
     ComPtr<ID3D12CommandAllocator> cmdAllocator;
     HRESULT hResult;
@@ -320,6 +331,16 @@ void D3DTexture::generateMipmaps(CommandBuffer *commandBuffer) {
   generateMipmapsFn((D3DCommandList *)commandBuffer);
 }
 
+uint32_t D3DTexture::getNumUploadLevels(uint32_t x, uint32_t y, uint32_t z,
+                                        int32_t w, int32_t h, int32_t d,
+                                        int32_t arrayLayers) {
+  // An upload of the whole texture contains the precomputed mip levels
+  bool wholeTexture = x == 0 && y == 0 && z == 0 && uint32_t(w) == this->w &&
+                      uint32_t(h) == this->h && uint32_t(d) == this->d &&
+                      uint32_t(arrayLayers) == this->arrayLayers;
+  return (wholeTexture && !genMipmaps) ? mipLevels : 1;
+}
+
 void D3DTexture::uploadFn(D3DCommandList *cmdList, void *data, uint32_t size,
                           D3DBuffer *stagingBuffer, uint32_t x, uint32_t y,
                           uint32_t z, int32_t w, int32_t h, int32_t d,
@@ -328,39 +349,66 @@ void D3DTexture::uploadFn(D3DCommandList *cmdList, void *data, uint32_t size,
     if (x != 0 || y != 0 || z != 0)
       NGFX_LOG_TRACE("TODO: support sub-region update");
     resourceBarrier(cmdList, D3D12_RESOURCE_STATE_COPY_DEST);
-    uint32_t rowPitch = size / (h * d * arrayLayers);
-    uint32_t slicePitch = size / (d * arrayLayers);
-    vector<D3D12_SUBRESOURCE_DATA> textureData(arrayLayers);
+    // The data contains the levels from the largest to the smallest,
+    // and the subresources are indexed by layer, then by level
+    uint32_t numLevels = getNumUploadLevels(x, y, z, w, h, d, arrayLayers);
+    vector<D3D12_SUBRESOURCE_DATA> textureData(arrayLayers * numLevels);
+    auto formatInfo = PixelFormatUtil::getFormatInfo(format);
     uint8_t *srcData = (uint8_t *)data;
-    for (uint32_t j = 0; j < uint32_t(arrayLayers); j++) {
-      textureData[j] = {srcData, long(rowPitch), slicePitch};
-      srcData += slicePitch;
+    for (uint32_t level = 0; level < numLevels; level++) {
+      uint32_t levelW = glm::max(uint32_t(w) >> level, 1u),
+               levelH = glm::max(uint32_t(h) >> level, 1u),
+               levelD = glm::max(uint32_t(d) >> level, 1u);
+      // The layout of the formats that aren't described by PixelFormatUtil,
+      // e.g. the depth formats, is derived from the size
+      uint32_t rowPitch = formatInfo
+                              ? PixelFormatUtil::getRowPitch(format, levelW)
+                              : size / (h * d * arrayLayers);
+      uint32_t numRows =
+          formatInfo ? (levelH + formatInfo->blockHeight - 1) /
+                           formatInfo->blockHeight
+                     : levelH;
+      uint32_t slicePitch = rowPitch * numRows;
+      for (uint32_t layer = 0; layer < uint32_t(arrayLayers); layer++) {
+        textureData[layer * numLevels + level] = {srcData, long(rowPitch),
+                                                  slicePitch};
+        srcData += slicePitch * levelD;
+      }
+    }
+    uint64_t layerSize;
+    D3D_TRACE(layerSize = GetRequiredIntermediateSize(v.Get(), 0, numLevels));
+    layerSize = (layerSize + D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1) /
+                D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT *
+                D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT;
+    for (uint32_t layer = 0; layer < uint32_t(arrayLayers); layer++) {
+      uint64_t bufferSize = UpdateSubresources(
+          cmdList->v.Get(), v.Get(), stagingBuffer->v.Get(), layer * layerSize,
+          layer * mipLevels, numLevels, &textureData[layer * numLevels]);
+      assert(bufferSize);
     }
-    uint64_t bufferSize =
-        UpdateSubresources(cmdList->v.Get(), v.Get(), stagingBuffer->v.Get(), 0,
-                           0, arrayLayers, textureData.data());
-    assert(bufferSize);
   }
 }
 
 void D3DTexture::download(void *data, uint32_t size, uint32_t x, uint32_t y,
                           uint32_t z, int32_t w, int32_t h, int32_t d,
-                          int32_t arrayLayers) {
+                          int32_t arrayLayers, uint32_t level) {
   auto &copyCommandList = ctx->d3dCopyCommandList;
   const bool flipY = true; //TODO:move to param
+  if (level >= mipLevels)
+    NGFX_ERR("invalid mip level: %u", level);
   if (w == -1)
-    w = this->w;
+    w = std::max(this->w >> level, 1u);
   if (h == -1)
-    h = this->h;
+    h = std::max(this->h >> level, 1u);
   if (d == -1)
-    d = this->d;
+    d = std::max(this->d >> level, 1u);
 
   D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint;
   uint32_t numRows;
   uint64_t srcSize, rowSizeBytes;
   D3D12_RESOURCE_DESC desc = v->GetDesc();
   D3D_TRACE(ctx->d3dDevice.v->GetCopyableFootprints(
-      &desc, 0, 1, 0, &footprint, &numRows, &rowSizeBytes, &srcSize));
+      &desc, level, 1, 0, &footprint, &numRows, &rowSizeBytes, &srcSize));
 
   D3DReadbackBuffer readbackBuffer;
   readbackBuffer.create(ctx, uint32_t(srcSize));
@@ -368,7 +416,7 @@ void D3DTexture::download(void *data, uint32_t size, uint32_t x, uint32_t y,
   D3D12_BOX srcRegion = {0, 0, 0, UINT(w), UINT(h), 1};
 
   copyCommandList.begin();
-  downloadFn(&copyCommandList, readbackBuffer, srcRegion, footprint);
+  downloadFn(&copyCommandList, readbackBuffer, srcRegion, footprint, level);
   copyCommandList.end();
   ctx->d3dCommandQueue.submit(&copyCommandList);
   ctx->d3dCommandQueue.waitIdle();
@@ -389,7 +437,8 @@ void D3DTexture::download(void *data, uint32_t size, uint32_t x, uint32_t y,
 void D3DTexture::downloadFn(D3DCommandList *cmdList,
                             D3DReadbackBuffer &readbackBuffer,
                             D3D12_BOX &srcRegion,
-                            D3D12_PLACED_SUBRESOURCE_FOOTPRINT &dstFootprint) {
+                            D3D12_PLACED_SUBRESOURCE_FOOTPRINT &dstFootprint,
+                            uint32_t level) {
   resourceBarrier(cmdList, D3D12_RESOURCE_STATE_COPY_SOURCE);
 
   D3D12_TEXTURE_COPY_LOCATION dstLocation = {
@@ -397,7 +446,9 @@ void D3DTexture::downloadFn(D3DCommandList *cmdList,
       D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT,
       {dstFootprint}};
   D3D12_TEXTURE_COPY_LOCATION srcLocation = {
-      v.Get(), D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX, 0};
+      v.Get(), D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX, {}};
+  // The subresource of the level in the first array layer
+  srcLocation.SubresourceIndex = level;
 
   D3D_TRACE(cmdList->v->CopyTextureRegion(&dstLocation, 0, 0, 0, &srcLocation,
                                           &srcRegion));
@@ -460,7 +511,8 @@ Texture *Texture::create(GraphicsContext *ctx, Graphics *graphics, void *data,
                          ImageUsageFlags imageUsageFlags,
                          TextureType textureType, bool genMipmaps,
                          FilterMode minFilter, FilterMode magFilter,
-                         FilterMode mipFilter, uint32_t numSamples) {
+                         FilterMode mipFilter, uint32_t numSamples,
+                         uint32_t mipLevels) {
   D3DTexture *d3dTexture = new D3DTexture();
   D3DSamplerDesc samplerDesc;
   uint32_t filter = minFilter << 2 | magFilter << 1 | mipFilter;
@@ -476,6 +528,22 @@ Texture *Texture::create(GraphicsContext *ctx, Graphics *graphics, void *data,
   samplerDesc.Filter = filterMap[filter];
   d3dTexture->create(d3d(ctx), (D3DGraphics *)graphics, data, size, w, h, d,
                      arrayLayers, DXGI_FORMAT(format), imageUsageFlags,
-                     textureType, genMipmaps, numSamples, samplerDesc);
+                     textureType, genMipmaps, numSamples, samplerDesc,
+                     mipLevels);
   return d3dTexture;
 }
+
+bool Texture::isFormatSupported(GraphicsContext *ctx, PixelFormat format) {
+  // DXGI doesn't have the ETC2 and ASTC formats
+  auto formatInfo = PixelFormatUtil::getFormatInfo(format);
+  if (formatInfo &&
+      (formatInfo->compression == PIXELFORMAT_COMPRESSION_ETC2 ||
+       formatInfo->compression == PIXELFORMAT_COMPRESSION_ASTC))
+    return false;
+  D3D12_FEATURE_DATA_FORMAT_SUPPORT formatSupport = {DXGI_FORMAT(format)};
+  if (FAILED(d3d(ctx)->d3dDevice.v->CheckFeatureSupport(
+          D3D12_FEATURE_FORMAT_SUPPORT, &formatSupport,
+          sizeof(formatSupport))))
+    return false;
+  return formatSupport.Support1 & D3D12_FORMAT_SUPPORT1_SHADER_SAMPLE;
+}
@@ -84,9 +84,12 @@ void MTLGraphics::beginProfile(CommandBuffer *commandBuffer) {
     [ device sampleTimestamps: &cpuTimestamp[0] gpuTimestamp: &gpuTimestamp[0] ];
 }
 
-uint64_t MTLGraphics::endProfile(CommandBuffer *commandBuffer) {
+void MTLGraphics::endProfile(CommandBuffer *commandBuffer) {
     auto device = mtl(ctx)->mtlDevice.v;
     [ device sampleTimestamps: &cpuTimestamp[1] gpuTimestamp: &gpuTimestamp[1] ];
+}
+
+uint64_t MTLGraphics::getProfileResult() {
     return gpuTimestamp[1] - gpuTimestamp[0];
 }
 
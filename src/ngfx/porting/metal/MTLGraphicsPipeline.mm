@@ -90,19 +90,20 @@ GraphicsPipeline* GraphicsPipeline::create(GraphicsContext* ctx, const GraphicsP
     MTLVertexDescriptor *vertexDescriptor = [MTLVertexDescriptor new];
     auto& vertexAttributeBindings = mtlGraphicsPipeline->vertexAttributeBindings;
     vertexAttributeBindings.resize(vs->attributes.size());
+    auto vertexInputs = getVertexInputs(vs, state.vertexBufferLayouts);
     for (uint32_t j = 0; j<vs->attributes.size(); j++) {
         auto& attr = vs->attributes[j];
+        auto& vertexInput = vertexInputs[j];
         auto mtlAttr = vertexDescriptor.attributes[attr.location - numVSDescriptors];
-        mtlAttr.bufferIndex = attr.location;
+        mtlAttr.bufferIndex = vertexInput.binding;
         auto mtlLayout = vertexDescriptor.layouts[mtlAttr.bufferIndex];
-        uint32_t stride = attr.elementSize;
         auto mtlVertexFormat = attr.format;
         mtlAttr.format = ::MTLVertexFormat(mtlVertexFormat);
-        mtlAttr.offset = 0;
-        mtlLayout.stride = stride;
+        mtlAttr.offset = vertexInput.offset;
+        mtlLayout.stride = vertexInput.stride;
         if (instanceAttributes.find(attr.name) != instanceAttributes.end())
             mtlLayout.stepFunction = MTLVertexStepFunctionPerInstance;
-        vertexAttributeBindings[j] = attr.location;
+        vertexAttributeBindings[j] = vertexInput.binding;
     }
     
     MTLGraphicsPipeline::Shaders shaders;
@@ -0,0 +1,188 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "ngfx/porting/vulkan/VKAsyncCompute.h"
+#include "ngfx/core/Trace.h"
+#include "ngfx/porting/vulkan/VKDebugUtil.h"
+#include "ngfx/porting/vulkan/VKGraphicsContext.h"
+#include <algorithm>
+using namespace ngfx;
+
+void VKAsyncCompute::create(VKGraphicsContext *ctx, Graphics *graphics,
+                            bool enableDedicatedQueue) {
+  this->ctx = ctx;
+  this->graphics = graphics;
+  auto device = ctx->vkDevice.v;
+  auto &queueFamilyIndices = ctx->vkDevice.queueFamilyIndices;
+  dedicatedQueue = ctx->dedicatedComputeQueue && enableDedicatedQueue;
+  commandBuffer.create(device, dedicatedQueue ? ctx->vkComputeCommandPool.v
+                                              : ctx->vkCommandPool.v);
+  fence.create(device, VK_FENCE_CREATE_SIGNALED_BIT);
+  computeCompleteSemaphore.create(device);
+  graphicsCompleteSemaphore.create(device);
+  computeState = {dedicatedQueue ? queueFamilyIndices.compute
+                                 : queueFamilyIndices.graphics,
+                  VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                  VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+                  VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+                  VK_IMAGE_LAYOUT_GENERAL};
+  graphicsState = {
+      queueFamilyIndices.graphics,
+      VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+          VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+          VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+      VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_INDEX_READ_BIT |
+          VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT |
+          VK_ACCESS_SHADER_READ_BIT,
+      VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+}
+
+VKAsyncCompute::~VKAsyncCompute() { wait(); }
+
+void VKAsyncCompute::addSharedBuffer(Buffer *buffer) {
+  sharedBuffers.push_back(vk(buffer));
+}
+
+void VKAsyncCompute::addSharedTexture(Texture *texture) {
+  sharedTextures.push_back(vk(texture));
+}
+
+void VKAsyncCompute::transfer(VkCommandBuffer cmdBuffer,
+                              const QueueState &src, const QueueState &dst,
+                              bool acquire) {
+  bool ownershipTransfer = (src.queueFamilyIndex != dst.queueFamilyIndex);
+  if (!acquire && !ownershipTransfer)
+    return;
+  // The release barrier only makes the writes available and the acquire
+  // barrier only makes them visible, the layout transition is the same
+  // The acquire barrier is chained to the semaphore wait of its
+  // submission, which waits at the destination stages
+  bool srcScope = !acquire || !ownershipTransfer, dstScope = acquire;
+  VkPipelineStageFlags srcStageMask = srcScope ? src.stageMask : dst.stageMask;
+  VkPipelineStageFlags dstStageMask =
+      dstScope ? dst.stageMask : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+  uint32_t srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+           dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  if (ownershipTransfer) {
+    srcQueueFamilyIndex = src.queueFamilyIndex;
+    dstQueueFamilyIndex = dst.queueFamilyIndex;
+  }
+  std::vector<VkBufferMemoryBarrier> bufferMemoryBarriers;
+  for (auto buffer : sharedBuffers) {
+    bufferMemoryBarriers.push_back(
+        {VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER, nullptr,
+         srcScope ? src.bufferAccessMask : 0,
+         dstScope ? dst.bufferAccessMask : 0, srcQueueFamilyIndex,
+         dstQueueFamilyIndex, buffer->v, 0, VK_WHOLE_SIZE});
+    if (acquire)
+      buffer->setAccess(dst.bufferAccessMask, dst.stageMask);
+  }
+  std::vector<VkImageMemoryBarrier> imageMemoryBarriers;
+  for (auto texture : sharedTextures) {
+    auto &vkImage = texture->vkImage;
+    imageMemoryBarriers.push_back(
+        {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+         nullptr,
+         srcScope ? src.imageAccessMask : 0,
+         dstScope ? dst.imageAccessMask : 0,
+         src.imageLayout,
+         dst.imageLayout,
+         srcQueueFamilyIndex,
+         dstQueueFamilyIndex,
+         vkImage.v,
+         {texture->aspectFlags, 0, texture->mipLevels, 0,
+          texture->arrayLayers}});
+    if (acquire) {
+      for (uint32_t j = 0; j < vkImage.imageLayout.size(); j++) {
+        vkImage.imageLayout[j] = dst.imageLayout;
+        vkImage.accessMask[j] = dst.imageAccessMask;
+        vkImage.stageMask[j] = dst.stageMask;
+      }
+    }
+  }
+  VK_TRACE(vkCmdPipelineBarrier(
+      cmdBuffer, srcStageMask, dstStageMask, 0, 0, nullptr,
+      uint32_t(bufferMemoryBarriers.size()), bufferMemoryBarriers.data(),
+      uint32_t(imageMemoryBarriers.size()), imageMemoryBarriers.data()));
+}
+
+void VKAsyncCompute::submit(RecordFn record) {
+  NGFX_TRACE_SCOPE("VKAsyncCompute::submit");
+  auto &queue = ctx->vkQueue;
+  if (dedicatedQueue) {
+    // The frame that joins the previous compute pass signals the semaphore
+    // that this pass waits on, and consumes the previous pass's semaphores
+    auto &frameSignalSemaphores = queue.frameSignalSemaphores;
+    if (std::find(frameSignalSemaphores.begin(), frameSignalSemaphores.end(),
+                  &graphicsCompleteSemaphore) != frameSignalSemaphores.end())
+      NGFX_ERR("submit: no frame was submitted since the last compute pass");
+  }
+  fence.wait();
+  fence.reset();
+  commandBuffer.begin();
+  if (numSubmissions == 0) {
+    // The previous contents of the shared resources are discarded
+    QueueState initialState = {computeState.queueFamilyIndex,
+                               VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0, 0,
+                               VK_IMAGE_LAYOUT_UNDEFINED};
+    transfer(commandBuffer.v, initialState, computeState, true);
+  } else {
+    transfer(commandBuffer.v, graphicsState, computeState, true);
+  }
+  graphics->beginComputePass(&commandBuffer);
+  record(&commandBuffer);
+  graphics->endComputePass(&commandBuffer);
+  transfer(commandBuffer.v, computeState, graphicsState, false);
+  commandBuffer.end();
+  auto &computeQueue = ctx->vkComputeQueue;
+  if (!dedicatedQueue) {
+    // Same queue: the barriers recorded by join are enough
+    queue.submit(&commandBuffer, 0, {}, {}, &fence);
+  } else {
+    std::vector<Semaphore *> waitSemaphores;
+    if (numSubmissions != 0)
+      waitSemaphores.push_back(&graphicsCompleteSemaphore);
+    computeQueue.submit(&commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                        waitSemaphores, {&computeCompleteSemaphore}, &fence);
+    // The next frame waits for this compute pass, and signals the
+    // semaphore that the next compute pass waits on
+    queue.frameWaitSemaphores.push_back(&computeCompleteSemaphore);
+    queue.frameWaitStageMasks.push_back(graphicsState.stageMask);
+    queue.frameSignalSemaphores.push_back(&graphicsCompleteSemaphore);
+  }
+  numSubmissions++;
+}
+
+void VKAsyncCompute::join(CommandBuffer *commandBuffer) {
+  transfer(vk(commandBuffer)->v, computeState, graphicsState, true);
+}
+
+void VKAsyncCompute::release(CommandBuffer *commandBuffer) {
+  transfer(vk(commandBuffer)->v, graphicsState, computeState, false);
+}
+
+void VKAsyncCompute::wait() { fence.wait(); }
+
+AsyncCompute *AsyncCompute::create(GraphicsContext *ctx, Graphics *graphics,
+                                   bool enableDedicatedQueue) {
+  VKAsyncCompute *vkAsyncCompute = new VKAsyncCompute();
+  vkAsyncCompute->create(vk(ctx), graphics, enableDedicatedQueue);
+  return vkAsyncCompute;
+}
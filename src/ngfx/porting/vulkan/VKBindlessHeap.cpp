@@ -0,0 +1,282 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "ngfx/porting/vulkan/VKBindlessHeap.h"
+#include "ngfx/porting/vulkan/VKBuffer.h"
+#include "ngfx/porting/vulkan/VKCommandBuffer.h"
+#include "ngfx/porting/vulkan/VKComputePipeline.h"
+#include "ngfx/porting/vulkan/VKDebugUtil.h"
+#include "ngfx/porting/vulkan/VKGraphicsContext.h"
+#include "ngfx/porting/vulkan/VKGraphicsPipeline.h"
+#include "ngfx/porting/vulkan/VKTexture.h"
+#include <algorithm>
+#include <vector>
+using namespace ngfx;
+
+void VKBindlessHeap::create(VKGraphicsContext *ctx, uint32_t maxTextures,
+                            uint32_t maxStorageImages,
+                            uint32_t maxStorageBuffers) {
+  VkResult vkResult;
+  this->ctx = ctx;
+  device = ctx->vkDevice.v;
+  auto &props = ctx->vkPhysicalDevice.descriptorIndexingProperties;
+  auto &features = ctx->vkDevice.descriptorIndexingFeatures;
+  // Resources are added while earlier submissions that bind the arrays
+  // are pending, so every array must be updatable after bind.
+  // The storage arrays aren't created if the device doesn't support it
+  maxTextures =
+      std::min({maxTextures, props.maxPerStageDescriptorUpdateAfterBindSamplers,
+                props.maxPerStageDescriptorUpdateAfterBindSampledImages,
+                props.maxDescriptorSetUpdateAfterBindSampledImages});
+  maxStorageImages =
+      features.descriptorBindingStorageImageUpdateAfterBind
+          ? std::min(maxStorageImages,
+                     props.maxPerStageDescriptorUpdateAfterBindStorageImages)
+          : 0;
+  maxStorageBuffers =
+      features.descriptorBindingStorageBufferUpdateAfterBind
+          ? std::min(maxStorageBuffers,
+                     props.maxPerStageDescriptorUpdateAfterBindStorageBuffers)
+          : 0;
+
+  std::vector<VkDescriptorPoolSize> poolSizes;
+  if (maxTextures)
+    poolSizes.push_back(
+        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, maxTextures});
+  if (maxStorageImages)
+    poolSizes.push_back({VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, maxStorageImages});
+  if (maxStorageBuffers)
+    poolSizes.push_back(
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, maxStorageBuffers});
+  VkDescriptorPoolCreateInfo poolCreateInfo = {
+      VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+      nullptr,
+      VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT,
+      3,
+      uint32_t(poolSizes.size()),
+      poolSizes.data()};
+  V(vkCreateDescriptorPool(device, &poolCreateInfo, nullptr,
+                           &descriptorPool));
+  createArray(textures, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+              maxTextures);
+  createArray(storageImages, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+              maxStorageImages);
+  createArray(storageBuffers, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+              maxStorageBuffers);
+}
+
+void VKBindlessHeap::createArray(DescriptorArray &array,
+                                 VkDescriptorType type, uint32_t capacity) {
+  VkResult vkResult;
+  array.type = type;
+  array.capacity = capacity;
+  if (capacity == 0)
+    return;
+  // The array is partially bound: only the descriptors that are accessed
+  // by the shaders need to be valid. The descriptors that aren't used by
+  // the pending submissions can be written after the array is bound
+  VkDescriptorBindingFlagsEXT bindingFlags =
+      VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT |
+      VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT |
+      VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT_EXT;
+  VkDescriptorSetLayoutBindingFlagsCreateInfoEXT bindingFlagsCreateInfo = {
+      VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT,
+      nullptr, 1, &bindingFlags};
+  VkDescriptorSetLayoutBinding layoutBinding = {0, type, capacity,
+                                                VK_SHADER_STAGE_ALL, nullptr};
+  VkDescriptorSetLayoutCreateInfo layoutCreateInfo = {
+      VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+      &bindingFlagsCreateInfo,
+      VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT, 1,
+      &layoutBinding};
+  V(vkCreateDescriptorSetLayout(device, &layoutCreateInfo, nullptr,
+                                &array.layout));
+  VkDescriptorSetAllocateInfo allocInfo = {
+      VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO, nullptr, descriptorPool,
+      1, &array.layout};
+  V(vkAllocateDescriptorSets(device, &allocInfo, &array.set));
+}
+
+VKBindlessHeap::~VKBindlessHeap() {
+  for (auto array : {&textures, &storageImages, &storageBuffers}) {
+    if (array->layout)
+      VK_TRACE(vkDestroyDescriptorSetLayout(device, array->layout, nullptr));
+  }
+  if (descriptorPool)
+    VK_TRACE(vkDestroyDescriptorPool(device, descriptorPool, nullptr));
+}
+
+VKBindlessHeap::DescriptorArray &
+VKBindlessHeap::getArray(VkDescriptorType type) {
+  if (type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER)
+    return textures;
+  else if (type == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE)
+    return storageImages;
+  else if (type != VK_DESCRIPTOR_TYPE_STORAGE_BUFFER)
+    NGFX_ERR("unsupported bindless descriptor type: %d", type);
+  return storageBuffers;
+}
+
+VKBindlessHeap::DescriptorArray &
+VKBindlessHeap::getCreatedArray(VkDescriptorType type) {
+  auto &array = getArray(type);
+  if (!array.layout)
+    NGFX_ERR("bindless descriptor type %d is not supported by the device",
+             type);
+  return array;
+}
+
+bool VKBindlessHeap::isComplete(const FreeIndex &freeIndex) {
+  if (!freeIndex.pendingCommandBuffers.empty())
+    return false;
+  for (auto &it : freeIndex.tickets) {
+    if (!it.first->isComplete(it.second))
+      return false;
+  }
+  return true;
+}
+
+uint32_t VKBindlessHeap::allocate(DescriptorArray &array) {
+  auto &freeList = array.freeList;
+  auto it = std::find_if(freeList.begin(), freeList.end(),
+                         [&](const FreeIndex &f) { return isComplete(f); });
+  if (it == freeList.end() && array.size < array.capacity)
+    return array.size++;
+  if (it == freeList.end()) {
+    // Wait until the oldest removed index that has been submitted can
+    // be reused
+    it = std::find_if(freeList.begin(), freeList.end(), [](auto &f) {
+      return f.pendingCommandBuffers.empty();
+    });
+    if (it == freeList.end())
+      NGFX_ERR("bindless heap is full: %d descriptors", array.capacity);
+    for (auto &ticket : it->tickets)
+      ticket.first->wait(ticket.second);
+  }
+  uint32_t index = it->index;
+  freeList.erase(it);
+  return index;
+}
+
+void VKBindlessHeap::write(DescriptorArray &array, uint32_t index,
+                           const VkDescriptorImageInfo *imageInfo,
+                           const VkDescriptorBufferInfo *bufferInfo) {
+  VkWriteDescriptorSet writeDescriptorSet = {
+      VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+      nullptr,
+      array.set,
+      0,
+      index,
+      1,
+      array.type,
+      imageInfo,
+      bufferInfo,
+      nullptr};
+  VK_TRACE(vkUpdateDescriptorSets(device, 1, &writeDescriptorSet, 0,
+                                  nullptr));
+}
+
+uint32_t VKBindlessHeap::addTexture(Texture *texture) {
+  auto vkTexture = vk(texture);
+  if (!(vkTexture->imageUsageFlags & VK_IMAGE_USAGE_SAMPLED_BIT))
+    NGFX_ERR("incorrect image usage flags: missing IMAGE_USAGE_SAMPLED_BIT");
+  uint32_t index = allocate(getCreatedArray(
+      VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER));
+  VkDescriptorImageInfo imageInfo = {vkTexture->sampler,
+                                     vkTexture->vkDefaultImageView->v,
+                                     VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+  write(textures, index, &imageInfo, nullptr);
+  return index;
+}
+
+uint32_t VKBindlessHeap::addStorageImage(Texture *texture) {
+  auto vkTexture = vk(texture);
+  if (!(vkTexture->imageUsageFlags & VK_IMAGE_USAGE_STORAGE_BIT))
+    NGFX_ERR("incorrect image usage flags: missing IMAGE_USAGE_STORAGE_BIT");
+  uint32_t index =
+      allocate(getCreatedArray(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE));
+  VkDescriptorImageInfo imageInfo = {VK_NULL_HANDLE,
+                                     vkTexture->vkDefaultImageView->v,
+                                     VK_IMAGE_LAYOUT_GENERAL};
+  write(storageImages, index, &imageInfo, nullptr);
+  return index;
+}
+
+uint32_t VKBindlessHeap::addStorageBuffer(Buffer *buffer) {
+  uint32_t index =
+      allocate(getCreatedArray(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER));
+  VkDescriptorBufferInfo bufferInfo = {vk(buffer)->v, 0, VK_WHOLE_SIZE};
+  write(storageBuffers, index, nullptr, &bufferInfo);
+  return index;
+}
+
+void VKBindlessHeap::remove(DescriptorType type, uint32_t index) {
+  // The index may still be accessed by the submissions that bind the heap,
+  // and by the next submission of the command buffers recorded with it
+  getArray(VkDescriptorType(type))
+      .freeList.push_back({index, lastTickets, recordedCommandBuffers});
+}
+
+void VKBindlessHeap::onSubmit(CommandBuffer *commandBuffer, Queue *queue,
+                              uint64_t ticket) {
+  if (boundCommandBuffers.find(commandBuffer) == boundCommandBuffers.end())
+    return;
+  lastTickets[queue] = ticket;
+  if (!recordedCommandBuffers.erase(commandBuffer))
+    return;
+  for (auto array : {&textures, &storageImages, &storageBuffers}) {
+    for (auto &freeIndex : array->freeList) {
+      if (freeIndex.pendingCommandBuffers.erase(commandBuffer))
+        freeIndex.tickets[queue] = ticket;
+    }
+  }
+}
+
+void VKBindlessHeap::bind(CommandBuffer *commandBuffer, Graphics *graphics,
+                          DescriptorType type, uint32_t set) {
+  auto &array = getCreatedArray(VkDescriptorType(type));
+  VkPipelineLayout pipelineLayout;
+  VkPipelineBindPoint pipelineBindPoint;
+  if (VKGraphicsPipeline *graphicsPipeline =
+          dynamic_cast<VKGraphicsPipeline *>(graphics->currentPipeline)) {
+    pipelineLayout = graphicsPipeline->pipelineLayout;
+    pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+  } else if (VKComputePipeline *computePipeline =
+                 dynamic_cast<VKComputePipeline *>(
+                     graphics->currentPipeline)) {
+    pipelineLayout = computePipeline->pipelineLayout;
+    pipelineBindPoint = VK_PIPELINE_BIND_POINT_COMPUTE;
+  } else
+    NGFX_ERR("no pipeline is bound");
+  VK_TRACE(vkCmdBindDescriptorSets(vk(commandBuffer)->v, pipelineBindPoint,
+                                   pipelineLayout, set, 1, &array.set, 0,
+                                   nullptr));
+  boundCommandBuffers.insert(commandBuffer);
+  recordedCommandBuffers.insert(commandBuffer);
+}
+
+uint32_t VKBindlessHeap::capacity(DescriptorType type) {
+  return getArray(VkDescriptorType(type)).capacity;
+}
+
+VkDescriptorSetLayout
+VKBindlessHeap::getDescriptorSetLayout(VkDescriptorType type) {
+  return getCreatedArray(type).layout;
+}
@@ -19,6 +19,7 @@
  * under the License.
  */
 #include "ngfx/porting/vulkan/VKBuffer.h"
+#include "ngfx/core/Trace.h"
 #include "ngfx/porting/vulkan/VKDebugUtil.h"
 #include "ngfx/porting/vulkan/VKGraphicsContext.h"
 #include <cstring>
@@ -27,6 +28,7 @@ using namespace ngfx;
 void VKBuffer::create(VKGraphicsContext *ctx, const void *data, uint32_t size,
                       VkBufferUsageFlags bufferUsageFlags,
                       VkMemoryPropertyFlags memoryPropertyFlags) {
+  NGFX_TRACE_SCOPE("VKBuffer::create");
   this->ctx = ctx;
   this->size = size;
   createBuffer(data, size, bufferUsageFlags);
@@ -90,7 +92,74 @@ void VKBuffer::initDescriptorSet(VkDescriptorPool descriptorPool,
   VK_TRACE(vkUpdateDescriptorSets(device, 1, &writeDescriptorSet, 0, nullptr));
 }
 
+static const VkAccessFlags WRITE_ACCESS_MASK =
+    VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+    VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT |
+    VK_ACCESS_MEMORY_WRITE_BIT;
+
+bool VKBuffer::updateAccess(VkAccessFlags dstAccessMask,
+                            VkPipelineStageFlags dstStageMask,
+                            VkBufferMemoryBarrier &bufferMemoryBarrier,
+                            VkPipelineStageFlags &srcStageMask) {
+  bool dstWrite = dstAccessMask & WRITE_ACCESS_MASK;
+  VkAccessFlags srcAccessMask = writeAccessMask;
+  if (!dstWrite) {
+    readStageMask |= dstStageMask;
+    // no GPU write (host writes are made visible by the queue submit),
+    // or the write is already visible to this stage: no barrier needed
+    if (writeStageMask == 0 ||
+        ((visibleStageMask & dstStageMask) == dstStageMask &&
+         (visibleAccessMask & dstAccessMask) == dstAccessMask))
+      return false;
+    srcStageMask = writeStageMask;
+    visibleAccessMask |= dstAccessMask;
+    visibleStageMask |= dstStageMask;
+  } else {
+    srcStageMask = writeStageMask | readStageMask;
+    writeAccessMask = dstAccessMask & WRITE_ACCESS_MASK;
+    writeStageMask = dstStageMask;
+    readStageMask = 0;
+    // a write isn't visible to the next accesses, even from the same stage
+    visibleAccessMask = 0;
+    visibleStageMask = 0;
+    // first GPU access: no barrier needed
+    if (srcStageMask == 0)
+      return false;
+  }
+  // write after read only needs an execution dependency
+  bufferMemoryBarrier = {VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+                         nullptr,
+                         srcAccessMask,
+                         dstAccessMask,
+                         VK_QUEUE_FAMILY_IGNORED,
+                         VK_QUEUE_FAMILY_IGNORED,
+                         v,
+                         0,
+                         VK_WHOLE_SIZE};
+  return true;
+}
+
+void VKBuffer::setAccess(VkAccessFlags accessMask,
+                         VkPipelineStageFlags stageMask) {
+  writeAccessMask = accessMask & WRITE_ACCESS_MASK;
+  writeStageMask = readStageMask = visibleStageMask = stageMask;
+  visibleAccessMask = accessMask;
+}
+
+void VKBuffer::barrier(VkCommandBuffer commandBuffer,
+                       VkAccessFlags dstAccessMask,
+                       VkPipelineStageFlags dstStageMask) {
+  VkBufferMemoryBarrier bufferMemoryBarrier;
+  VkPipelineStageFlags srcStageMask;
+  if (!updateAccess(dstAccessMask, dstStageMask, bufferMemoryBarrier,
+                    srcStageMask))
+    return;
+  VK_TRACE(vkCmdPipelineBarrier(commandBuffer, srcStageMask, dstStageMask, 0, 0,
+                                nullptr, 1, &bufferMemoryBarrier, 0, nullptr));
+}
+
 void VKBuffer::upload(const void *data, uint32_t size, uint32_t offset) {
+  NGFX_TRACE_SCOPE("VKBuffer::upload");
   uint8_t *dst = (uint8_t *)map();
   memcpy(dst + offset, data, size);
   unmap();
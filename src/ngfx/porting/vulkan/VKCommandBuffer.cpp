@@ -20,6 +20,7 @@
  */
 #include "ngfx/porting/vulkan/VKCommandBuffer.h"
 #include "ngfx/porting/vulkan/VKDebugUtil.h"
+#include "ngfx/porting/vulkan/VKGraphicsContext.h"
 using namespace ngfx;
 
 void VKCommandBuffer::create(VkDevice device, VkCommandPool cmdPool,
@@ -48,3 +49,12 @@ void VKCommandBuffer::end() {
   VkResult vkResult;
   V(vkEndCommandBuffer(v));
 }
+
+CommandBuffer *CommandBuffer::create(GraphicsContext *ctx,
+                                     CommandBufferLevel level) {
+  VKCommandBuffer *vkCommandBuffer = new VKCommandBuffer();
+  auto vkCtx = vk(ctx);
+  vkCommandBuffer->create(vkCtx->vkDevice.v, vkCtx->vkCommandPool.v,
+                          VkCommandBufferLevel(level));
+  return vkCommandBuffer;
+}
@@ -19,6 +19,7 @@
  * under the License.
  */
 #include "ngfx/porting/vulkan/VKComputePipeline.h"
+#include "ngfx/core/Trace.h"
 #include "ngfx/porting/vulkan/VKDebugUtil.h"
 using namespace ngfx;
 
@@ -26,21 +27,20 @@ void VKComputePipeline::create(
     VKGraphicsContext *ctx,
     const std::vector<VKPipeline::Descriptor> &descriptors,
     VkShaderModule shaderModule) {
+  NGFX_TRACE_SCOPE("VKComputePipeline::create");
   VkResult vkResult;
   this->device = ctx->vkDevice.v;
-  std::vector<VkDescriptorSetLayout> descriptorSetLayouts(descriptors.size());
-  for (int j = 0; j < descriptors.size(); j++) {
-    auto &descriptor = descriptors[j];
-    descriptorSetLayouts[j] = ctx->vkDescriptorSetLayoutCache.get(
-        descriptor.type, descriptor.stageFlags);
-  }
+  this->descriptors = descriptors;
+  std::vector<VkDescriptorSetLayout> descriptorSetLayouts;
+  VKPipelineUtil::getDescriptorSetLayouts(ctx, descriptors,
+                                          descriptorSetLayouts);
   pipelineLayoutCreateInfo = {VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
                               nullptr,
                               0,
                               uint32_t(descriptorSetLayouts.size()),
                               descriptorSetLayouts.data(),
-                              0,
-                              nullptr};
+                              pushConstantRange.size ? 1u : 0u,
+                              &pushConstantRange};
   V(vkCreatePipelineLayout(device, &pipelineLayoutCreateInfo, nullptr,
                            &pipelineLayout));
 
@@ -73,6 +73,8 @@ ComputePipeline *ComputePipeline::create(GraphicsContext *graphicsContext,
   std::vector<VKPipeline::Descriptor> vkDescriptors(numDescriptors);
   VKPipelineUtil::parseDescriptors(cs->descriptors, VK_SHADER_STAGE_COMPUTE_BIT,
                                    vkDescriptors, descriptorBindings);
+  VKPipelineUtil::addPushConstantRange(cs, VK_SHADER_STAGE_COMPUTE_BIT,
+                                       vkComputePipeline->pushConstantRange);
   vkComputePipeline->create(vk(graphicsContext), vkDescriptors, vk(cs)->v);
   return vkComputePipeline;
 }
@@ -125,6 +125,37 @@ void VKDevice::getDeviceExtensions() {
     deviceExtensions.push_back(VK_EXT_DEBUG_REPORT_EXTENSION_NAME);
     enableDebugMarkers = true;
   }
+  // Allows creating images with usage flags that are only supported by
+  // the format of a view (e.g. storage usage on sRGB images)
+  if (vkPhysicalDevice->extensionSupported(
+          VK_KHR_MAINTENANCE2_EXTENSION_NAME)) {
+    deviceExtensions.push_back(VK_KHR_MAINTENANCE2_EXTENSION_NAME);
+    enableMaintenance2 = true;
+  }
+  // Allows tracking submissions with a counter instead of fences
+  if (vkPhysicalDevice->extensionSupported(
+          VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME) &&
+      vkPhysicalDevice->timelineSemaphoreFeatures.timelineSemaphore) {
+    deviceExtensions.push_back(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+    enableTimelineSemaphore = true;
+  }
+  // Allows indexing large arrays of descriptors that are updated after
+  // they're bound, while submissions that don't use the updated
+  // descriptors are pending (bindless resources)
+  auto &indexingFeatures = vkPhysicalDevice->descriptorIndexingFeatures;
+  if (vkPhysicalDevice->extensionSupported(
+          VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME) &&
+      vkPhysicalDevice->extensionSupported(
+          VK_KHR_MAINTENANCE3_EXTENSION_NAME) &&
+      indexingFeatures.runtimeDescriptorArray &&
+      indexingFeatures.descriptorBindingPartiallyBound &&
+      indexingFeatures.shaderSampledImageArrayNonUniformIndexing &&
+      indexingFeatures.descriptorBindingSampledImageUpdateAfterBind &&
+      indexingFeatures.descriptorBindingUpdateUnusedWhilePending) {
+    deviceExtensions.push_back(VK_KHR_MAINTENANCE3_EXTENSION_NAME);
+    deviceExtensions.push_back(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+    enableDescriptorIndexing = true;
+  }
 }
 void VKDevice::create(VKPhysicalDevice *vkPhysicalDevice) {
   VkResult vkResult;
@@ -134,17 +165,75 @@ void VKDevice::create(VKPhysicalDevice *vkPhysicalDevice) {
 
   createInfo = {};
   createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+  if (enableTimelineSemaphore) {
+    timelineSemaphoreFeatures = {
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR,
+        nullptr, VK_TRUE};
+    createInfo.pNext = &timelineSemaphoreFeatures;
+  }
+  enabledFeatures = {};
+  // The block compressed texture formats
+  auto &deviceFeatures = vkPhysicalDevice->deviceFeatures;
+  enabledFeatures.textureCompressionBC = deviceFeatures.textureCompressionBC;
+  enabledFeatures.textureCompressionETC2 =
+      deviceFeatures.textureCompressionETC2;
+  enabledFeatures.textureCompressionASTC_LDR =
+      deviceFeatures.textureCompressionASTC_LDR;
+  // Indirect draws with a draw count greater than one
+  enabledFeatures.multiDrawIndirect = deviceFeatures.multiDrawIndirect;
+  if (enableDescriptorIndexing) {
+    auto &supportedFeatures = vkPhysicalDevice->deviceFeatures;
+    enabledFeatures.shaderSampledImageArrayDynamicIndexing =
+        supportedFeatures.shaderSampledImageArrayDynamicIndexing;
+    enabledFeatures.shaderStorageImageArrayDynamicIndexing =
+        supportedFeatures.shaderStorageImageArrayDynamicIndexing;
+    enabledFeatures.shaderStorageBufferArrayDynamicIndexing =
+        supportedFeatures.shaderStorageBufferArrayDynamicIndexing;
+    // Only enable the features used by the bindless descriptor heap
+    auto &supportedIndexingFeatures =
+        vkPhysicalDevice->descriptorIndexingFeatures;
+    descriptorIndexingFeatures = {
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT};
+    descriptorIndexingFeatures.shaderSampledImageArrayNonUniformIndexing =
+        VK_TRUE;
+    descriptorIndexingFeatures.shaderStorageImageArrayNonUniformIndexing =
+        supportedIndexingFeatures.shaderStorageImageArrayNonUniformIndexing;
+    descriptorIndexingFeatures.shaderStorageBufferArrayNonUniformIndexing =
+        supportedIndexingFeatures.shaderStorageBufferArrayNonUniformIndexing;
+    descriptorIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind =
+        VK_TRUE;
+    descriptorIndexingFeatures.descriptorBindingStorageImageUpdateAfterBind =
+        supportedIndexingFeatures.descriptorBindingStorageImageUpdateAfterBind;
+    descriptorIndexingFeatures.descriptorBindingStorageBufferUpdateAfterBind =
+        supportedIndexingFeatures
+            .descriptorBindingStorageBufferUpdateAfterBind;
+    descriptorIndexingFeatures.descriptorBindingUpdateUnusedWhilePending =
+        VK_TRUE;
+    descriptorIndexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+    descriptorIndexingFeatures.runtimeDescriptorArray = VK_TRUE;
+    descriptorIndexingFeatures.pNext = const_cast<void *>(createInfo.pNext);
+    createInfo.pNext = &descriptorIndexingFeatures;
+  }
   createInfo.queueCreateInfoCount =
       static_cast<uint32_t>(queueCreateInfos.size());
   ;
   createInfo.pQueueCreateInfos = queueCreateInfos.data();
-  createInfo.pEnabledFeatures = nullptr;
+  createInfo.pEnabledFeatures = &enabledFeatures;
   createInfo.enabledExtensionCount = (uint32_t)deviceExtensions.size();
   enabledDeviceExtensions.resize(deviceExtensions.size());
   for (uint32_t j = 0; j < deviceExtensions.size(); j++)
     enabledDeviceExtensions[j] = deviceExtensions[j].c_str();
   createInfo.ppEnabledExtensionNames = enabledDeviceExtensions.data();
   V(vkCreateDevice(vkPhysicalDevice->v, &createInfo, nullptr, &v));
+  if (enableTimelineSemaphore) {
+    getSemaphoreCounterValue =
+        reinterpret_cast<PFN_vkGetSemaphoreCounterValueKHR>(
+            vkGetDeviceProcAddr(v, "vkGetSemaphoreCounterValueKHR"));
+    waitSemaphores = reinterpret_cast<PFN_vkWaitSemaphoresKHR>(
+        vkGetDeviceProcAddr(v, "vkWaitSemaphoresKHR"));
+    signalSemaphore = reinterpret_cast<PFN_vkSignalSemaphoreKHR>(
+        vkGetDeviceProcAddr(v, "vkSignalSemaphoreKHR"));
+  }
 }
 void VKDevice::waitIdle() {
   VkResult vkResult;
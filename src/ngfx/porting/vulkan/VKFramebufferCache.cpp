@@ -0,0 +1,145 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "ngfx/porting/vulkan/VKFramebufferCache.h"
+#include "ngfx/core/Util.h"
+using namespace ngfx;
+
+size_t VKFramebufferCache::KeyHash::operator()(const Key &key) const {
+  uint64_t seed = uint64_t(key.renderPass);
+  for (auto imageView : key.imageViews)
+    Util::hashCombine(seed, uint64_t(imageView));
+  Util::hashCombine(seed, key.w);
+  Util::hashCombine(seed, key.h);
+  Util::hashCombine(seed, key.layers);
+  return size_t(seed);
+}
+
+void VKFramebufferCache::create(GraphicsContext::CacheStats *stats,
+                                uint32_t capacity) {
+  this->stats = stats;
+  this->capacity = capacity;
+}
+
+std::shared_ptr<Framebuffer>
+VKFramebufferCache::get(VkRenderPass renderPass,
+                        const std::vector<VkImageView> &imageViews, uint32_t w,
+                        uint32_t h, uint32_t layers, CreateFn createFn) {
+  Key key = {renderPass, imageViews, w, h, layers};
+  auto it = index.find(key);
+  if (it != index.end()) {
+    stats->hits++;
+    auto entry = it->second;
+    entries.splice(entries.begin(), entries, entry);
+    return entry->framebuffer;
+  }
+  stats->misses++;
+  std::shared_ptr<Framebuffer> framebuffer(createFn());
+  entries.push_front({key, framebuffer});
+  auto entry = entries.begin();
+  index[key] = entry;
+  framebufferIndex[framebuffer.get()] = entry;
+  for (auto imageView : imageViews)
+    imageViewIndex.emplace(imageView, entry);
+  trim();
+  return framebuffer;
+}
+
+void VKFramebufferCache::use(CommandBuffer *commandBuffer,
+                             Framebuffer *framebuffer) {
+  auto it = framebufferIndex.find(framebuffer);
+  if (it == framebufferIndex.end())
+    return;
+  auto entry = it->second;
+  entry->commandBuffers.insert(commandBuffer);
+  entry->pendingCommandBuffers.insert(commandBuffer);
+  commandBufferFramebuffers[commandBuffer].insert(framebuffer);
+}
+
+void VKFramebufferCache::onSubmit(CommandBuffer *commandBuffer, Queue *queue,
+                                  uint64_t ticket) {
+  // A command buffer may be submitted again without being recorded again,
+  // so each submission updates the tickets of its framebuffers
+  auto it = commandBufferFramebuffers.find(commandBuffer);
+  if (it == commandBufferFramebuffers.end())
+    return;
+  for (auto framebuffer : it->second) {
+    auto entry = framebufferIndex.at(framebuffer);
+    entry->queue = queue;
+    entry->ticket = ticket;
+    entry->pendingCommandBuffers.erase(commandBuffer);
+  }
+}
+
+bool VKFramebufferCache::isInUse(const Entry &entry) {
+  if (!entry.pendingCommandBuffers.empty())
+    return true;
+  return entry.queue && !entry.queue->isComplete(entry.ticket);
+}
+
+void VKFramebufferCache::erase(EntryIterator it) {
+  for (auto imageView : it->key.imageViews) {
+    auto range = imageViewIndex.equal_range(imageView);
+    for (auto viewIt = range.first; viewIt != range.second; viewIt++) {
+      if (viewIt->second == it) {
+        imageViewIndex.erase(viewIt);
+        break;
+      }
+    }
+  }
+  auto framebuffer = it->framebuffer.get();
+  for (auto commandBuffer : it->commandBuffers) {
+    auto &framebuffers = commandBufferFramebuffers[commandBuffer];
+    framebuffers.erase(framebuffer);
+    if (framebuffers.empty())
+      commandBufferFramebuffers.erase(commandBuffer);
+  }
+  framebufferIndex.erase(framebuffer);
+  index.erase(it->key);
+  entries.erase(it);
+  stats->evictions++;
+}
+
+void VKFramebufferCache::trim() {
+  // Evict the least recently used framebuffers, skipping the ones
+  // that may still be used by the GPU
+  auto it = entries.end();
+  while (entries.size() > capacity && it != entries.begin()) {
+    auto entry = std::prev(it);
+    if (isInUse(*entry)) {
+      it = entry;
+      continue;
+    }
+    erase(entry);
+  }
+}
+
+void VKFramebufferCache::evict(VkImageView imageView) {
+  auto it = imageViewIndex.find(imageView);
+  while (it != imageViewIndex.end()) {
+    erase(it->second);
+    it = imageViewIndex.find(imageView);
+  }
+}
+
+void VKFramebufferCache::clear() {
+  while (!entries.empty())
+    erase(entries.begin());
+}
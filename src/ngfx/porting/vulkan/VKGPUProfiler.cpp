@@ -0,0 +1,92 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "ngfx/porting/vulkan/VKGPUProfiler.h"
+#include "ngfx/porting/vulkan/VKCommandBuffer.h"
+#include "ngfx/porting/vulkan/VKDebugUtil.h"
+#include "ngfx/porting/vulkan/VKGraphicsContext.h"
+using namespace ngfx;
+
+void VKGPUProfiler::create(VKGraphicsContext *ctx, uint32_t numFrames,
+                           uint32_t maxRegions) {
+  init(numFrames, maxRegions);
+  device = ctx->vkDevice.v;
+  auto &physicalDevice = ctx->vkPhysicalDevice;
+  auto &limits = physicalDevice.deviceProperties.limits;
+  uint32_t timestampValidBits =
+      physicalDevice
+          .queueFamilyProperties[ctx->vkDevice.queueFamilyIndices.graphics]
+          .timestampValidBits;
+  if (timestampValidBits == 0 || !limits.timestampComputeAndGraphics) {
+    NGFX_LOG("timestamp queries not supported, GPU profiling disabled");
+    enabled = false;
+    return;
+  }
+  timestampPeriod = limits.timestampPeriod;
+  if (timestampValidBits < 64)
+    timestampMask = (1ull << timestampValidBits) - 1;
+  vkQueryPools.resize(numFrames);
+  for (auto &queryPool : vkQueryPools) {
+    queryPool.reset(new VKQueryPool());
+    queryPool->create(device, VK_QUERY_TYPE_TIMESTAMP, maxQueries);
+  }
+}
+
+void VKGPUProfiler::resetQueries(CommandBuffer *commandBuffer,
+                                 uint32_t frameSlot) {
+  VK_TRACE(vkCmdResetQueryPool(vk(commandBuffer)->v,
+                               vkQueryPools[frameSlot]->v, 0, maxQueries));
+}
+
+void VKGPUProfiler::writeTimestamp(CommandBuffer *commandBuffer,
+                                   uint32_t frameSlot, uint32_t query,
+                                   bool begin) {
+  VK_TRACE(vkCmdWriteTimestamp(vk(commandBuffer)->v,
+                               begin ? VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT
+                                     : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                               vkQueryPools[frameSlot]->v, query));
+}
+
+void VKGPUProfiler::getTimestamps(uint32_t frameSlot, uint32_t numQueries,
+                                  std::vector<uint64_t> &timestamps,
+                                  std::vector<bool> &available) {
+  // Each result is followed by its availability, so the queries that were
+  // never written don't prevent reading back the others
+  std::vector<uint64_t> data(2 * numQueries);
+  VkResult vkResult = vkGetQueryPoolResults(
+      device, vkQueryPools[frameSlot]->v, 0, numQueries,
+      data.size() * sizeof(uint64_t), data.data(), 2 * sizeof(uint64_t),
+      VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+  if (vkResult != VK_SUCCESS && vkResult != VK_NOT_READY)
+    NGFX_ERR("vkGetQueryPoolResults failed: %d", vkResult);
+  timestamps.resize(numQueries);
+  available.resize(numQueries);
+  for (uint32_t j = 0; j < numQueries; j++) {
+    timestamps[j] = data[2 * j] & timestampMask;
+    available[j] = data[2 * j + 1] != 0;
+  }
+}
+
+GPUProfiler *GPUProfiler::create(GraphicsContext *ctx, uint32_t numFrames,
+                                 uint32_t maxRegions) {
+  VKGPUProfiler *vkProfiler = new VKGPUProfiler();
+  vkProfiler->create(vk(ctx), numFrames, maxRegions);
+  return vkProfiler;
+}
@@ -27,8 +27,32 @@
 #include "ngfx/porting/vulkan/VKGraphicsPipeline.h"
 #include "ngfx/porting/vulkan/VKRenderPass.h"
 #include "ngfx/porting/vulkan/VKTexture.h"
+#include <algorithm>
+#include <vector>
 using namespace ngfx;
 
+// The accesses that compute writes are made visible to when a render pass
+// begins
+static const VkAccessFlags GRAPHICS_READ_ACCESS_MASK =
+    VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_INDEX_READ_BIT |
+    VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT |
+    VK_ACCESS_SHADER_READ_BIT;
+static const VkPipelineStageFlags GRAPHICS_READ_STAGE_MASK =
+    VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+    VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+static VkPipelineStageFlags
+getPipelineStageFlags(ShaderStageFlags shaderStageFlags) {
+  VkPipelineStageFlags stageFlags = 0;
+  if (shaderStageFlags & VK_SHADER_STAGE_VERTEX_BIT)
+    stageFlags |= VK_PIPELINE_STAGE_VERTEX_SHADER_BIT;
+  if (shaderStageFlags & VK_SHADER_STAGE_FRAGMENT_BIT)
+    stageFlags |= VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+  if (shaderStageFlags & VK_SHADER_STAGE_COMPUTE_BIT)
+    stageFlags |= VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+  return stageFlags ? stageFlags : VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+}
+
 void VKGraphics::beginRenderPass(CommandBuffer *commandBuffer,
                                  RenderPass *renderPass,
                                  Framebuffer *framebuffer, glm::vec4 clearColor,
@@ -36,6 +60,18 @@ void VKGraphics::beginRenderPass(CommandBuffer *commandBuffer,
   currentRenderPass = renderPass;
   currentFramebuffer = framebuffer;
   auto &vkCommandBuffer = vk(commandBuffer)->v;
+  if (computeWritesPending) {
+    // make buffers written by compute shaders visible to the graphics stages
+    VkMemoryBarrier memoryBarrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+                                     nullptr, VK_ACCESS_SHADER_WRITE_BIT,
+                                     GRAPHICS_READ_ACCESS_MASK};
+    VK_TRACE(vkCmdPipelineBarrier(
+        vkCommandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        GRAPHICS_READ_STAGE_MASK, 0, 1, &memoryBarrier, 0, nullptr, 0,
+        nullptr));
+    computeWritesPending = false;
+  }
+  vk(ctx)->vkFramebufferCache.use(commandBuffer, framebuffer);
   auto vkFramebuffer = vk(framebuffer);
   auto &vkAttachmentInfos = vkFramebuffer->vkAttachmentInfos;
   std::vector<VkClearValue> clearValues(vkAttachmentInfos.size());
@@ -93,18 +129,45 @@ void VKGraphics::endRenderPass(CommandBuffer *commandBuffer) {
 void VKGraphics::beginProfile(CommandBuffer *commandBuffer) {
     auto *vkCtx = vk(ctx);
     auto *vkCommandBuffer = vk(commandBuffer)->v;
+    // Read back the result of the previous profile before the queries are
+    // reset
+    readProfileResult();
     vkCmdResetQueryPool(vkCommandBuffer, vkCtx->vkQueryPool.v, 0, 2);
+    profileQueriesReset = true;
     vkCmdWriteTimestamp(vkCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, vkCtx->vkQueryPool.v, 0);
 }
 
-uint64_t VKGraphics::endProfile(CommandBuffer *commandBuffer) {
+void VKGraphics::endProfile(CommandBuffer *commandBuffer) {
     auto *vkCtx = vk(ctx);
     auto *vkCommandBuffer = vk(commandBuffer)->v;
     vkCmdWriteTimestamp(vkCommandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, vkCtx->vkQueryPool.v, 1);
+}
+
+uint64_t VKGraphics::getProfileResult() {
+    readProfileResult();
+    return profileResult;
+}
+
+void VKGraphics::readProfileResult() {
+    // Don't wait: if the profile is still executing, keep the last result
+    if (!profileQueriesReset)
+        return;
+    auto *vkCtx = vk(ctx);
+    auto &physicalDevice = vkCtx->vkPhysicalDevice;
+    uint32_t timestampValidBits =
+        physicalDevice.queueFamilyProperties[vkCtx->vkDevice.queueFamilyIndices.graphics]
+            .timestampValidBits;
+    uint64_t timestampMask =
+        (timestampValidBits < 64) ? (1ull << timestampValidBits) - 1 : ~0ull;
     uint64_t t[2];
-    vkGetQueryPoolResults(vkCtx->vkDevice.v, vkCtx->vkQueryPool.v, 0, 2, sizeof(t), t,
-                          sizeof(t[0]), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
-    return t[1] - t[0];
+    VkResult vkResult = vkGetQueryPoolResults(
+        vkCtx->vkDevice.v, vkCtx->vkQueryPool.v, 0, 2, sizeof(t), t,
+        sizeof(t[0]), VK_QUERY_RESULT_64_BIT);
+    // The difference modulo the valid bits handles the wraparound
+    if (vkResult == VK_SUCCESS)
+        profileResult = uint64_t(
+            double((t[1] - t[0]) & timestampMask) *
+            physicalDevice.deviceProperties.limits.timestampPeriod);
 }
 
 void VKGraphics::bindComputePipeline(CommandBuffer *commandBuffer,
@@ -113,6 +176,7 @@ void VKGraphics::bindComputePipeline(CommandBuffer *commandBuffer,
                              VK_PIPELINE_BIND_POINT_COMPUTE,
                              vk(computePipeline)->v));
   currentPipeline = computePipeline;
+  computeBufferBindings.clear();
 }
 
 void VKGraphics::bindGraphicsPipeline(CommandBuffer *commandBuffer,
@@ -139,12 +203,24 @@ void VKGraphics::bindTexture(CommandBuffer *commandBuffer, Texture *texture,
     descriptorSet = &vkTexture->samplerDescriptorSet;
   } else if (VKComputePipeline *computePipeline =
                  dynamic_cast<VKComputePipeline *>(currentPipeline)) {
-    if (!(vkTexture->imageUsageFlags & VK_IMAGE_USAGE_STORAGE_BIT)) {
-      NGFX_ERR("incorrect image usage flags: missing IMAGE_USAGE_STORAGE_BIT");
-    }
     pipelineLayout = computePipeline->pipelineLayout;
     pipelineBindPoint = VK_PIPELINE_BIND_POINT_COMPUTE;
-    descriptorSet = &vkTexture->storageImageDescriptorSet;
+    // Compute shaders can also sample a texture, e.g. a depth buffer
+    auto &descriptors = computePipeline->descriptors;
+    if (set < descriptors.size() &&
+        descriptors[set].type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER) {
+      if (!(vkTexture->imageUsageFlags & VK_IMAGE_USAGE_SAMPLED_BIT)) {
+        NGFX_ERR(
+            "incorrect image usage flags: missing IMAGE_USAGE_SAMPLED_BIT");
+      }
+      descriptorSet = &vkTexture->samplerDescriptorSet;
+    } else {
+      if (!(vkTexture->imageUsageFlags & VK_IMAGE_USAGE_STORAGE_BIT)) {
+        NGFX_ERR(
+            "incorrect image usage flags: missing IMAGE_USAGE_STORAGE_BIT");
+      }
+      descriptorSet = &vkTexture->storageImageDescriptorSet;
+    }
   } else
     NGFX_ERR();
   VK_TRACE(vkCmdBindDescriptorSets(vk(commandBuffer)->v, pipelineBindPoint,
@@ -152,14 +228,86 @@ void VKGraphics::bindTexture(CommandBuffer *commandBuffer, Texture *texture,
                                    nullptr));
 }
 
+void VKGraphics::pushConstants(CommandBuffer *commandBuffer, const void *data,
+                               uint32_t size, uint32_t offset) {
+  auto pipeline = dynamic_cast<VKPipeline *>(currentPipeline);
+  if (!pipeline)
+    NGFX_ERR("pushConstants: no pipeline is bound");
+  auto &range = pipeline->pushConstantRange;
+  if (offset < range.offset || (offset + size) > (range.offset + range.size))
+    NGFX_ERR("pushConstants: [%u, %u] is outside of the push constant range",
+             offset, offset + size);
+  VK_TRACE(vkCmdPushConstants(vk(commandBuffer)->v, pipeline->pipelineLayout,
+                              range.stageFlags, offset, size, data));
+}
+
+void VKGraphics::bindGraphicsBuffer(CommandBuffer *commandBuffer,
+                                    VKBuffer *buffer, VkAccessFlags accessMask,
+                                    VkPipelineStageFlags stageMask) {
+  if (!currentRenderPass) {
+    buffer->barrier(vk(commandBuffer)->v, accessMask, stageMask);
+    return;
+  }
+  VkBufferMemoryBarrier bufferMemoryBarrier;
+  VkPipelineStageFlags srcStageMask;
+  if (!buffer->updateAccess(accessMask, stageMask, bufferMemoryBarrier,
+                            srcStageMask))
+    return;
+  // The barrier is covered by the one recorded when the render pass began,
+  // if the buffer was written by a compute shader
+  bool computeWrite =
+      srcStageMask == VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT &&
+      (bufferMemoryBarrier.srcAccessMask & ~VK_ACCESS_SHADER_WRITE_BIT) == 0;
+  if (!computeWrite || (accessMask & ~GRAPHICS_READ_ACCESS_MASK))
+    NGFX_ERR("buffer barrier inside a render pass, from stages 0x%x to 0x%x",
+             srcStageMask, stageMask);
+}
+
 void VKGraphics::bindVertexBuffer(CommandBuffer *commandBuffer, Buffer *buffer,
                                   uint32_t location, uint32_t stride) {
+  bindGraphicsBuffer(commandBuffer, vk(buffer),
+                     VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT,
+                     VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
   VkDeviceSize offsets[] = {0};
   VK_TRACE(vkCmdBindVertexBuffers(vk(commandBuffer)->v, location, 1,
                                   &vk(buffer)->v, offsets));
 }
+void VKGraphics::bindVertexBuffers(CommandBuffer *commandBuffer,
+                                   const std::vector<Buffer *> &buffers,
+                                   const std::vector<uint32_t> &bindings,
+                                   const std::vector<uint32_t> &strides) {
+  std::vector<uint32_t> order(buffers.size());
+  for (uint32_t j = 0; j < order.size(); j++) {
+    order[j] = j;
+    bindGraphicsBuffer(commandBuffer, vk(buffers[j]),
+                       VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT,
+                       VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
+  }
+  std::sort(order.begin(), order.end(),
+            [&](uint32_t a, uint32_t b) { return bindings[a] < bindings[b]; });
+  // Bind each range of consecutive bindings with a single command
+  std::vector<VkBuffer> vkBuffers;
+  std::vector<VkDeviceSize> offsets;
+  for (uint32_t j = 0; j < order.size(); j++) {
+    vkBuffers.push_back(vk(buffers[order[j]])->v);
+    offsets.push_back(0);
+    bool lastInRange = (j + 1) == order.size() ||
+                       bindings[order[j + 1]] != (bindings[order[j]] + 1);
+    if (!lastInRange)
+      continue;
+    uint32_t numBuffers = uint32_t(vkBuffers.size());
+    uint32_t firstBinding = bindings[order[j]] + 1 - numBuffers;
+    VK_TRACE(vkCmdBindVertexBuffers(vk(commandBuffer)->v, firstBinding,
+                                    numBuffers, vkBuffers.data(),
+                                    offsets.data()));
+    vkBuffers.clear();
+    offsets.clear();
+  }
+}
 void VKGraphics::bindIndexBuffer(CommandBuffer *commandBuffer, Buffer *buffer,
                                  IndexFormat indexFormat) {
+  bindGraphicsBuffer(commandBuffer, vk(buffer), VK_ACCESS_INDEX_READ_BIT,
+                     VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
   VkDeviceSize offset = 0;
   VK_TRACE(vkCmdBindIndexBuffer(vk(commandBuffer)->v, vk(buffer)->v, offset,
                                 VkIndexType(indexFormat)));
@@ -189,6 +337,12 @@ void VKGraphics::bindUniformBuffer(CommandBuffer *commandBuffer, Buffer *buffer,
                                    ShaderStageFlags shaderStageFlags) {
   bindBufferFN0(commandBuffer, buffer, set, currentPipeline,
                 &vk(buffer)->getUboDescriptorSet(shaderStageFlags));
+  if (dynamic_cast<VKComputePipeline *>(currentPipeline))
+    computeBufferBindings[set] = {vk(buffer), VK_ACCESS_UNIFORM_READ_BIT,
+                                  VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT};
+  else
+    bindGraphicsBuffer(commandBuffer, vk(buffer), VK_ACCESS_UNIFORM_READ_BIT,
+                       getPipelineStageFlags(shaderStageFlags));
 }
 
 void VKGraphics::bindStorageBuffer(CommandBuffer *commandBuffer, Buffer *buffer,
@@ -196,16 +350,74 @@ void VKGraphics::bindStorageBuffer(CommandBuffer *commandBuffer, Buffer *buffer,
                                    ShaderStageFlags shaderStageFlags) {
   bindBufferFN0(commandBuffer, buffer, set, currentPipeline,
                 &vk(buffer)->getSsboDescriptorSet(shaderStageFlags));
+  // The shader access (readonly / writeonly) isn't known here,
+  // so storage buffers are conservatively tracked as read-write for
+  // dispatches. Draws only read them, since their barriers would have
+  // to be recorded inside the render pass
+  if (dynamic_cast<VKComputePipeline *>(currentPipeline))
+    computeBufferBindings[set] = {
+        vk(buffer), VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT};
+  else
+    bindGraphicsBuffer(commandBuffer, vk(buffer), VK_ACCESS_SHADER_READ_BIT,
+                       getPipelineStageFlags(shaderStageFlags));
+}
+
+void VKGraphics::computeBarriers(CommandBuffer *commandBuffer,
+                                 VKBuffer *indirectBuffer) {
+  std::vector<VkBufferMemoryBarrier> bufferMemoryBarriers;
+  VkPipelineStageFlags srcStageMask = 0,
+                       dstStageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+  if (indirectBuffer) {
+    VkBufferMemoryBarrier bufferMemoryBarrier;
+    VkPipelineStageFlags bufferSrcStageMask;
+    if (indirectBuffer->updateAccess(VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
+                                     VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                                     bufferMemoryBarrier,
+                                     bufferSrcStageMask)) {
+      bufferMemoryBarriers.push_back(bufferMemoryBarrier);
+      srcStageMask |= bufferSrcStageMask;
+      dstStageMask |= VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
+    }
+  }
+  for (auto &it : computeBufferBindings) {
+    auto &binding = it.second;
+    VkBufferMemoryBarrier bufferMemoryBarrier;
+    VkPipelineStageFlags bufferSrcStageMask;
+    if (binding.buffer->updateAccess(binding.accessMask, binding.stageMask,
+                                     bufferMemoryBarrier, bufferSrcStageMask)) {
+      bufferMemoryBarriers.push_back(bufferMemoryBarrier);
+      srcStageMask |= bufferSrcStageMask;
+    }
+    if (binding.accessMask & VK_ACCESS_SHADER_WRITE_BIT)
+      computeWritesPending = true;
+  }
+  if (!bufferMemoryBarriers.empty()) {
+    VK_TRACE(vkCmdPipelineBarrier(
+        vk(commandBuffer)->v, srcStageMask, dstStageMask, 0, 0, nullptr,
+        uint32_t(bufferMemoryBarriers.size()), bufferMemoryBarriers.data(), 0,
+        nullptr));
+  }
 }
 
 void VKGraphics::dispatch(CommandBuffer *commandBuffer, uint32_t groupCountX,
                           uint32_t groupCountY, uint32_t groupCountZ,
                           uint32_t threadsPerGroupX, uint32_t threadsPerGroupY,
                           uint32_t threadsPerGroupZ) {
+  computeBarriers(commandBuffer);
   VK_TRACE(vkCmdDispatch(vk(commandBuffer)->v, groupCountX, groupCountY,
                          groupCountZ));
 }
 
+void VKGraphics::dispatchIndirect(CommandBuffer *commandBuffer, Buffer *buffer,
+                                  uint32_t offset, uint32_t threadsPerGroupX,
+                                  uint32_t threadsPerGroupY,
+                                  uint32_t threadsPerGroupZ) {
+  computeBarriers(commandBuffer, vk(buffer));
+  VK_TRACE(vkCmdDispatchIndirect(vk(commandBuffer)->v, vk(buffer)->v,
+                                 VkDeviceSize(offset)));
+}
+
 void VKGraphics::draw(CommandBuffer *commandBuffer, uint32_t vertexCount,
                       uint32_t instanceCount, uint32_t firstVertex,
                       uint32_t firstInstance) {
@@ -218,6 +430,28 @@ void VKGraphics::drawIndexed(CommandBuffer *cmdBuffer, uint32_t indexCount,
   VK_TRACE(vkCmdDrawIndexed(vk(cmdBuffer)->v, indexCount, instanceCount,
                             firstIndex, vertexOffset, firstInstance));
 }
+void VKGraphics::drawIndirect(CommandBuffer *cmdBuffer, Buffer *buffer,
+                              uint32_t offset, uint32_t drawCount,
+                              uint32_t stride) {
+  if (drawCount > 1 && !ctx->multiDrawIndirect)
+    NGFX_ERR("multi draw indirect is not supported, drawCount: %u", drawCount);
+  bindGraphicsBuffer(cmdBuffer, vk(buffer),
+                     VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
+                     VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT);
+  VK_TRACE(vkCmdDrawIndirect(vk(cmdBuffer)->v, vk(buffer)->v,
+                             VkDeviceSize(offset), drawCount, stride));
+}
+void VKGraphics::drawIndexedIndirect(CommandBuffer *cmdBuffer, Buffer *buffer,
+                                     uint32_t offset, uint32_t drawCount,
+                                     uint32_t stride) {
+  if (drawCount > 1 && !ctx->multiDrawIndirect)
+    NGFX_ERR("multi draw indirect is not supported, drawCount: %u", drawCount);
+  bindGraphicsBuffer(cmdBuffer, vk(buffer),
+                     VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
+                     VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT);
+  VK_TRACE(vkCmdDrawIndexedIndirect(vk(cmdBuffer)->v, vk(buffer)->v,
+                                    VkDeviceSize(offset), drawCount, stride));
+}
 
 void VKGraphics::setViewport(CommandBuffer *commandBuffer, Rect2D r) {
   viewport = r;
@@ -238,7 +472,12 @@ void VKGraphics::setScissor(CommandBuffer *commandBuffer, Rect2D r) {
 }
 
 void VKGraphics::waitIdle(CommandBuffer *cmdBuffer) {
-  vk(ctx)->vkDevice.waitIdle();
+  // Wait for the command buffer's last submission, on the queue it was
+  // submitted to, without draining the device
+  if (cmdBuffer && cmdBuffer->queue)
+    cmdBuffer->queue->wait(cmdBuffer->ticket);
+  else
+    vk(ctx)->vkDevice.waitIdle();
 }
 
 Graphics *Graphics::create(GraphicsContext *ctx) {
@@ -19,6 +19,7 @@
  * under the License.
  */
 #include "ngfx/porting/vulkan/VKGraphicsContext.h"
+#include "ngfx/porting/vulkan/VKTexture.h"
 using namespace ngfx;
 using namespace std;
 #define MAX_DESCRIPTOR_SETS MAX_DESCRIPTORS * 4
@@ -35,8 +36,25 @@ void VKGraphicsContext::create(const char *appName, bool enableDepthStencil,
   vkDevice.create(&vkPhysicalDevice);
   vkCommandPool.create(vkDevice.v, vkDevice.queueFamilyIndices.graphics);
   vkQueue.create(this, vkDevice.queueFamilyIndices.graphics, 0);
+  // Fall back to the graphics queue if there's no dedicated compute family
+  auto &queueFamilyIndices = vkDevice.queueFamilyIndices;
+  dedicatedComputeQueue =
+      (queueFamilyIndices.compute != queueFamilyIndices.graphics);
+  if (dedicatedComputeQueue) {
+    vkComputeCommandPool.create(vkDevice.v, queueFamilyIndices.compute);
+    vkComputeQueue.create(this, queueFamilyIndices.compute, 0);
+  } else {
+    vkComputeQueue.create(this, queueFamilyIndices.graphics, 0);
+  }
   initDescriptorPool();
   vkDescriptorSetLayoutCache.create(vkDevice.v);
+  vkFramebufferCache.create(&framebufferCacheStats);
+  if (vkDevice.enableDescriptorIndexing) {
+    vkBindlessHeap.reset(new VKBindlessHeap());
+    vkBindlessHeap->create(this);
+    bindlessHeap = vkBindlessHeap.get();
+  }
+  multiDrawIndirect = vkDevice.enabledFeatures.multiDrawIndirect;
   this->enableDepthStencil = enableDepthStencil;
   depthFormat = PixelFormat(vkPhysicalDevice.depthFormat);
   vkQueryPool.create(vkDevice.v, VK_QUERY_TYPE_TIMESTAMP, 2);
@@ -66,21 +84,44 @@ void VKGraphicsContext::initDescriptorPool() {
 };
 
 RenderPass *VKGraphicsContext::getRenderPass(RenderPassConfig config) {
-  for (auto &r : vkRenderPassCache) {
-    if (r->config == config)
-      return &r->vkRenderPass;
+  auto it = vkRenderPassCache.find(config);
+  if (it != vkRenderPassCache.end()) {
+    renderPassCacheStats.hits++;
+    return &it->second->vkRenderPass;
   }
+  renderPassCacheStats.misses++;
   auto renderPassData = make_unique<VKRenderPassData>();
+  renderPassData->config = config;
   initRenderPass(config, renderPassData->vkRenderPass);
   auto result = &renderPassData->vkRenderPass;
-  vkRenderPassCache.emplace_back(std::move(renderPassData));
+  vkRenderPassCache.emplace(config, std::move(renderPassData));
   return result;
 }
 
+shared_ptr<Framebuffer> VKGraphicsContext::getFramebuffer(
+    RenderPass *renderPass, const vector<Framebuffer::Attachment> &attachments,
+    uint32_t w, uint32_t h, uint32_t layers) {
+  vector<VkImageView> imageViews(attachments.size());
+  for (uint32_t j = 0; j < attachments.size(); j++) {
+    auto &attachment = attachments[j];
+    imageViews[j] = vk(attachment.texture)
+                        ->getImageView(VK_IMAGE_VIEW_TYPE_2D, 1, 1,
+                                       attachment.level, attachment.layer)
+                        ->v;
+  }
+  return vkFramebufferCache.get(vk(renderPass)->v, imageViews, w, h, layers,
+                                [&]() {
+                                  return Framebuffer::create(
+                                      device, renderPass, attachments, w, h,
+                                      layers);
+                                });
+}
+
 void VKGraphicsContext::initRenderPass(const RenderPassConfig &config,
                                        VKRenderPass &renderPass) {
   std::vector<VkAttachmentDescription> attachments;
   uint32_t depthAttachmentBaseIndex = 0;
+  bool readDepthAfterPass = false;
 
   for (uint32_t j = 0; j < config.numColorAttachments(); j++) {
     auto &colorAttachmentDesc = config.colorAttachmentDescriptions[j];
@@ -128,9 +169,16 @@ void VKGraphicsContext::initRenderPass(const RenderPassConfig &config,
         (depthStencilAttachmentDesc->finalLayout)
             ? VkImageLayout(*depthStencilAttachmentDesc->finalLayout)
             : VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    // Keep the depth buffer if it's sampled after the render pass,
+    // e.g. to build a depth pyramid
+    readDepthAfterPass =
+        config.numSamples == 1 &&
+        (finalLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL ||
+         finalLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL);
     attachments.push_back({
          0, depthFormat, VkSampleCountFlagBits(config.numSamples),
-         VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_DONT_CARE,
+         VK_ATTACHMENT_LOAD_OP_CLEAR,
+         readDepthAfterPass ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE,
          VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_DONT_CARE,
          initialLayout, finalLayout
     });
@@ -185,6 +233,25 @@ void VKGraphicsContext::initRenderPass(const RenderPassConfig &config,
           VK_DEPENDENCY_BY_REGION_BIT
       }
   };
+  if (readDepthAfterPass) {
+      // The depth writes must be visible to the shaders that sample
+      // the depth buffer, and these reads must complete before the depth
+      // buffer is cleared by the next render pass
+      dependencies.push_back({
+          VK_SUBPASS_EXTERNAL, 0,
+          VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+          VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+          0, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+          0
+      });
+      dependencies.push_back({
+          0, VK_SUBPASS_EXTERNAL,
+          VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+          VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+          VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+          0
+      });
+  }
 
   renderPass.create(vkDevice.v, attachments, subpasses, dependencies);
 }
@@ -322,6 +389,7 @@ CommandBuffer *VKGraphicsContext::computeCommandBuffer() {
 void VKGraphicsContext::createBindings() {
   device = &vkDevice;
   queue = &vkQueue;
+  computeQueue = &vkComputeQueue;
   defaultRenderPass =
       offscreen ? vkDefaultOffscreenRenderPass : vkDefaultRenderPass;
   defaultOffscreenRenderPass = vkDefaultOffscreenRenderPass;
@@ -19,11 +19,13 @@
  * under the License.
  */
 #include "ngfx/porting/vulkan/VKGraphicsPipeline.h"
+#include "ngfx/core/Trace.h"
 #include "ngfx/graphics/CommandBuffer.h"
 #include "ngfx/graphics/GraphicsContext.h"
 #include "ngfx/porting/vulkan/VKDebugUtil.h"
 #include "ngfx/porting/vulkan/VKGraphicsContext.h"
 #include "ngfx/porting/vulkan/VKShaderModule.h"
+#include <algorithm>
 #include <vector>
 using namespace ngfx;
 
@@ -34,7 +36,9 @@ void VKGraphicsPipeline::create(
     const std::vector<VkVertexInputAttributeDescription> &vertexInputAttributes,
     const std::vector<VKPipeline::ShaderStage> &shaderStages,
     VkFormat colorFormat) {
+  NGFX_TRACE_SCOPE("VKGraphicsPipeline::create");
   this->device = vk(ctx->device)->v;
+  this->descriptors = descriptors;
   VkResult vkResult;
 
   inputAssemblyState = {
@@ -126,19 +130,15 @@ void VKGraphicsPipeline::create(
                          "main",
                          nullptr};
   }
-  descriptorSetLayouts.resize(descriptors.size());
-  for (int j = 0; j < descriptors.size(); j++) {
-    auto &descriptor = descriptors[j];
-    descriptorSetLayouts[j] = ctx->vkDescriptorSetLayoutCache.get(
-        descriptor.type, descriptor.stageFlags);
-  }
+  VKPipelineUtil::getDescriptorSetLayouts(ctx, descriptors,
+                                          descriptorSetLayouts);
   pipelineLayoutCreateInfo = {VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
                               nullptr,
                               0,
                               uint32_t(descriptorSetLayouts.size()),
                               descriptorSetLayouts.data(),
-                              0,
-                              nullptr};
+                              pushConstantRange.size ? 1u : 0u,
+                              &pushConstantRange};
   V(vkCreatePipelineLayout(device, &pipelineLayoutCreateInfo, nullptr,
                            &pipelineLayout));
 
@@ -165,10 +165,6 @@ void VKGraphicsPipeline::create(
                               nullptr, &v));
 }
 
-static std::map<VertexFormat, uint32_t> strideMap = {{VERTEXFORMAT_FLOAT, 4},
-                                                     {VERTEXFORMAT_FLOAT2, 8},
-                                                     {VERTEXFORMAT_FLOAT3, 12},
-                                                     {VERTEXFORMAT_FLOAT4, 16}};
 GraphicsPipeline *
 GraphicsPipeline::create(GraphicsContext *graphicsContext, const State &state,
                          VertexShaderModule *vs, FragmentShaderModule *fs,
@@ -206,35 +202,43 @@ GraphicsPipeline::create(GraphicsContext *graphicsContext, const State &state,
   VKPipelineUtil::parseDescriptors(fs->descriptors,
                                    VK_SHADER_STAGE_FRAGMENT_BIT, vkDescriptors,
                                    descriptorBindings);
+  auto &pushConstantRange = vkGraphicsPipeline->pushConstantRange;
+  VKPipelineUtil::addPushConstantRange(vs, VK_SHADER_STAGE_VERTEX_BIT,
+                                       pushConstantRange);
+  VKPipelineUtil::addPushConstantRange(fs, VK_SHADER_STAGE_FRAGMENT_BIT,
+                                       pushConstantRange);
 
   std::vector<VkVertexInputAttributeDescription> vkVertexInputAttributes;
   auto &vertexAttributeBindings = vkGraphicsPipeline->vertexAttributeBindings;
   vertexAttributeBindings.resize(vs->attributes.size());
-  // TODO: support interleaved vertex bindings
+  auto vertexInputs = getVertexInputs(vs, state.vertexBufferLayouts);
+  std::vector<VkVertexInputBindingDescription> vkVertexInputBindings;
   for (uint32_t j = 0; j < vs->attributes.size(); j++) {
     auto &va = vs->attributes[j];
-    uint32_t binding = va.location, offset = 0;
+    auto &vertexInput = vertexInputs[j];
+    uint32_t offset = vertexInput.offset;
     for (uint32_t k = 0; k < va.count; k++) {
       vkVertexInputAttributes.push_back(
-          {va.location + k, binding, VkFormat(va.format), offset});
+          {va.location + k, vertexInput.binding, VkFormat(va.format), offset});
       offset += va.elementSize;
     }
-    vertexAttributeBindings[j] = j;
+    vertexAttributeBindings[j] = vertexInput.binding;
+    // The attributes of an interleaved layout share the same binding
+    auto it = std::find_if(vkVertexInputBindings.begin(),
+                           vkVertexInputBindings.end(), [&](auto &b) {
+                             return b.binding == vertexInput.binding;
+                           });
+    if (it != vkVertexInputBindings.end())
+      continue;
+    VkVertexInputRate inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    if (instanceAttributes.find(va.name) != instanceAttributes.end())
+      inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+    vkVertexInputBindings.push_back(
+        {vertexInput.binding, vertexInput.stride, inputRate});
   }
   std::vector<VKPipeline::ShaderStage> vkShaderStages = {
       {VK_SHADER_STAGE_VERTEX_BIT, (VKVertexShaderModule *)vs},
       {VK_SHADER_STAGE_FRAGMENT_BIT, (VKFragmentShaderModule *)fs}};
-  std::vector<VkVertexInputBindingDescription> vkVertexInputBindings(
-      vs->attributes.size());
-  for (uint32_t j = 0; j < vs->attributes.size(); j++) {
-    auto &attr = vs->attributes[j];
-    uint32_t binding = attr.location;
-    VkVertexInputRate inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-    if (instanceAttributes.find(attr.name) != instanceAttributes.end())
-      inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
-    vkVertexInputBindings[j] = {binding, attr.elementSize * attr.count,
-                                inputRate};
-  }
   vkGraphicsPipeline->create(vk(graphicsContext), vkState, vkDescriptors,
                              vkVertexInputBindings, vkVertexInputAttributes,
                              vkShaderStages, VkFormat(colorFormat));
@@ -67,6 +67,18 @@ void VKInstance::create(const char *appName, const char *engineName,
       instanceExtensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
     }
   }
+  uint32_t instanceExtensionCount;
+  vkEnumerateInstanceExtensionProperties(nullptr, &instanceExtensionCount,
+                                         nullptr);
+  instanceExtensionProperties.resize(instanceExtensionCount);
+  vkEnumerateInstanceExtensionProperties(nullptr, &instanceExtensionCount,
+                                         instanceExtensionProperties.data());
+  if (hasInstanceExtension(
+          VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME)) {
+    instanceExtensions.push_back(
+        VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+    enablePhysicalDeviceProperties2 = true;
+  }
 
   createInfo = {};
   createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -89,6 +101,15 @@ bool VKInstance::hasInstanceLayer(const char *name) {
   return false;
 }
 
+bool VKInstance::hasInstanceExtension(const char *name) {
+  for (VkExtensionProperties &props : instanceExtensionProperties) {
+    if (strcmp(props.extensionName, name) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
 VKInstance::~VKInstance() {
   if (v)
     VK_TRACE(vkDestroyInstance(v, nullptr));
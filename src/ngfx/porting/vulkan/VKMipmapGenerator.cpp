@@ -0,0 +1,246 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "ngfx/porting/vulkan/VKMipmapGenerator.h"
+#include "ngfx/porting/vulkan/VKDebugUtil.h"
+#include "ngfx/porting/vulkan/VKGraphicsContext.h"
+#include "ngfx/porting/vulkan/VKTexture.h"
+#include <algorithm>
+using namespace ngfx;
+
+#define NUM_BINDINGS (MAX_LEVELS_PER_DISPATCH + 1)
+
+void VKMipmapGenerator::create(VKGraphicsContext *ctx) {
+  VkResult vkResult;
+  this->ctx = ctx;
+  device = ctx->vkDevice.v;
+  // binding 0: source level, bindings 1..N: destination levels
+  std::vector<VkDescriptorSetLayoutBinding> layoutBindings(NUM_BINDINGS);
+  for (uint32_t j = 0; j < NUM_BINDINGS; j++)
+    layoutBindings[j] = {j, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1,
+                         VK_SHADER_STAGE_COMPUTE_BIT, nullptr};
+  VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo = {
+      VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO, nullptr, 0,
+      uint32_t(layoutBindings.size()), layoutBindings.data()};
+  V(vkCreateDescriptorSetLayout(device, &descriptorSetLayoutCreateInfo,
+                                nullptr, &descriptorSetLayout));
+  VkPushConstantRange pushConstantRange = {VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                                           sizeof(PushConstants)};
+  VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {
+      VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+      nullptr,
+      0,
+      1,
+      &descriptorSetLayout,
+      1,
+      &pushConstantRange};
+  V(vkCreatePipelineLayout(device, &pipelineLayoutCreateInfo, nullptr,
+                           &pipelineLayout));
+  shaderModule.initFromFile(device, NGFX_DATA_DIR "/generateMipmaps.comp");
+  VkPipelineShaderStageCreateInfo shaderStageCreateInfo = {
+      VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+      nullptr,
+      0,
+      VK_SHADER_STAGE_COMPUTE_BIT,
+      shaderModule.v,
+      "main",
+      nullptr};
+  VkComputePipelineCreateInfo createInfo = {
+      VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+      nullptr,
+      0,
+      shaderStageCreateInfo,
+      pipelineLayout,
+      0,
+      0};
+  V(vkCreateComputePipelines(device, ctx->vkPipelineCache.v, 1, &createInfo,
+                             nullptr, &pipeline));
+}
+
+VKMipmapGenerator::~VKMipmapGenerator() {
+  for (auto descriptorPool : descriptorPools)
+    VK_TRACE(vkDestroyDescriptorPool(device, descriptorPool, nullptr));
+  if (pipeline)
+    VK_TRACE(vkDestroyPipeline(device, pipeline, nullptr));
+  if (pipelineLayout)
+    VK_TRACE(vkDestroyPipelineLayout(device, pipelineLayout, nullptr));
+  if (descriptorSetLayout)
+    VK_TRACE(
+        vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr));
+}
+
+bool VKMipmapGenerator::isFormatSupported(VKDevice *device, VkFormat format) {
+  if (format == VK_FORMAT_R8G8B8A8_SRGB) {
+    if (!device->enableMaintenance2)
+      return false;
+  } else if (format != VK_FORMAT_R8G8B8A8_UNORM)
+    return false;
+  VkFormatProperties formatProperties;
+  VK_TRACE(vkGetPhysicalDeviceFormatProperties(device->vkPhysicalDevice->v,
+                                               VK_FORMAT_R8G8B8A8_UNORM,
+                                               &formatProperties));
+  return formatProperties.optimalTilingFeatures &
+         VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT;
+}
+
+VKMipmapGenerator::DescriptorSet VKMipmapGenerator::allocateDescriptorSet() {
+  VkResult vkResult;
+  VkDescriptorSet descriptorSet;
+  // Use the first pool with a free descriptor set
+  for (auto descriptorPool : descriptorPools) {
+    VkDescriptorSetAllocateInfo allocInfo = {
+        VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO, nullptr,
+        descriptorPool, 1, &descriptorSetLayout};
+    vkResult = vkAllocateDescriptorSets(device, &allocInfo, &descriptorSet);
+    if (vkResult == VK_SUCCESS)
+      return {descriptorPool, descriptorSet};
+    if (vkResult != VK_ERROR_OUT_OF_POOL_MEMORY &&
+        vkResult != VK_ERROR_FRAGMENTED_POOL)
+      NGFX_ERR("vkAllocateDescriptorSets failed: %d", vkResult);
+  }
+  VkDescriptorPoolSize poolSize = {
+      VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+      MAX_DESCRIPTOR_SETS_PER_POOL * NUM_BINDINGS};
+  VkDescriptorPoolCreateInfo poolCreateInfo = {
+      VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+      nullptr,
+      VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT,
+      MAX_DESCRIPTOR_SETS_PER_POOL,
+      1,
+      &poolSize};
+  VkDescriptorPool descriptorPool;
+  V(vkCreateDescriptorPool(device, &poolCreateInfo, nullptr,
+                           &descriptorPool));
+  descriptorPools.push_back(descriptorPool);
+  VkDescriptorSetAllocateInfo allocInfo = {
+      VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO, nullptr, descriptorPool,
+      1, &descriptorSetLayout};
+  V(vkAllocateDescriptorSets(device, &allocInfo, &descriptorSet));
+  return {descriptorPool, descriptorSet};
+}
+
+void VKMipmapGenerator::freeDescriptorSets(VKTexture *texture) {
+  VkResult vkResult;
+  for (auto &it : texture->mipmapDescriptorSets)
+    V(vkFreeDescriptorSets(device, it.second.pool, 1, &it.second.v));
+  texture->mipmapDescriptorSets.clear();
+}
+
+VkDescriptorSet VKMipmapGenerator::getDescriptorSet(VKTexture *texture,
+                                                    uint32_t srcLevel) {
+  auto &descriptorSets = texture->mipmapDescriptorSets;
+  auto it = descriptorSets.find(srcLevel);
+  if (it != descriptorSets.end())
+    return it->second.v;
+  auto &imageViews = texture->mipmapImageViews;
+  if (imageViews.empty()) {
+    // One storage view per level, sRGB textures are accessed through
+    // a UNORM view
+    imageViews.resize(texture->mipLevels);
+    for (uint32_t j = 0; j < texture->mipLevels; j++) {
+      imageViews[j].reset(new VKImageView());
+      imageViews[j]->create(device, texture->vkImage.v,
+                            VK_IMAGE_VIEW_TYPE_2D_ARRAY,
+                            VK_FORMAT_R8G8B8A8_UNORM, texture->aspectFlags, 1,
+                            texture->arrayLayers, j, 0);
+    }
+  }
+  DescriptorSet descriptorSet = allocateDescriptorSet();
+  // Unused destination bindings point to the last level,
+  // the shader doesn't write to them
+  uint32_t lastLevel = texture->mipLevels - 1;
+  std::vector<VkDescriptorImageInfo> imageInfos(NUM_BINDINGS);
+  std::vector<VkWriteDescriptorSet> writeDescriptorSets(NUM_BINDINGS);
+  for (uint32_t j = 0; j < NUM_BINDINGS; j++) {
+    uint32_t level = std::min(srcLevel + j, lastLevel);
+    imageInfos[j] = {VK_NULL_HANDLE, imageViews[level]->v,
+                     VK_IMAGE_LAYOUT_GENERAL};
+    writeDescriptorSets[j] = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                              nullptr,
+                              descriptorSet.v,
+                              j,
+                              0,
+                              1,
+                              VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+                              &imageInfos[j],
+                              nullptr,
+                              nullptr};
+  }
+  VK_TRACE(vkUpdateDescriptorSets(device, uint32_t(writeDescriptorSets.size()),
+                                  writeDescriptorSets.data(), 0, nullptr));
+  descriptorSets[srcLevel] = descriptorSet;
+  return descriptorSet.v;
+}
+
+void VKMipmapGenerator::generateMipmaps(VkCommandBuffer cmdBuffer,
+                                        VKTexture *texture,
+                                        MipmapFilter filter) {
+  auto &vkImage = texture->vkImage;
+  uint32_t mipLevels = texture->mipLevels, arrayLayers = texture->arrayLayers;
+  auto aspectFlags = texture->aspectFlags;
+  vkImage.changeLayout(cmdBuffer, VK_IMAGE_LAYOUT_GENERAL,
+                       VK_ACCESS_SHADER_READ_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, aspectFlags, 0, 1,
+                       0, arrayLayers);
+  vkImage.changeLayout(cmdBuffer, VK_IMAGE_LAYOUT_GENERAL,
+                       VK_ACCESS_SHADER_WRITE_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, aspectFlags, 1,
+                       mipLevels - 1, 0, arrayLayers);
+  VK_TRACE(vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                             pipeline));
+  // The Kaiser filter reads a 4x4 footprint from the source level,
+  // so each dispatch only writes one level
+  uint32_t maxLevelsPerDispatch =
+      (filter == MIPMAP_FILTER_KAISER) ? 1 : MAX_LEVELS_PER_DISPATCH;
+  PushConstants pushConstants;
+  pushConstants.filter = int32_t(filter);
+  pushConstants.srgb = (texture->vkFormat == VK_FORMAT_R8G8B8A8_SRGB);
+  pushConstants.padding = 0;
+  for (uint32_t srcLevel = 0; srcLevel < (mipLevels - 1);) {
+    uint32_t numLevels =
+        std::min(maxLevelsPerDispatch, mipLevels - 1 - srcLevel);
+    pushConstants.numLevels = int32_t(numLevels);
+    VkDescriptorSet descriptorSet = getDescriptorSet(texture, srcLevel);
+    VK_TRACE(vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                                     pipelineLayout, 0, 1, &descriptorSet, 0,
+                                     nullptr));
+    VK_TRACE(vkCmdPushConstants(cmdBuffer, pipelineLayout,
+                                VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                                sizeof(pushConstants), &pushConstants));
+    uint32_t dstW = std::max(texture->w >> (srcLevel + 1), 1u),
+             dstH = std::max(texture->h >> (srcLevel + 1), 1u);
+    VK_TRACE(vkCmdDispatch(cmdBuffer, (dstW + TILE_SIZE - 1) / TILE_SIZE,
+                           (dstH + TILE_SIZE - 1) / TILE_SIZE, arrayLayers));
+    srcLevel += numLevels;
+    if (srcLevel < (mipLevels - 1)) {
+      VkMemoryBarrier memoryBarrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+                                       nullptr, VK_ACCESS_SHADER_WRITE_BIT,
+                                       VK_ACCESS_SHADER_READ_BIT};
+      VK_TRACE(vkCmdPipelineBarrier(cmdBuffer,
+                                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1,
+                                    &memoryBarrier, 0, nullptr, 0, nullptr));
+    }
+  }
+  for (uint32_t j = 0; j < vkImage.accessMask.size(); j++) {
+    vkImage.accessMask[j] = VK_ACCESS_SHADER_WRITE_BIT;
+    vkImage.stageMask[j] = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+  }
+}
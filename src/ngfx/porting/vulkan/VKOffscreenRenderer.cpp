@@ -0,0 +1,168 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "ngfx/porting/vulkan/VKOffscreenRenderer.h"
+#include "ngfx/core/Trace.h"
+#include "ngfx/porting/vulkan/VKDebugUtil.h"
+#include "ngfx/porting/vulkan/VKGraphicsContext.h"
+#include "ngfx/porting/vulkan/VKQueue.h"
+#include "ngfx/porting/vulkan/VKTexture.h"
+using namespace ngfx;
+
+static VkMemoryPropertyFlags
+getReadbackMemoryFlags(VKPhysicalDevice *physicalDevice) {
+  // Prefer cached memory, reading from uncached memory is very slow
+  VkMemoryPropertyFlags cachedFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                      VK_MEMORY_PROPERTY_HOST_COHERENT_BIT |
+                                      VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+  auto &memoryProperties = physicalDevice->deviceMemoryProperties;
+  for (uint32_t j = 0; j < memoryProperties.memoryTypeCount; j++) {
+    if ((memoryProperties.memoryTypes[j].propertyFlags & cachedFlags) ==
+        cachedFlags)
+      return cachedFlags;
+  }
+  return VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+         VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+}
+
+void VKOffscreenRenderer::create(VKGraphicsContext *ctx, Graphics *graphics,
+                                 uint32_t w, uint32_t h, uint32_t numFrames,
+                                 bool enableDepthStencil) {
+  this->ctx = ctx;
+  this->graphics = graphics;
+  this->w = w;
+  this->h = h;
+  this->numFrames = numFrames;
+  size = w * h * 4;
+  auto device = ctx->vkDevice.v;
+  VkMemoryPropertyFlags readbackMemoryFlags =
+      getReadbackMemoryFlags(&ctx->vkPhysicalDevice);
+  // The default offscreen render pass has a depth attachment if the
+  // context does, so the render pass is created from the arguments
+  GraphicsContext::RenderPassConfig renderPassConfig = {
+      {{PIXELFORMAT_RGBA8_UNORM, std::nullopt, std::nullopt}},
+      std::nullopt,
+      false,
+      1};
+  if (enableDepthStencil)
+    renderPassConfig.depthStencilAttachmentDescription = {
+        ctx->depthFormat, std::nullopt, std::nullopt};
+  renderPass = ctx->getRenderPass(renderPassConfig);
+  slots.resize(numFrames);
+  for (auto &slot : slots) {
+    slot.reset(new Slot());
+    slot->outputTexture.reset(Texture::create(
+        ctx, graphics, nullptr, PIXELFORMAT_RGBA8_UNORM, size, w, h, 1, 1,
+        ImageUsageFlags(IMAGE_USAGE_SAMPLED_BIT | IMAGE_USAGE_TRANSFER_SRC_BIT |
+                        IMAGE_USAGE_COLOR_ATTACHMENT_BIT)));
+    std::vector<Framebuffer::Attachment> attachments = {
+        {slot->outputTexture.get()}};
+    if (enableDepthStencil) {
+      slot->depthTexture.reset(Texture::create(
+          ctx, graphics, nullptr, ctx->depthFormat, size, w, h, 1, 1,
+          IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT));
+      attachments.push_back({slot->depthTexture.get()});
+    }
+    slot->outputFramebuffer.reset(Framebuffer::create(
+        ctx->device, renderPass, attachments, w, h));
+    slot->commandBuffer.create(device, ctx->vkCommandPool.v);
+    slot->fence.create(device);
+    slot->readbackBuffer.create(ctx, nullptr, size,
+                                VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                readbackMemoryFlags);
+    slot->readbackData = slot->readbackBuffer.map();
+  }
+}
+
+VKOffscreenRenderer::~VKOffscreenRenderer() {
+  for (auto &slot : slots) {
+    if (slot->pending)
+      slot->fence.wait();
+    slot->readbackBuffer.unmap();
+  }
+}
+
+void VKOffscreenRenderer::readback(Slot &slot) {
+  NGFX_TRACE_SCOPE("VKOffscreenRenderer::readback");
+  slot.fence.wait();
+  slot.fence.reset();
+  slot.pending = false;
+  if (onFrameReady)
+    onFrameReady({slot.frameIndex, w, h, size, slot.readbackData});
+}
+
+void VKOffscreenRenderer::renderFrame(RecordFn record) {
+  NGFX_TRACE_SCOPE("VKOffscreenRenderer::renderFrame");
+  auto &slot = *slots[frameIndex % numFrames];
+  if (slot.pending)
+    readback(slot);
+  auto &commandBuffer = slot.commandBuffer;
+  auto outputTexture = vk(slot.outputTexture.get());
+  commandBuffer.begin();
+  outputTexture->changeLayout(&commandBuffer,
+                              IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+  graphics->beginRenderPass(&commandBuffer, renderPass,
+                            slot.outputFramebuffer.get(), ctx->clearColor);
+  graphics->setViewport(&commandBuffer, {0, 0, w, h});
+  graphics->setScissor(&commandBuffer, {0, 0, w, h});
+  record(&commandBuffer, frameIndex);
+  graphics->endRenderPass(&commandBuffer);
+  outputTexture->downloadFn(commandBuffer.v, nullptr, size,
+                            &slot.readbackBuffer);
+  // Make the copy visible to the host when the fence is signaled
+  VkBufferMemoryBarrier bufferMemoryBarrier = {
+      VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+      nullptr,
+      VK_ACCESS_TRANSFER_WRITE_BIT,
+      VK_ACCESS_HOST_READ_BIT,
+      VK_QUEUE_FAMILY_IGNORED,
+      VK_QUEUE_FAMILY_IGNORED,
+      slot.readbackBuffer.v,
+      0,
+      VK_WHOLE_SIZE};
+  VK_TRACE(vkCmdPipelineBarrier(commandBuffer.v, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1,
+                                &bufferMemoryBarrier, 0, nullptr));
+  commandBuffer.end();
+  vk(ctx->queue)->submit(&commandBuffer,
+                         VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, {}, {},
+                         &slot.fence);
+  slot.frameIndex = frameIndex++;
+  slot.pending = true;
+}
+
+void VKOffscreenRenderer::flush() {
+  uint64_t firstFrame = frameIndex > numFrames ? frameIndex - numFrames : 0;
+  for (uint64_t j = firstFrame; j < frameIndex; j++) {
+    auto &slot = *slots[j % numFrames];
+    if (slot.pending)
+      readback(slot);
+  }
+}
+
+OffscreenRenderer *OffscreenRenderer::create(GraphicsContext *ctx,
+                                             Graphics *graphics, uint32_t w,
+                                             uint32_t h, uint32_t numFrames,
+                                             bool enableDepthStencil) {
+  VKOffscreenRenderer *vkOffscreenRenderer = new VKOffscreenRenderer();
+  vkOffscreenRenderer->create(vk(ctx), graphics, w, h, numFrames,
+                              enableDepthStencil);
+  return vkOffscreenRenderer;
+}
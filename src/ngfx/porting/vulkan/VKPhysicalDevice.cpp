@@ -47,6 +47,48 @@ void VKPhysicalDevice::getProperties() {
     }
   }
 }
+void VKPhysicalDevice::getExtendedProperties(VkInstance instance) {
+  // The entry points are null if the extension isn't enabled
+  auto getFeatures2 = reinterpret_cast<PFN_vkGetPhysicalDeviceFeatures2KHR>(
+      vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceFeatures2KHR"));
+  auto getProperties2 =
+      reinterpret_cast<PFN_vkGetPhysicalDeviceProperties2KHR>(
+          vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceProperties2KHR"));
+  if (!getFeatures2 || !getProperties2)
+    return;
+  VkPhysicalDeviceFeatures2KHR features2 = {
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR, nullptr};
+  bool timelineSemaphore =
+      extensionSupported(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+  if (timelineSemaphore) {
+    timelineSemaphoreFeatures.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+    features2.pNext = &timelineSemaphoreFeatures;
+  }
+  bool descriptorIndexing =
+      extensionSupported(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+  if (descriptorIndexing) {
+    descriptorIndexingFeatures.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+    descriptorIndexingFeatures.pNext = features2.pNext;
+    features2.pNext = &descriptorIndexingFeatures;
+  }
+  if (!features2.pNext)
+    return;
+  getFeatures2(v, &features2);
+  // The structures are stored separately
+  timelineSemaphoreFeatures.pNext = nullptr;
+  descriptorIndexingFeatures.pNext = nullptr;
+  if (!descriptorIndexing)
+    return;
+  descriptorIndexingProperties.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
+  VkPhysicalDeviceProperties2KHR properties2 = {
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2_KHR,
+      &descriptorIndexingProperties};
+  getProperties2(v, &properties2);
+}
+
 void VKPhysicalDevice::selectDevice(VkInstance instance) {
   VkResult vkResult;
   uint32_t gpuCount = 0;
@@ -120,6 +162,7 @@ VKPhysicalDevice::getMemoryType(uint32_t type,
 void VKPhysicalDevice::create(VkInstance instance) {
   selectDevice(instance);
   getProperties();
+  getExtendedProperties(instance);
   chooseDepthFormat();
 }
 
@@ -19,7 +19,10 @@
  * under the License.
  */
 #include "ngfx/porting/vulkan/VKPipeline.h"
+#include "ngfx/porting/vulkan/VKBindlessHeap.h"
 #include "ngfx/porting/vulkan/VKDebugUtil.h"
+#include "ngfx/porting/vulkan/VKGraphicsContext.h"
+#include <algorithm>
 using namespace ngfx;
 
 VKPipeline::~VKPipeline() {
@@ -29,6 +32,44 @@ VKPipeline::~VKPipeline() {
     VK_TRACE(vkDestroyPipeline(device, v, nullptr));
 }
 
+void VKPipelineUtil::getDescriptorSetLayouts(
+    VKGraphicsContext *ctx,
+    const std::vector<VKPipeline::Descriptor> &descriptors,
+    std::vector<VkDescriptorSetLayout> &layouts) {
+  layouts.resize(descriptors.size());
+  for (uint32_t j = 0; j < descriptors.size(); j++) {
+    auto &descriptor = descriptors[j];
+    if (descriptor.bindless) {
+      if (!ctx->vkBindlessHeap)
+        NGFX_ERR("bindless descriptors are not supported by the device");
+      layouts[j] =
+          ctx->vkBindlessHeap->getDescriptorSetLayout(descriptor.type);
+    } else {
+      layouts[j] = ctx->vkDescriptorSetLayoutCache.get(descriptor.type,
+                                                       descriptor.stageFlags);
+    }
+  }
+}
+
+void VKPipelineUtil::addPushConstantRange(ShaderModule *shaderModule,
+                                          VkShaderStageFlagBits shaderStage,
+                                          VkPushConstantRange &range) {
+  auto &stageRange = shaderModule->pushConstantRange;
+  if (stageRange.size == 0)
+    return;
+  // A single range visible to all the stages that use push constants,
+  // so that a push doesn't need to match the per-stage ranges
+  if (range.size == 0) {
+    range = {VkShaderStageFlags(shaderStage), stageRange.offset,
+             stageRange.size};
+    return;
+  }
+  uint32_t begin = std::min(range.offset, stageRange.offset),
+           end = std::max(range.offset + range.size,
+                          stageRange.offset + stageRange.size);
+  range = {range.stageFlags | shaderStage, begin, end - begin};
+}
+
 void VKPipelineUtil::parseDescriptors(
     std::vector<ShaderModule::DescriptorInfo> &descriptors,
     VkShaderStageFlagBits shaderStage,
@@ -39,6 +80,7 @@ void VKPipelineUtil::parseDescriptors(
     auto &vkDesc = vkDescriptors[descriptor.set];
     vkDesc.type = VkDescriptorType(descriptor.type);
     vkDesc.stageFlags |= shaderStage;
+    vkDesc.bindless = descriptor.bindless;
     descriptorBindings[descriptor.set] = descriptor.set;
   }
 };
@@ -19,6 +19,7 @@
  * under the License.
  */
 #include "ngfx/porting/vulkan/VKQueue.h"
+#include "ngfx/core/Trace.h"
 #include "ngfx/porting/vulkan/VKCommandBuffer.h"
 #include "ngfx/porting/vulkan/VKDebugUtil.h"
 #include "ngfx/porting/vulkan/VKFence.h"
@@ -31,10 +32,14 @@ void VKQueue::create(VKGraphicsContext *ctx, int queueFamilyIndex,
                      int queueIndex) {
   this->ctx = ctx;
   VK_TRACE(vkGetDeviceQueue(ctx->vkDevice.v, queueFamilyIndex, queueIndex, &v));
+  enableTimeline = ctx->vkDevice.enableTimelineSemaphore;
+  if (enableTimeline)
+    timelineSemaphore.createTimeline(&ctx->vkDevice);
 }
 VKQueue::~VKQueue() {}
 
 void VKQueue::present() {
+  NGFX_TRACE_SCOPE("VKQueue::present");
   VkResult vkResult;
   Swapchain *swapChain = ctx->swapchain;
   uint32_t currentImageIndex = ctx->currentImageIndex;
@@ -54,44 +59,116 @@ void VKQueue::present() {
 void VKQueue::submit(CommandBuffer *commandBuffer) {
   if (commandBuffer == &ctx->vkComputeCommandBuffer) {
     submit(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, {}, {},
-           ctx->computeFence);
+           enableTimeline ? nullptr : ctx->computeFence);
   } else if (commandBuffer == &ctx->vkCopyCommandBuffer) {
     submit(commandBuffer, 0, {}, {}, nullptr);
-  } else if (ctx->offscreen && commandBuffer == &ctx->vkDrawCommandBuffers[0]) {
-    submit(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, {}, {},
-           nullptr);
   } else {
-    submit(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-           {ctx->presentCompleteSemaphore}, {ctx->renderCompleteSemaphore},
-           ctx->frameFences[ctx->currentImageIndex]);
+    std::vector<VkPipelineStageFlags> waitStageMasks = frameWaitStageMasks;
+    std::vector<Semaphore *> waitSemaphores = frameWaitSemaphores,
+                             signalSemaphores = frameSignalSemaphores;
+    Fence *waitFence = nullptr;
+    // Without a swapchain, no command buffer waits for the presentation
+    if (!ctx->offscreen) {
+      waitStageMasks.push_back(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+      waitSemaphores.push_back(ctx->presentCompleteSemaphore);
+      signalSemaphores.push_back(ctx->renderCompleteSemaphore);
+      // With timeline semaphores the swapchain waits on the ticket of
+      // the image's command buffer instead
+      if (!enableTimeline)
+        waitFence = ctx->frameFences[ctx->currentImageIndex];
+    }
+    frameWaitStageMasks.clear();
+    frameWaitSemaphores.clear();
+    frameSignalSemaphores.clear();
+    submit(commandBuffer, waitStageMasks, waitSemaphores, signalSemaphores,
+           waitFence);
   }
 }
-void VKQueue::submit(CommandBuffer *commandBuffer,
-                     VkPipelineStageFlags waitStageMask,
-                     const std::vector<Semaphore *> &waitSemaphores,
-                     const std::vector<Semaphore *> &signalSemaphores,
-                     Fence *waitFence) {
+uint64_t VKQueue::submit(CommandBuffer *commandBuffer,
+                         VkPipelineStageFlags waitStageMask,
+                         const std::vector<Semaphore *> &waitSemaphores,
+                         const std::vector<Semaphore *> &signalSemaphores,
+                         Fence *waitFence) {
+  std::vector<VkPipelineStageFlags> waitStageMasks(waitSemaphores.size(),
+                                                   waitStageMask);
+  return submit(commandBuffer, waitStageMasks, waitSemaphores,
+                signalSemaphores, waitFence);
+}
+uint64_t
+VKQueue::submit(CommandBuffer *commandBuffer,
+                const std::vector<VkPipelineStageFlags> &waitStageMasks,
+                const std::vector<Semaphore *> &waitSemaphores,
+                const std::vector<Semaphore *> &signalSemaphores,
+                Fence *waitFence) {
+  NGFX_TRACE_SCOPE("VKQueue::submit");
   VkResult vkResult;
+  uint64_t ticket = ++lastTicket;
+  commandBuffer->ticket = ticket;
+  commandBuffer->queue = this;
+  ctx->vkFramebufferCache.onSubmit(commandBuffer, this, ticket);
+  if (ctx->vkBindlessHeap)
+    ctx->vkBindlessHeap->onSubmit(commandBuffer, this, ticket);
+  // The values are ignored for binary semaphores
   std::vector<VkSemaphore> vkWaitSemaphores(waitSemaphores.size());
-  for (size_t j = 0; j < waitSemaphores.size(); j++)
+  std::vector<uint64_t> waitValues(waitSemaphores.size());
+  for (size_t j = 0; j < waitSemaphores.size(); j++) {
     vkWaitSemaphores[j] = vk(waitSemaphores[j])->v;
+    waitValues[j] = vk(waitSemaphores[j])->signalValue;
+  }
   std::vector<VkSemaphore> vkSignalSemaphores(signalSemaphores.size());
-  for (size_t j = 0; j < signalSemaphores.size(); j++)
-    vkSignalSemaphores[j] = vk(signalSemaphores[j])->v;
+  std::vector<uint64_t> signalValues(signalSemaphores.size());
+  for (size_t j = 0; j < signalSemaphores.size(); j++) {
+    auto semaphore = vk(signalSemaphores[j]);
+    vkSignalSemaphores[j] = semaphore->v;
+    if (semaphore->type == VK_SEMAPHORE_TYPE_TIMELINE_KHR)
+      signalValues[j] = ++semaphore->signalValue;
+  }
+  if (enableTimeline) {
+    vkSignalSemaphores.push_back(timelineSemaphore.v);
+    signalValues.push_back(ticket);
+    timelineSemaphore.signalValue = ticket;
+  }
+  VkTimelineSemaphoreSubmitInfoKHR timelineSubmitInfo = {
+      VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR,
+      nullptr,
+      uint32_t(waitValues.size()),
+      waitValues.data(),
+      uint32_t(signalValues.size()),
+      signalValues.data()};
   VkSubmitInfo submitInfo = {VK_STRUCTURE_TYPE_SUBMIT_INFO,
-                             nullptr,
+                             enableTimeline ? &timelineSubmitInfo : nullptr,
                              uint32_t(vkWaitSemaphores.size()),
                              vkWaitSemaphores.data(),
-                             &waitStageMask,
+                             waitStageMasks.data(),
                              1,
                              &vk(commandBuffer)->v,
                              uint32_t(vkSignalSemaphores.size()),
                              vkSignalSemaphores.data()};
   V(vkQueueSubmit(v, 1, &submitInfo,
                   waitFence ? vk(waitFence)->v : VK_NULL_HANDLE));
+  return ticket;
 }
 
 void VKQueue::waitIdle() {
   VkResult vkResult;
   V(vkQueueWaitIdle(v));
+  completedTicketValue = lastTicket;
+}
+
+uint64_t VKQueue::completedTicket() {
+  if (enableTimeline)
+    completedTicketValue = timelineSemaphore.getValue();
+  return completedTicketValue;
+}
+
+void VKQueue::wait(uint64_t ticket) {
+  NGFX_TRACE_SCOPE("VKQueue::wait");
+  if (ticket <= completedTicketValue)
+    return;
+  if (!enableTimeline) {
+    waitIdle();
+    return;
+  }
+  timelineSemaphore.wait(ticket, UINT64_MAX);
+  completedTicketValue = ticket;
 }
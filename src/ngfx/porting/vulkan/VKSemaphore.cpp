@@ -29,27 +29,54 @@ void VKSemaphore::create(VkDevice device) {
   V(vkCreateSemaphore(device, &createInfo, nullptr, &v));
 }
 
+void VKSemaphore::createTimeline(VKDevice *vkDevice, uint64_t initialValue) {
+  this->device = vkDevice->v;
+  this->vkDevice = vkDevice;
+  VkResult vkResult;
+  type = VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+  signalValue = initialValue;
+  typeCreateInfo = {VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR, nullptr,
+                    type, initialValue};
+  createInfo = {VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO, &typeCreateInfo, 0};
+  V(vkCreateSemaphore(device, &createInfo, nullptr, &v));
+}
+
 VKSemaphore::~VKSemaphore() {
   if (v)
     VK_TRACE(vkDestroySemaphore(device, v, nullptr));
 }
 
 uint64_t VKSemaphore::wait() {
-  /*VkResult vkResult;
-  uint64_t value;
-  VkSemaphoreWaitInfo waitInfo = {
-      VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO, nullptr, 0,
-      1, &v, &value
-  };
-  V(vkWaitSemaphores(device, &waitInfo, UINT64_MAX));
-  return value;*/
-  return 0;
+  if (type != VK_SEMAPHORE_TYPE_TIMELINE_KHR)
+    return 0;
+  wait(signalValue, UINT64_MAX);
+  return signalValue;
 }
 
 void VKSemaphore::signal(uint64_t value) {
-  /*VkResult vkResult;
-  VkSemaphoreSignalInfo signalInfo = {
-  VK_STRUCTURE_TYPE_SEMAPHORE_SIGNAL_INFO, nullptr, v, value
-  };
-  V(vkSignalSemaphore(device, &signalInfo));*/
+  if (type != VK_SEMAPHORE_TYPE_TIMELINE_KHR)
+    return;
+  VkResult vkResult;
+  VkSemaphoreSignalInfoKHR signalInfo = {
+      VK_STRUCTURE_TYPE_SEMAPHORE_SIGNAL_INFO_KHR, nullptr, v, value};
+  V(vkDevice->signalSemaphore(device, &signalInfo));
+  signalValue = value;
+}
+
+bool VKSemaphore::wait(uint64_t value, uint64_t timeout) {
+  VkSemaphoreWaitInfoKHR waitInfo = {VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR,
+                                     nullptr, 0, 1, &v, &value};
+  VkResult vkResult = vkDevice->waitSemaphores(device, &waitInfo, timeout);
+  if (vkResult == VK_TIMEOUT)
+    return false;
+  if (vkResult != VK_SUCCESS)
+    NGFX_ERR("vkWaitSemaphoresKHR failed: %d", vkResult);
+  return true;
+}
+
+uint64_t VKSemaphore::getValue() {
+  VkResult vkResult;
+  uint64_t value;
+  V(vkDevice->getSemaphoreCounterValue(device, v, &value));
+  return value;
 }
@@ -19,6 +19,7 @@
  * under the License.
  */
 #include "ngfx/porting/vulkan/VKShaderModule.h"
+#include "ngfx/core/Trace.h"
 #include "ngfx/core/File.h"
 #include "ngfx/graphics/Config.h"
 #include "ngfx/porting/vulkan/VKDebugUtil.h"
@@ -28,6 +29,7 @@ using namespace std;
 
 void VKShaderModule::initFromFile(VkDevice device,
                                   const std::string &filename) {
+  NGFX_TRACE_SCOPE("VKShaderModule::initFromFile");
   File file;
 #ifdef USE_PRECOMPILED_SHADERS
   file.read(filename + ".spv");
@@ -209,6 +209,11 @@ void VKSwapchain::acquireNextImage() {
   uint32_t *imageIndex = &ctx->currentImageIndex;
   V(vkAcquireNextImageKHR(device, v, UINT64_MAX, vk(semaphore)->v,
                           VK_NULL_HANDLE, imageIndex));
+  // Wait until the image's previous frame has completed
+  if (ctx->vkQueue.enableTimeline) {
+    ctx->vkQueue.wait(ctx->drawCommandBuffer()->ticket);
+    return;
+  }
   auto waitFence = ctx->frameFences[ctx->currentImageIndex];
   waitFence->wait();
   waitFence->reset();
@@ -19,6 +19,8 @@
  * under the License.
  */
 #include "ngfx/porting/vulkan/VKTexture.h"
+#include "ngfx/core/Trace.h"
+#include "ngfx/graphics/PixelFormatUtil.h"
 #include "ngfx/porting/vulkan/VKBlit.h"
 #include "ngfx/porting/vulkan/VKBuffer.h"
 #include "ngfx/porting/vulkan/VKCommandBuffer.h"
@@ -33,7 +35,8 @@ void VKTexture::create(VKGraphicsContext *ctx, void *data, uint32_t size,
                        VkImageUsageFlags imageUsageFlags,
                        VkImageViewType imageViewType, bool genMipmaps,
                        VKSamplerCreateInfo *pSamplerCreateInfo,
-                       uint32_t numSamples) {
+                       uint32_t numSamples, uint32_t mipLevels) {
+  NGFX_TRACE_SCOPE("VKTexture::create");
   this->ctx = ctx;
   this->w = extent.width;
   this->h = extent.height;
@@ -62,13 +65,49 @@ void VKTexture::create(VKGraphicsContext *ctx, void *data, uint32_t size,
     imageType = VK_IMAGE_TYPE_3D;
   this->mipLevels =
       genMipmaps ? floor(log2(float(glm::min(extent.width, extent.height)))) + 1
-                 : 1;
-  vkImage.create(&ctx->vkDevice, extent, format, imageUsageFlags, imageType,
-                 mipLevels, arrayLayers, numSamples,
-                 (imageViewType == VK_IMAGE_VIEW_TYPE_CUBE)
-                     ? VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT
-                     : 0);
-  vkDefaultImageView = getImageView(imageViewType, mipLevels, arrayLayers);
+                 : mipLevels;
+  // The dimensions come from the files, check them against the device limits
+  // before they reach vkCreateImage
+  auto &limits = ctx->vkPhysicalDevice.deviceProperties.limits;
+  uint32_t maxDimension =
+      (imageViewType == VK_IMAGE_VIEW_TYPE_CUBE) ? limits.maxImageDimensionCube
+      : (imageType == VK_IMAGE_TYPE_1D)          ? limits.maxImageDimension1D
+      : (imageType == VK_IMAGE_TYPE_2D)          ? limits.maxImageDimension2D
+                                                 : limits.maxImageDimension3D;
+  if (std::max({w, h, d}) > maxDimension ||
+      arrayLayers > limits.maxImageArrayLayers ||
+      this->mipLevels == 0 ||
+      this->mipLevels > PixelFormatUtil::getMaxMipLevels(w, h, d))
+    NGFX_ERR("invalid texture dimensions: %ux%ux%u, %u layers, %u levels", w,
+             h, d, arrayLayers, this->mipLevels);
+  VkImageUsageFlags vkImageUsageFlags = imageUsageFlags;
+  VkImageCreateFlags imageCreateFlags =
+      (imageViewType == VK_IMAGE_VIEW_TYPE_CUBE)
+          ? VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT
+          : 0;
+  // The compute path is only used if the texture is created with the
+  // storage usage, so other textures don't pay for it
+  computeMipmaps =
+      genMipmaps && this->mipLevels != 1 && imageType == VK_IMAGE_TYPE_2D &&
+      (imageUsageFlags & VK_IMAGE_USAGE_STORAGE_BIT) &&
+      VKMipmapGenerator::isFormatSupported(&ctx->vkDevice, format);
+  // sRGB formats don't support storage, the mipmap generator
+  // uses a UNORM view. Without VK_KHR_maintenance2, the storage usage
+  // is dropped
+  bool srgbStorage = (imageUsageFlags & VK_IMAGE_USAGE_STORAGE_BIT) &&
+                     format == VK_FORMAT_R8G8B8A8_SRGB;
+  if (srgbStorage && ctx->vkDevice.enableMaintenance2)
+    imageCreateFlags |= VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT |
+                        VK_IMAGE_CREATE_EXTENDED_USAGE_BIT_KHR;
+  else if (srgbStorage) {
+    NGFX_LOG("VK_KHR_maintenance2 not supported, sRGB storage disabled, "
+             "mipmaps generated with blits");
+    vkImageUsageFlags &= ~VK_IMAGE_USAGE_STORAGE_BIT;
+  }
+  vkImage.create(&ctx->vkDevice, extent, format, vkImageUsageFlags, imageType,
+                 this->mipLevels, arrayLayers, numSamples, imageCreateFlags);
+  vkDefaultImageView =
+      getImageView(imageViewType, this->mipLevels, arrayLayers);
   auto &copyCommandBuffer = ctx->vkCopyCommandBuffer;
   std::unique_ptr<VKBuffer> stagingBuffer;
   if (data) {
@@ -79,15 +118,15 @@ void VKTexture::create(VKGraphicsContext *ctx, void *data, uint32_t size,
   uploadFn(copyCommandBuffer.v, data, size, stagingBuffer.get());
 
   if (imageUsageFlags & IMAGE_USAGE_SAMPLED_BIT) {
-    if (genMipmaps)
-      samplerCreateInfo->maxLod = mipLevels;
+    if (this->mipLevels != 1)
+      samplerCreateInfo->maxLod = float(this->mipLevels);
     if (!sampler)
       initSampler();
     if (!samplerDescriptorSet)
       initSamplerDescriptorSet(copyCommandBuffer.v);
   }
 
-  if (imageUsageFlags & IMAGE_USAGE_STORAGE_BIT) {
+  if ((imageUsageFlags & IMAGE_USAGE_STORAGE_BIT) && !srgbStorage) {
     if (!storageImageDescriptorSet)
       initStorageImageDescriptorSet(copyCommandBuffer.v);
   }
@@ -100,16 +139,17 @@ void VKTexture::create(VKGraphicsContext *ctx, void *data, uint32_t size,
     vkImage.changeLayout(copyCommandBuffer.v, VK_IMAGE_LAYOUT_GENERAL,
                          VK_ACCESS_SHADER_READ_BIT,
                          VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, aspectFlags, 0,
-                         mipLevels, 0, this->arrayLayers);
+                         this->mipLevels, 0, this->arrayLayers);
   } else if (imageUsageFlags & VK_IMAGE_USAGE_SAMPLED_BIT) {
     vkImage.changeLayout(
         copyCommandBuffer.v, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
         VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-        aspectFlags, 0, mipLevels, 0, this->arrayLayers);
+        aspectFlags, 0, this->mipLevels, 0, this->arrayLayers);
   }
   copyCommandBuffer.end();
-  vk(ctx->queue)->submit(&copyCommandBuffer, 0, {}, {}, nullptr);
-  ctx->queue->waitIdle();
+  uint64_t ticket =
+      vk(ctx->queue)->submit(&copyCommandBuffer, 0, {}, {}, nullptr);
+  ctx->queue->wait(ticket);
 }
 
 void VKTexture::generateMipmaps(CommandBuffer *commandBuffer) {
@@ -117,6 +157,14 @@ void VKTexture::generateMipmaps(CommandBuffer *commandBuffer) {
 }
 
 void VKTexture::generateMipmapsFn(VkCommandBuffer cmdBuffer) {
+  if (computeMipmaps && mipmapFilter != MIPMAP_FILTER_BLIT) {
+    if (!ctx->vkMipmapGenerator) {
+      ctx->vkMipmapGenerator.reset(new VKMipmapGenerator());
+      ctx->vkMipmapGenerator->create(ctx);
+    }
+    ctx->vkMipmapGenerator->generateMipmaps(cmdBuffer, this, mipmapFilter);
+    return;
+  }
   vkImage.changeLayout(cmdBuffer, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
                        VK_ACCESS_TRANSFER_READ_BIT,
                        VK_PIPELINE_STAGE_TRANSFER_BIT, aspectFlags, 0, 1, 0,
@@ -148,6 +196,7 @@ void VKTexture::upload(void *data, uint32_t size, uint32_t x, uint32_t y,
                        uint32_t z, int32_t w, int32_t h, int32_t d,
                        int32_t arrayLayers) {
   auto &copyCommandBuffer = ctx->vkCopyCommandBuffer;
+  NGFX_TRACE_SCOPE("VKTexture::upload");
   std::unique_ptr<VKBuffer> stagingBuffer;
   if (data) {
     stagingBuffer.reset(new VKBuffer());
@@ -173,8 +222,9 @@ void VKTexture::upload(void *data, uint32_t size, uint32_t x, uint32_t y,
         aspectFlags, 0, mipLevels, 0, this->arrayLayers);
   }
   copyCommandBuffer.end();
-  vk(ctx->queue)->submit(&copyCommandBuffer, 0, {}, {}, nullptr);
-  ctx->queue->waitIdle();
+  uint64_t ticket =
+      vk(ctx->queue)->submit(&copyCommandBuffer, 0, {}, {}, nullptr);
+  ctx->queue->wait(ticket);
 }
 
 void VKTexture::uploadFn(VkCommandBuffer cmdBuffer, void *data, uint32_t size,
@@ -190,28 +240,44 @@ void VKTexture::uploadFn(VkCommandBuffer cmdBuffer, void *data, uint32_t size,
       d = this->d;
     if (arrayLayers == -1)
       arrayLayers = this->arrayLayers;
+    // An upload of the whole texture contains the precomputed mip levels,
+    // they're copied from the staging buffer with one region per level
+    bool wholeTexture = x == 0 && y == 0 && z == 0 &&
+                        uint32_t(w) == this->w && uint32_t(h) == this->h &&
+                        uint32_t(d) == this->d &&
+                        uint32_t(arrayLayers) == this->arrayLayers;
+    uint32_t numLevels = (wholeTexture && !genMipmaps) ? mipLevels : 1;
     vkImage.changeLayout(cmdBuffer, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
                          VK_ACCESS_TRANSFER_WRITE_BIT,
-                         VK_PIPELINE_STAGE_TRANSFER_BIT, aspectFlags, 0, 1, 0,
-                         arrayLayers);
-    std::vector<VkBufferImageCopy> bufferCopyRegions = {
-        {0,
-         0,
-         0,
-         {aspectFlags, 0, 0, uint32_t(arrayLayers)},
-         {int32_t(x), int32_t(y), int32_t(z)},
-         {uint32_t(w), uint32_t(h), uint32_t(d)}}};
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, aspectFlags, 0,
+                         numLevels, 0, arrayLayers);
+    std::vector<VkBufferImageCopy> bufferCopyRegions(numLevels);
+    VkDeviceSize bufferOffset = 0;
+    for (uint32_t level = 0; level < numLevels; level++) {
+      if (level != 0)
+        bufferOffset += PixelFormatUtil::getLevelSize(
+            PixelFormat(vkFormat), w, h, d, arrayLayers, level - 1);
+      bufferCopyRegions[level] = {
+          bufferOffset,
+          0,
+          0,
+          {aspectFlags, level, 0, uint32_t(arrayLayers)},
+          {int32_t(x), int32_t(y), int32_t(z)},
+          {glm::max(uint32_t(w) >> level, 1u),
+           glm::max(uint32_t(h) >> level, 1u),
+           glm::max(uint32_t(d) >> level, 1u)}};
+    }
     VK_TRACE(vkCmdCopyBufferToImage(
         cmdBuffer, stagingBuffer->v, vkImage.v, vkImage.imageLayout[0],
         uint32_t(bufferCopyRegions.size()), bufferCopyRegions.data()));
   }
-  if (data && mipLevels != 1)
+  if (data && genMipmaps && mipLevels != 1)
     generateMipmapsFn(cmdBuffer);
 }
 
 void VKTexture::download(void *data, uint32_t size, uint32_t x, uint32_t y,
                          uint32_t z, int32_t w, int32_t h, int32_t d,
-                         int32_t arrayLayers) {
+                         int32_t arrayLayers, uint32_t level) {
   auto &copyCommandBuffer = ctx->vkCopyCommandBuffer;
   std::unique_ptr<VKBuffer> stagingBuffer;
   stagingBuffer.reset(new VKBuffer());
@@ -219,23 +285,26 @@ void VKTexture::download(void *data, uint32_t size, uint32_t x, uint32_t y,
 
   copyCommandBuffer.begin();
   downloadFn(copyCommandBuffer.v, data, size, stagingBuffer.get(), x, y, z, w,
-             h, d, arrayLayers);
+             h, d, arrayLayers, level);
   copyCommandBuffer.end();
-  vk(ctx->queue)->submit(&copyCommandBuffer, 0, {}, {}, nullptr);
-  ctx->queue->waitIdle();
+  uint64_t ticket =
+      vk(ctx->queue)->submit(&copyCommandBuffer, 0, {}, {}, nullptr);
+  ctx->queue->wait(ticket);
   stagingBuffer->download(data, size);
 }
 
 void VKTexture::downloadFn(VkCommandBuffer cmdBuffer, void *data, uint32_t size,
                            VKBuffer *stagingBuffer, uint32_t x, uint32_t y,
                            uint32_t z, int32_t w, int32_t h, int32_t d,
-                           int32_t arrayLayers) {
+                           int32_t arrayLayers, uint32_t level) {
+  if (level >= mipLevels)
+    NGFX_ERR("invalid mip level: %u", level);
   if (w == -1)
-    w = this->w;
+    w = std::max(this->w >> level, 1u);
   if (h == -1)
-    h = this->h;
+    h = std::max(this->h >> level, 1u);
   if (d == -1)
-    d = this->d;
+    d = std::max(this->d >> level, 1u);
   if (arrayLayers == -1)
     arrayLayers = this->arrayLayers;
 
@@ -246,7 +315,7 @@ void VKTexture::downloadFn(VkCommandBuffer cmdBuffer, void *data, uint32_t size,
       {0,
        0,
        0,
-       {aspectFlags, 0, 0, 1},
+       {aspectFlags, level, 0, 1},
        {int32_t(x), int32_t(y), int32_t(z)},
        {uint32_t(w), uint32_t(h), uint32_t(d)}}};
   VK_TRACE(vkCmdCopyImageToBuffer(
@@ -255,6 +324,11 @@ void VKTexture::downloadFn(VkCommandBuffer cmdBuffer, void *data, uint32_t size,
 }
 
 VKTexture::~VKTexture() {
+  // Evict the cached framebuffers that reference the image views
+  for (auto &imageView : vkImageViewCache)
+    ctx->vkFramebufferCache.evict(imageView->v);
+  if (!mipmapDescriptorSets.empty())
+    ctx->vkMipmapGenerator->freeDescriptorSets(this);
   if (sampler)
     VK_TRACE(vkDestroySampler(ctx->vkDevice.v, sampler, nullptr));
 }
@@ -383,7 +457,8 @@ Texture *Texture::create(GraphicsContext *ctx, Graphics *graphics, void *data,
                          ImageUsageFlags imageUsageFlags,
                          TextureType textureType, bool genMipmaps,
                          FilterMode minFilter, FilterMode magFilter,
-                         FilterMode mipFilter, uint32_t numSamples) {
+                         FilterMode mipFilter, uint32_t numSamples,
+                         uint32_t mipLevels) {
   VKTexture *vkTexture = new VKTexture();
   VKSamplerCreateInfo *samplerCreateInfo = nullptr;
   if (imageUsageFlags & IMAGE_USAGE_SAMPLED_BIT) {
@@ -397,7 +472,28 @@ Texture *Texture::create(GraphicsContext *ctx, Graphics *graphics, void *data,
   vkTexture->create(vk(ctx), data, size, {w, h, d}, arrayLayers,
                     VkFormat(format), imageUsageFlags,
                     VkImageViewType(textureType), genMipmaps, samplerCreateInfo,
-                    numSamples);
+                    numSamples, mipLevels);
   vkTexture->format = format;
   return vkTexture;
 }
+
+bool Texture::isFormatSupported(GraphicsContext *ctx, PixelFormat format) {
+  auto &vkDevice = vk(ctx)->vkDevice;
+  // The compressed formats also require the device feature
+  auto formatInfo = PixelFormatUtil::getFormatInfo(format);
+  if (formatInfo) {
+    auto &enabledFeatures = vkDevice.enabledFeatures;
+    if ((formatInfo->compression == PIXELFORMAT_COMPRESSION_BC &&
+         !enabledFeatures.textureCompressionBC) ||
+        (formatInfo->compression == PIXELFORMAT_COMPRESSION_ETC2 &&
+         !enabledFeatures.textureCompressionETC2) ||
+        (formatInfo->compression == PIXELFORMAT_COMPRESSION_ASTC &&
+         !enabledFeatures.textureCompressionASTC_LDR))
+      return false;
+  }
+  VkFormatProperties formatProperties;
+  VK_TRACE(vkGetPhysicalDeviceFormatProperties(
+      vkDevice.vkPhysicalDevice->v, VkFormat(format), &formatProperties));
+  return formatProperties.optimalTilingFeatures &
+         VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+}
@@ -0,0 +1,135 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "AsyncComputeApp.h"
+#include "ngfx/computeOps/MatrixMultiplyCPUOp.h"
+#include "ngfx/core/DebugUtil.h"
+#include "ngfx/core/Timer.h"
+#include <cmath>
+using namespace ngfx;
+using namespace glm;
+using namespace std;
+
+/* Runs a matrix multiply on the compute queue each frame, overlapping with
+   an offscreen render on the graphics queue. The result buffer is shared
+   with the graphics queue and validated against the CPU result.
+   Each frame submits its render, then the compute pass, then a command buffer that joins
+   the compute pass, so the compute pass only waits for the join of the previous frame and
+   can run during the render. The frames aren't waited for, the command buffers of the
+   frames in flight are reused in turn. The frame rate is compared with the frame rate of
+   serialized compute passes, with the dedicated compute queue and with the fallback to the
+   graphics queue */
+AsyncComputeApp::AsyncComputeApp() : ComputeApplication("Async Compute") {}
+
+void AsyncComputeApp::validateResult() {
+    float* result = (float*)matrixMultiplyOp->bDst->map();
+    std::vector<float> ref(MATRIX_SIZE, 0);
+    MatrixMultiplyCPUOp cpuOp(
+        { MATRIX_DIM, MATRIX_DIM, src0.data() },
+        { MATRIX_DIM, MATRIX_DIM, src1.data() },
+        { MATRIX_DIM, MATRIX_DIM, ref.data() }
+    );
+    cpuOp.apply();
+    const float ERR_THRESHOLD = 0.02f;
+    for (uint32_t j = 0; j < MATRIX_SIZE; j++) {
+        if (fabs(ref[j] - result[j]) > ERR_THRESHOLD) NGFX_ERR("%d %f %f", j, ref[j], result[j]);
+    }
+    matrixMultiplyOp->bDst->unmap();
+}
+
+float AsyncComputeApp::runFrames(bool overlap) {
+    auto ctx = graphicsContext.get();
+    Timer timer;
+    for (uint32_t j = 0; j < NUM_FRAMES; j++) {
+        auto renderCommandBuffer = renderCommandBuffers[j % NUM_FRAME_BUFFERS].get(),
+             joinCommandBuffer = joinCommandBuffers[j % NUM_FRAME_BUFFERS].get();
+        // Wait for the frame that used the command buffers
+        graphics->waitIdle(renderCommandBuffer);
+        graphics->waitIdle(joinCommandBuffer);
+        renderCommandBuffer->begin();
+        outputTexture->changeLayout(renderCommandBuffer, IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+        ctx->beginOffscreenRenderPass(renderCommandBuffer, graphics.get(), outputFramebuffer.get());
+        for (uint32_t k = 0; k < NUM_DRAWS; k++) drawColorOp->draw(renderCommandBuffer, graphics.get());
+        ctx->endOffscreenRenderPass(renderCommandBuffer, graphics.get());
+        renderCommandBuffer->end();
+        ctx->submit(renderCommandBuffer);
+        if (!overlap) graphics->waitIdle(renderCommandBuffer);
+        asyncCompute->submit([&](CommandBuffer* commandBuffer) {
+            matrixMultiplyOp->apply(commandBuffer, graphics.get());
+        });
+        joinCommandBuffer->begin();
+        asyncCompute->join(joinCommandBuffer);
+        asyncCompute->release(joinCommandBuffer);
+        joinCommandBuffer->end();
+        ctx->submit(joinCommandBuffer);
+    }
+    for (auto& commandBuffer : joinCommandBuffers) graphics->waitIdle(commandBuffer.get());
+    asyncCompute->wait();
+    timer.update();
+    return NUM_FRAMES / timer.elapsed;
+}
+
+void AsyncComputeApp::run() {
+    init();
+    src0.resize(MATRIX_SIZE); src1.resize(MATRIX_SIZE); dst.resize(MATRIX_SIZE);
+    for (uint32_t j = 0; j < MATRIX_SIZE; j++) {
+        src0[j] = (rand() % 1000) / 100.0f; src1[j] = (rand() % 1000) / 100.0f;
+    }
+    auto ctx = graphicsContext.get();
+    matrixMultiplyOp.reset(new MatrixMultiplyGPUOp(ctx,
+        { MATRIX_DIM, MATRIX_DIM, src0.data() },
+        { MATRIX_DIM, MATRIX_DIM, src1.data() },
+        { MATRIX_DIM, MATRIX_DIM, dst.data() }));
+    drawColorOp.reset(new DrawColorOp(ctx,
+        { vec2(-1.0f, -1.0f), vec2(1.0f, -1.0f), vec2(0.0f, 1.0f) },
+        vec4(1.0, 0.0, 0.0, 1.0)));
+    outputTexture.reset(Texture::create(ctx, graphics.get(), nullptr, PIXELFORMAT_RGBA8_UNORM,
+        FRAME_WIDTH * FRAME_HEIGHT * 4, FRAME_WIDTH, FRAME_HEIGHT, 1, 1,
+        ImageUsageFlags(IMAGE_USAGE_SAMPLED_BIT | IMAGE_USAGE_COLOR_ATTACHMENT_BIT)));
+    outputFramebuffer.reset(Framebuffer::create(ctx->device, ctx->defaultOffscreenRenderPass,
+        { { outputTexture.get() } }, FRAME_WIDTH, FRAME_HEIGHT));
+    for (uint32_t j = 0; j < NUM_FRAME_BUFFERS; j++) {
+        renderCommandBuffers.emplace_back(CommandBuffer::create(ctx));
+        joinCommandBuffers.emplace_back(CommandBuffer::create(ctx));
+    }
+    // The fallback to the graphics queue is tested even if the device has a dedicated queue
+    for (bool enableDedicatedQueue : { true, false }) {
+        asyncCompute.reset(AsyncCompute::create(ctx, graphics.get(), enableDedicatedQueue));
+        asyncCompute->addSharedBuffer(matrixMultiplyOp->bDst.get());
+        if (enableDedicatedQueue && !asyncCompute->dedicatedQueue)
+            printf("no dedicated compute queue\n");
+        else {
+            // On the same queue, the compute passes are serialized with the renders
+            float serializedFps = runFrames(false), fps = runFrames(true);
+            printf("%s queue: %u frames: %f fps, serialized: %f fps, overlap speedup: %.2fx\n",
+                asyncCompute->dedicatedQueue ? "compute" : "graphics", NUM_FRAMES, fps, serializedFps,
+                fps / serializedFps);
+            validateResult();
+        }
+        asyncCompute.reset();
+    }
+    close();
+}
+
+int main() {
+    AsyncComputeApp app;
+    app.run();
+    return 0;
+}
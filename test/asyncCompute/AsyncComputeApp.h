@@ -0,0 +1,53 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#pragma once
+#include "ngfx/compute/AsyncCompute.h"
+#include "ngfx/compute/ComputeApplication.h"
+#include "ngfx/computeOps/MatrixMultiplyGPUOp.h"
+#include "ngfx/drawOps/DrawColorOp.h"
+#include <memory>
+#include <vector>
+
+namespace ngfx {
+    class AsyncComputeApp : public ComputeApplication {
+    public:
+        AsyncComputeApp();
+        virtual void run();
+        static const uint32_t MATRIX_DIM = 256, MATRIX_SIZE = MATRIX_DIM * MATRIX_DIM;
+        static const uint32_t FRAME_WIDTH = 1920, FRAME_HEIGHT = 1080, NUM_FRAMES = 100;
+        /** The number of frames in flight, and of draws per frame */
+        static const uint32_t NUM_FRAME_BUFFERS = 2, NUM_DRAWS = 20;
+    protected:
+        /** Run the frames and return the frame rate.
+         *  @param overlap If false, each compute pass is submitted after the previous render
+         *  completed, so they don't overlap */
+        float runFrames(bool overlap);
+        void validateResult();
+        std::vector<float> src0, src1, dst;
+        std::unique_ptr<MatrixMultiplyGPUOp> matrixMultiplyOp;
+        std::unique_ptr<DrawColorOp> drawColorOp;
+        std::unique_ptr<Texture> outputTexture;
+        std::unique_ptr<Framebuffer> outputFramebuffer;
+        std::unique_ptr<AsyncCompute> asyncCompute;
+        /** The command buffers of the render and of the join of each frame in flight */
+        std::vector<std::unique_ptr<CommandBuffer>> renderCommandBuffers, joinCommandBuffers;
+    };
+};
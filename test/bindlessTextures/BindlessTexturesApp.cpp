@@ -0,0 +1,116 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "BindlessTexturesApp.h"
+#include "ngfx/core/DebugUtil.h"
+#include "ngfx/drawOps/DrawTexturesOp.h"
+#include "ngfx/graphics/OffscreenRenderer.h"
+using namespace ngfx;
+using namespace glm;
+using namespace std;
+
+/* Draws textures selected from the bindless descriptor heap, and checks that
+   the heap reuses the indices of removed textures once the submissions that
+   access them are complete.
+   Runs headless, e.g. on lavapipe: VK_ICD_FILENAMES=.../lvp_icd.x86_64.json ./bindlessTextures */
+BindlessTexturesApp::BindlessTexturesApp() : ComputeApplication("BindlessTextures") {}
+
+void BindlessTexturesApp::checkDrawTexturesOp(const vector<uint32_t>& order) {
+    // A vertical strip per texture, so the columns don't depend on the
+    // orientation of the frame
+    vector<Texture*> stripTextures(NUM_TEXTURES);
+    vector<vec4> rects(NUM_TEXTURES);
+    const float w = 2.0f / NUM_TEXTURES;
+    for (uint32_t j = 0; j < NUM_TEXTURES; j++) {
+        stripTextures[j] = textures[order[j]].get();
+        rects[j] = vec4(-1.0f + float(j) * w, -1.0f, w, 2.0f);
+    }
+    DrawTexturesOp drawTexturesOp(graphicsContext.get(), stripTextures, rects);
+    unique_ptr<OffscreenRenderer> renderer(OffscreenRenderer::create(graphicsContext.get(),
+        graphics.get(), FRAME_WIDTH, FRAME_HEIGHT));
+    vector<uvec3> stripColors(NUM_TEXTURES);
+    renderer->onFrameReady = [&](const OffscreenRenderer::Frame& frame) {
+        auto pixels = (const uint8_t*)frame.data;
+        for (uint32_t j = 0; j < NUM_TEXTURES; j++) {
+            uint32_t x = (2 * j + 1) * frame.w / (2 * NUM_TEXTURES), y = frame.h / 2;
+            const uint8_t* p = &pixels[(y * frame.w + x) * 4];
+            stripColors[j] = uvec3(p[0], p[1], p[2]);
+        }
+    };
+    renderer->renderFrame([&](CommandBuffer* commandBuffer, uint64_t) {
+        drawTexturesOp.draw(commandBuffer, graphics.get());
+    });
+    renderer->flush();
+    // The colors don't depend on the order of the red and blue channels
+    for (uint32_t j = 0; j < NUM_TEXTURES; j++) {
+        auto& c0 = stripColors[j];
+        auto& c1 = colors[order[j]];
+        if (c0.x != c1.x || c0.y != c1.y || c0.z != c1.z)
+            NGFX_ERR("strip %u: color (%d, %d, %d), expected texture %u (%d, %d, %d)", j,
+                c0.x, c0.y, c0.z, order[j], c1.x, c1.y, c1.z);
+    }
+}
+
+void BindlessTexturesApp::checkIndexReuse() {
+    // The previous submissions are complete, so removing and adding a texture
+    // more times than the heap has room for must reuse the removed indices
+    auto bindlessHeap = graphicsContext->bindlessHeap;
+    uint32_t capacity = bindlessHeap->capacity(DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+    for (uint32_t j = 0; j <= capacity; j++) {
+        uint32_t index = bindlessHeap->addTexture(textures[0].get());
+        if (index >= capacity)
+            NGFX_ERR("index %u out of range, capacity: %u", index, capacity);
+        bindlessHeap->remove(DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, index);
+    }
+    printf("bindless heap: %u texture indices, removed indices are reused\n", capacity);
+}
+
+void BindlessTexturesApp::run() {
+    init();
+    if (!graphicsContext->bindlessHeap) {
+        printf("descriptor indexing isn't supported, skipping\n");
+        close();
+        return;
+    }
+    // Colors that are exact in any 8 bit color format
+    colors = { uvec3(255, 0, 255), uvec3(0, 255, 0), uvec3(255, 255, 255) };
+    const uint32_t size = 2;
+    for (auto& color : colors) {
+        vector<uint8_t> data;
+        for (uint32_t j = 0; j < size * size; j++)
+            data.insert(data.end(), { uint8_t(color.x), uint8_t(color.y), uint8_t(color.z), 255 });
+        textures.emplace_back(Texture::create(graphicsContext.get(), graphics.get(), data.data(),
+            PIXELFORMAT_RGBA8_UNORM, uint32_t(data.size()), size, size, 1, 1));
+    }
+    checkDrawTexturesOp({ 0, 1, 2 });
+    // The textures of the first op are removed from the heap, the second op
+    // reuses their indices with other textures
+    checkDrawTexturesOp({ 2, 0, 1 });
+    printf("DrawTexturesOp: each rectangle has the color of its texture\n");
+    checkIndexReuse();
+    textures.clear();
+    close();
+}
+
+int main() {
+    BindlessTexturesApp app;
+    app.run();
+    return 0;
+}
@@ -0,0 +1,39 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#pragma once
+#include "ngfx/compute/ComputeApplication.h"
+#include "ngfx/graphics/Texture.h"
+#include <memory>
+#include <vector>
+
+namespace ngfx {
+    class BindlessTexturesApp : public ComputeApplication {
+    public:
+        BindlessTexturesApp();
+        virtual void run();
+        static const uint32_t FRAME_WIDTH = 1920, FRAME_HEIGHT = 1080, NUM_TEXTURES = 3;
+    protected:
+        void checkDrawTexturesOp(const std::vector<uint32_t>& order);
+        void checkIndexReuse();
+        std::vector<std::unique_ptr<Texture>> textures;
+        std::vector<glm::uvec3> colors;
+    };
+};
@@ -0,0 +1,162 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include "ClusterCullingApp.h"
+#include "TestUtil.h"
+#include "ngfx/core/DebugUtil.h"
+#include "ngfx/graphics/Frustum.h"
+#include "ngfx/graphics/MeshOptimizer.h"
+#include "ngfx/graphics/MeshUtil.h"
+#include <glm/gtx/transform.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+using namespace ngfx;
+using namespace glm;
+using namespace std;
+
+/* Partitions a sphere into meshlets, culls them on the GPU for several views,
+   and checks the culling results against the CPU and the rendered image against the full mesh */
+ClusterCullingApp::ClusterCullingApp() : RenderTestApp("ClusterCulling", FRAME_WIDTH, FRAME_HEIGHT) {}
+
+void ClusterCullingApp::checkMeshlets(const MeshData& meshData) {
+    // The meshlets cover all the faces, within the size limits
+    uint32_t nextFace = 0;
+    for (auto& meshlet : meshData.meshlets) {
+        if (meshlet.firstFace != nextFace || meshlet.numVerts > 64 || meshlet.numFaces > 124)
+            NGFX_ERR("invalid meshlet: first face %u, %u vertices, %u faces", meshlet.firstFace,
+                meshlet.numVerts, meshlet.numFaces);
+        vec3 center = vec3(meshlet.boundingSphere);
+        float radius = meshlet.boundingSphere.w;
+        for (uint32_t j = meshlet.firstFace; j < meshlet.firstFace + meshlet.numFaces; j++) {
+            for (uint32_t k = 0; k < 3; k++) {
+                if (length(meshData.pos[meshData.faces[j][k]] - center) > radius * 1.001f)
+                    NGFX_ERR("face %u is outside the bounding sphere of its meshlet", j);
+            }
+        }
+        nextFace += meshlet.numFaces;
+    }
+    if (nextFace != meshData.faces.size())
+        NGFX_ERR("the meshlets cover %u faces, expected %u", nextFace, uint32_t(meshData.faces.size()));
+}
+
+void ClusterCullingApp::countCulledMeshlets(const MeshData& meshData, const mat4& modelView, const mat4& proj,
+        uint32_t& numFrustumCulled, uint32_t& numBackfaceCulled) {
+    // The frustum planes are in model space
+    Frustum frustum(proj * modelView);
+    vec3 cameraPos = vec3(inverse(modelView)[3]);
+    numFrustumCulled = numBackfaceCulled = 0;
+    for (auto& meshlet : meshData.meshlets) {
+        vec3 center = vec3(meshlet.boundingSphere);
+        float radius = meshlet.boundingSphere.w;
+        if (!frustum.intersects(BoundingSphere(center, radius))) { numFrustumCulled++; continue; }
+        vec3 v = center - cameraPos;
+        if (dot(v, vec3(meshlet.normalCone)) >= meshlet.normalCone.w * length(v) + radius) numBackfaceCulled++;
+    }
+}
+
+void ClusterCullingApp::render(DrawMeshOp& drawMeshOp, ClusterCullOp* clusterCullOp, mat4 modelViewMat,
+        vector<uint8_t>& pixels) {
+    mat4 modelViewInverseTransposeMat = transpose(inverse(modelViewMat));
+    mat4 modelViewProjMat = projMat * modelViewMat;
+    DrawMeshOp::LightData lightData;
+    drawMeshOp.update(modelViewMat, modelViewInverseTransposeMat, modelViewProjMat, lightData);
+    auto commandBuffer = graphicsContext->copyCommandBuffer();
+    commandBuffer->begin();
+    if (clusterCullOp) clusterCullOp->apply(commandBuffer, graphics.get());
+    beginRenderPass(commandBuffer);
+    if (clusterCullOp)
+        drawMeshOp.drawIndirect(commandBuffer, graphics.get(), clusterCullOp->bIndices.get(),
+            clusterCullOp->bDrawArgs.get());
+    else drawMeshOp.draw(commandBuffer, graphics.get());
+    graphics->endRenderPass(commandBuffer);
+    endFrame(commandBuffer, pixels);
+}
+
+void ClusterCullingApp::run() {
+    init();
+    createFramebuffer();
+    projMat = perspective(radians(60.0f), float(FRAME_WIDTH) / float(FRAME_HEIGHT), 0.1f, 100.0f);
+
+    MeshData meshData;
+    TestUtil::createSphere(200, 400, meshData);
+    MeshOptimizer::optimizeVertexCache(meshData);
+    MeshOptimizer::buildMeshlets(meshData);
+    checkMeshlets(meshData);
+
+    // The meshlets are stored in the mesh file
+    const char* file = "clusterCulling.mesh";
+    MeshUtil::exportMesh(file, meshData);
+    MeshData importedMeshData;
+    MeshUtil::importMesh(file, importedMeshData);
+    remove(file);
+    if (importedMeshData.faces != meshData.faces || importedMeshData.meshlets.size() != meshData.meshlets.size() ||
+        memcmp(importedMeshData.meshlets.data(), meshData.meshlets.data(),
+            meshData.meshlets.size() * sizeof(Meshlet)) != 0)
+        NGFX_ERR("the meshlets don't match after importing the mesh");
+
+    DrawMeshOp drawMeshOp(graphicsContext.get(), importedMeshData);
+    ClusterCullOp clusterCullOp(graphicsContext.get(), importedMeshData);
+    uint32_t numMeshlets = uint32_t(meshData.meshlets.size()), numFaces = uint32_t(meshData.faces.size());
+    struct View {
+        const char* name;
+        vec3 eye, center;
+    };
+    // The close view only sees a small part of the sphere
+    const View views[] = { { "front", vec3(0.0f, 0.0f, 3.0f), vec3(0.0f) },
+        { "top", vec3(0.0f, 3.0f, 0.1f), vec3(0.0f) },
+        { "close", vec3(0.0f, 0.0f, 1.3f), vec3(0.0f, 0.0f, 0.9f) } };
+    vector<uint8_t> refPixels, pixels;
+    for (auto& view : views) {
+        mat4 modelViewMat = lookAt(view.eye, view.center, vec3(0.0f, 1.0f, 0.0f));
+        clusterCullOp.update(modelViewMat, projMat);
+        render(drawMeshOp, nullptr, modelViewMat, refPixels);
+        render(drawMeshOp, &clusterCullOp, modelViewMat, pixels);
+        auto stats = clusterCullOp.getStats();
+        uint32_t numFrustumCulled, numBackfaceCulled;
+        countCulledMeshlets(meshData, modelViewMat, projMat, numFrustumCulled, numBackfaceCulled);
+        printf("%s view: %u meshlets, %u visible, %u frustum culled, %u back face culled, %u / %u faces drawn\n",
+            view.name, stats.numMeshlets, stats.numVisible, stats.numFrustumCulled, stats.numBackfaceCulled,
+            stats.numVisibleFaces, numFaces);
+        // Allow for rounding differences on the culling boundaries
+        int tolerance = int(numMeshlets / 100);
+        if (abs(int(stats.numFrustumCulled) - int(numFrustumCulled)) > tolerance ||
+            abs(int(stats.numBackfaceCulled) - int(numBackfaceCulled)) > tolerance)
+            NGFX_ERR("%s view: expected %u frustum culled, %u back face culled", view.name, numFrustumCulled,
+                numBackfaceCulled);
+        if ((stats.numFrustumCulled + stats.numBackfaceCulled) * 5 < numMeshlets * 2)
+            NGFX_ERR("%s view: less than 40%% of the meshlets are culled", view.name);
+        // Only back facing or offscreen meshlets are culled, so the images match
+        uint32_t numDiffs = 0;
+        for (uint32_t j = 0; j < FRAME_WIDTH * FRAME_HEIGHT * 4; j++) {
+            if (abs(int(pixels[j]) - int(refPixels[j])) > 2) numDiffs++;
+        }
+        if (numDiffs > FRAME_WIDTH * FRAME_HEIGHT / 1000)
+            NGFX_ERR("%s view: %u pixel components differ from the full mesh", view.name, numDiffs);
+    }
+    close();
+}
+
+int main() {
+    ClusterCullingApp app;
+    app.run();
+    return 0;
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "RenderTestApp.h"
+using namespace ngfx;
+using namespace std;
+
+RenderTestApp::RenderTestApp(const string& name, uint32_t frameWidth, uint32_t frameHeight)
+    : ComputeApplication(name), frameWidth(frameWidth), frameHeight(frameHeight) {}
+
+void RenderTestApp::init() {
+    // The meshes are drawn with depth testing
+    graphicsContext.reset(GraphicsContext::create(appName.c_str(), true));
+    graphicsContext->setSurface(nullptr);
+    graphics.reset(Graphics::create(graphicsContext.get()));
+}
+
+void RenderTestApp::createFramebuffer(RenderPass* renderPass, ImageUsageFlags depthImageUsageFlags) {
+    this->renderPass = renderPass ? renderPass : graphicsContext->defaultOffscreenRenderPass;
+    uint32_t size = frameWidth * frameHeight * 4;
+    colorTexture.reset(Texture::create(graphicsContext.get(), graphics.get(), nullptr, PIXELFORMAT_RGBA8_UNORM,
+        size, frameWidth, frameHeight, 1, 1,
+        ImageUsageFlags(IMAGE_USAGE_SAMPLED_BIT | IMAGE_USAGE_COLOR_ATTACHMENT_BIT | IMAGE_USAGE_TRANSFER_SRC_BIT)));
+    depthTexture.reset(Texture::create(graphicsContext.get(), graphics.get(), nullptr,
+        graphicsContext->depthFormat, size, frameWidth, frameHeight, 1, 1, depthImageUsageFlags));
+    framebuffer.reset(Framebuffer::create(graphicsContext->device, this->renderPass,
+        { { colorTexture.get() }, { depthTexture.get() } }, frameWidth, frameHeight));
+}
+
+void RenderTestApp::beginRenderPass(CommandBuffer* commandBuffer) {
+    colorTexture->changeLayout(commandBuffer, IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+    graphics->beginRenderPass(commandBuffer, renderPass, framebuffer.get(), graphicsContext->clearColor);
+    graphics->setViewport(commandBuffer, { 0, 0, frameWidth, frameHeight });
+    graphics->setScissor(commandBuffer, { 0, 0, frameWidth, frameHeight });
+}
+
+void RenderTestApp::endFrame(CommandBuffer* commandBuffer, vector<uint8_t>& pixels) {
+    commandBuffer->end();
+    graphicsContext->submit(commandBuffer);
+    graphics->waitIdle(commandBuffer);
+    pixels.resize(frameWidth * frameHeight * 4);
+    colorTexture->download(pixels.data(), uint32_t(pixels.size()));
+}
+
+void RenderTestApp::renderFrame(function<void(CommandBuffer*)> draw, vector<uint8_t>& pixels) {
+    auto commandBuffer = graphicsContext->copyCommandBuffer();
+    commandBuffer->begin();
+    beginRenderPass(commandBuffer);
+    draw(commandBuffer);
+    graphics->endRenderPass(commandBuffer);
+    endFrame(commandBuffer, pixels);
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#pragma once
+#include "ngfx/compute/ComputeApplication.h"
+#include "ngfx/graphics/Framebuffer.h"
+#include "ngfx/graphics/Texture.h"
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ngfx {
+    /* The base class of the tests that draw headless with depth testing,
+       to an offscreen color and depth framebuffer, and read back the pixels */
+    class RenderTestApp : public ComputeApplication {
+    public:
+        RenderTestApp(const std::string& name, uint32_t frameWidth, uint32_t frameHeight);
+    protected:
+        void init() override;
+        /* Create the color and depth textures and the framebuffer.
+           By default, the framebuffer uses the default offscreen render pass */
+        void createFramebuffer(RenderPass* renderPass = nullptr,
+            ImageUsageFlags depthImageUsageFlags = IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT);
+        /* Begin the render pass, with a viewport and a scissor that cover the frame */
+        void beginRenderPass(CommandBuffer* commandBuffer);
+        /* End the command buffer, submit it, wait for it and read back the pixels */
+        void endFrame(CommandBuffer* commandBuffer, std::vector<uint8_t>& pixels);
+        /* Record a frame whose render pass contains the commands of the draw function,
+           and read back the pixels */
+        void renderFrame(std::function<void(CommandBuffer*)> draw, std::vector<uint8_t>& pixels);
+        uint32_t frameWidth, frameHeight;
+        std::unique_ptr<Texture> colorTexture, depthTexture;
+        std::unique_ptr<Framebuffer> framebuffer;
+        RenderPass* renderPass = nullptr;
+    };
+};
@@ -0,0 +1,46 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "TestUtil.h"
+#include <glm/gtc/constants.hpp>
+using namespace ngfx;
+using namespace glm;
+
+void TestUtil::createSphere(uint32_t numRings, uint32_t numSegments, MeshData& meshData) {
+    meshData = MeshData();
+    for (uint32_t j = 0; j <= numRings; j++) {
+        float theta = pi<float>() * j / numRings;
+        for (uint32_t k = 0; k <= numSegments; k++) {
+            float phi = 2.0f * pi<float>() * k / numSegments;
+            vec3 p(sin(theta) * cos(phi), cos(theta), sin(theta) * sin(phi));
+            meshData.pos.push_back(p);
+            meshData.normal.push_back(p);
+        }
+    }
+    for (uint32_t j = 0; j < numRings; j++) {
+        for (uint32_t k = 0; k < numSegments; k++) {
+            int i0 = j * (numSegments + 1) + k, i1 = i0 + numSegments + 1;
+            meshData.faces.push_back(ivec3(i0, i0 + 1, i1));
+            meshData.faces.push_back(ivec3(i0 + 1, i1 + 1, i1));
+        }
+    }
+    meshData.bounds[0] = vec3(-1.0f);
+    meshData.bounds[1] = vec3(1.0f);
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "ComputeChainApp.h"
+#include "ngfx/computeOps/MatrixMultiplyCPUOp.h"
+#include "ngfx/core/DebugUtil.h"
+#include <cmath>
+using namespace ngfx;
+using namespace std;
+
+ChainedMatrixMultiplyOp::ChainedMatrixMultiplyOp(GraphicsContext* ctx, MatrixParam src0, MatrixParam src1,
+        MatrixParam dst, Buffer* src0Buffer, Buffer* dstBuffer)
+    : MatrixMultiplyGPUOp(ctx, src0, src1, dst), src0Buffer(src0Buffer), dstBuffer(dstBuffer) {}
+
+void ChainedMatrixMultiplyOp::apply(CommandBuffer* commandBuffer, Graphics* graphics) {
+    graphics->bindComputePipeline(commandBuffer, computePipeline);
+    graphics->bindUniformBuffer(commandBuffer, bUbo.get(), U_UBO, SHADER_STAGE_COMPUTE_BIT);
+    graphics->bindStorageBuffer(commandBuffer, src0Buffer ? src0Buffer : bSrc0.get(), SSBO_SRC0,
+        SHADER_STAGE_COMPUTE_BIT);
+    graphics->bindStorageBuffer(commandBuffer, bSrc1.get(), SSBO_SRC1, SHADER_STAGE_COMPUTE_BIT);
+    graphics->bindStorageBuffer(commandBuffer, dstBuffer ? dstBuffer : bDst.get(), SSBO_DST,
+        SHADER_STAGE_COMPUTE_BIT);
+    graphics->dispatch(commandBuffer, dst.w, dst.h, 1, 1, 1, 1);
+}
+
+/* Records dependent matrix multiplies in a single compute pass, without waiting between them,
+   so their ordering relies on the barriers inserted by the buffer access tracking:
+   C = A * B, then D = C * B reads C (read after write), then C = D * B overwrites C
+   (write after read). The results are validated against the CPU */
+ComputeChainApp::ComputeChainApp() : ComputeApplication("Compute Chain") {}
+
+void ComputeChainApp::onInit() {
+    a.resize(MATRIX_SIZE); b.resize(MATRIX_SIZE);
+    c.resize(MATRIX_SIZE); d.resize(MATRIX_SIZE); e.resize(MATRIX_SIZE);
+    // Small values, so the products of 3 matrices stay in the float precision
+    for (uint32_t j = 0; j < MATRIX_SIZE; j++) {
+        a[j] = (rand() % 1000) / 1000.0f - 0.5f; b[j] = (rand() % 1000) / 1000.0f - 0.5f;
+    }
+    auto ctx = graphicsContext.get();
+    MatrixMultiplyOp::MatrixParam pa = { MATRIX_DIM, MATRIX_DIM, a.data() },
+        pb = { MATRIX_DIM, MATRIX_DIM, b.data() },
+        pc = { MATRIX_DIM, MATRIX_DIM, c.data() }, pd = { MATRIX_DIM, MATRIX_DIM, d.data() };
+    op0.reset(new MatrixMultiplyGPUOp(ctx, pa, pb, pc));
+    op1.reset(new ChainedMatrixMultiplyOp(ctx, pc, pb, pd, op0->bDst.get(), nullptr));
+    op2.reset(new ChainedMatrixMultiplyOp(ctx, pd, pb, pc, op1->bDst.get(), op0->bDst.get()));
+}
+
+void ComputeChainApp::onRecordCommandBuffer(CommandBuffer* commandBuffer) {
+    graphics->beginComputePass(commandBuffer);
+    op0->apply(commandBuffer, graphics.get());
+    op1->apply(commandBuffer, graphics.get());
+    op2->apply(commandBuffer, graphics.get());
+    graphics->endComputePass(commandBuffer);
+}
+
+void ComputeChainApp::validate(const char* name, Buffer* buffer, const vector<float>& ref) {
+    float* result = (float*)buffer->map();
+    const float ERR_THRESHOLD = 1e-3f;
+    for (uint32_t j = 0; j < MATRIX_SIZE; j++) {
+        if (fabs(ref[j] - result[j]) > ERR_THRESHOLD * fmax(1.0f, fabs(ref[j])))
+            NGFX_ERR("%s: %u: %f, expected %f", name, j, result[j], ref[j]);
+    }
+    buffer->unmap();
+}
+
+void ComputeChainApp::onComputeFinished() {
+    MatrixMultiplyOp::MatrixParam pb = { MATRIX_DIM, MATRIX_DIM, b.data() };
+    MatrixMultiplyCPUOp({ MATRIX_DIM, MATRIX_DIM, a.data() }, pb, { MATRIX_DIM, MATRIX_DIM, c.data() }).apply();
+    MatrixMultiplyCPUOp({ MATRIX_DIM, MATRIX_DIM, c.data() }, pb, { MATRIX_DIM, MATRIX_DIM, d.data() }).apply();
+    MatrixMultiplyCPUOp({ MATRIX_DIM, MATRIX_DIM, d.data() }, pb, { MATRIX_DIM, MATRIX_DIM, e.data() }).apply();
+    validate("D = (A * B) * B", op1->bDst.get(), d);
+    validate("C = D * B", op0->bDst.get(), e);
+}
+
+int main() {
+    ComputeChainApp app;
+    app.run();
+    return 0;
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#pragma once
+#include "ngfx/compute/ComputeApplication.h"
+#include "ngfx/computeOps/MatrixMultiplyGPUOp.h"
+#include <memory>
+#include <vector>
+
+namespace ngfx {
+    /** A matrix multiply that reads its first matrix from, or writes its result to,
+        the buffer of another op */
+    class ChainedMatrixMultiplyOp : public MatrixMultiplyGPUOp {
+    public:
+        ChainedMatrixMultiplyOp(GraphicsContext* ctx, MatrixParam src0, MatrixParam src1, MatrixParam dst,
+            Buffer* src0Buffer, Buffer* dstBuffer);
+        void apply(CommandBuffer* commandBuffer, Graphics* graphics) override;
+        /** The buffers bound instead of bSrc0 and bDst, if not null */
+        Buffer *src0Buffer, *dstBuffer;
+    };
+
+    class ComputeChainApp : public ComputeApplication {
+    public:
+        ComputeChainApp();
+        virtual void onInit();
+        virtual void onRecordCommandBuffer(CommandBuffer* commandBuffer);
+        static const uint32_t MATRIX_DIM = 256, MATRIX_SIZE = MATRIX_DIM * MATRIX_DIM;
+    protected:
+        virtual void onComputeFinished();
+        void validate(const char* name, Buffer* buffer, const std::vector<float>& ref);
+        std::vector<float> a, b, c, d, e;
+        std::unique_ptr<MatrixMultiplyGPUOp> op0;
+        std::unique_ptr<ChainedMatrixMultiplyOp> op1, op2;
+    };
+};
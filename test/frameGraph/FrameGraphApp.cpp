@@ -0,0 +1,103 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "FrameGraphApp.h"
+#include "ngfx/core/DebugUtil.h"
+#include "ngfx/graphics/FrameGraph.h"
+#include <vector>
+using namespace ngfx;
+using namespace std;
+
+/* Runs a chain of filters with a frame graph, and checks that the transient
+   textures are aliased, that the unused passes are culled, and that each
+   filter reads the output of the previous one.
+   Runs headless, e.g. on lavapipe: VK_ICD_FILENAMES=.../lvp_icd.x86_64.json ./frameGraph */
+void CopyFilterOp::draw(CommandBuffer* commandBuffer, Graphics* graphics) {
+    drawTextureOp.texture = inputTextures[0];
+    drawTextureOp.draw(commandBuffer, graphics);
+}
+
+FrameGraphApp::FrameGraphApp() : ComputeApplication("FrameGraph") {}
+
+void FrameGraphApp::checkFilterChain(bool importFramebuffer, const uint8_t color[4]) {
+    const uint32_t size = TEXTURE_SIZE * TEXTURE_SIZE * 4;
+    vector<uint8_t> data(size);
+    for (uint32_t j = 0; j < size; j++) data[j] = color[j % 4];
+    auto ctx = graphicsContext.get();
+    unique_ptr<Texture> inputTexture(Texture::create(ctx, graphics.get(), data.data(),
+        PIXELFORMAT_RGBA8_UNORM, size, TEXTURE_SIZE, TEXTURE_SIZE, 1, 1));
+    unique_ptr<Texture> outputTexture(Texture::create(ctx, graphics.get(), nullptr,
+        PIXELFORMAT_RGBA8_UNORM, size, TEXTURE_SIZE, TEXTURE_SIZE, 1, 1,
+        ImageUsageFlags(IMAGE_USAGE_SAMPLED_BIT | IMAGE_USAGE_TRANSFER_SRC_BIT |
+                        IMAGE_USAGE_TRANSFER_DST_BIT | IMAGE_USAGE_COLOR_ATTACHMENT_BIT)));
+    shared_ptr<Framebuffer> outputFramebuffer;
+    if (importFramebuffer)
+        outputFramebuffer = ctx->getFramebuffer(ctx->defaultOffscreenRenderPass,
+            { { outputTexture.get() } }, TEXTURE_SIZE, TEXTURE_SIZE);
+
+    FrameGraph frameGraph(ctx, graphics.get());
+    vector<unique_ptr<CopyFilterOp>> filterOps;
+    auto input = frameGraph.importTexture("input", inputTexture.get());
+    auto output = frameGraph.importTexture("output", outputTexture.get(), outputFramebuffer.get());
+    FrameGraph::TextureDescription desc = { TEXTURE_SIZE, TEXTURE_SIZE, PIXELFORMAT_RGBA8_UNORM };
+    auto src = input;
+    for (uint32_t j = 0; j < NUM_FILTERS; j++) {
+        auto dst = (j == NUM_FILTERS - 1) ? output : frameGraph.createTexture("t" + to_string(j), desc);
+        filterOps.emplace_back(new CopyFilterOp(ctx));
+        frameGraph.addFilterPass(filterOps.back().get(), { src }, dst);
+        src = dst;
+    }
+    // A pass that doesn't contribute to the output
+    filterOps.emplace_back(new CopyFilterOp(ctx));
+    frameGraph.addFilterPass(filterOps.back().get(), { input }, frameGraph.createTexture("unused", desc));
+    frameGraph.compile();
+    if (frameGraph.numActivePasses() != NUM_FILTERS)
+        NGFX_ERR("%u active passes, expected %u", frameGraph.numActivePasses(), NUM_FILTERS);
+    if (frameGraph.numPhysicalTextures() != 2)
+        NGFX_ERR("%u physical textures, expected 2", frameGraph.numPhysicalTextures());
+
+    auto commandBuffer = ctx->copyCommandBuffer();
+    commandBuffer->begin();
+    frameGraph.execute(commandBuffer);
+    commandBuffer->end();
+    ctx->submit(commandBuffer);
+    graphics->waitIdle(commandBuffer);
+    vector<uint8_t> outputData(size);
+    outputTexture->download(outputData.data(), size);
+    for (uint32_t j = 0; j < size; j++) {
+        if (outputData[j] != color[j % 4])
+            NGFX_ERR("output byte %u: %d, expected %d", j, outputData[j], color[j % 4]);
+    }
+}
+
+void FrameGraphApp::run() {
+    init();
+    const uint8_t color0[4] = { 32, 128, 224, 255 }, color1[4] = { 200, 100, 50, 255 };
+    checkFilterChain(false, color0);
+    checkFilterChain(true, color1);
+    printf("FrameGraph: %u filters with 2 physical textures, the output matches the input\n", NUM_FILTERS);
+    close();
+}
+
+int main() {
+    FrameGraphApp app;
+    app.run();
+    return 0;
+}
@@ -0,0 +1,47 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#pragma once
+#include "ngfx/compute/ComputeApplication.h"
+#include "ngfx/drawOps/DrawTextureOp.h"
+#include "ngfx/graphics/FilterOp.h"
+#include <memory>
+
+namespace ngfx {
+    /** A filter that copies its input texture */
+    class CopyFilterOp : public FilterOp {
+    public:
+        CopyFilterOp(GraphicsContext* ctx) : FilterOp(ctx), drawTextureOp(ctx, nullptr) {}
+        void draw(CommandBuffer* commandBuffer, Graphics* graphics) override;
+    protected:
+        DrawTextureOp drawTextureOp;
+    };
+
+    class FrameGraphApp : public ComputeApplication {
+    public:
+        FrameGraphApp();
+        virtual void run();
+        static const uint32_t TEXTURE_SIZE = 64, NUM_FILTERS = 20;
+    protected:
+        /** Run a chain of copy filters and check the output
+         *  @param importFramebuffer Import the output with a framebuffer created by the app */
+        void checkFilterChain(bool importFramebuffer, const uint8_t color[4]);
+    };
+};
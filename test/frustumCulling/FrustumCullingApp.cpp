@@ -0,0 +1,116 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include "FrustumCullingApp.h"
+#include "ngfx/core/DebugUtil.h"
+#include "ngfx/graphics/Camera.h"
+#include <glm/gtx/transform.hpp>
+#include <chrono>
+#include <cstdio>
+#include <random>
+using namespace ngfx;
+using namespace glm;
+using namespace std;
+
+/* Culls a million random bounding spheres and boxes against the frustum of a camera, with each
+   SIMD width supported by the CPU. Checks that the visible volumes match the scalar test, except
+   for the volumes that touch a plane, where the rounding differs, and prints the number of volumes
+   tested per second on one core. The test runs on the CPU */
+FrustumCullingApp::FrustumCullingApp() : ComputeApplication("FrustumCulling") {}
+
+float FrustumCullingApp::getPlaneDistance(const Frustum& frustum, const BoundingSphere& sphere) {
+    float minDistance = FLT_MAX;
+    for (auto& plane : frustum.planes)
+        minDistance = glm::min(minDistance, abs(dot(vec3(plane), sphere.center) + plane.w + sphere.radius));
+    return minDistance;
+}
+
+float FrustumCullingApp::getPlaneDistance(const Frustum& frustum, const BoundingBox& box) {
+    float minDistance = FLT_MAX;
+    for (auto& plane : frustum.planes) {
+        vec3 p(plane.x >= 0.0f ? box.max.x : box.min.x, plane.y >= 0.0f ? box.max.y : box.min.y,
+            plane.z >= 0.0f ? box.max.z : box.min.z);
+        minDistance = glm::min(minDistance, abs(dot(vec3(plane), p) + plane.w));
+    }
+    return minDistance;
+}
+
+template <typename T> void FrustumCullingApp::checkVisible(const Frustum& frustum, const T& volumes,
+        const vector<uint32_t>& visible, uint32_t simdWidth) {
+    vector<bool> isVisible(volumes.size(), false);
+    for (uint32_t j = 0; j < visible.size(); j++) {
+        if (j > 0 && visible[j] <= visible[j - 1])
+            NGFX_ERR("SIMD width %u: the visible list isn't in increasing order", simdWidth);
+        isVisible[visible[j]] = true;
+    }
+    for (uint32_t j = 0; j < volumes.size(); j++) {
+        if (isVisible[j] != frustum.intersects(volumes[j]) && getPlaneDistance(frustum, volumes[j]) > 1e-4f)
+            NGFX_ERR("SIMD width %u: volume %u doesn't match the scalar test", simdWidth, j);
+    }
+}
+
+template <typename T> double FrustumCullingApp::benchmark(const Frustum& frustum, const T& volumes,
+        uint32_t simdWidth) {
+    vector<uint32_t> visible;
+    frustum.cull(volumes, visible, simdWidth);
+    checkVisible(frustum, volumes, visible, simdWidth);
+    auto t0 = chrono::steady_clock::now();
+    for (uint32_t j = 0; j < NUM_ITERATIONS; j++)
+        frustum.cull(volumes, visible, simdWidth);
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+    printf("%zu visible, ", visible.size());
+    return double(volumes.size()) * NUM_ITERATIONS / elapsed;
+}
+
+void FrustumCullingApp::run() {
+    Camera camera;
+    camera.zoom = -50.0f;
+    camera.yaw = 30.0f;
+    camera.update();
+    mat4 projMat = perspective(radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+    Frustum frustum = camera.getFrustum(projMat);
+
+    mt19937 rng(1);
+    uniform_real_distribution<float> posDist(-100.0f, 100.0f), sizeDist(0.01f, 2.0f);
+    BoundingSphereArray spheres;
+    BoundingBoxArray boxes;
+    for (uint32_t j = 0; j < NUM_VOLUMES; j++) {
+        vec3 center(posDist(rng), posDist(rng), posDist(rng));
+        spheres.push_back(BoundingSphere(center, sizeDist(rng)));
+        vec3 extent(sizeDist(rng), sizeDist(rng), sizeDist(rng));
+        boxes.push_back(BoundingBox(center - extent, center + extent));
+    }
+    for (uint32_t simdWidth : { 1, 4, 8, 16 }) {
+        if (!Frustum::isSIMDWidthSupported(simdWidth)) continue;
+        printf("SIMD width %u: spheres: ", simdWidth);
+        double sphereRate = benchmark(frustum, spheres, simdWidth);
+        printf("%.1f M tests/s, boxes: ", sphereRate * 1e-6);
+        double boxRate = benchmark(frustum, boxes, simdWidth);
+        printf("%.1f M tests/s\n", boxRate * 1e-6);
+    }
+    close();
+}
+
+int main() {
+    FrustumCullingApp app;
+    app.run();
+    return 0;
+}
@@ -0,0 +1,39 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#pragma once
+#include "ngfx/compute/ComputeApplication.h"
+#include "ngfx/graphics/Frustum.h"
+#include <vector>
+
+namespace ngfx {
+    class FrustumCullingApp : public ComputeApplication {
+    public:
+        FrustumCullingApp();
+        virtual void run();
+        static const uint32_t NUM_VOLUMES = 1000000, NUM_ITERATIONS = 100;
+    protected:
+        template <typename T> void checkVisible(const Frustum& frustum, const T& volumes,
+            const std::vector<uint32_t>& visible, uint32_t simdWidth);
+        float getPlaneDistance(const Frustum& frustum, const BoundingSphere& sphere);
+        float getPlaneDistance(const Frustum& frustum, const BoundingBox& box);
+        template <typename T> double benchmark(const Frustum& frustum, const T& volumes, uint32_t simdWidth);
+    };
+};
@@ -0,0 +1,205 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include "GLBSceneApp.h"
+#include "TestUtil.h"
+#include "ngfx/core/DebugUtil.h"
+#include "ngfx/graphics/GLBScene.h"
+#include <glm/gtx/transform.hpp>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <json.hpp>
+using namespace ngfx;
+using namespace glm;
+using namespace std;
+using json = nlohmann::json;
+
+/* Writes a .glb file with a sphere whose positions and normals are interleaved, with 16-bit indices,
+   and a mesh with a quad drawn as a triangle strip with 8-bit indices and without normals, plus a
+   point primitive. Checks that the sphere is read in place and the quad is repacked, with the normals
+   generated, that the node transforms are applied to the instances, and that the sphere drawn from
+   the file mapping matches the sphere drawn from the mesh data */
+GLBSceneApp::GLBSceneApp() : RenderTestApp("GLBScene", FRAME_WIDTH, FRAME_HEIGHT) {}
+
+void GLBSceneApp::writeGLB(const string& file, const MeshData& sphere) {
+    vector<uint8_t> bin;
+    auto append = [&](const void* data, size_t size) {
+        size_t offset = bin.size();
+        bin.insert(bin.end(), (const uint8_t*)data, (const uint8_t*)data + size);
+        bin.resize((bin.size() + 3) & ~size_t(3));
+        return offset;
+    };
+    uint32_t numVerts = uint32_t(sphere.pos.size());
+    vector<vec3> vertices;
+    for (uint32_t j = 0; j < numVerts; j++) {
+        vertices.push_back(sphere.pos[j]);
+        vertices.push_back(sphere.normal[j]);
+    }
+    vector<uint16_t> indices;
+    for (auto& face : sphere.faces)
+        indices.insert(indices.end(), { uint16_t(face[0]), uint16_t(face[1]), uint16_t(face[2]) });
+    size_t verticesOffset = append(vertices.data(), vertices.size() * sizeof(vec3));
+    size_t indicesOffset = append(indices.data(), indices.size() * sizeof(uint16_t));
+    const vec3 quadPos[] = { vec3(0, 0, 0), vec3(1, 0, 0), vec3(0, 1, 0), vec3(1, 1, 0) };
+    const uint8_t quadIndices[] = { 0, 1, 2, 3 };
+    size_t quadPosOffset = append(quadPos, sizeof(quadPos));
+    size_t quadIndicesOffset = append(quadIndices, sizeof(quadIndices));
+
+    json gltf;
+    gltf["asset"] = { { "version", "2.0" } };
+    gltf["buffers"] = { { { "byteLength", bin.size() } } };
+    gltf["bufferViews"] = {
+        { { "buffer", 0 }, { "byteOffset", verticesOffset }, { "byteLength", vertices.size() * sizeof(vec3) },
+          { "byteStride", 2 * sizeof(vec3) } },
+        { { "buffer", 0 }, { "byteOffset", indicesOffset }, { "byteLength", indices.size() * sizeof(uint16_t) } },
+        { { "buffer", 0 }, { "byteOffset", quadPosOffset }, { "byteLength", sizeof(quadPos) } },
+        { { "buffer", 0 }, { "byteOffset", quadIndicesOffset }, { "byteLength", sizeof(quadIndices) } }
+    };
+    gltf["accessors"] = {
+        { { "bufferView", 0 }, { "componentType", 5126 }, { "count", numVerts }, { "type", "VEC3" },
+          { "min", { -1, -1, -1 } }, { "max", { 1, 1, 1 } } },
+        { { "bufferView", 0 }, { "byteOffset", sizeof(vec3) }, { "componentType", 5126 }, { "count", numVerts },
+          { "type", "VEC3" } },
+        { { "bufferView", 1 }, { "componentType", 5123 }, { "count", indices.size() }, { "type", "SCALAR" } },
+        { { "bufferView", 2 }, { "componentType", 5126 }, { "count", 4 }, { "type", "VEC3" },
+          { "min", { 0, 0, 0 } }, { "max", { 1, 1, 0 } } },
+        { { "bufferView", 3 }, { "componentType", 5121 }, { "count", 4 }, { "type", "SCALAR" } }
+    };
+    gltf["meshes"] = {
+        { { "name", "sphere" },
+          { "primitives", { { { "attributes", { { "POSITION", 0 }, { "NORMAL", 1 } } }, { "indices", 2 } } } } },
+        { { "name", "quad" },
+          { "primitives", {
+              { { "attributes", { { "POSITION", 3 } } }, { "mode", 0 } },
+              { { "attributes", { { "POSITION", 3 } } }, { "indices", 4 }, { "mode", 5 } } } } }
+    };
+    gltf["nodes"] = {
+        { { "translation", { 1, 2, 3 } }, { "children", { 1 } } },
+        { { "mesh", 0 }, { "scale", { 2, 2, 2 } } },
+        { { "mesh", 1 }, { "matrix", { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 4, 5, 6, 1 } } }
+    };
+    gltf["scenes"] = { { { "nodes", { 0, 2 } } } };
+    gltf["scene"] = 0;
+    string jsonChunk = gltf.dump();
+    jsonChunk.resize((jsonChunk.size() + 3) & ~size_t(3), ' ');
+
+    ofstream out(file, ios::binary);
+    uint32_t header[] = { 0x46546C67, 2, uint32_t(12 + 8 + jsonChunk.size() + 8 + bin.size()) };
+    uint32_t jsonChunkHeader[] = { uint32_t(jsonChunk.size()), 0x4E4F534A };
+    uint32_t binChunkHeader[] = { uint32_t(bin.size()), 0x004E4942 };
+    out.write((const char*)header, sizeof(header));
+    out.write((const char*)jsonChunkHeader, sizeof(jsonChunkHeader));
+    out.write(jsonChunk.data(), jsonChunk.size());
+    out.write((const char*)binChunkHeader, sizeof(binChunkHeader));
+    out.write((const char*)bin.data(), bin.size());
+}
+
+void GLBSceneApp::render(DrawMeshOp& drawMeshOp, vector<uint8_t>& pixels) {
+    mat4 modelViewMat = lookAt(vec3(0.0f, 1.0f, 2.5f), vec3(0.0f), vec3(0.0f, 1.0f, 0.0f));
+    mat4 projMat = perspective(radians(60.0f), float(FRAME_WIDTH) / float(FRAME_HEIGHT), 0.1f, 100.0f);
+    mat4 modelViewInverseTransposeMat = transpose(inverse(modelViewMat));
+    mat4 modelViewProjMat = projMat * modelViewMat;
+    DrawMeshOp::LightData lightData;
+    drawMeshOp.update(modelViewMat, modelViewInverseTransposeMat, modelViewProjMat, lightData);
+    renderFrame([&](CommandBuffer* commandBuffer) { drawMeshOp.draw(commandBuffer, graphics.get()); }, pixels);
+}
+
+double GLBSceneApp::compare(const vector<uint8_t>& pixels, const vector<uint8_t>& refPixels) {
+    double totalDiff = 0.0;
+    for (uint32_t j = 0; j < FRAME_WIDTH * FRAME_HEIGHT; j++) {
+        int maxDiff = 0;
+        for (uint32_t k = 0; k < 4; k++)
+            maxDiff = std::max(maxDiff, abs(int(pixels[j * 4 + k]) - int(refPixels[j * 4 + k])));
+        totalDiff += maxDiff;
+    }
+    return totalDiff / (FRAME_WIDTH * FRAME_HEIGHT);
+}
+
+void GLBSceneApp::run() {
+    init();
+    createFramebuffer();
+
+    MeshData sphere;
+    TestUtil::createSphere(100, 200, sphere);
+    const string file = "glbScene.glb";
+    writeGLB(file, sphere);
+    GLBScene scene;
+    scene.load(file);
+    if (scene.meshes.size() != 2 || scene.primitives.size() != 2 || scene.instances.size() != 2)
+        NGFX_ERR("%zu meshes, %zu primitives, %zu instances, expected 2, 2, 2", scene.meshes.size(),
+            scene.primitives.size(), scene.instances.size());
+
+    // The sphere is read in place
+    auto& spherePrimitive = scene.primitives[scene.meshes[0].firstPrimitive];
+    auto& sphereView = spherePrimitive.view;
+    if (!spherePrimitive.pos.empty() || !spherePrimitive.normal.empty() || !spherePrimitive.indices.empty())
+        NGFX_ERR("the sphere is repacked");
+    if (sphereView.posStride != 2 * sizeof(vec3) || sphereView.normal != sphereView.pos + sizeof(vec3) ||
+        sphereView.indexSize != 2)
+        NGFX_ERR("the sphere layout doesn't match the file");
+    MeshData meshData;
+    scene.getMeshData(scene.meshes[0].firstPrimitive, meshData);
+    if (meshData.pos != sphere.pos || meshData.normal != sphere.normal || meshData.faces != sphere.faces)
+        NGFX_ERR("the sphere doesn't match the file");
+
+    // The quad strip is converted to a triangle list, with the same winding order
+    auto& quadPrimitive = scene.primitives[scene.meshes[1].firstPrimitive];
+    if (scene.meshes[1].numPrimitives != 1 || quadPrimitive.mesh != 1 || quadPrimitive.indices.empty() ||
+        quadPrimitive.normal.empty())
+        NGFX_ERR("the quad isn't repacked");
+    scene.getMeshData(scene.meshes[1].firstPrimitive, meshData);
+    if (meshData.faces != vector<ivec3>{ ivec3(0, 1, 2), ivec3(1, 3, 2) })
+        NGFX_ERR("the quad triangles don't match the strip");
+    for (auto& normal : meshData.normal) {
+        if (length(normal - vec3(0.0f, 0.0f, 1.0f)) > 1e-5f)
+            NGFX_ERR("the quad normals don't match the quad");
+    }
+    if (meshData.bounds[0] != vec3(0.0f) || meshData.bounds[1] != vec3(1.0f, 1.0f, 0.0f))
+        NGFX_ERR("the quad bounds don't match the quad");
+
+    // The node transforms are concatenated
+    mat4 sphereTransform = translate(vec3(1.0f, 2.0f, 3.0f)) * scale(vec3(2.0f));
+    mat4 quadTransform = translate(vec3(4.0f, 5.0f, 6.0f));
+    for (auto& instance : scene.instances) {
+        mat4 transform = instance.mesh == 0 ? sphereTransform : quadTransform;
+        for (uint32_t j = 0; j < 4; j++) {
+            if (length(instance.transform[j] - transform[j]) > 1e-5f)
+                NGFX_ERR("mesh %u: the instance transform doesn't match the nodes", instance.mesh);
+        }
+    }
+
+    vector<uint8_t> refPixels, pixels;
+    DrawMeshOp refDrawMeshOp(graphicsContext.get(), sphere);
+    render(refDrawMeshOp, refPixels);
+    DrawMeshOp drawMeshOp(graphicsContext.get(), sphereView);
+    render(drawMeshOp, pixels);
+    double meanDiff = compare(pixels, refPixels);
+    printf("mean difference: %f\n", meanDiff);
+    if (meanDiff > 1.0) NGFX_ERR("the sphere drawn from the file differs from the mesh data");
+    close();
+}
+
+int main() {
+    GLBSceneApp app;
+    app.run();
+    return 0;
+}
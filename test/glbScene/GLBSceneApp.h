@@ -0,0 +1,40 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#pragma once
+#include "RenderTestApp.h"
+#include "ngfx/drawOps/DrawMeshOp.h"
+#include "ngfx/graphics/MeshData.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ngfx {
+    class GLBSceneApp : public RenderTestApp {
+    public:
+        GLBSceneApp();
+        virtual void run();
+        static const uint32_t FRAME_WIDTH = 512, FRAME_HEIGHT = 512;
+    protected:
+        void writeGLB(const std::string& file, const MeshData& sphere);
+        void render(DrawMeshOp& drawMeshOp, std::vector<uint8_t>& pixels);
+        double compare(const std::vector<uint8_t>& pixels, const std::vector<uint8_t>& refPixels);
+    };
+};
@@ -0,0 +1,193 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "GPUProfilerApp.h"
+#include "ngfx/core/DebugUtil.h"
+#include "ngfx/core/Timer.h"
+#include <cmath>
+#include <fstream>
+#include <memory>
+#include <sstream>
+using namespace ngfx;
+using namespace std;
+
+/* Checks the resolution of the GPU profiler regions: the nesting, the delayed readback,
+   the dropped frames, the conversion of the ticks with the timestamp period, the wraparound
+   of the timestamps and the Chrome trace export, with a profiler whose timestamps are set
+   by the test. Then profiles a few frames on the device */
+TestGPUProfiler::TestGPUProfiler(uint32_t numFrames) {
+    init(numFrames, 16);
+    queries.resize(numFrames);
+    frameAvailable.resize(numFrames);
+    timestampPeriod = GPUProfilerApp::TIMESTAMP_PERIOD;
+    timestampMask = 0xFFFFFFFFull;
+}
+
+void TestGPUProfiler::resetQueries(CommandBuffer*, uint32_t frameSlot) {
+    queries[frameSlot].clear();
+    frameAvailable[frameSlot] = available;
+}
+
+void TestGPUProfiler::writeTimestamp(CommandBuffer*, uint32_t frameSlot, uint32_t query, bool) {
+    queries[frameSlot][query] = tick & timestampMask;
+}
+
+void TestGPUProfiler::getTimestamps(uint32_t frameSlot, uint32_t numQueries, vector<uint64_t>& timestamps,
+        vector<bool>& available) {
+    timestamps.assign(numQueries, 0);
+    available.assign(numQueries, false);
+    for (auto& query : queries[frameSlot]) {
+        timestamps[query.first] = query.second;
+        available[query.first] = frameAvailable[frameSlot];
+    }
+}
+
+GPUProfilerApp::GPUProfilerApp() : ComputeApplication("GPUProfiler") {}
+
+static void checkRegion(const GPUProfiler::Region& region, const char* name, uint32_t depth, uint64_t frame,
+        uint64_t startTicks, uint64_t durationTicks) {
+    double start = startTicks * GPUProfilerApp::TIMESTAMP_PERIOD * 1e-6,
+           duration = durationTicks * GPUProfilerApp::TIMESTAMP_PERIOD * 1e-6;
+    if (region.name != name || region.depth != depth || region.frame != frame ||
+        abs(region.start - start) > 1e-9 || abs(region.duration - duration) > 1e-9)
+        NGFX_ERR("region %s (depth %u, frame %llu): start: %f ms, duration: %f ms, expected %s (depth %u, "
+            "frame %llu): start: %f ms, duration %f ms", region.name.c_str(), region.depth,
+            (unsigned long long)region.frame, region.start, region.duration, name, depth,
+            (unsigned long long)frame, start, duration);
+}
+
+void GPUProfilerApp::testResolve() {
+    TestGPUProfiler profiler(NUM_FRAMES);
+    // The first frame starts 100 ticks before the timestamps wrap around, the frames are
+    // 1000 ticks apart. Each frame has a region with 2 nested regions, and a region left open
+    const uint64_t frameStart = 0x100000000ull - 100;
+    for (uint32_t j = 0; j < NUM_FRAMES + 1; j++) {
+        profiler.tick = frameStart + j * 1000;
+        profiler.available = (j != 1);
+        profiler.beginFrame(nullptr);
+        // The results of a frame are read back when its queries are reused
+        if (j < NUM_FRAMES && !profiler.trace.empty())
+            NGFX_ERR("frame %u: the results were read back before the queries were reused", j);
+        profiler.beginRegion(nullptr, "frame");
+        profiler.tick += 50;
+        profiler.beginRegion(nullptr, "pass1");
+        profiler.tick += 200;
+        profiler.endRegion(nullptr);
+        profiler.beginRegion(nullptr, "pass2");
+        profiler.tick += 300;
+        profiler.endRegion(nullptr);
+        profiler.tick += 10;
+        profiler.endRegion(nullptr);
+        profiler.beginRegion(nullptr, "open");
+    }
+    // Frame 0 is resolved at the beginning of frame 3
+    auto& results = profiler.results;
+    if (results.size() != 3)
+        NGFX_ERR("%zu regions resolved, expected 3", results.size());
+    checkRegion(results[0], "frame", 0, 0, 0, 560);
+    checkRegion(results[1], "pass1", 1, 0, 50, 200);
+    checkRegion(results[2], "pass2", 1, 0, 250, 300);
+    // Frame 1 isn't available when it's resolved, frame 2 follows frame 0
+    for (uint32_t j = 0; j < 2; j++) {
+        profiler.tick = frameStart + (NUM_FRAMES + 1 + j) * 1000;
+        profiler.beginFrame(nullptr);
+    }
+    if (profiler.numDroppedFrames != 1)
+        NGFX_ERR("%llu dropped frames, expected 1", (unsigned long long)profiler.numDroppedFrames);
+    if (profiler.trace.size() != 6)
+        NGFX_ERR("%zu regions in the trace, expected 6", profiler.trace.size());
+    checkRegion(results[0], "frame", 0, 2, 2000, 560);
+    checkRegion(results[2], "pass2", 1, 2, 2250, 300);
+    testChromeTrace(profiler, "gpuProfiler.json");
+}
+
+void GPUProfilerApp::testChromeTrace(GPUProfiler& profiler, const string& filename) {
+    profiler.exportChromeTrace(filename);
+    ifstream in(filename);
+    if (!in.is_open())
+        NGFX_ERR("cannot open file: %s", filename.c_str());
+    stringstream sstream;
+    sstream << in.rdbuf();
+    in.close();
+    string contents = sstream.str();
+    if (contents.find("{\"traceEvents\":[") != 0 || contents.find("],\"displayTimeUnit\"") == string::npos)
+        NGFX_ERR("%s: invalid trace file", filename.c_str());
+    // The events are complete events, in microseconds
+    uint32_t numEvents = 0;
+    for (size_t pos = contents.find("\"ph\":\"X\""); pos != string::npos; pos = contents.find("\"ph\":\"X\"", pos + 1))
+        numEvents++;
+    if (numEvents != profiler.trace.size())
+        NGFX_ERR("%s: %u events, expected %zu", filename.c_str(), numEvents, profiler.trace.size());
+    const string pass2 = "{\"name\":\"pass2\",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":0.625,"
+        "\"dur\":0.750,\"args\":{\"frame\":0}}";
+    if (contents.find(pass2) == string::npos)
+        NGFX_ERR("%s: missing event: %s", filename.c_str(), pass2.c_str());
+    remove(filename.c_str());
+}
+
+void GPUProfilerApp::testDevice() {
+    unique_ptr<GPUProfiler> profiler(GPUProfiler::create(graphicsContext.get(), NUM_FRAMES));
+    if (!profiler->enabled) {
+        printf("timestamp queries not supported, skipping the device test\n");
+        return;
+    }
+    auto commandBuffer = graphicsContext->copyCommandBuffer();
+    double elapsed = 0.0;
+    for (uint32_t j = 0; j < 2 * NUM_FRAMES; j++) {
+        commandBuffer->begin();
+        profiler->beginFrame(commandBuffer);
+        profiler->beginRegion(commandBuffer, "frame");
+        profiler->beginRegion(commandBuffer, "pass");
+        profiler->endRegion(commandBuffer);
+        profiler->endRegion(commandBuffer);
+        commandBuffer->end();
+        Timer timer;
+        graphicsContext->submit(commandBuffer);
+        graphics->waitIdle(commandBuffer);
+        timer.update();
+        elapsed = std::max(elapsed, double(timer.elapsed) * 1000.0);
+    }
+    // The frames waited for the device, so none of them is dropped, and a region can't
+    // last longer than its frame on the CPU
+    if (profiler->numDroppedFrames != 0 || profiler->trace.size() != 2 * NUM_FRAMES)
+        NGFX_ERR("%zu regions resolved, %llu dropped frames", profiler->trace.size(),
+            (unsigned long long)profiler->numDroppedFrames);
+    for (uint32_t j = 0; j < profiler->trace.size(); j += 2) {
+        auto &frame = profiler->trace[j], &pass = profiler->trace[j + 1];
+        if (frame.depth != 0 || pass.depth != 1 || pass.start < frame.start ||
+            pass.start + pass.duration > frame.start + frame.duration + 1e-6 || frame.duration > elapsed)
+            NGFX_ERR("frame %llu: invalid regions: frame: %f + %f ms, pass: %f + %f ms",
+                (unsigned long long)frame.frame, frame.start, frame.duration, pass.start, pass.duration);
+    }
+    printf("%zu regions, frame: %f ms\n", profiler->trace.size(), profiler->trace[0].duration);
+}
+
+void GPUProfilerApp::run() {
+    testResolve();
+    init();
+    testDevice();
+    close();
+}
+
+int main() {
+    GPUProfilerApp app;
+    app.run();
+    return 0;
+}
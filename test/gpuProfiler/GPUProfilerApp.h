@@ -0,0 +1,58 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#pragma once
+#include "ngfx/compute/ComputeApplication.h"
+#include "ngfx/graphics/GPUProfiler.h"
+#include <map>
+#include <string>
+
+namespace ngfx {
+    /** A profiler whose timestamps are set by the test, with 32 valid bits */
+    class TestGPUProfiler : public GPUProfiler {
+    public:
+        TestGPUProfiler(uint32_t numFrames);
+        /** The tick of the next timestamps */
+        uint64_t tick = 0;
+        /** Set to false before beginFrame to simulate a frame whose results aren't available
+            when it's resolved */
+        bool available = true;
+    protected:
+        void resetQueries(CommandBuffer* commandBuffer, uint32_t frameSlot) override;
+        void writeTimestamp(CommandBuffer* commandBuffer, uint32_t frameSlot, uint32_t query, bool begin) override;
+        void getTimestamps(uint32_t frameSlot, uint32_t numQueries, std::vector<uint64_t>& timestamps,
+            std::vector<bool>& available) override;
+        std::vector<std::map<uint32_t, uint64_t>> queries;
+        std::vector<bool> frameAvailable;
+    };
+
+    class GPUProfilerApp : public ComputeApplication {
+    public:
+        GPUProfilerApp();
+        virtual void run();
+        static const uint32_t NUM_FRAMES = 3;
+        /** The duration of a tick of the test profiler, in nanoseconds */
+        static constexpr double TIMESTAMP_PERIOD = 2.5;
+    protected:
+        void testResolve();
+        void testChromeTrace(GPUProfiler& profiler, const std::string& filename);
+        void testDevice();
+    };
+};
@@ -0,0 +1,239 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include "InstancingApp.h"
+#include "TestUtil.h"
+#include "ngfx/core/DebugUtil.h"
+#include "ngfx/core/Timer.h"
+#include "ngfx/graphics/Frustum.h"
+#include "ngfx/graphics/OffscreenRenderer.h"
+#include <glm/gtx/transform.hpp>
+#include <cmath>
+using namespace ngfx;
+using namespace glm;
+using namespace std;
+
+/* Renders a grid of spheres headless, with one DrawMeshOp per instance and
+   with a single DrawMeshInstancedOp, and compares the frame rates.
+   First checks that each instance of a small grid is drawn with its own color.
+   The per-op path allocates 5 buffers per instance, so it's limited
+   by the device's maximum number of memory allocations.
+   Then culls the instances against a narrower frustum on the GPU, validates the
+   number of visible instances against the CPU and draws them with an indirect draw */
+InstancingApp::InstancingApp() : ComputeApplication("Instancing") {}
+
+void InstancingApp::createInstances(uint32_t numInstances, vector<mat4>& modelMats, vector<vec4>& colors) {
+    // A cubic grid that fills the unit cube
+    uint32_t dim = uint32_t(ceil(cbrt(float(numInstances))));
+    float cellSize = 2.0f / dim;
+    modelMats.resize(numInstances);
+    colors.resize(numInstances);
+    for (uint32_t j = 0; j < numInstances; j++) {
+        uvec3 cell(j % dim, (j / dim) % dim, j / (dim * dim));
+        vec3 center = vec3(-1.0f) + (vec3(cell) + 0.5f) * cellSize;
+        modelMats[j] = translate(center) * scale(vec3(0.4f * cellSize));
+        colors[j] = vec4(vec3(cell) / float(dim), 1.0f);
+    }
+}
+
+void InstancingApp::checkDrawMeshInstancedOp() {
+    // A 3x3 grid with unlit colors, so each instance covers pixels of its exact color.
+    // The colors don't depend on the order of the red and blue channels
+    const uint32_t numInstances = 9;
+    const float values[3] = { 0.25f, 0.5f, 1.0f };
+    vector<mat4> modelMats(numInstances);
+    vector<vec4> colors(numInstances);
+    for (uint32_t j = 0; j < numInstances; j++) {
+        vec3 center(0.6f * (float(j % 3) - 1.0f), 0.6f * (float(j / 3) - 1.0f), 0.0f);
+        modelMats[j] = translate(center) * scale(vec3(0.25f));
+        colors[j] = vec4(values[j % 3], values[j / 3], values[j % 3], 1.0f);
+    }
+    DrawMeshOp::LightData unlit;
+    unlit.ambient = vec4(1.0f);
+    unlit.diffuse = unlit.specular = vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    DrawMeshInstancedOp drawMeshInstancedOp(graphicsContext.get(), meshData, numInstances);
+    drawMeshInstancedOp.update(viewMat, projMat, unlit);
+    drawMeshInstancedOp.updateInstances(modelMats, colors);
+    unique_ptr<OffscreenRenderer> renderer(OffscreenRenderer::create(graphicsContext.get(),
+        graphics.get(), FRAME_WIDTH, FRAME_HEIGHT));
+    vector<uint32_t> numPixels(numInstances, 0);
+    renderer->onFrameReady = [&](const OffscreenRenderer::Frame& frame) {
+        auto pixels = (const uint8_t*)frame.data;
+        for (uint32_t j = 0; j < frame.w * frame.h; j++) {
+            const uint8_t* p = &pixels[j * 4];
+            for (uint32_t k = 0; k < numInstances; k++) {
+                vec3 c = vec3(colors[k]) * 255.0f;
+                if (abs(p[0] - c.x) <= 2.0f && abs(p[1] - c.y) <= 2.0f && abs(p[2] - c.z) <= 2.0f) {
+                    numPixels[k]++;
+                    break;
+                }
+            }
+        }
+    };
+    renderer->renderFrame([&](CommandBuffer* commandBuffer, uint64_t) {
+        drawMeshInstancedOp.draw(commandBuffer, graphics.get());
+    });
+    renderer->flush();
+    // Each sphere covers about 19000 pixels
+    for (uint32_t j = 0; j < numInstances; j++) {
+        if (numPixels[j] < 10000)
+            NGFX_ERR("instance %u: %u pixels with its color, expected at least 10000", j, numPixels[j]);
+    }
+    printf("%u instances, DrawMeshInstancedOp: each instance has its color\n", numInstances);
+}
+
+float InstancingApp::benchmarkDrawMeshOps(uint32_t numInstances) {
+    vector<mat4> modelMats;
+    vector<vec4> colors;
+    createInstances(numInstances, modelMats, colors);
+    vector<unique_ptr<DrawMeshOp>> drawMeshOps(numInstances);
+    for (uint32_t j = 0; j < numInstances; j++) {
+        drawMeshOps[j].reset(new DrawMeshOp(graphicsContext.get(), meshData));
+        mat4 modelViewMat = viewMat * modelMats[j];
+        mat4 modelViewInverseTransposeMat = transpose(inverse(modelViewMat));
+        mat4 modelViewProjMat = projMat * modelViewMat;
+        drawMeshOps[j]->update(modelViewMat, modelViewInverseTransposeMat, modelViewProjMat, lightData);
+    }
+    unique_ptr<OffscreenRenderer> renderer(OffscreenRenderer::create(graphicsContext.get(),
+        graphics.get(), FRAME_WIDTH, FRAME_HEIGHT));
+    Timer timer;
+    for (uint32_t j = 0; j < NUM_FRAMES; j++) {
+        renderer->renderFrame([&](CommandBuffer* commandBuffer, uint64_t) {
+            for (auto& drawMeshOp : drawMeshOps) drawMeshOp->draw(commandBuffer, graphics.get());
+        });
+    }
+    renderer->flush();
+    timer.update();
+    return NUM_FRAMES / timer.elapsed;
+}
+
+float InstancingApp::benchmarkDrawMeshInstancedOp(uint32_t numInstances) {
+    vector<mat4> modelMats;
+    vector<vec4> colors;
+    createInstances(numInstances, modelMats, colors);
+    DrawMeshInstancedOp drawMeshInstancedOp(graphicsContext.get(), meshData, numInstances);
+    drawMeshInstancedOp.update(viewMat, projMat, lightData);
+    drawMeshInstancedOp.updateInstances(modelMats, colors);
+    if (drawMeshInstancedOp.numInstances != numInstances)
+        NGFX_ERR("%u instances, expected %u", drawMeshInstancedOp.numInstances, numInstances);
+    unique_ptr<OffscreenRenderer> renderer(OffscreenRenderer::create(graphicsContext.get(),
+        graphics.get(), FRAME_WIDTH, FRAME_HEIGHT));
+    Timer timer;
+    for (uint32_t j = 0; j < NUM_FRAMES; j++) {
+        renderer->renderFrame([&](CommandBuffer* commandBuffer, uint64_t) {
+            drawMeshInstancedOp.draw(commandBuffer, graphics.get());
+        });
+    }
+    renderer->flush();
+    timer.update();
+    return NUM_FRAMES / timer.elapsed;
+}
+
+uint32_t InstancingApp::countVisibleInstances(const mat4& viewProj, const vector<mat4>& modelMats) {
+    Frustum frustum(viewProj);
+    auto& b = meshData.bounds;
+    vec3 sphereCenter = 0.5f * (b[0] + b[1]);
+    float sphereRadius = 0.5f * length(b[1] - b[0]);
+    uint32_t numVisible = 0;
+    for (auto& model : modelMats) {
+        vec3 center = vec3(model * vec4(sphereCenter, 1.0f));
+        float maxScale = sqrt(glm::max(glm::max(dot(vec3(model[0]), vec3(model[0])),
+            dot(vec3(model[1]), vec3(model[1]))), dot(vec3(model[2]), vec3(model[2]))));
+        if (frustum.intersects(BoundingSphere(center, sphereRadius * maxScale))) numVisible++;
+    }
+    return numVisible;
+}
+
+float InstancingApp::benchmarkFrustumCulling(uint32_t numInstances) {
+    vector<mat4> modelMats;
+    vector<vec4> colors;
+    createInstances(numInstances, modelMats, colors);
+    // A narrow frustum from inside the grid, so most instances are culled
+    mat4 cullViewMat = lookAt(vec3(0.0f, 0.0f, 0.5f), vec3(0.0f, 0.0f, -1.0f), vec3(0.0f, 1.0f, 0.0f));
+    mat4 cullProjMat = perspective(radians(30.0f), float(FRAME_WIDTH) / float(FRAME_HEIGHT), 0.1f, 100.0f);
+    DrawMeshInstancedOp drawMeshInstancedOp(graphicsContext.get(), meshData, numInstances);
+    drawMeshInstancedOp.update(cullViewMat, cullProjMat, lightData);
+    drawMeshInstancedOp.updateInstances(modelMats, colors);
+    FrustumCullOp frustumCullOp(graphicsContext.get(), meshData);
+    mat4 viewProj = cullProjMat * cullViewMat;
+    frustumCullOp.update(viewProj, drawMeshInstancedOp.bInstanceModel.get(),
+        drawMeshInstancedOp.bInstanceColor.get(), numInstances);
+
+    auto commandBuffer = graphicsContext->copyCommandBuffer();
+    commandBuffer->begin();
+    frustumCullOp.apply(commandBuffer, graphics.get());
+    commandBuffer->end();
+    Timer timer;
+    graphicsContext->submit(commandBuffer);
+    graphics->waitIdle(commandBuffer);
+    timer.update();
+    DrawIndexedIndirectCommand drawArgs;
+    frustumCullOp.bDrawArgs->download(&drawArgs, sizeof(drawArgs));
+    // The reset pass writes the index count from its push constants
+    if (drawArgs.indexCount != uint32_t(meshData.faces.size()) * 3)
+        NGFX_ERR("index count: %u, expected %u", drawArgs.indexCount, uint32_t(meshData.faces.size()) * 3);
+    uint32_t numVisible = countVisibleInstances(viewProj, modelMats);
+    // Allow for rounding differences on the frustum boundaries
+    if (abs(int(drawArgs.instanceCount) - int(numVisible)) > int(numInstances / 1000))
+        NGFX_ERR("%u visible instances, expected %u", drawArgs.instanceCount, numVisible);
+    printf("%u instances, frustum culling: %u visible, %f ms\n", numInstances, numVisible,
+        timer.elapsed * 1000.0f);
+
+    unique_ptr<OffscreenRenderer> renderer(OffscreenRenderer::create(graphicsContext.get(),
+        graphics.get(), FRAME_WIDTH, FRAME_HEIGHT));
+    timer.update();
+    for (uint32_t j = 0; j < NUM_FRAMES; j++) {
+        renderer->renderFrame([&](CommandBuffer* commandBuffer, uint64_t) {
+            drawMeshInstancedOp.drawIndirect(commandBuffer, graphics.get(), frustumCullOp.bDrawArgs.get(),
+                frustumCullOp.bVisibleModel.get(), frustumCullOp.bVisibleColor.get());
+        });
+    }
+    renderer->flush();
+    timer.update();
+    return NUM_FRAMES / timer.elapsed;
+}
+
+void InstancingApp::run() {
+    init();
+    TestUtil::createSphere(8, 16, meshData);
+    viewMat = lookAt(vec3(0.0f, 0.0f, 3.0f), vec3(0.0f), vec3(0.0f, 1.0f, 0.0f));
+    projMat = perspective(radians(60.0f), float(FRAME_WIDTH) / float(FRAME_HEIGHT), 0.1f, 100.0f);
+    checkDrawMeshInstancedOp();
+    for (uint32_t numInstances : { 100, 500 }) {
+        float fps = benchmarkDrawMeshOps(numInstances);
+        printf("%u instances, DrawMeshOp per instance: %f fps\n", numInstances, fps);
+    }
+    for (uint32_t numInstances : { 100, 500, 10000, 100000 }) {
+        float fps = benchmarkDrawMeshInstancedOp(numInstances);
+        printf("%u instances, DrawMeshInstancedOp: %f fps\n", numInstances, fps);
+    }
+    for (uint32_t numInstances : { 10000, 100000 }) {
+        float fps = benchmarkFrustumCulling(numInstances);
+        printf("%u instances, DrawMeshInstancedOp with frustum culling: %f fps\n", numInstances, fps);
+    }
+    close();
+}
+
+int main() {
+    InstancingApp app;
+    app.run();
+    return 0;
+}
@@ -0,0 +1,47 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#pragma once
+#include "ngfx/compute/ComputeApplication.h"
+#include "ngfx/computeOps/FrustumCullOp.h"
+#include "ngfx/drawOps/DrawMeshInstancedOp.h"
+#include "ngfx/drawOps/DrawMeshOp.h"
+#include "ngfx/graphics/MeshData.h"
+#include <memory>
+#include <vector>
+
+namespace ngfx {
+    class InstancingApp : public ComputeApplication {
+    public:
+        InstancingApp();
+        virtual void run();
+        static const uint32_t FRAME_WIDTH = 1920, FRAME_HEIGHT = 1080, NUM_FRAMES = 20;
+    protected:
+        void createInstances(uint32_t numInstances, std::vector<mat4>& modelMats, std::vector<vec4>& colors);
+        void checkDrawMeshInstancedOp();
+        float benchmarkDrawMeshOps(uint32_t numInstances);
+        float benchmarkDrawMeshInstancedOp(uint32_t numInstances);
+        float benchmarkFrustumCulling(uint32_t numInstances);
+        uint32_t countVisibleInstances(const mat4& viewProj, const std::vector<mat4>& modelMats);
+        MeshData meshData;
+        mat4 viewMat, projMat;
+        DrawMeshOp::LightData lightData;
+    };
+};
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include "InterleavedVerticesApp.h"
+#include "TestUtil.h"
+#include "ngfx/core/DebugUtil.h"
+#include "ngfx/graphics/MeshUtil.h"
+#include <glm/gtx/transform.hpp>
+#include <cstdio>
+#include <cstring>
+using namespace ngfx;
+using namespace glm;
+using namespace std;
+
+/* Checks the layout of the interleaved vertices, and checks that a mesh drawn from an interleaved
+   vertex buffer matches the same mesh drawn from separate vertex buffers, for the float and the
+   quantized vertex formats */
+InterleavedVerticesApp::InterleavedVerticesApp() : RenderTestApp("InterleavedVertices", FRAME_WIDTH, FRAME_HEIGHT) {}
+
+void InterleavedVerticesApp::render(DrawMeshOp& drawMeshOp, vector<uint8_t>& pixels) {
+    mat4 modelViewMat = lookAt(vec3(0.0f, 0.0f, 3.0f), vec3(0.0f), vec3(0.0f, 1.0f, 0.0f));
+    mat4 projMat = perspective(radians(60.0f), float(FRAME_WIDTH) / float(FRAME_HEIGHT), 0.1f, 100.0f);
+    mat4 modelViewInverseTransposeMat = transpose(inverse(modelViewMat));
+    mat4 modelViewProjMat = projMat * modelViewMat;
+    DrawMeshOp::LightData lightData;
+    drawMeshOp.update(modelViewMat, modelViewInverseTransposeMat, modelViewProjMat, lightData);
+    renderFrame([&](CommandBuffer* commandBuffer) { drawMeshOp.draw(commandBuffer, graphics.get()); }, pixels);
+}
+
+void InterleavedVerticesApp::run() {
+    init();
+    createFramebuffer();
+
+    MeshData meshData;
+    TestUtil::createSphere(64, 128, meshData);
+
+    // Each vertex is a position followed by a normal
+    vector<uint8_t> vertices;
+    uint32_t stride = MeshUtil::interleaveVertices(meshData, vertices);
+    if (stride != 2 * sizeof(vec3) || vertices.size() != meshData.pos.size() * stride)
+        NGFX_ERR("unexpected interleaved vertex size: %u", stride);
+    for (uint32_t j = 0; j < meshData.pos.size(); j++) {
+        if (memcmp(&vertices[j * stride], &meshData.pos[j], sizeof(vec3)) != 0 ||
+            memcmp(&vertices[j * stride + sizeof(vec3)], &meshData.normal[j], sizeof(vec3)) != 0)
+            NGFX_ERR("vertex %u doesn't match after interleaving", j);
+    }
+
+    vector<uint8_t> refPixels, pixels;
+    auto check = [&](const char* name, DrawMeshOp& separateOp, DrawMeshOp& interleavedOp) {
+        render(separateOp, refPixels);
+        render(interleavedOp, pixels);
+        // The mesh covers the center of the frame, the corner is the background
+        uint32_t numCovered = 0;
+        for (uint32_t j = 0; j < FRAME_WIDTH * FRAME_HEIGHT; j++) {
+            if (memcmp(&refPixels[j * 4], &refPixels[0], 4) != 0) numCovered++;
+        }
+        if (pixels != refPixels)
+            NGFX_ERR("%s: the interleaved vertices are drawn differently", name);
+        if (numCovered == 0) NGFX_ERR("%s: the mesh isn't drawn", name);
+        printf("%s: %u pixels match\n", name, numCovered);
+    };
+    DrawMeshOp separateOp(graphicsContext.get(), meshData, false), interleavedOp(graphicsContext.get(), meshData);
+    check("float", separateOp, interleavedOp);
+
+    // The quantized vertices are padded to a multiple of 4 bytes
+    QuantizedMeshData quantizedMeshData;
+    MeshUtil::quantizeMesh(meshData, quantizedMeshData, POSITION_ENCODING_HALF4, NORMAL_ENCODING_OCT8);
+    stride = MeshUtil::interleaveVertices(quantizedMeshData, vertices);
+    if (stride != 12) NGFX_ERR("unexpected quantized interleaved vertex size: %u", stride);
+    DrawMeshOp quantizedSeparateOp(graphicsContext.get(), quantizedMeshData, false),
+        quantizedInterleavedOp(graphicsContext.get(), quantizedMeshData);
+    check("quantized", quantizedSeparateOp, quantizedInterleavedOp);
+    close();
+}
+
+int main() {
+    InterleavedVerticesApp app;
+    app.run();
+    return 0;
+}
@@ -0,0 +1,171 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "KTXTextureApp.h"
+#include "ngfx/core/DebugUtil.h"
+#include "ngfx/graphics/PixelFormatUtil.h"
+#include "ngfx/graphics/TextureCodec.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+using namespace ngfx;
+using namespace std;
+
+/* Encodes an image with mip levels in each block compressed format and checks the PSNR of the
+   decoded image, saves and loads it as a KTX2 file, and creates a texture from the file: natively
+   if the device supports the format, decoded to RGBA8 otherwise. Also uploads the decoded levels
+   with a single copy, and checks the first level of each texture */
+KTXTextureApp::KTXTextureApp() : ComputeApplication("KTXTexture") {}
+
+void KTXTextureApp::createImage(vector<uint8_t>& rgba) {
+    // The left columns are transparent, for the 1-bit alpha of BC1
+    rgba.resize(IMAGE_WIDTH * IMAGE_HEIGHT * 4);
+    for (uint32_t y = 0; y < IMAGE_HEIGHT; y++) {
+        for (uint32_t x = 0; x < IMAGE_WIDTH; x++) {
+            uint8_t* p = &rgba[(y * IMAGE_WIDTH + x) * 4];
+            p[0] = uint8_t(x * 255 / IMAGE_WIDTH);
+            p[1] = uint8_t(y * 255 / IMAGE_HEIGHT);
+            p[2] = uint8_t(128.0f + 100.0f * sinf(x * 0.1f) * cosf(y * 0.07f));
+            p[3] = (x < 16) ? 0 : uint8_t(128 + y * 127 / IMAGE_HEIGHT);
+        }
+    }
+}
+
+void KTXTextureApp::createKTXFile(PixelFormat format, const vector<uint8_t>& rgba, KTXFile& ktxFile) {
+    ktxFile.format = format;
+    ktxFile.w = IMAGE_WIDTH;
+    ktxFile.h = IMAGE_HEIGHT;
+    ktxFile.mipLevels = uint32_t(floor(log2(float(std::max(IMAGE_WIDTH, IMAGE_HEIGHT))))) + 1;
+    ktxFile.data.resize(ktxFile.getLevelOffset(ktxFile.mipLevels));
+    vector<uint8_t> level = rgba, nextLevel;
+    for (uint32_t j = 0; j < ktxFile.mipLevels; j++) {
+        uint32_t w = std::max(IMAGE_WIDTH >> j, 1u), h = std::max(IMAGE_HEIGHT >> j, 1u);
+        TextureCodec::encode(format, level.data(), w, h, &ktxFile.data[ktxFile.getLevelOffset(j)]);
+        uint32_t nextW = std::max(w / 2, 1u), nextH = std::max(h / 2, 1u);
+        nextLevel.resize(nextW * nextH * 4);
+        for (uint32_t y = 0; y < nextH; y++) {
+            for (uint32_t x = 0; x < nextW; x++) {
+                uint32_t x1 = std::min(2 * x + 1, w - 1), y1 = std::min(2 * y + 1, h - 1);
+                for (uint32_t k = 0; k < 4; k++)
+                    nextLevel[(y * nextW + x) * 4 + k] = uint8_t((level[(2 * y * w + 2 * x) * 4 + k] +
+                        level[(2 * y * w + x1) * 4 + k] + level[(y1 * w + 2 * x) * 4 + k] +
+                        level[(y1 * w + x1) * 4 + k] + 2) / 4);
+            }
+        }
+        level.swap(nextLevel);
+    }
+}
+
+double KTXTextureApp::getPSNR(PixelFormat format, const uint8_t* rgba, const uint8_t* refRgba) {
+    // The channels that the format stores. The transparent BC1 texels are black
+    uint32_t numChannels = 4;
+    if (format == PIXELFORMAT_BC4_UNORM) numChannels = 1;
+    else if (format == PIXELFORMAT_BC5_UNORM) numChannels = 2;
+    else if (format == PIXELFORMAT_ETC2_RGB8_UNORM || format == PIXELFORMAT_ETC2_RGB8_SRGB) numChannels = 3;
+    bool bc1 = format == PIXELFORMAT_BC1_RGBA_UNORM || format == PIXELFORMAT_BC1_RGBA_SRGB;
+    double squaredError = 0.0;
+    uint32_t numSamples = 0;
+    for (uint32_t j = 0; j < IMAGE_WIDTH * IMAGE_HEIGHT; j++) {
+        if (bc1) {
+            bool transparent = refRgba[j * 4 + 3] < 128;
+            if (transparent != (rgba[j * 4 + 3] == 0))
+                NGFX_ERR("texel %u: the BC1 alpha doesn't match the image", j);
+            if (transparent) continue;
+        }
+        for (uint32_t k = 0; k < (bc1 ? 3 : numChannels); k++) {
+            double diff = double(rgba[j * 4 + k]) - double(refRgba[j * 4 + k]);
+            squaredError += diff * diff;
+            numSamples++;
+        }
+    }
+    double mse = squaredError / numSamples;
+    return (mse > 0.0) ? 10.0 * log10(255.0 * 255.0 / mse) : 100.0;
+}
+
+void KTXTextureApp::checkTexture(Texture* texture, const KTXFile& ktxFile) {
+    if (texture->format != ktxFile.format || texture->mipLevels != ktxFile.mipLevels)
+        NGFX_ERR("texture format: %d, %u levels, expected %d, %u levels", texture->format, texture->mipLevels,
+            ktxFile.format, ktxFile.mipLevels);
+    uint32_t size = ktxFile.getLevelSize(0);
+    vector<uint8_t> data(size);
+    texture->download(data.data(), size);
+    if (memcmp(data.data(), ktxFile.data.data(), size) != 0)
+        NGFX_ERR("the first level of the texture doesn't match the file");
+}
+
+void KTXTextureApp::run() {
+    init();
+    vector<uint8_t> rgba;
+    createImage(rgba);
+    const struct {
+        PixelFormat format;
+        const char* name;
+        double minPSNR;
+    } formats[] = {
+        { PIXELFORMAT_BC1_RGBA_UNORM, "bc1", 30.0 }, { PIXELFORMAT_BC3_UNORM, "bc3", 30.0 },
+        { PIXELFORMAT_BC4_UNORM, "bc4", 40.0 }, { PIXELFORMAT_BC5_UNORM, "bc5", 40.0 },
+        { PIXELFORMAT_ETC2_RGB8_UNORM, "etc2rgb", 30.0 }, { PIXELFORMAT_ETC2_RGBA8_SRGB, "etc2rgba", 30.0 }
+    };
+    for (auto& format : formats) {
+        KTXFile ktxFile;
+        createKTXFile(format.format, rgba, ktxFile);
+        vector<uint8_t> decoded(rgba.size());
+        TextureCodec::decode(format.format, ktxFile.data.data(), IMAGE_WIDTH, IMAGE_HEIGHT, decoded.data());
+        double psnr = getPSNR(format.format, decoded.data(), rgba.data());
+        printf("%s: %u levels, %zu bytes, PSNR: %.2f dB\n", format.name, ktxFile.mipLevels, ktxFile.data.size(),
+            psnr);
+        if (psnr < format.minPSNR) NGFX_ERR("%s: the PSNR is lower than %.2f dB", format.name, format.minPSNR);
+
+        string file = string("ktxTexture_") + format.name + ".ktx2";
+        ktxFile.save(file);
+        KTXFile loadedKTXFile;
+        loadedKTXFile.load(file);
+        if (loadedKTXFile.format != ktxFile.format || loadedKTXFile.w != ktxFile.w ||
+            loadedKTXFile.h != ktxFile.h || loadedKTXFile.mipLevels != ktxFile.mipLevels ||
+            loadedKTXFile.data != ktxFile.data)
+            NGFX_ERR("%s: the loaded file doesn't match the saved file", format.name);
+
+        // The texture is created with the device format, or decoded
+        bool supported = Texture::isFormatSupported(graphicsContext.get(), format.format);
+        printf("%s: %s\n", format.name, supported ? "supported" : "decoded to RGBA8");
+        KTXFile decodedKTXFile = loadedKTXFile;
+        decodedKTXFile.decode();
+        if (memcmp(decodedKTXFile.data.data(), decoded.data(), decoded.size()) != 0)
+            NGFX_ERR("%s: the decoded file doesn't match the decoded image", format.name);
+        unique_ptr<Texture> texture(Texture::create(graphicsContext.get(), graphics.get(), file.c_str()));
+        checkTexture(texture.get(), supported ? loadedKTXFile : decodedKTXFile);
+
+        // The decoded levels are uploaded with a single copy
+        texture.reset(Texture::create(graphicsContext.get(), graphics.get(), decodedKTXFile.data.data(),
+            decodedKTXFile.format, uint32_t(decodedKTXFile.data.size()), IMAGE_WIDTH, IMAGE_HEIGHT, 1, 1,
+            ImageUsageFlags(IMAGE_USAGE_SAMPLED_BIT | IMAGE_USAGE_TRANSFER_SRC_BIT | IMAGE_USAGE_TRANSFER_DST_BIT),
+            TEXTURE_TYPE_2D, false, FILTER_LINEAR, FILTER_LINEAR, FILTER_LINEAR, 1, decodedKTXFile.mipLevels));
+        checkTexture(texture.get(), decodedKTXFile);
+    }
+    close();
+}
+
+int main() {
+    KTXTextureApp app;
+    app.run();
+    return 0;
+}
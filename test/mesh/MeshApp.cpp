@@ -78,6 +78,7 @@ void MeshApp::onUpdate() {
     float aspect = 1920.0f / 1080.0f; //TODO: float(window->w) / float(window->h);
     projMat = perspective(radians(60.0f), aspect, 0.1f, 100.0f);
     modelViewProjMat = projMat * modelViewMat;
+    drawMeshOp->selectLOD(modelViewMat, projMat, 1080.0f);
     DrawMeshOp::LightData lightData;
     drawMeshOp->update(modelViewMat, modelViewInverseTransposeMat, modelViewProjMat, lightData);
 }
@@ -0,0 +1,156 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include "MeshBVHApp.h"
+#include "TestUtil.h"
+#include "ngfx/core/DebugUtil.h"
+#include <glm/gtx/transform.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+using namespace ngfx;
+using namespace glm;
+using namespace std;
+
+/* Builds the BVH of a high-poly sphere whose triangles are in random order, as with a scanned mesh,
+   and casts picking rays through a grid of points of the viewport. Checks that the hits match
+   a brute-force test over all the triangles, that the BVH doesn't depend on the number of threads,
+   and that it's the same after saving and loading it. The test runs on the CPU */
+MeshBVHApp::MeshBVHApp() : ComputeApplication("MeshBVH") {}
+
+bool MeshBVHApp::intersectBruteForce(const MeshData& meshData, const Ray& ray, MeshBVH::Hit& hit) {
+    bool found = false;
+    float tMax = ray.tMax;
+    for (uint32_t j = 0; j < meshData.faces.size(); j++) {
+        auto& face = meshData.faces[j];
+        vec3 v0 = meshData.pos[face[0]], e1 = meshData.pos[face[1]] - v0, e2 = meshData.pos[face[2]] - v0;
+        vec3 p = cross(ray.dir, e2);
+        float det = dot(e1, p);
+        if (det == 0.0f) continue;
+        float invDet = 1.0f / det;
+        vec3 s = ray.origin - v0;
+        float u = dot(s, p) * invDet;
+        if (u < 0.0f || u > 1.0f) continue;
+        vec3 q = cross(s, e1);
+        float v = dot(ray.dir, q) * invDet;
+        if (v < 0.0f || (u + v) > 1.0f) continue;
+        float t = dot(e2, q) * invDet;
+        if (t < ray.tMin || t >= tMax) continue;
+        tMax = t;
+        hit.t = t;
+        hit.face = j;
+        hit.barycentrics = vec2(u, v);
+        found = true;
+    }
+    return found;
+}
+
+void MeshBVHApp::castRays(const MeshBVH& bvh, const vector<Ray>& rays, vector<MeshBVH::Hit>& hits) {
+    hits.assign(rays.size(), MeshBVH::Hit());
+    for (uint32_t j = 0; j < rays.size(); j++) {
+        bool found = bvh.intersect(rays[j], hits[j]);
+        if (found != bvh.intersectAny(rays[j]))
+            NGFX_ERR("ray %u: the closest hit and the any hit queries don't match", j);
+    }
+}
+
+void MeshBVHApp::run() {
+    // The triangles are in random order
+    MeshData meshData;
+    TestUtil::createSphere(500, 1000, meshData);
+    mt19937 rng(1);
+    shuffle(meshData.faces.begin(), meshData.faces.end(), rng);
+
+    MeshBVH bvhs[2];
+    MeshBVH::BuildOptions options;
+    const uint32_t numThreads[] = { 1, 0 };
+    for (uint32_t j = 0; j < 2; j++) {
+        options.numThreads = numThreads[j];
+        auto t0 = chrono::steady_clock::now();
+        bvhs[j].build(meshData, options);
+        double elapsed = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+        printf("%u triangles, build (%s): %.1f ms\n", uint32_t(meshData.faces.size()),
+            numThreads[j] == 1 ? "1 thread" : "all threads", elapsed);
+    }
+    auto& bvh = bvhs[1];
+    if (bvhs[0].nodes.size() != bvh.nodes.size() || bvhs[0].faceIndices != bvh.faceIndices ||
+        memcmp(bvhs[0].nodes.data(), bvh.nodes.data(), bvh.nodes.size() * sizeof(MeshBVH::Node)) != 0)
+        NGFX_ERR("the BVH depends on the number of threads");
+
+    // Picking rays through a grid of points of the viewport
+    mat4 viewMat = lookAt(vec3(0.0f, 0.0f, 3.0f), vec3(0.0f), vec3(0.0f, 1.0f, 0.0f));
+    mat4 projMat = perspective(radians(60.0f), 1.0f, 0.1f, 100.0f);
+    mat4 viewProjMat = projMat * viewMat;
+    vector<Ray> rays;
+    for (uint32_t j = 0; j < GRID_SIZE; j++) {
+        for (uint32_t k = 0; k < GRID_SIZE; k++) {
+            vec2 ndc = (vec2(k, j) + 0.5f) / float(GRID_SIZE) * 2.0f - 1.0f;
+            rays.push_back(Ray::fromNDC(ndc, viewProjMat));
+        }
+    }
+    vector<MeshBVH::Hit> hits;
+    auto t0 = chrono::steady_clock::now();
+    castRays(bvh, rays, hits);
+    double bvhTime = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+    uint32_t numHits = 0;
+    for (uint32_t j = 0; j < rays.size(); j++) {
+        if (hits[j].face == MeshBVH::INVALID_INDEX) continue;
+        numHits++;
+        vec3 p = rays[j].origin + hits[j].t * rays[j].dir;
+        if (abs(length(p) - 1.0f) > 1e-3f) NGFX_ERR("ray %u: the hit point isn't on the sphere", j);
+    }
+    if (numHits == 0) NGFX_ERR("no ray hits the sphere");
+
+    double bruteForceTime = 0.0;
+    uint32_t numBruteForceRays = 0;
+    for (uint32_t j = 0; j < rays.size(); j += BRUTE_FORCE_STEP) {
+        MeshBVH::Hit hit;
+        auto t0 = chrono::steady_clock::now();
+        bool found = intersectBruteForce(meshData, rays[j], hit);
+        bruteForceTime += chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+        numBruteForceRays++;
+        // A ray through a shared edge may hit either face
+        if (found != (hits[j].face != MeshBVH::INVALID_INDEX) || (found && abs(hit.t - hits[j].t) > 1e-5f))
+            NGFX_ERR("ray %u: the hit doesn't match the brute force hit", j);
+    }
+    printf("%zu rays, %u hits, BVH: %.4f ms per ray, brute force: %.2f ms per ray\n", rays.size(), numHits,
+        bvhTime / rays.size(), bruteForceTime / numBruteForceRays);
+
+    bvh.save("meshBVH.bvh");
+    MeshBVH loadedBVH;
+    loadedBVH.load("meshBVH.bvh", meshData);
+    vector<MeshBVH::Hit> loadedHits;
+    castRays(loadedBVH, rays, loadedHits);
+    for (uint32_t j = 0; j < rays.size(); j++) {
+        if (loadedHits[j].face != hits[j].face || loadedHits[j].t != hits[j].t)
+            NGFX_ERR("ray %u: the loaded BVH doesn't match", j);
+    }
+    remove("meshBVH.bvh");
+    close();
+}
+
+int main() {
+    MeshBVHApp app;
+    app.run();
+    return 0;
+}
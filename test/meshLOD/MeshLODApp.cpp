@@ -0,0 +1,126 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include "MeshLODApp.h"
+#include "TestUtil.h"
+#include "ngfx/core/DebugUtil.h"
+#include "ngfx/graphics/MeshOptimizer.h"
+#include "ngfx/graphics/MeshUtil.h"
+#include <glm/gtx/transform.hpp>
+#include <cstdio>
+#include <cstdlib>
+using namespace ngfx;
+using namespace glm;
+using namespace std;
+
+/* Generates the levels of detail of a sphere, checks that they survive a round trip through the mesh file
+   format, and checks that a distant sphere is drawn with an order of magnitude fewer triangles
+   without a visible difference */
+MeshLODApp::MeshLODApp() : RenderTestApp("MeshLOD", FRAME_WIDTH, FRAME_HEIGHT) {}
+
+void MeshLODApp::getMatrices(float distance, mat4& modelViewMat, mat4& projMat) {
+    modelViewMat = lookAt(vec3(0.0f, 0.0f, distance), vec3(0.0f), vec3(0.0f, 1.0f, 0.0f));
+    projMat = perspective(radians(60.0f), float(FRAME_WIDTH) / float(FRAME_HEIGHT), 0.1f, 100.0f);
+}
+
+void MeshLODApp::render(DrawMeshOp& drawMeshOp, float distance, vector<uint8_t>& pixels) {
+    mat4 modelViewMat, projMat;
+    getMatrices(distance, modelViewMat, projMat);
+    mat4 modelViewInverseTransposeMat = transpose(inverse(modelViewMat));
+    mat4 modelViewProjMat = projMat * modelViewMat;
+    DrawMeshOp::LightData lightData;
+    drawMeshOp.update(modelViewMat, modelViewInverseTransposeMat, modelViewProjMat, lightData);
+    renderFrame([&](CommandBuffer* commandBuffer) { drawMeshOp.draw(commandBuffer, graphics.get()); }, pixels);
+}
+
+double MeshLODApp::compare(const vector<uint8_t>& pixels, const vector<uint8_t>& refPixels) {
+    double totalDiff = 0.0;
+    for (uint32_t j = 0; j < FRAME_WIDTH * FRAME_HEIGHT; j++) {
+        int maxDiff = 0;
+        for (uint32_t k = 0; k < 4; k++)
+            maxDiff = std::max(maxDiff, abs(int(pixels[j * 4 + k]) - int(refPixels[j * 4 + k])));
+        totalDiff += maxDiff;
+    }
+    return totalDiff / (FRAME_WIDTH * FRAME_HEIGHT);
+}
+
+void MeshLODApp::run() {
+    init();
+    createFramebuffer();
+
+    MeshData meshData;
+    TestUtil::createSphere(250, 500, meshData);
+    MeshOptimizer::generateLODs(meshData);
+    auto& lods = meshData.lods;
+    for (uint32_t j = 0; j < lods.size(); j++) {
+        printf("LOD %u: %u faces, error: %f\n", j, lods[j].numFaces, lods[j].error);
+        if (j > 0 && (lods[j].numFaces >= lods[j - 1].numFaces || lods[j].error < lods[j - 1].error))
+            NGFX_ERR("LOD %u is not coarser than LOD %u", j, j - 1);
+    }
+    if (lods.size() < 5) NGFX_ERR("%u LODs, expected at least 5", uint32_t(lods.size()));
+
+    // The LODs are stored in the mesh file
+    const char* file = "meshLOD.mesh";
+    MeshUtil::exportMesh(file, meshData);
+    MeshData importedMeshData;
+    MeshUtil::importMesh(file, importedMeshData);
+    remove(file);
+    if (importedMeshData.faces != meshData.faces || importedMeshData.lods.size() != lods.size())
+        NGFX_ERR("the LODs don't match after importing the mesh");
+    for (uint32_t j = 0; j < lods.size(); j++) {
+        auto& lod = importedMeshData.lods[j];
+        if (lod.firstFace != lods[j].firstFace || lod.numFaces != lods[j].numFaces || lod.error != lods[j].error)
+            NGFX_ERR("LOD %u doesn't match after importing the mesh", j);
+    }
+
+    DrawMeshOp drawMeshOp(graphicsContext.get(), importedMeshData);
+    vector<uint8_t> refPixels, pixels;
+    struct View {
+        const char* name;
+        float distance;
+    };
+    const View views[] = { { "near", 1.5f }, { "far", 20.0f } };
+    uint32_t nearLOD = 0;
+    for (auto& view : views) {
+        mat4 modelViewMat, projMat;
+        getMatrices(view.distance, modelViewMat, projMat);
+        uint32_t lod = drawMeshOp.selectLOD(modelViewMat, projMat, float(FRAME_HEIGHT));
+        drawMeshOp.lod = 0;
+        render(drawMeshOp, view.distance, refPixels);
+        drawMeshOp.lod = lod;
+        render(drawMeshOp, view.distance, pixels);
+        double meanDiff = compare(pixels, refPixels);
+        uint32_t numFaces = drawMeshOp.numLODFaces(lod);
+        printf("%s view: LOD %u, %u faces (%.1fx fewer), mean difference: %f\n", view.name, lod, numFaces,
+            double(lods[0].numFaces) / numFaces, meanDiff);
+        if (meanDiff > 1.0) NGFX_ERR("%s view: LOD %u differs from LOD 0", view.name, lod);
+        if (view.distance == views[0].distance) nearLOD = lod;
+        else if (lod <= nearLOD || numFaces * 10 > lods[0].numFaces)
+            NGFX_ERR("%s view: LOD %u doesn't reduce the number of faces enough", view.name, lod);
+    }
+    close();
+}
+
+int main() {
+    MeshLODApp app;
+    app.run();
+    return 0;
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include "MeshOptimizerApp.h"
+#include "TestUtil.h"
+#include "ngfx/core/DebugUtil.h"
+#include "ngfx/graphics/GPUProfiler.h"
+#include "ngfx/graphics/MeshOptimizer.h"
+#include <glm/gtx/transform.hpp>
+#include <algorithm>
+#include <numeric>
+#include <random>
+using namespace ngfx;
+using namespace glm;
+using namespace std;
+
+/* Renders a high-poly sphere headless whose triangles and vertices are in random order,
+   as with a scanned mesh, then applies the vertex cache, overdraw and vertex fetch
+   optimization passes, and compares the vertex cache statistics and the GPU time
+   of the DrawMeshOp */
+MeshOptimizerApp::MeshOptimizerApp() : RenderTestApp("MeshOptimizer", FRAME_WIDTH, FRAME_HEIGHT) {}
+
+void MeshOptimizerApp::shuffleMesh(MeshData& meshData) {
+    mt19937 rng(1);
+    shuffle(meshData.faces.begin(), meshData.faces.end(), rng);
+    vector<int> remap(meshData.pos.size());
+    iota(remap.begin(), remap.end(), 0);
+    shuffle(remap.begin(), remap.end(), rng);
+    vector<vec3> pos(meshData.pos.size()), normal(meshData.normal.size());
+    for (uint32_t j = 0; j < remap.size(); j++) {
+        pos[remap[j]] = meshData.pos[j];
+        normal[remap[j]] = meshData.normal[j];
+    }
+    meshData.pos = move(pos);
+    meshData.normal = move(normal);
+    for (auto& face : meshData.faces) face = ivec3(remap[face[0]], remap[face[1]], remap[face[2]]);
+}
+
+double MeshOptimizerApp::benchmark(MeshData& meshData) {
+    DrawMeshOp drawMeshOp(graphicsContext.get(), meshData);
+    mat4 modelViewMat = lookAt(vec3(0.0f, 0.0f, 3.0f), vec3(0.0f), vec3(0.0f, 1.0f, 0.0f));
+    mat4 modelViewInverseTransposeMat = transpose(inverse(modelViewMat));
+    mat4 projMat = perspective(radians(60.0f), float(FRAME_WIDTH) / float(FRAME_HEIGHT), 0.1f, 100.0f);
+    mat4 modelViewProjMat = projMat * modelViewMat;
+    DrawMeshOp::LightData lightData;
+    drawMeshOp.update(modelViewMat, modelViewInverseTransposeMat, modelViewProjMat, lightData);
+    unique_ptr<GPUProfiler> profiler(GPUProfiler::create(graphicsContext.get()));
+    graphics->profiler = profiler.get();
+    auto commandBuffer = graphicsContext->copyCommandBuffer();
+    for (uint32_t j = 0; j < NUM_FRAMES; j++) {
+        commandBuffer->begin();
+        profiler->beginFrame(commandBuffer);
+        beginRenderPass(commandBuffer);
+        drawMeshOp.draw(commandBuffer, graphics.get());
+        graphics->endRenderPass(commandBuffer);
+        commandBuffer->end();
+        graphicsContext->submit(commandBuffer);
+        graphics->waitIdle(commandBuffer);
+    }
+    graphics->profiler = nullptr;
+    // The profiler resolves the frames a few frames late, average the resolved ones
+    double totalTime = 0.0;
+    uint32_t numRegions = 0;
+    for (auto& region : profiler->trace) {
+        if (region.name != "DrawMeshOp") continue;
+        totalTime += region.duration;
+        numRegions++;
+    }
+    return numRegions ? totalTime / numRegions : 0.0;
+}
+
+void MeshOptimizerApp::run() {
+    init();
+    createFramebuffer();
+
+    MeshData meshData;
+    TestUtil::createSphere(500, 1000, meshData);
+    shuffleMesh(meshData);
+    auto stats = MeshOptimizer::analyzeVertexCache(meshData);
+    double time = benchmark(meshData);
+    printf("%u triangles, input: ACMR: %f, ATVR: %f, DrawMeshOp: %f ms\n", uint32_t(meshData.faces.size()),
+        stats.acmr, stats.atvr, time);
+    uint32_t numFaces = uint32_t(meshData.faces.size()), numVerts = uint32_t(meshData.pos.size());
+    MeshOptimizer::optimizeVertexCache(meshData);
+    MeshOptimizer::optimizeOverdraw(meshData);
+    MeshOptimizer::optimizeVertexFetch(meshData);
+    if (meshData.faces.size() != numFaces || meshData.pos.size() != numVerts)
+        NGFX_ERR("the optimized mesh has %u triangles and %u vertices, expected %u and %u",
+            uint32_t(meshData.faces.size()), uint32_t(meshData.pos.size()), numFaces, numVerts);
+    auto optimizedStats = MeshOptimizer::analyzeVertexCache(meshData);
+    if (optimizedStats.acmr > 1.0f)
+        NGFX_ERR("ACMR: %f, expected less than 1.0", optimizedStats.acmr);
+    time = benchmark(meshData);
+    printf("%u triangles, optimized: ACMR: %f, ATVR: %f, DrawMeshOp: %f ms\n", numFaces,
+        optimizedStats.acmr, optimizedStats.atvr, time);
+    close();
+}
+
+int main() {
+    MeshOptimizerApp app;
+    app.run();
+    return 0;
+}
@@ -0,0 +1,37 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#pragma once
+#include "RenderTestApp.h"
+#include "ngfx/drawOps/DrawMeshOp.h"
+#include "ngfx/graphics/MeshData.h"
+#include <memory>
+
+namespace ngfx {
+    class MeshOptimizerApp : public RenderTestApp {
+    public:
+        MeshOptimizerApp();
+        virtual void run();
+        static const uint32_t FRAME_WIDTH = 1920, FRAME_HEIGHT = 1080, NUM_FRAMES = 20;
+    protected:
+        void shuffleMesh(MeshData& meshData);
+        double benchmark(MeshData& meshData);
+    };
+};
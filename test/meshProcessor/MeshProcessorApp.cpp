@@ -0,0 +1,127 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include "MeshProcessorApp.h"
+#include "TestUtil.h"
+#include "ngfx/core/DebugUtil.h"
+#include "ngfx/graphics/MeshProcessor.h"
+#include <glm/gtx/transform.hpp>
+#include <chrono>
+#include <cstdio>
+#include <random>
+using namespace ngfx;
+using namespace glm;
+using namespace std;
+
+/* Turns a sphere into a triangle soup without normals, as exported by some scanners, with a small
+   noise on the positions, then welds the vertices, removes the triangles collapsed at the poles and
+   generates the normals. Checks that the result has the topology and the normals of the sphere,
+   that it doesn't depend on the number of threads, and that it's drawn like the sphere */
+MeshProcessorApp::MeshProcessorApp() : RenderTestApp("MeshProcessor", FRAME_WIDTH, FRAME_HEIGHT) {}
+
+void MeshProcessorApp::createTriangleSoup(const MeshData& meshData, float noise, MeshData& triangleSoup) {
+    mt19937 rng(1);
+    uniform_real_distribution<float> dist(-noise, noise);
+    for (auto& face : meshData.faces) {
+        ivec3 soupFace;
+        for (uint32_t k = 0; k < 3; k++) {
+            soupFace[k] = int(triangleSoup.pos.size());
+            triangleSoup.pos.push_back(meshData.pos[face[k]] + vec3(dist(rng), dist(rng), dist(rng)));
+        }
+        triangleSoup.faces.push_back(soupFace);
+    }
+}
+
+void MeshProcessorApp::render(MeshData& meshData, vector<uint8_t>& pixels) {
+    DrawMeshOp drawMeshOp(graphicsContext.get(), meshData);
+    mat4 modelViewMat = lookAt(vec3(0.0f, 1.0f, 2.5f), vec3(0.0f), vec3(0.0f, 1.0f, 0.0f));
+    mat4 projMat = perspective(radians(60.0f), float(FRAME_WIDTH) / float(FRAME_HEIGHT), 0.1f, 100.0f);
+    mat4 modelViewInverseTransposeMat = transpose(inverse(modelViewMat));
+    mat4 modelViewProjMat = projMat * modelViewMat;
+    DrawMeshOp::LightData lightData;
+    drawMeshOp.update(modelViewMat, modelViewInverseTransposeMat, modelViewProjMat, lightData);
+    renderFrame([&](CommandBuffer* commandBuffer) { drawMeshOp.draw(commandBuffer, graphics.get()); }, pixels);
+}
+
+double MeshProcessorApp::compare(const vector<uint8_t>& pixels, const vector<uint8_t>& refPixels) {
+    double totalDiff = 0.0;
+    for (uint32_t j = 0; j < FRAME_WIDTH * FRAME_HEIGHT; j++) {
+        int maxDiff = 0;
+        for (uint32_t k = 0; k < 4; k++)
+            maxDiff = std::max(maxDiff, abs(int(pixels[j * 4 + k]) - int(refPixels[j * 4 + k])));
+        totalDiff += maxDiff;
+    }
+    return totalDiff / (FRAME_WIDTH * FRAME_HEIGHT);
+}
+
+void MeshProcessorApp::run() {
+    init();
+    createFramebuffer();
+
+    const uint32_t numRings = 250, numSegments = 500;
+    MeshData sphere, triangleSoup;
+    TestUtil::createSphere(numRings, numSegments, sphere);
+    createTriangleSoup(sphere, 1e-6f, triangleSoup);
+
+    // The seam and the poles of the sphere are welded as well,
+    // the triangles that touch the poles collapse on one side
+    MeshProcessor::Options options;
+    options.weldTolerance = 1e-5f;
+    vector<MeshData> results(2, triangleSoup);
+    const uint32_t numThreads[] = { 1, 0 };
+    MeshProcessor::Stats stats;
+    for (uint32_t j = 0; j < 2; j++) {
+        options.numThreads = numThreads[j];
+        auto t0 = chrono::steady_clock::now();
+        stats = MeshProcessor::process(results[j], options);
+        double elapsed = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+        printf("%s: %.1f ms\n", numThreads[j] == 1 ? "1 thread" : "all threads", elapsed);
+    }
+    auto& result = results[1];
+    size_t numVerts = (numRings - 1) * numSegments + 2, numFaces = 2 * (numRings - 1) * numSegments;
+    printf("%zu -> %zu vertices, %u degenerate faces removed\n", triangleSoup.pos.size(), result.pos.size(),
+        stats.numDegenerateFaces);
+    if (result.pos.size() != numVerts || result.faces.size() != numFaces)
+        NGFX_ERR("%zu vertices, %zu faces, expected %zu vertices, %zu faces", result.pos.size(),
+            result.faces.size(), numVerts, numFaces);
+    if (results[0].pos != result.pos || results[0].normal != result.normal || results[0].faces != result.faces)
+        NGFX_ERR("the result depends on the number of threads");
+    for (uint32_t j = 0; j < result.pos.size(); j++) {
+        if (dot(result.normal[j], normalize(result.pos[j])) < 0.999f)
+            NGFX_ERR("vertex %u: the normal doesn't match the sphere normal", j);
+    }
+    if (length(result.bounds[0] - vec3(-1.0f)) > 1e-4f || length(result.bounds[1] - vec3(1.0f)) > 1e-4f)
+        NGFX_ERR("the bounds don't match the sphere bounds");
+
+    vector<uint8_t> refPixels, pixels;
+    render(sphere, refPixels);
+    render(result, pixels);
+    double meanDiff = compare(pixels, refPixels);
+    printf("mean difference: %f\n", meanDiff);
+    if (meanDiff > 1.0) NGFX_ERR("the processed mesh differs from the sphere");
+    close();
+}
+
+int main() {
+    MeshProcessorApp app;
+    app.run();
+    return 0;
+}
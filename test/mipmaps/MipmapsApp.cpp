@@ -0,0 +1,145 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "MipmapsApp.h"
+#include "ngfx/core/DebugUtil.h"
+#include "ngfx/core/Timer.h"
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+using namespace ngfx;
+using namespace std;
+
+/* Compares the blit based mipmap generation with the compute filters.
+   The levels generated by the compute filters are read back and compared with the blit levels,
+   on a gradient, then each filter is timed on noise.
+   Runs headless, e.g. on lavapipe: VK_ICD_FILENAMES=.../lvp_icd.x86_64.json ./mipmaps */
+MipmapsApp::MipmapsApp() : ComputeApplication("Mipmaps") {}
+
+float MipmapsApp::benchmark(Texture* texture, MipmapFilter filter) {
+    texture->mipmapFilter = filter;
+    auto commandBuffer = graphicsContext->copyCommandBuffer();
+    commandBuffer->begin();
+    for (uint32_t j = 0; j < NUM_ITERATIONS; j++) texture->generateMipmaps(commandBuffer);
+    commandBuffer->end();
+    Timer timer;
+    graphicsContext->submit(commandBuffer);
+    graphics->waitIdle(commandBuffer);
+    timer.update();
+    return timer.elapsed * 1000.0f / NUM_ITERATIONS;
+}
+
+void MipmapsApp::generateMipmaps(Texture* texture, MipmapFilter filter, vector<vector<uint8_t>>& levels) {
+    texture->mipmapFilter = filter;
+    auto commandBuffer = graphicsContext->copyCommandBuffer();
+    commandBuffer->begin();
+    texture->generateMipmaps(commandBuffer);
+    commandBuffer->end();
+    graphicsContext->submit(commandBuffer);
+    graphics->waitIdle(commandBuffer);
+    levels.resize(texture->mipLevels);
+    for (uint32_t level = 0; level < texture->mipLevels; level++) {
+        uint32_t levelSize = max(texture->w >> level, 1u);
+        levels[level].resize(levelSize * levelSize * 4);
+        texture->download(levels[level].data(), uint32_t(levels[level].size()), 0, 0, 0, -1, -1, -1, -1, level);
+    }
+}
+
+void MipmapsApp::verify(PixelFormat format, const char* formatName) {
+    // A gradient, which the symmetric filters preserve, so the compute levels match the blit
+    // levels up to the rounding of each level. The sRGB levels are filtered in linear space
+    // by both paths
+    vector<uint8_t> data(VERIFY_SIZE * VERIFY_SIZE * 4);
+    for (uint32_t y = 0; y < VERIFY_SIZE; y++) {
+        for (uint32_t x = 0; x < VERIFY_SIZE; x++) {
+            uint8_t* p = &data[(y * VERIFY_SIZE + x) * 4];
+            p[0] = uint8_t(x); p[1] = uint8_t(y); p[2] = uint8_t(255 - (x + y) / 2); p[3] = 255;
+        }
+    }
+    unique_ptr<Texture> texture(Texture::create(graphicsContext.get(), graphics.get(), data.data(),
+        format, uint32_t(data.size()), VERIFY_SIZE, VERIFY_SIZE, 1, 1,
+        ImageUsageFlags(IMAGE_USAGE_SAMPLED_BIT | IMAGE_USAGE_STORAGE_BIT |
+                        IMAGE_USAGE_TRANSFER_SRC_BIT | IMAGE_USAGE_TRANSFER_DST_BIT),
+        TEXTURE_TYPE_2D, true));
+    vector<vector<uint8_t>> blitLevels, levels;
+    generateMipmaps(texture.get(), MIPMAP_FILTER_BLIT, blitLevels);
+    // The Kaiser filter clamps its wider footprint at the edges, and on the smallest levels the
+    // gradient isn't linear enough in linear space for the filters to agree, so its comparison
+    // skips a border of 2 texels and the levels below 16x16
+    struct Tolerance { MipmapFilter filter; const char* name; int maxError; uint32_t border, minSize; };
+    const Tolerance tolerances[] = {
+        { MIPMAP_FILTER_BOX, "box", 3, 0, 1 }, { MIPMAP_FILTER_KAISER, "kaiser", 4, 2, 16 }
+    };
+    for (auto& tolerance : tolerances) {
+        generateMipmaps(texture.get(), tolerance.filter, levels);
+        int maxError = 0;
+        for (uint32_t level = 1; level < texture->mipLevels; level++) {
+            uint32_t levelSize = max(texture->w >> level, 1u);
+            if (levelSize < tolerance.minSize) break;
+            uint32_t b = tolerance.border;
+            for (uint32_t y = b; y < levelSize - b; y++) {
+                for (uint32_t x = b; x < levelSize - b; x++) {
+                    for (uint32_t k = 0; k < 4; k++) {
+                        uint32_t offset = (y * levelSize + x) * 4 + k;
+                        int error = abs(int(levels[level][offset]) - int(blitLevels[level][offset]));
+                        maxError = max(maxError, error);
+                        if (error > tolerance.maxError)
+                            NGFX_ERR("%s %s: level %u (%u, %u): %u, the blit level has %u", formatName,
+                                tolerance.name, level, x, y, levels[level][offset], blitLevels[level][offset]);
+                    }
+                }
+            }
+        }
+        printf("%s %s: max error: %d\n", formatName, tolerance.name, maxError);
+    }
+}
+
+void MipmapsApp::run() {
+    init();
+    const uint32_t size = TEXTURE_SIZE * TEXTURE_SIZE * 4;
+    vector<uint8_t> data(size);
+    for (uint32_t j = 0; j < size; j++) data[j] = uint8_t(rand() % 256);
+    const vector<pair<PixelFormat, const char*>> formats = {
+        { PIXELFORMAT_RGBA8_UNORM, "RGBA8_UNORM" }, { PIXELFORMAT_RGBA8_SRGB, "RGBA8_SRGB" }
+    };
+    const vector<pair<MipmapFilter, const char*>> filters = {
+        { MIPMAP_FILTER_BLIT, "blit" }, { MIPMAP_FILTER_BOX, "box" }, { MIPMAP_FILTER_KAISER, "kaiser" }
+    };
+    for (auto& format : formats) verify(format.first, format.second);
+    for (auto& format : formats) {
+        unique_ptr<Texture> texture(Texture::create(graphicsContext.get(), graphics.get(), data.data(),
+            format.first, size, TEXTURE_SIZE, TEXTURE_SIZE, 1, 1,
+            ImageUsageFlags(IMAGE_USAGE_SAMPLED_BIT | IMAGE_USAGE_STORAGE_BIT |
+                            IMAGE_USAGE_TRANSFER_SRC_BIT | IMAGE_USAGE_TRANSFER_DST_BIT),
+            TEXTURE_TYPE_2D, true));
+        for (auto& filter : filters) {
+            float elapsed = benchmark(texture.get(), filter.first);
+            printf("%s %ux%u %u levels, %s: %f ms\n", format.second, TEXTURE_SIZE, TEXTURE_SIZE,
+                texture->mipLevels, filter.second, elapsed);
+        }
+    }
+    close();
+}
+
+int main() {
+    MipmapsApp app;
+    app.run();
+    return 0;
+}
@@ -0,0 +1,38 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#pragma once
+#include "ngfx/compute/ComputeApplication.h"
+#include "ngfx/graphics/Texture.h"
+#include <memory>
+#include <vector>
+
+namespace ngfx {
+    class MipmapsApp : public ComputeApplication {
+    public:
+        MipmapsApp();
+        virtual void run();
+        static const uint32_t TEXTURE_SIZE = 4096, NUM_ITERATIONS = 10, VERIFY_SIZE = 256;
+    protected:
+        float benchmark(Texture* texture, MipmapFilter filter);
+        void generateMipmaps(Texture* texture, MipmapFilter filter, std::vector<std::vector<uint8_t>>& levels);
+        void verify(PixelFormat format, const char* formatName);
+    };
+};
@@ -0,0 +1,139 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include "OcclusionCullingApp.h"
+#include "TestUtil.h"
+#include "ngfx/core/DebugUtil.h"
+#include "ngfx/core/Timer.h"
+#include <glm/gtx/transform.hpp>
+using namespace ngfx;
+using namespace glm;
+using namespace std;
+
+/* Renders a wall in front of a grid of spheres headless, and culls the spheres
+   with a Hi-Z occlusion pass on the GPU.
+   The first frame has no visibility history, so only the frustum culling applies.
+   In the following frames the wall is drawn to the depth buffer first, and every
+   sphere behind it must be occluded */
+OcclusionCullingApp::OcclusionCullingApp() : RenderTestApp("OcclusionCulling", FRAME_WIDTH, FRAME_HEIGHT) {}
+
+void OcclusionCullingApp::createScene(uint32_t gridSize, vector<mat4>& modelMats, vector<vec4>& colors) {
+    // The wall: a flattened sphere that covers the grid
+    modelMats.push_back(translate(vec3(0.0f, 0.0f, 1.0f)) * scale(vec3(2.0f, 2.0f, 0.05f)));
+    colors.push_back(vec4(0.5f, 0.5f, 0.5f, 1.0f));
+    // Two spheres on each side of the wall, inside the frustum
+    for (float x : { -2.6f, 2.6f }) {
+        modelMats.push_back(translate(vec3(x, 0.0f, 1.0f)) * scale(vec3(0.2f)));
+        colors.push_back(vec4(0.0f, 1.0f, 0.0f, 1.0f));
+    }
+    // Two spheres outside the frustum
+    for (float x : { -20.0f, 20.0f }) {
+        modelMats.push_back(translate(vec3(x, 0.0f, 1.0f)) * scale(vec3(0.2f)));
+        colors.push_back(vec4(1.0f, 0.0f, 0.0f, 1.0f));
+    }
+    // The grid behind the wall
+    float cellSize = 2.4f / gridSize;
+    for (uint32_t j = 0; j < gridSize * gridSize * gridSize; j++) {
+        uvec3 cell(j % gridSize, (j / gridSize) % gridSize, j / (gridSize * gridSize));
+        vec3 center = vec3(-1.2f, -1.2f, -4.0f) + (vec3(cell) + 0.5f) * vec3(cellSize, cellSize, 3.0f / gridSize);
+        modelMats.push_back(translate(center) * scale(vec3(0.4f * cellSize)));
+        colors.push_back(vec4(vec3(cell) / float(gridSize), 1.0f));
+    }
+}
+
+void OcclusionCullingApp::drawPass(CommandBuffer* commandBuffer, DrawMeshInstancedOp* drawOp, HiZCullOp* cullOp) {
+    beginRenderPass(commandBuffer);
+    drawOp->drawIndirect(commandBuffer, graphics.get(), cullOp->bDrawArgs.get(),
+        cullOp->bVisibleModel.get(), cullOp->bVisibleColor.get());
+    graphics->endRenderPass(commandBuffer);
+}
+
+void OcclusionCullingApp::benchmark(uint32_t gridSize) {
+    vector<mat4> modelMats;
+    vector<vec4> colors;
+    createScene(gridSize, modelMats, colors);
+    uint32_t numInstances = uint32_t(modelMats.size()), numHidden = gridSize * gridSize * gridSize;
+    DrawMeshInstancedOp drawMeshInstancedOp(graphicsContext.get(), meshData, numInstances);
+    drawMeshInstancedOp.update(viewMat, projMat, lightData);
+    drawMeshInstancedOp.updateInstances(modelMats, colors);
+    HiZCullOp hizCullOp(graphicsContext.get(), meshData, FRAME_WIDTH, FRAME_HEIGHT);
+    hizCullOp.update(projMat * viewMat, drawMeshInstancedOp.bInstanceModel.get(),
+        drawMeshInstancedOp.bInstanceColor.get(), numInstances);
+
+    auto commandBuffer = graphicsContext->copyCommandBuffer();
+    Timer timer;
+    for (uint32_t j = 0; j < NUM_FRAMES; j++) {
+        commandBuffer->begin();
+        // Phase 1: draw the instances that were visible in the previous frame
+        // to the depth buffer, and build the depth pyramid
+        hizCullOp.cullPreviousVisible(commandBuffer, graphics.get());
+        drawPass(commandBuffer, &drawMeshInstancedOp, &hizCullOp);
+        hizCullOp.buildDepthPyramid(commandBuffer, graphics.get(), depthTexture.get());
+        // Phase 2: test every instance against the depth pyramid and draw the visible ones
+        hizCullOp.apply(commandBuffer, graphics.get());
+        drawPass(commandBuffer, &drawMeshInstancedOp, &hizCullOp);
+        commandBuffer->end();
+        graphicsContext->submit(commandBuffer);
+        graphics->waitIdle(commandBuffer);
+
+        auto stats = hizCullOp.getStats();
+        if (stats.numVisible + stats.numFrustumCulled + stats.numOcclusionCulled != numInstances)
+            NGFX_ERR("frame %u: %u visible, %u frustum culled, %u occlusion culled, expected %u instances", j,
+                stats.numVisible, stats.numFrustumCulled, stats.numOcclusionCulled, numInstances);
+        if (stats.numFrustumCulled != 2)
+            NGFX_ERR("frame %u: %u frustum culled, expected 2", j, stats.numFrustumCulled);
+        // Without history, nothing is drawn to the depth buffer in the first frame
+        uint32_t expectedOcclusionCulled = (j == 0) ? 0 : numHidden;
+        if (stats.numOcclusionCulled != expectedOcclusionCulled)
+            NGFX_ERR("frame %u: %u occlusion culled, expected %u", j, stats.numOcclusionCulled,
+                expectedOcclusionCulled);
+        if (j == NUM_FRAMES - 1)
+            printf("%u instances: %u visible, %u frustum culled, %u occlusion culled\n", numInstances,
+                stats.numVisible, stats.numFrustumCulled, stats.numOcclusionCulled);
+    }
+    timer.update();
+    printf("%u instances, Hi-Z occlusion culling: %f fps\n", numInstances, NUM_FRAMES / timer.elapsed);
+}
+
+void OcclusionCullingApp::run() {
+    init();
+    TestUtil::createSphere(8, 16, meshData);
+    viewMat = lookAt(vec3(0.0f, 0.0f, 5.0f), vec3(0.0f), vec3(0.0f, 1.0f, 0.0f));
+    projMat = perspective(radians(60.0f), float(FRAME_WIDTH) / float(FRAME_HEIGHT), 0.1f, 100.0f);
+    // The depth buffer is sampled by the depth pyramid pass after the render pass
+    GraphicsContext::RenderPassConfig renderPassConfig = {
+        { { PIXELFORMAT_RGBA8_UNORM, nullopt, nullopt } },
+        GraphicsContext::AttachmentDescription { graphicsContext->depthFormat, nullopt,
+            IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL },
+        false, 1 };
+    createFramebuffer(graphicsContext->getRenderPass(renderPassConfig),
+        ImageUsageFlags(IMAGE_USAGE_SAMPLED_BIT | IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT));
+    for (uint32_t gridSize : { 10, 30 }) {
+        benchmark(gridSize);
+    }
+    close();
+}
+
+int main() {
+    OcclusionCullingApp app;
+    app.run();
+    return 0;
+}
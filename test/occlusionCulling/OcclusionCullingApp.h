@@ -0,0 +1,43 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#pragma once
+#include "RenderTestApp.h"
+#include "ngfx/computeOps/HiZCullOp.h"
+#include "ngfx/drawOps/DrawMeshInstancedOp.h"
+#include "ngfx/graphics/MeshData.h"
+#include <memory>
+#include <vector>
+
+namespace ngfx {
+    class OcclusionCullingApp : public RenderTestApp {
+    public:
+        OcclusionCullingApp();
+        virtual void run();
+        static const uint32_t FRAME_WIDTH = 1024, FRAME_HEIGHT = 768, NUM_FRAMES = 10;
+    protected:
+        void createScene(uint32_t gridSize, std::vector<mat4>& modelMats, std::vector<vec4>& colors);
+        void drawPass(CommandBuffer* commandBuffer, DrawMeshInstancedOp* drawOp, HiZCullOp* cullOp);
+        void benchmark(uint32_t gridSize);
+        MeshData meshData;
+        mat4 viewMat, projMat;
+        DrawMeshOp::LightData lightData;
+    };
+};
@@ -0,0 +1,116 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "OffscreenApp.h"
+#include "ngfx/core/DebugUtil.h"
+#include "ngfx/core/Timer.h"
+#include "ngfx/graphics/ImageWriter.h"
+#include <array>
+#include <cinttypes>
+using namespace ngfx;
+using namespace glm;
+using namespace std;
+
+/* Renders a sequence of frames headless and reads back the pixels,
+   with one frame in flight (render, wait, read back) and with a ring of frames.
+   Each frame is cleared with a color derived from its index, so the pixels returned
+   for each frame are checked to come from that frame.
+   Then writes the sequence to PNG files with a pool of encoder threads */
+OffscreenApp::OffscreenApp() : ComputeApplication("Offscreen") {}
+
+typedef std::array<uint8_t, 4> Color;
+
+static Color getClearColor(uint64_t frameIndex) {
+    // The blue channel is always set, so the clear color never matches the triangle
+    return { uint8_t(frameIndex % 256), uint8_t((frameIndex * 37) % 256),
+        uint8_t(128 + (frameIndex * 11) % 128), 255 };
+}
+
+void OffscreenApp::validateFrame(const OffscreenRenderer::Frame& frame) {
+    if (frame.w != FRAME_WIDTH || frame.h != FRAME_HEIGHT || frame.size != frame.w * frame.h * 4)
+        NGFX_ERR("frame %" PRIu64 ": invalid size: %ux%u, %u bytes", frame.index, frame.w, frame.h, frame.size);
+    const Color clearColor = getClearColor(frame.index), triangleColor = { 255, 0, 0, 255 };
+    const Color* pixels = (const Color*)frame.data;
+    uint32_t numClearPixels = 0, numTrianglePixels = 0;
+    for (uint32_t j = 0; j < frame.w * frame.h; j++) {
+        const Color& c = pixels[j];
+        if (c == clearColor) numClearPixels++;
+        else if (c == triangleColor) numTrianglePixels++;
+        else NGFX_ERR("frame %" PRIu64 ": pixel (%u, %u): (%u, %u, %u, %u), "
+            "expected clear color (%u, %u, %u, %u)", frame.index, j % frame.w, j / frame.w, c[0], c[1], c[2], c[3],
+            clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+    }
+    // The triangle covers half of the frame
+    int halfSize = frame.w * frame.h / 2;
+    if (abs(int(numTrianglePixels) - halfSize) > int(frame.w + frame.h))
+        NGFX_ERR("frame %" PRIu64 ": %u triangle pixels, %u clear pixels", frame.index, numTrianglePixels,
+            numClearPixels);
+}
+
+float OffscreenApp::benchmark(uint32_t numFramesInFlight, bool validate, ImageWriter* imageWriter) {
+    unique_ptr<OffscreenRenderer> renderer(OffscreenRenderer::create(graphicsContext.get(),
+        graphics.get(), FRAME_WIDTH, FRAME_HEIGHT, numFramesInFlight));
+    uint64_t nextFrame = 0;
+    renderer->onFrameReady = [&](const OffscreenRenderer::Frame& frame) {
+        if (frame.index != nextFrame) NGFX_ERR("frame %" PRIu64 " out of order", frame.index);
+        nextFrame++;
+        if (validate) validateFrame(frame);
+        if (imageWriter) imageWriter->write(frame.index, frame.data, frame.w, frame.h);
+    };
+    Timer timer;
+    for (uint32_t j = 0; j < NUM_FRAMES; j++) {
+        // The clear color is recorded in the frame's render pass
+        Color clearColor = getClearColor(renderer->frameIndex);
+        graphicsContext->clearColor = vec4(clearColor[0], clearColor[1], clearColor[2], clearColor[3]) / 255.0f;
+        renderer->renderFrame([&](CommandBuffer* commandBuffer, uint64_t) {
+            drawColorOp->draw(commandBuffer, graphics.get());
+        });
+    }
+    renderer->flush();
+    if (nextFrame != NUM_FRAMES) NGFX_ERR("%" PRIu64 " frames returned, expected %u", nextFrame, NUM_FRAMES);
+    if (imageWriter) imageWriter->finish();
+    timer.update();
+    return NUM_FRAMES / timer.elapsed;
+}
+
+void OffscreenApp::run() {
+    init();
+    drawColorOp.reset(new DrawColorOp(graphicsContext.get(),
+        { vec2(-1.0f, -1.0f), vec2(1.0f, -1.0f), vec2(0.0f, 1.0f) },
+        vec4(1.0, 0.0, 0.0, 1.0)));
+    for (uint32_t numFramesInFlight : { 1, 2, 3, 4 }) {
+        // Check the pixels in a separate run, so the check isn't included in the timings
+        benchmark(numFramesInFlight, true);
+        float fps = benchmark(numFramesInFlight);
+        printf("%ux%u, %u frames in flight: %f fps\n", FRAME_WIDTH, FRAME_HEIGHT, numFramesInFlight, fps);
+    }
+    ImageWriter imageWriter("offscreen_%03d.png");
+    float fps = benchmark(3, false, &imageWriter);
+    auto stats = imageWriter.getStats();
+    printf("%ux%u, PNG output: %f fps, encode time: %f s, renderer blocked: %f s\n", FRAME_WIDTH, FRAME_HEIGHT,
+        fps, stats.encodeTime, stats.waitTime);
+    close();
+}
+
+int main() {
+    OffscreenApp app;
+    app.run();
+    return 0;
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include "QuantizedMeshApp.h"
+#include "TestUtil.h"
+#include "ngfx/core/DebugUtil.h"
+#include "ngfx/graphics/MeshUtil.h"
+#include <glm/gtx/transform.hpp>
+#include <cstdio>
+#include <cstdlib>
+using namespace ngfx;
+using namespace glm;
+using namespace std;
+
+/* Renders a sphere with each vertex encoding, after a round trip through the mesh file format,
+   and compares the result with the float mesh */
+QuantizedMeshApp::QuantizedMeshApp() : RenderTestApp("QuantizedMesh", FRAME_WIDTH, FRAME_HEIGHT) {}
+
+void QuantizedMeshApp::render(DrawMeshOp& drawMeshOp, vector<uint8_t>& pixels) {
+    mat4 modelViewMat = lookAt(vec3(0.0f, 0.0f, 3.0f), vec3(0.0f), vec3(0.0f, 1.0f, 0.0f));
+    mat4 modelViewInverseTransposeMat = transpose(inverse(modelViewMat));
+    mat4 projMat = perspective(radians(60.0f), float(FRAME_WIDTH) / float(FRAME_HEIGHT), 0.1f, 100.0f);
+    mat4 modelViewProjMat = projMat * modelViewMat;
+    DrawMeshOp::LightData lightData;
+    drawMeshOp.update(modelViewMat, modelViewInverseTransposeMat, modelViewProjMat, lightData);
+    renderFrame([&](CommandBuffer* commandBuffer) { drawMeshOp.draw(commandBuffer, graphics.get()); }, pixels);
+}
+
+void QuantizedMeshApp::run() {
+    init();
+    createFramebuffer();
+
+    MeshData meshData;
+    TestUtil::createSphere(100, 200, meshData);
+    vector<uint8_t> refPixels, pixels;
+    {
+        DrawMeshOp drawMeshOp(graphicsContext.get(), meshData);
+        render(drawMeshOp, refPixels);
+    }
+    uint32_t floatSize = uint32_t(meshData.pos.size() * sizeof(vec3) + meshData.normal.size() * sizeof(vec3) +
+        meshData.faces.size() * sizeof(ivec3));
+    struct Encoding {
+        const char* name;
+        PositionEncoding posEncoding;
+        NormalEncoding normalEncoding;
+    };
+    const Encoding encodings[] = {
+        { "float/float", POSITION_ENCODING_FLOAT3, NORMAL_ENCODING_FLOAT3 },
+        { "half/half", POSITION_ENCODING_HALF4, NORMAL_ENCODING_HALF4 },
+        { "unorm16/snorm8", POSITION_ENCODING_UNORM16, NORMAL_ENCODING_SNORM8 },
+        { "unorm16/unorm10", POSITION_ENCODING_UNORM16, NORMAL_ENCODING_UNORM10 },
+        { "unorm16/oct16", POSITION_ENCODING_UNORM16, NORMAL_ENCODING_OCT16 },
+        { "unorm16/oct8", POSITION_ENCODING_UNORM16, NORMAL_ENCODING_OCT8 }
+    };
+    const char* file = "quantizedMesh.mesh";
+    for (auto& encoding : encodings) {
+        QuantizedMeshData quantizedMeshData;
+        MeshUtil::quantizeMesh(meshData, quantizedMeshData, encoding.posEncoding, encoding.normalEncoding);
+        MeshUtil::exportMesh(file, quantizedMeshData);
+        quantizedMeshData = QuantizedMeshData();
+        MeshUtil::importMesh(file, quantizedMeshData);
+        if (quantizedMeshData.indexSize != 2)
+            NGFX_ERR("%s: %u-byte indices, expected 16-bit indices", encoding.name, quantizedMeshData.indexSize);
+        {
+            DrawMeshOp drawMeshOp(graphicsContext.get(), quantizedMeshData);
+            render(drawMeshOp, pixels);
+        }
+        // Count the pixels that differ noticeably from the float mesh, e.g. on the silhouette
+        uint32_t numDiffs = 0;
+        double totalDiff = 0.0;
+        for (uint32_t j = 0; j < FRAME_WIDTH * FRAME_HEIGHT; j++) {
+            int maxDiff = 0;
+            for (uint32_t k = 0; k < 4; k++)
+                maxDiff = std::max(maxDiff, abs(int(pixels[j * 4 + k]) - int(refPixels[j * 4 + k])));
+            totalDiff += maxDiff;
+            if (maxDiff > 16) numDiffs++;
+        }
+        double meanDiff = totalDiff / (FRAME_WIDTH * FRAME_HEIGHT);
+        uint32_t quantizedSize = uint32_t(quantizedMeshData.pos.size() + quantizedMeshData.normal.size() +
+            quantizedMeshData.indices.size());
+        printf("%s: %u bytes per vertex, %u -> %u bytes (%.2fx), mean difference: %f, different pixels: %u\n",
+            encoding.name, quantizedMeshData.posStride() + quantizedMeshData.normalStride(), floatSize,
+            quantizedSize, double(floatSize) / quantizedSize, meanDiff, numDiffs);
+        if (meanDiff > 1.0 || numDiffs > FRAME_WIDTH * FRAME_HEIGHT / 100)
+            NGFX_ERR("%s: the quantized mesh differs from the float mesh", encoding.name);
+    }
+    remove(file);
+    close();
+}
+
+int main() {
+    QuantizedMeshApp app;
+    app.run();
+    return 0;
+}
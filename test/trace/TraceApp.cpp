@@ -0,0 +1,93 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "TraceApp.h"
+#include "ngfx/core/DebugUtil.h"
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <thread>
+using namespace ngfx;
+using namespace std;
+
+/* Records CPU trace events from a thread that overflows its ring buffer while
+   the events are dumped, and checks that the dumps only contain whole events.
+   Doesn't require a GPU */
+uint32_t TraceApp::checkDump(const string& filename, const string& name) {
+    ifstream in(filename);
+    if (!in.is_open())
+        NGFX_ERR("cannot open file: %s", filename.c_str());
+    stringstream sstream;
+    sstream << in.rdbuf();
+    string contents = sstream.str();
+    if (contents.find("{\"traceEvents\":[") != 0 || contents.find("],\"displayTimeUnit\"") == string::npos)
+        NGFX_ERR("%s: invalid trace file", filename.c_str());
+    // Each event lasts 1 us, a torn event would mix the timestamps of two events
+    const string durKey = "\"dur\":";
+    size_t pos = 0;
+    while ((pos = contents.find(durKey, pos)) != string::npos) {
+        pos += durKey.size();
+        double dur = stod(contents.substr(pos, contents.find('}', pos) - pos));
+        if (dur != 1.0)
+            NGFX_ERR("%s: event with duration %f us, expected 1 us", filename.c_str(), dur);
+    }
+    uint32_t numEvents = 0;
+    const string nameKey = "{\"name\":\"" + name + "\",\"cat\"";
+    for (pos = contents.find(nameKey); pos != string::npos; pos = contents.find(nameKey, pos + 1))
+        numEvents++;
+    return numEvents;
+}
+
+void TraceApp::run() {
+    Trace::clear();
+    atomic<bool> done = { false };
+    thread worker([&]() {
+        Trace::setThreadName("worker");
+        for (uint64_t j = 0; j < NUM_EVENTS || !done; j++) Trace::addEvent("worker", j * 2000, j * 2000 + 1000);
+    });
+    // Dump while the worker overwrites its oldest events
+    for (uint32_t j = 0; j < NUM_DUMPS; j++) {
+        Trace::dump("trace_concurrent.json");
+        uint32_t numEvents = checkDump("trace_concurrent.json", "worker");
+        if (numEvents >= Trace::BUFFER_SIZE)
+            NGFX_ERR("%u events in a dump, expected at most %u", numEvents, Trace::BUFFER_SIZE - 1);
+    }
+    done = true;
+    worker.join();
+    uint64_t start = Trace::now();
+    for (uint64_t j = 0; j < 10; j++) Trace::addEvent("main", start + j * 2000, start + j * 2000 + 1000);
+    Trace::dump("trace.json");
+    uint32_t numWorkerEvents = checkDump("trace.json", "worker"), numMainEvents = checkDump("trace.json", "main");
+    if (numWorkerEvents != Trace::BUFFER_SIZE - 1)
+        NGFX_ERR("worker: %u events, expected %u", numWorkerEvents, Trace::BUFFER_SIZE - 1);
+    if (numMainEvents != 10)
+        NGFX_ERR("main: %u events, expected 10", numMainEvents);
+    Trace::clear();
+    Trace::dump("trace_cleared.json");
+    if (checkDump("trace_cleared.json", "worker") != 0 || checkDump("trace_cleared.json", "main") != 0)
+        NGFX_ERR("events left after Trace::clear");
+    printf("Trace: %u dumps while recording, %u events kept per thread\n", NUM_DUMPS, numWorkerEvents);
+}
+
+int main() {
+    TraceApp app;
+    app.run();
+    return 0;
+}
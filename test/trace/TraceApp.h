@@ -0,0 +1,35 @@
+/*
+ * Copyright 2020 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#pragma once
+#include "ngfx/core/Trace.h"
+#include <string>
+
+namespace ngfx {
+    class TraceApp {
+    public:
+        virtual void run();
+        /** The worker records at least NUM_EVENTS events, and until the dumps are done */
+        static const uint32_t NUM_EVENTS = Trace::BUFFER_SIZE + 1000, NUM_DUMPS = 10;
+    protected:
+        /** Check the events of a dump, returns the number of events with the name */
+        uint32_t checkDump(const std::string& filename, const std::string& name);
+    };
+};
@@ -0,0 +1,105 @@
+#include "KTXTool.h"
+#include "ngfx/core/DebugUtil.h"
+#include "ngfx/graphics/PixelFormatUtil.h"
+#include "ngfx/graphics/TextureCodec.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <stb_image.h>
+using namespace ngfx;
+using namespace std;
+
+void KTXTool::loadImage(const std::string& file, uint32_t& w, uint32_t& h, std::vector<uint8_t>& rgba) {
+	int iw, ih, channels;
+	stbi_uc* data = stbi_load(file.c_str(), &iw, &ih, &channels, 4);
+	if (!data) NGFX_ERR("cannot load image: %s", file.c_str());
+	w = uint32_t(iw); h = uint32_t(ih);
+	rgba.assign(data, data + size_t(w) * h * 4);
+	stbi_image_free(data);
+}
+
+static float toLinear(uint8_t v) {
+	float c = v / 255.0f;
+	return (c <= 0.04045f) ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+}
+
+static uint8_t fromLinear(float c) {
+	c = (c <= 0.0031308f) ? c * 12.92f : 1.055f * powf(c, 1.0f / 2.4f) - 0.055f;
+	return uint8_t(std::min(std::max(c * 255.0f + 0.5f, 0.0f), 255.0f));
+}
+
+void KTXTool::generateMipmaps(uint32_t w, uint32_t h, bool srgb, std::vector<std::vector<uint8_t>>& levels) {
+	uint32_t mipLevels = uint32_t(floor(log2(float(std::max(w, h))))) + 1;
+	float linear[256];
+	for (uint32_t j = 0; j < 256; j++) linear[j] = srgb ? toLinear(uint8_t(j)) : j / 255.0f;
+	levels.resize(mipLevels);
+	for (uint32_t level = 1; level < mipLevels; level++) {
+		uint32_t srcW = std::max(w >> (level - 1), 1u), srcH = std::max(h >> (level - 1), 1u);
+		uint32_t dstW = std::max(w >> level, 1u), dstH = std::max(h >> level, 1u);
+		auto& src = levels[level - 1];
+		auto& dst = levels[level];
+		dst.resize(size_t(dstW) * dstH * 4);
+		for (uint32_t y = 0; y < dstH; y++) {
+			for (uint32_t x = 0; x < dstW; x++) {
+				// The last row and column of an odd size are clamped
+				uint32_t x0 = std::min(2 * x, srcW - 1), x1 = std::min(2 * x + 1, srcW - 1);
+				uint32_t y0 = std::min(2 * y, srcH - 1), y1 = std::min(2 * y + 1, srcH - 1);
+				const uint8_t* p[4] = { &src[(size_t(y0) * srcW + x0) * 4], &src[(size_t(y0) * srcW + x1) * 4],
+					&src[(size_t(y1) * srcW + x0) * 4], &src[(size_t(y1) * srcW + x1) * 4] };
+				uint8_t* q = &dst[(size_t(y) * dstW + x) * 4];
+				for (uint32_t k = 0; k < 3; k++) {
+					float c = 0.25f * (linear[p[0][k]] + linear[p[1][k]] + linear[p[2][k]] + linear[p[3][k]]);
+					q[k] = srgb ? fromLinear(c) : uint8_t(c * 255.0f + 0.5f);
+				}
+				q[3] = uint8_t((p[0][3] + p[1][3] + p[2][3] + p[3][3] + 2) / 4);
+			}
+		}
+	}
+}
+
+static uint32_t getNumChannels(PixelFormat format) {
+	if (format == PIXELFORMAT_BC4_UNORM) return 1;
+	// BC1 stores 1-bit alpha, the PSNR only measures the opaque texels
+	if (format == PIXELFORMAT_BC1_RGBA_UNORM || format == PIXELFORMAT_BC1_RGBA_SRGB) return 3;
+	if (format == PIXELFORMAT_BC5_UNORM) return 2;
+	if (format == PIXELFORMAT_ETC2_RGB8_UNORM || format == PIXELFORMAT_ETC2_RGB8_SRGB) return 3;
+	return 4;
+}
+
+void KTXTool::encode(PixelFormat format, uint32_t w, uint32_t h,
+		const std::vector<std::vector<uint8_t>>& levels, KTXFile& ktxFile) {
+	ktxFile.format = format;
+	ktxFile.w = w; ktxFile.h = h;
+	ktxFile.mipLevels = uint32_t(levels.size());
+	ktxFile.data.resize(ktxFile.getLevelOffset(ktxFile.mipLevels));
+	bool compressed = PixelFormatUtil::isCompressed(format);
+	auto t0 = chrono::steady_clock::now();
+	for (uint32_t level = 0; level < ktxFile.mipLevels; level++) {
+		uint8_t* data = &ktxFile.data[ktxFile.getLevelOffset(level)];
+		if (compressed) TextureCodec::encode(format, levels[level].data(), std::max(w >> level, 1u),
+			std::max(h >> level, 1u), data);
+		else memcpy(data, levels[level].data(), levels[level].size());
+	}
+	double elapsed = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+	printf("%u levels: %zu -> %zu bytes (%.2f s)\n", ktxFile.mipLevels, size_t(w) * h * 4,
+		ktxFile.data.size(), elapsed);
+	if (!compressed) return;
+	// The PSNR of the first level, over the channels stored by the format
+	vector<uint8_t> decoded(size_t(w) * h * 4);
+	TextureCodec::decode(format, ktxFile.data.data(), w, h, decoded.data());
+	uint32_t numChannels = getNumChannels(format);
+	double squaredError = 0.0;
+	size_t numTexels = 0;
+	for (size_t j = 0; j < size_t(w) * h; j++) {
+		if (numChannels == 3 && decoded[j * 4 + 3] == 0) continue;
+		numTexels++;
+		for (uint32_t k = 0; k < numChannels; k++) {
+			double diff = double(levels[0][j * 4 + k]) - double(decoded[j * 4 + k]);
+			squaredError += diff * diff;
+		}
+	}
+	double mse = squaredError / (double(std::max(numTexels, size_t(1))) * numChannels);
+	printf("PSNR: %.2f dB\n", (mse > 0.0) ? 10.0 * log10(255.0 * 255.0 / mse) : INFINITY);
+}
\ No newline at end of file
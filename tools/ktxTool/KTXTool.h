@@ -0,0 +1,17 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "ngfx/graphics/KTXFile.h"
+
+namespace ngfx {
+	struct KTXTool {
+		/** Load an image (e.g. PNG) as RGBA8 */
+		static void loadImage(const std::string& file, uint32_t& w, uint32_t& h, std::vector<uint8_t>& rgba);
+		/** Generate the mip levels down to 1x1 from the first level, with a box filter.
+		 *  The sRGB images are filtered in linear space */
+		static void generateMipmaps(uint32_t w, uint32_t h, bool srgb, std::vector<std::vector<uint8_t>>& levels);
+		/** Encode the levels, and print the size, the PSNR and the encoding time */
+		static void encode(PixelFormat format, uint32_t w, uint32_t h,
+			const std::vector<std::vector<uint8_t>>& levels, KTXFile& ktxFile);
+	};
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#include "KTXTool.h"
+#include "ngfx/core/DebugUtil.h"
+#include "ngfx/graphics/PixelFormatUtil.h"
+#include <cstring>
+#include <map>
+#include <string>
+using namespace ngfx;
+using namespace std;
+
+struct FormatOption {
+	PixelFormat format, srgbFormat;
+};
+static const map<string, FormatOption> formatMap = {
+	{ "bc1", { PIXELFORMAT_BC1_RGBA_UNORM, PIXELFORMAT_BC1_RGBA_SRGB } },
+	{ "bc3", { PIXELFORMAT_BC3_UNORM, PIXELFORMAT_BC3_SRGB } },
+	{ "bc4", { PIXELFORMAT_BC4_UNORM, PIXELFORMAT_UNDEFINED } },
+	{ "bc5", { PIXELFORMAT_BC5_UNORM, PIXELFORMAT_UNDEFINED } },
+	{ "etc2rgb", { PIXELFORMAT_ETC2_RGB8_UNORM, PIXELFORMAT_ETC2_RGB8_SRGB } },
+	{ "etc2rgba", { PIXELFORMAT_ETC2_RGBA8_UNORM, PIXELFORMAT_ETC2_RGBA8_SRGB } },
+	{ "rgba8", { PIXELFORMAT_RGBA8_UNORM, PIXELFORMAT_RGBA8_SRGB } }
+};
+
+int main(int argc, char** argv) {
+	bool srgb = false, mipmaps = false;
+	string formatName = "bc3";
+	int argIndex = 1;
+	for (; argIndex < argc && argv[argIndex][0] == '-'; argIndex++) {
+		if (strcmp(argv[argIndex], "-format") == 0 && argIndex + 1 < argc) formatName = argv[++argIndex];
+		else if (strcmp(argv[argIndex], "-srgb") == 0) srgb = true;
+		else if (strcmp(argv[argIndex], "-mipmaps") == 0) mipmaps = true;
+		else NGFX_ERR("unknown option: %s", argv[argIndex]);
+	}
+	if ((argc - argIndex) != 2) NGFX_ERR("usage: ./ktxTool [-format bc1|bc3|bc4|bc5|etc2rgb|etc2rgba|rgba8] "
+		"[-srgb] [-mipmaps] <input> <output.ktx2>");
+	auto it = formatMap.find(formatName);
+	if (it == formatMap.end()) NGFX_ERR("unknown format: %s", formatName.c_str());
+	PixelFormat format = srgb ? it->second.srgbFormat : it->second.format;
+	if (format == PIXELFORMAT_UNDEFINED) NGFX_ERR("format %s doesn't have an sRGB variant", formatName.c_str());
+	uint32_t w, h;
+	vector<vector<uint8_t>> levels(1);
+	KTXTool::loadImage(argv[argIndex], w, h, levels[0]);
+	if (mipmaps) KTXTool::generateMipmaps(w, h, srgb, levels);
+	KTXFile ktxFile;
+	KTXTool::encode(format, w, h, levels, ktxFile);
+	ktxFile.save(argv[argIndex + 1]);
+}
\ No newline at end of file
@@ -1,11 +1,70 @@
-#include "ngfx/MeshTool.h"
+#include "MeshTool.h"
 #include "ngfx/graphics/MeshUtil.h"
 #include "ngfx/core/DebugUtil.h"
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
 using namespace ngfx;
+using namespace std;
+
+static const map<string, PositionEncoding> positionEncodingMap = {
+	{ "float", POSITION_ENCODING_FLOAT3 }, { "half", POSITION_ENCODING_HALF4 },
+	{ "unorm16", POSITION_ENCODING_UNORM16 }
+};
+static const map<string, NormalEncoding> normalEncodingMap = {
+	{ "float", NORMAL_ENCODING_FLOAT3 }, { "half", NORMAL_ENCODING_HALF4 },
+	{ "snorm8", NORMAL_ENCODING_SNORM8 }, { "unorm10", NORMAL_ENCODING_UNORM10 },
+	{ "oct16", NORMAL_ENCODING_OCT16 }, { "oct8", NORMAL_ENCODING_OCT8 }
+};
+
+template <typename T>
+static T parseEncoding(const map<string, T>& encodingMap, const char* value) {
+	auto it = encodingMap.find(value);
+	if (it == encodingMap.end()) NGFX_ERR("unknown encoding: %s", value);
+	return it->second;
+}
 
 int main(int argc, char** argv) {
-	if (argc != 3) ERR("usage: ./MeshUtil <input> <output>");
+	bool lods = false, optimize = false, meshlets = false, quantize = false;
+	bool weld = false, generateNormals = false, bvh = false;
+	float weldTolerance = 0.0f;
+	PositionEncoding posEncoding = POSITION_ENCODING_UNORM16;
+	NormalEncoding normalEncoding = NORMAL_ENCODING_OCT16;
+	int argIndex = 1;
+	for (; argIndex < argc && argv[argIndex][0] == '-'; argIndex++) {
+		if (strcmp(argv[argIndex], "-weld") == 0 && argIndex + 1 < argc) {
+			weld = true;
+			weldTolerance = float(atof(argv[++argIndex]));
+		}
+		else if (strcmp(argv[argIndex], "-generateNormals") == 0) generateNormals = true;
+		else if (strcmp(argv[argIndex], "-lods") == 0) lods = true;
+		else if (strcmp(argv[argIndex], "-optimize") == 0) optimize = true;
+		else if (strcmp(argv[argIndex], "-meshlets") == 0) meshlets = true;
+		else if (strcmp(argv[argIndex], "-quantize") == 0) quantize = true;
+		else if (strcmp(argv[argIndex], "-bvh") == 0) bvh = true;
+		else if (strcmp(argv[argIndex], "-positions") == 0 && argIndex + 1 < argc)
+			posEncoding = parseEncoding(positionEncodingMap, argv[++argIndex]);
+		else if (strcmp(argv[argIndex], "-normals") == 0 && argIndex + 1 < argc)
+			normalEncoding = parseEncoding(normalEncodingMap, argv[++argIndex]);
+		else NGFX_ERR("unknown option: %s", argv[argIndex]);
+	}
+	if ((argc - argIndex) != 2) NGFX_ERR("usage: ./meshTool [-weld <tolerance>] [-generateNormals] "
+		"[-lods] [-optimize] [-meshlets] [-quantize] [-bvh] "
+		"[-positions float|half|unorm16] [-normals float|half|snorm8|unorm10|oct16|oct8] <input> <output>");
 	MeshData meshData;
-	MeshTool::importPLY(argv[1], meshData);
-	MeshUtil::exportMesh(argv[2], meshData);
+	MeshTool::importPLY(argv[argIndex], meshData);
+	MeshTool::process(meshData, weld, weldTolerance, generateNormals);
+	if (lods) MeshTool::generateLODs(meshData);
+	if (optimize) MeshTool::optimize(meshData);
+	if (meshlets) MeshTool::buildMeshlets(meshData);
+	if (quantize) {
+		QuantizedMeshData quantizedMeshData;
+		MeshTool::quantize(meshData, quantizedMeshData, posEncoding, normalEncoding);
+		MeshUtil::exportMesh(argv[argIndex + 1], quantizedMeshData);
+		// The BVH bounds the vertices as they are loaded
+		if (bvh) MeshUtil::dequantizeMesh(quantizedMeshData, meshData);
+	}
+	else MeshUtil::exportMesh(argv[argIndex + 1], meshData);
+	if (bvh) MeshTool::buildBVH(meshData, string(argv[argIndex + 1]) + ".bvh");
 }
\ No newline at end of file
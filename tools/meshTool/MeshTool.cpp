@@ -1,45 +1,67 @@
-#include "ngfx/MeshTool.h"
+#include "MeshTool.h"
 #include "ngfx/core/DebugUtil.h"
-#include <glm/gtc/type_ptr.hpp>
+#include "ngfx/graphics/MeshBVH.h"
+#include "ngfx/graphics/MeshOptimizer.h"
+#include "ngfx/graphics/MeshProcessor.h"
+#include "ngfx/graphics/MeshUtil.h"
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
+#include <map>
 using namespace ngfx;
 using namespace std;
 
-void MeshTool::updateBounds(MeshData& meshData) {
-	auto& b = meshData.bounds;
-	for (auto& p : meshData.pos) {
-		b[0] = glm::min(p, b[0]);
-		b[1] = glm::max(p, b[1]);
-	}
+static uint32_t getPropertySize(const string& type) {
+	static const map<string, uint32_t> propertySizes = {
+		{ "char", 1 }, { "uchar", 1 }, { "int8", 1 }, { "uint8", 1 },
+		{ "short", 2 }, { "ushort", 2 }, { "int16", 2 }, { "uint16", 2 },
+		{ "int", 4 }, { "uint", 4 }, { "int32", 4 }, { "uint32", 4 },
+		{ "float", 4 }, { "float32", 4 }, { "double", 8 }, { "float64", 8 }
+	};
+	auto it = propertySizes.find(type);
+	if (it == propertySizes.end()) NGFX_ERR("unsupported property type: %s", type.c_str());
+	return it->second;
 }
 
 void MeshTool::importPLY(const std::string& file, MeshData& meshData) {
 	ifstream in(file, ios::binary);
-	if (!in.is_open()) ERR("cannot open file: %s", file.c_str());
+	if (!in.is_open()) NGFX_ERR("cannot open file: %s", file.c_str());
 	string param, format; double version;
 	in >> param; assert(param == "ply");
 	in >> param; assert(param == "format");
 	in >> format; assert(format == "binary_little_endian");
 	in >> version;
-	uint32_t numVerts, numFaces;
+	uint32_t numVerts = 0, numFaces = 0;
 	auto skipline = [&]() { in.ignore(1024, '\n'); };
-	bool hasNormals = false;
+	// The float vertex properties are read at their offset in the vertex,
+	// the other properties are skipped
+	map<string, uint32_t> vertexProperties;
+	uint32_t vertexSize = 0, indexCountSize = 0;
+	string element;
 	while (in >> param) {
 		if (param == "element") {
-			in >> param; 
-			if (param == "vertex") in >> numVerts;
-			else if (param == "face") in >> numFaces;
+			in >> element;
+			if (element == "vertex") in >> numVerts;
+			else if (element == "face") in >> numFaces;
+			else NGFX_ERR("unsupported element: %s", element.c_str());
 		}
 		else if (param == "property") {
-			in >> param;
-			if (param == "list") {
-				in >> param; assert(param == "uchar");
-				in >> param; assert(param == "int");
-				in >> param;
+			string type, name;
+			in >> type;
+			if (type == "list") {
+				string countType, indexType;
+				in >> countType >> indexType >> name;
+				assert(element == "face");
+				indexCountSize = getPropertySize(countType);
+				assert(getPropertySize(indexType) == sizeof(int));
 			}
-			else { 
-				in >> param; 
-				if (param == "nx") hasNormals = true;
+			else {
+				in >> name;
+				assert(element == "vertex");
+				if (type == "float" || type == "float32") vertexProperties[name] = vertexSize;
+				vertexSize += getPropertySize(type);
 			}
 		}
 		else if (param == "end_header") {
@@ -50,23 +72,108 @@ void MeshTool::importPLY(const std::string& file, MeshData& meshData) {
 			skipline();
 		}
 	}
-	assert(hasNormals);
+	auto getOffset = [&](const char* name) -> int32_t {
+		auto it = vertexProperties.find(name);
+		return (it == vertexProperties.end()) ? -1 : int32_t(it->second);
+	};
+	int32_t posOffsets[3] = { getOffset("x"), getOffset("y"), getOffset("z") };
+	int32_t normalOffsets[3] = { getOffset("nx"), getOffset("ny"), getOffset("nz") };
+	assert(posOffsets[0] != -1 && posOffsets[1] != -1 && posOffsets[2] != -1);
+	bool hasNormals = normalOffsets[0] != -1 && normalOffsets[1] != -1 && normalOffsets[2] != -1;
+	vector<char> vertices(size_t(numVerts) * vertexSize);
+	in.read(vertices.data(), vertices.size());
 	meshData.pos.resize(numVerts);
-	meshData.normal.resize(numVerts);
+	// The normals of a mesh without normals are generated by MeshTool::process
+	meshData.normal.resize(hasNormals ? numVerts : 0);
 	for (uint32_t j = 0; j < numVerts; j++) {
-		auto& pos = meshData.pos[j];
-		auto& normal = meshData.normal[j];
-		in.read((char*)value_ptr(pos), sizeof(pos));
-		in.read((char*)value_ptr(normal), sizeof(normal));
+		const char* vertex = &vertices[size_t(j) * vertexSize];
+		for (uint32_t k = 0; k < 3; k++) {
+			memcpy(&meshData.pos[j][k], vertex + posOffsets[k], sizeof(float));
+			if (hasNormals) memcpy(&meshData.normal[j][k], vertex + normalOffsets[k], sizeof(float));
+		}
 	}
-	meshData.faces.resize(numFaces);
+	// The polygons are split into triangle fans
+	meshData.faces.reserve(numFaces);
+	vector<int> polygon;
 	for (uint32_t j = 0; j < numFaces; j++) {
-		auto& face = meshData.faces[j];
-		uint8_t numFaceIndices = 0;
-		in.read((char*)&numFaceIndices, sizeof(numFaceIndices));
-		assert(numFaceIndices == 3);
-		in.read((char*)value_ptr(face), sizeof(face));
+		uint32_t numFaceIndices = 0;
+		in.read((char*)&numFaceIndices, indexCountSize);
+		polygon.resize(numFaceIndices);
+		in.read((char*)polygon.data(), numFaceIndices * sizeof(int));
+		for (uint32_t k = 2; k < numFaceIndices; k++)
+			meshData.faces.push_back(ivec3(polygon[0], polygon[k - 1], polygon[k]));
 	}
 	in.close();
-	updateBounds(meshData);
+}
+
+void MeshTool::process(MeshData& meshData, bool weld, float weldTolerance, bool generateNormals) {
+	MeshProcessor::Options options;
+	options.weldVertices = weld;
+	options.weldTolerance = weldTolerance;
+	options.generateNormals = generateNormals;
+	uint32_t numVerts = uint32_t(meshData.pos.size());
+	bool hasNormals = !meshData.normal.empty();
+	auto t0 = chrono::steady_clock::now();
+	auto stats = MeshProcessor::process(meshData, options);
+	double elapsed = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+	printf("vertices: %u -> %u, %u degenerate faces removed%s (%.2f s)\n", numVerts,
+		uint32_t(meshData.pos.size()), stats.numDegenerateFaces,
+		(generateNormals || !hasNormals) ? ", normals generated" : "", elapsed);
+}
+
+void MeshTool::optimize(MeshData& meshData) {
+	auto printStats = [&](const char* label) {
+		auto stats = MeshOptimizer::analyzeVertexCache(meshData);
+		printf("%s: ACMR: %f, ATVR: %f\n", label, stats.acmr, stats.atvr);
+	};
+	printStats("input");
+	MeshOptimizer::optimizeVertexCache(meshData);
+	printStats("vertex cache");
+	MeshOptimizer::optimizeOverdraw(meshData);
+	printStats("overdraw");
+	MeshOptimizer::optimizeVertexFetch(meshData);
+	printStats("vertex fetch");
+}
+
+void MeshTool::generateLODs(MeshData& meshData) {
+	MeshOptimizer::generateLODs(meshData);
+	for (uint32_t j = 0; j < meshData.lods.size(); j++) {
+		auto& lod = meshData.lods[j];
+		printf("LOD %u: %u faces, error: %f\n", j, lod.numFaces, lod.error);
+	}
+}
+
+void MeshTool::buildMeshlets(MeshData& meshData) {
+	MeshOptimizer::buildMeshlets(meshData);
+	auto& meshlets = meshData.meshlets;
+	if (meshlets.empty()) return;
+	uint32_t numVerts = 0, numFaces = 0, numCones = 0;
+	for (auto& meshlet : meshlets) {
+		numVerts += meshlet.numVerts;
+		numFaces += meshlet.numFaces;
+		if (meshlet.normalCone.w < 1.0f) numCones++;
+	}
+	printf("%zu meshlets, average: %.1f vertices, %.1f faces, %u meshlets can be back face culled\n",
+		meshlets.size(), double(numVerts) / meshlets.size(), double(numFaces) / meshlets.size(), numCones);
+}
+
+void MeshTool::quantize(MeshData& meshData, QuantizedMeshData& quantizedMeshData,
+		PositionEncoding posEncoding, NormalEncoding normalEncoding) {
+	MeshUtil::quantizeMesh(meshData, quantizedMeshData, posEncoding, normalEncoding);
+	auto& q = quantizedMeshData;
+	size_t vertexSize = meshData.pos.size() * sizeof(vec3) + meshData.normal.size() * sizeof(vec3);
+	size_t indexSize = meshData.faces.size() * sizeof(ivec3);
+	size_t quantizedVertexSize = q.pos.size() + q.normal.size(), quantizedIndexSize = q.indices.size();
+	printf("vertex data: %zu -> %zu bytes, index data: %zu -> %zu bytes (%.2fx)\n",
+		vertexSize, quantizedVertexSize, indexSize, quantizedIndexSize,
+		double(vertexSize + indexSize) / double(quantizedVertexSize + quantizedIndexSize));
+}
+
+void MeshTool::buildBVH(const MeshData& meshData, const std::string& file) {
+	MeshBVH bvh;
+	auto t0 = chrono::steady_clock::now();
+	bvh.build(meshData);
+	double elapsed = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+	bvh.save(file);
+	printf("BVH: %zu nodes, %zu faces (%.2f s)\n", bvh.nodes.size(), bvh.faceIndices.size(), elapsed);
 }
\ No newline at end of file
@@ -4,7 +4,25 @@
 
 namespace ngfx {
 	struct MeshTool {
+		/** Import a binary PLY file. The normals are optional */
 		static void importPLY(const std::string& file, MeshData& meshData);
-		static void updateBounds(MeshData& meshData);
+		/** Weld the vertices, remove the degenerate faces, generate the normals
+		 *  if needed and update the bounds, in parallel, and print the statistics */
+		static void process(MeshData& meshData, bool weld, float weldTolerance, bool generateNormals);
+		/** Run the vertex cache, overdraw and vertex fetch optimization passes,
+		 *  and print the vertex cache statistics before and after */
+		static void optimize(MeshData& meshData);
+		/** Generate the levels of detail,
+		 *  and print the number of faces and the error of each level */
+		static void generateLODs(MeshData& meshData);
+		/** Build the meshlets, and print their number and average size */
+		static void buildMeshlets(MeshData& meshData);
+		/** Pack the vertex attributes and the indices,
+		 *  and print the memory usage before and after */
+		static void quantize(MeshData& meshData, QuantizedMeshData& quantizedMeshData,
+			PositionEncoding posEncoding, NormalEncoding normalEncoding);
+		/** Build the BVH of the mesh and save it,
+		 *  and print the number of nodes and the build time */
+		static void buildBVH(const MeshData& meshData, const std::string& file);
 	};
 }
\ No newline at end of file